@@ -0,0 +1,189 @@
+/**
+ * \file Arena.hpp
+ * \author Andrey Popov
+ * 
+ * The module defines a bump allocator for short-lived objects and an STL-compatible adapter for it.
+ */
+
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <new>
+
+
+/**
+ * \class Arena
+ * \brief A bump allocator for objects that share the same lifetime
+ * 
+ * Memory is carved sequentially from large chunks. Individual deallocations are not supported;
+ * instead, the whole arena is reset at once, after which the memory is reused. Chunks are never
+ * released before the arena is destroyed, and thus once the arena has grown to accommodate the
+ * largest working set (for instance, the most busy event), no more heap allocations are performed.
+ * 
+ * The class is not thread-safe. It is meant to be owned by an object that is used by a single
+ * thread, such as PECReader.
+ * 
+ * The class is non-copyable.
+ */
+class Arena
+{
+public:
+    /// Constructor with a size of chunks (in bytes)
+    Arena(std::size_t chunkSize = 64 * 1024) noexcept;
+    
+    /// Copy constructor is deleted
+    Arena(Arena const &) = delete;
+    
+    /// Assignment operator is deleted
+    Arena &operator=(Arena const &) = delete;
+    
+    /// Destructor
+    ~Arena();
+
+public:
+    /**
+     * \brief Allocates a block of memory with the given size and alignment
+     * 
+     * The alignment must be a power of two. The memory stays valid until the next call to Reset.
+     */
+    void *Allocate(std::size_t nBytes, std::size_t alignment = alignof(long double));
+    
+    /// Marks all the memory as free. All pointers obtained earlier become invalid
+    void Reset() noexcept;
+    
+    /// Returns the total size of allocated chunks (in bytes)
+    std::size_t GetCapacity() const noexcept;
+    
+    /// Returns the number of chunks that have been allocated from the heap over the lifetime
+    unsigned long GetNumChunkAllocations() const noexcept;
+
+private:
+    /// A contiguous block of memory
+    struct Chunk
+    {
+        char *data;
+        std::size_t size;
+    };
+
+private:
+    /// Default size of a chunk
+    std::size_t chunkSize;
+    
+    /// Allocated chunks
+    std::vector<Chunk> chunks;
+    
+    /// Index of the chunk from which memory is being carved
+    unsigned curChunk;
+    
+    /// Position of the first free byte in the current chunk
+    std::size_t curPos;
+    
+    /// Number of chunk allocations
+    unsigned long nChunkAllocations;
+};
+
+
+/**
+ * \class ArenaAllocator
+ * \brief An STL-compatible allocator that takes memory from an Arena
+ * 
+ * Deallocation is a no-op; the memory is reclaimed when the arena is reset. If the allocator is
+ * not given an arena, it falls back to the global operator new. A copy of a container made with
+ * the copy constructor uses the global heap, so that it can safely outlive the arena.
+ */
+template<typename T>
+class ArenaAllocator
+{
+    template<typename U>
+    friend class ArenaAllocator;
+
+public:
+    typedef T value_type;
+
+public:
+    /// Constructor from an arena (or null to use the heap)
+    ArenaAllocator(Arena *arena = nullptr) noexcept;
+    
+    /// Constructor from an allocator for a different type
+    template<typename U>
+    ArenaAllocator(ArenaAllocator<U> const &src) noexcept;
+
+public:
+    /// Allocates memory for n objects
+    T *allocate(std::size_t n);
+    
+    /// Deallocates memory allocated with the heap; does nothing for memory from the arena
+    void deallocate(T *p, std::size_t n) noexcept;
+    
+    /// Returns an allocator to be used in a copy of a container, which is a heap allocator
+    ArenaAllocator select_on_container_copy_construction() const noexcept;
+    
+    /// Returns the arena used or null
+    Arena *GetArena() const noexcept;
+
+private:
+    /// Arena to take memory from
+    Arena *arena;
+};
+
+
+template<typename T>
+ArenaAllocator<T>::ArenaAllocator(Arena *arena_ /*= nullptr*/) noexcept:
+    arena(arena_)
+{}
+
+
+template<typename T>
+template<typename U>
+ArenaAllocator<T>::ArenaAllocator(ArenaAllocator<U> const &src) noexcept:
+    arena(src.arena)
+{}
+
+
+template<typename T>
+T *ArenaAllocator<T>::allocate(std::size_t n)
+{
+    if (arena)
+        return static_cast<T *>(arena->Allocate(n * sizeof(T), alignof(T)));
+    else
+        return static_cast<T *>(::operator new(n * sizeof(T)));
+}
+
+
+template<typename T>
+void ArenaAllocator<T>::deallocate(T *p, std::size_t) noexcept
+{
+    if (not arena)
+        ::operator delete(p);
+}
+
+
+template<typename T>
+ArenaAllocator<T> ArenaAllocator<T>::select_on_container_copy_construction() const noexcept
+{
+    return ArenaAllocator<T>();
+}
+
+
+template<typename T>
+Arena *ArenaAllocator<T>::GetArena() const noexcept
+{
+    return arena;
+}
+
+
+/// Allocators are equal if they use the same arena
+template<typename T, typename U>
+bool operator==(ArenaAllocator<T> const &lhs, ArenaAllocator<U> const &rhs) noexcept
+{
+    return (lhs.GetArena() == rhs.GetArena());
+}
+
+
+/// Allocators differ if they use different arenas
+template<typename T, typename U>
+bool operator!=(ArenaAllocator<T> const &lhs, ArenaAllocator<U> const &rhs) noexcept
+{
+    return (lhs.GetArena() != rhs.GetArena());
+}
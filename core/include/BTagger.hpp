@@ -10,7 +10,8 @@
 #include <PhysicsObjects.hpp>
 
 #include <string>
-#include <map>
+#include <array>
+#include <vector>
 
 
 /**
@@ -25,6 +26,16 @@
  * It is recommended that b-tagging is performed by the means of this class only but never using
  * values of b-tagging discriminators provided by class Jet.
  * 
+ * Decisions for all the working points can be evaluated once per jet and cached in the jet with
+ * the help of method CacheTagBits. If a jet carries decisions produced by a b-tagger with the same
+ * algorithm, method IsTagged only reads the corresponding bit. PECReader fills the cache for all
+ * jets if a b-tagger is provided in its configuration.
+ * 
+ * Thresholds are stored in a flat array indexed with the working point, and thresholds of
+ * unsupported working points are set to infinity. This allows to evaluate decisions for all the
+ * working points without branching. Methods TagJets and ComputeTagBits classify a whole collection
+ * of jets (or columns of discriminators and pseudorapidities) in one pass.
+ * 
  * The class provides valid copy and move constructors and assignment operator. Is is thread-safe.
  */
 class BTagger
@@ -71,7 +82,8 @@ public:
      * 
      * Returns false if the jet is outside a pseudorapidity acceptance defined according to
      * BTagSFInterface::GetMaxPseudorapidity(). If the requested working point is not supported, an
-     * exception is thrown.
+     * exception is thrown. If the jet carries cached decisions of a compatible b-tagger, they are
+     * used.
      */
     bool IsTagged(WorkingPoint wp, Jet const &jet) const;
     
@@ -96,6 +108,58 @@ public:
      */
     bool operator()(Jet const &jet) const;
     
+    /**
+     * \brief Evaluates b-tagging decisions for all the supported working points
+     * 
+     * The bit with index int(wp) of the returned value is set if the jet is tagged at working
+     * point wp. Bits of unsupported working points are never set. Cached decisions stored in the
+     * jet are ignored.
+     */
+    unsigned ComputeTagBits(Jet const &jet) const;
+    
+    /**
+     * \brief Evaluates b-tagging decisions for all working points and stores them in the jet
+     * 
+     * Subsequent calls to IsTagged for this jet (with this or any other b-tagger with the same
+     * algorithm) will only read the stored decisions.
+     */
+    void CacheTagBits(Jet &jet) const;
+    
+    /// Calls CacheTagBits for each jet in the collection
+    void TagJets(std::vector<Jet> &jets) const;
+    
+    /**
+     * \brief Evaluates b-tagging decisions for columns of discriminators and pseudorapidities
+     * 
+     * The arrays must contain n elements each. The discriminators must correspond to the algorithm
+     * of this. The decisions are written to array bits in the same format as returned by
+     * ComputeTagBits(Jet const &). The loop contains no branches and can be vectorised by the
+     * compiler. The comparisons are performed in single precision with the thresholds rounded
+     * down to the closest float values, which gives exactly the same decisions as the comparisons
+     * in double precision in IsTagged since discriminators and pseudorapidities are stored as
+     * float.
+     */
+    void ComputeTagBits(unsigned n, float const *discriminators, float const *eta,
+     unsigned char *bits) const;
+    
+    /// Returns the code that identifies decisions cached by this b-tagger in a jet
+    int GetTagBitsCode() const;
+    
+    /**
+     * \brief Returns the numerical threshold for the given working point
+     * 
+     * If the working point is not supported for the chosen algorithm, an exception is thrown. The
+     * method is intended for classes that freeze the b-tagging configuration at construction.
+     */
+    double GetThreshold(WorkingPoint wp) const;
+    
+    /**
+     * \brief Returns value of the discriminator of the chosen algorithm for the given jet
+     * 
+     * No acceptance check is performed.
+     */
+    double GetDiscriminator(Jet const &jet) const;
+    
     /// Returns the b-tagging algorithm in use
     Algorithm GetAlgorithm() const;
     
@@ -107,7 +171,11 @@ public:
     
     /// Returns a string that encodes the algorithm and the working point
     std::string GetTextCode() const;
-    
+
+private:
+    /// Throws an exception to report an unsupported working point
+    [[noreturn]] void ThrowUnsupportedWP(WorkingPoint wp, std::string const &method) const;
+
 private:
     /// Chosen b-tagging algorithm
     Algorithm algo;
@@ -115,9 +183,30 @@ private:
     /// Default working point of the b-tagging algorithm
     WorkingPoint defaultWP;
     
-    /// Numerical thresholds for the chosen b-tagging algorithm
-    std::map<WorkingPoint, double> thresholds;
+    /**
+     * \brief Numerical thresholds for the chosen b-tagging algorithm
+     * 
+     * The array is indexed with int(WorkingPoint). Thresholds for unsupported working points are
+     * set to infinity.
+     */
+    std::array<double, 3> thresholds;
+    
+    /**
+     * \brief Thresholds rounded down to float values for the batched evaluation
+     * 
+     * For any float x, (x > float threshold) is equivalent to (x > double threshold).
+     */
+    std::array<float, 3> floatThresholds;
+    
+    /// Mask of supported working points; bit int(wp) is set for each of them
+    unsigned supportedMask;
+    
+    /// Index of the appropriate b-tagging discriminator for Jet::GetBTagDiscriminator
+    unsigned discriminatorIndex;
+    
+    /// Maximal absolute pseudorapidity of a jet that can be b-tagged
+    double maxAbsEta;
     
-    /// Pointer to a method of class Jet to access an appropriate b-tagging discriminator
-    double (Jet::*bTagMethod)() const;
+    /// Maximal absolute pseudorapidity rounded down to a float value
+    float floatMaxAbsEta;
 };
@@ -0,0 +1,233 @@
+/**
+ * \file ColumnCache.hpp
+ * \author Andrey Popov
+ * 
+ * The module defines classes to write and read an uncompressed columnar cache of a source file.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+
+/**
+ * \struct ColumnCacheKey
+ * \brief Describes the content a column cache must correspond to
+ * 
+ * A cache is valid only if all the fields coincide with the ones stored in the cache file.
+ */
+struct ColumnCacheKey
+{
+    /// Size of the source file in bytes
+    std::uint64_t sourceSize;
+    
+    /// Modification time of the source file (seconds since the epoch)
+    std::int64_t sourceMTime;
+    
+    /// Hash of the set of columns (names, element sizes, maximal lengths)
+    std::uint64_t columnsHash;
+    
+    /// Number of entries
+    std::uint64_t nEntries;
+    
+    /// Number of columns
+    std::uint32_t nColumns;
+};
+
+
+/**
+ * \class ColumnCache
+ * \brief Provides access to a column cache file mapped into memory
+ * 
+ * The cache file contains values of a set of columns (branches) for all entries of a source file.
+ * The data are not compressed. They are split into blocks of consecutive entries; within a block
+ * the values of each column are stored contiguously, preceded by an array of offsets. The file
+ * is mapped into memory, and the user is given pointers to the mapped data. Reading from the cache
+ * thus avoids decompression and ROOT I/O, but not necessarily copying: SyncTreeReader copies the
+ * values from the mapping into the buffers bound to the branches. A cache file is written with the
+ * help of class ColumnCacheWriter.
+ * 
+ * The layout is as follows. The file starts with a header, which includes a magic string, version
+ * of the format, the key (see ColumnCacheKey), the block size, and the position of the block
+ * index. Each block starts with an array of positions of columns (relative to the start of the
+ * block). Each column contains (n + 1) 32-bit offsets, where n is the number of entries in the
+ * block, followed by the data (aligned at 8 bytes). The block index at the end of the file
+ * contains positions of all blocks. The data are stored in the native byte order.
+ * 
+ * The class is non-copyable.
+ */
+class ColumnCache
+{
+public:
+    /// Header of a cache file
+    struct Header
+    {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t blockSize;
+        ColumnCacheKey key;
+        std::uint64_t blockIndexPos;
+    };
+    
+    /// Magic string that identifies a cache file
+    static char const magic[8];
+    
+    /// Current version of the format
+    static std::uint32_t const version = 1;
+
+public:
+    /// Constructor with no parameters
+    ColumnCache() noexcept;
+    
+    /// Copy constructor is deleted
+    ColumnCache(ColumnCache const &) = delete;
+    
+    /// Assignment operator is deleted
+    ColumnCache &operator=(ColumnCache const &) = delete;
+    
+    /// Destructor
+    ~ColumnCache();
+
+public:
+    /**
+     * \brief Maps the given cache file into memory
+     * 
+     * The last argument gives the maximal size in bytes of a value of each column. Positions of
+     * all blocks and columns and the offsets of all values are validated against the size of the
+     * file and these limits, so that the data served later never point outside of the mapping or
+     * overflow a buffer of the user. Returns false if the file does not exist, cannot be mapped,
+     * does not correspond to the given key, or fails the validation. In this case this is left
+     * closed.
+     */
+    bool Open(std::string const &path, ColumnCacheKey const &key,
+     std::vector<unsigned> const &maxSizes);
+    
+    /// Unmaps the currently mapped file (if any)
+    void Close() noexcept;
+    
+    /// Checks if a cache file is mapped
+    bool IsOpen() const noexcept;
+    
+    /**
+     * \brief Returns a pointer to the value of a column in the given entry
+     * 
+     * The size of the value in bytes is written into the last argument. The pointer stays valid
+     * until the cache is closed. No range checks are performed.
+     */
+    void const *GetData(unsigned column, unsigned long entry, unsigned &nBytes) const noexcept;
+
+private:
+    /// Checks that all blocks and values of the mapped file lie within it
+    bool Validate(std::uint64_t blockIndexPos, unsigned nColumns,
+     std::vector<unsigned> const &maxSizes) const noexcept;
+
+private:
+    /// Beginning of the mapped file
+    char const *base;
+    
+    /// Size of the mapped file
+    std::size_t size;
+    
+    /// Index of blocks (points into the mapped file)
+    std::uint64_t const *blockIndex;
+    
+    /// Number of entries per block
+    unsigned blockSize;
+    
+    /// Total number of entries
+    unsigned long nEntries;
+};
+
+
+/**
+ * \class ColumnCacheWriter
+ * \brief Writes a column cache file
+ * 
+ * The user adds values of all the columns for each entry in the same order, calling method
+ * EndEntry after each entry, and then calls method Finish. The data are written to a temporary
+ * file, which is renamed into the final one only if all the entries have been written
+ * successfully, so that a partially written cache is never visible to readers. Only one block of
+ * entries is kept in memory.
+ * 
+ * The class is non-copyable.
+ */
+class ColumnCacheWriter
+{
+public:
+    /**
+     * \brief Constructor
+     * 
+     * Creates the temporary file. If it cannot be created, the writer is put in the failed state,
+     * and all subsequent calls have no effect.
+     */
+    ColumnCacheWriter(std::string const &path, ColumnCacheKey const &key,
+     unsigned blockSize = 4096);
+    
+    /// Copy constructor is deleted
+    ColumnCacheWriter(ColumnCacheWriter const &) = delete;
+    
+    /// Assignment operator is deleted
+    ColumnCacheWriter &operator=(ColumnCacheWriter const &) = delete;
+    
+    /// Destructor; removes the temporary file if Finish has not been called successfully
+    ~ColumnCacheWriter();
+
+public:
+    /// Appends value of the given column in the current entry
+    void Append(unsigned column, void const *data, unsigned nBytes);
+    
+    /// Ends the current entry
+    void EndEntry();
+    
+    /**
+     * \brief Writes the remaining data and renames the temporary file
+     * 
+     * Returns false if an error occurred at any stage.
+     */
+    bool Finish();
+    
+    /// Checks if an error has occurred
+    bool Failed() const noexcept;
+
+private:
+    /// Writes the buffered block to the file
+    void FlushBlock();
+    
+    /// Writes a chunk of data to the file
+    void Write(void const *data, std::size_t nBytes);
+
+private:
+    /// Final and temporary paths
+    std::string path, tmpPath;
+    
+    /// Key to be written into the header
+    ColumnCacheKey key;
+    
+    /// Number of entries per block
+    unsigned blockSize;
+    
+    /// File descriptor of the temporary file
+    int fd;
+    
+    /// Current position in the file
+    std::uint64_t filePos;
+    
+    /// Indicates whether an error has occurred
+    bool failed;
+    
+    /// Indicates whether the file has been finished successfully
+    bool finished;
+    
+    /// Number of entries in the current block and in total
+    unsigned nEntriesBlock;
+    std::uint64_t nEntriesTotal;
+    
+    /// Offsets and data of all columns in the current block
+    std::vector<std::vector<std::uint32_t>> offsets;
+    std::vector<std::vector<char>> data;
+    
+    /// Positions of written blocks
+    std::vector<std::uint64_t> blockIndex;
+};
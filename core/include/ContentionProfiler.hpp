@@ -0,0 +1,174 @@
+/**
+ * \file ContentionProfiler.hpp
+ * \author Andrey Popov
+ * 
+ * The module defines a facility to measure contention on the global locks used by RunManager.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <array>
+#include <vector>
+#include <string>
+#include <chrono>
+
+
+/**
+ * \class ContentionProfiler
+ * \brief Counts acquisitions of global locks and the time threads spend waiting for them
+ * 
+ * The class is a collection of static counters. The global locks (the queue of datasets in
+ * RunManager, ROOTLock, and the mutex of the logger) are acquired with method Acquire. When the
+ * profiler is disabled, it simply locks the mutex, so the overhead is limited to checking an atomic
+ * flag. When it is enabled, a lock is first tried without blocking; only if the mutex is already
+ * owned by another thread, the waiting time is measured. The counters are updated with relaxed
+ * atomic operations and do not introduce additional synchronization between threads.
+ * 
+ * In addition to the global counters, the total time the current thread has spent waiting for
+ * any of the locks is accumulated in a thread-local variable.
+ * 
+ * The profiler is enabled by RunManager if requested by the user, and the summary is printed at
+ * the end of RunManager::Process.
+ */
+class ContentionProfiler
+{
+public:
+    /// Profiled locks
+    enum class LockID: unsigned
+    {
+        Datasets,  ///< Queue of datasets in RunManager
+        ROOT,      ///< Global lock that protects ROOT routines (class ROOTLock)
+        Logger     ///< Mutex of the logger (every output operation is counted)
+    };
+    
+    /// Statistics for a single lock
+    struct LockStats
+    {
+        /// Number of times the lock has been acquired
+        unsigned long nAcquisitions;
+        
+        /// Number of acquisitions that found the lock owned by another thread
+        unsigned long nContended;
+        
+        /// Total and maximal time spent waiting for the lock, in seconds
+        double waitTime, maxWaitTime;
+    };
+    
+    /// Activity of a single processing thread
+    struct ThreadStats
+    {
+        /// Constructor with no parameters; sets all counters to zero
+        ThreadStats() noexcept;
+        
+        /// Lifetime of the thread, in seconds
+        double wallTime;
+        
+        /// Time spent processing datasets, in seconds
+        double busyTime;
+        
+        /// Time spent waiting for any of the profiled locks, in seconds
+        double lockWaitTime;
+        
+        /// Number of processed files
+        unsigned nFiles;
+        
+        /**
+         * \brief Number of events delivered by PECReader
+         * 
+         * Events rejected by early filters that plugins have registered in the reader (see
+         * Plugin::RegisterEarlyFilters) are not delivered and thus not included.
+         */
+        unsigned long nEvents;
+    };
+
+private:
+    /// Counters for a single lock
+    struct Counters
+    {
+        std::atomic<unsigned long> nAcquisitions, nContended;
+        std::atomic<unsigned long long> waitTime, maxWaitTime;  // in nanoseconds
+    };
+
+public:
+    /// Constructor is deleted
+    ContentionProfiler() = delete;
+
+public:
+    /// Enables or disables the profiler
+    static void Enable(bool enable = true) noexcept;
+    
+    /// Checks if the profiler is enabled
+    static bool IsEnabled() noexcept;
+    
+    /// Resets all the global counters. Thread-local counters are not affected
+    static void Reset() noexcept;
+    
+    /**
+     * \brief Locks the given mutex, updating the counters for the lock with the given ID
+     * 
+     * The mutex must provide methods lock and try_lock.
+     */
+    template<typename Mutex>
+    static void Acquire(LockID id, Mutex &mutex);
+    
+    /// Returns statistics for the given lock
+    static LockStats GetLockStats(LockID id) noexcept;
+    
+    /// Returns the total time (in seconds) the current thread has spent waiting for locks
+    static double GetThreadLockWaitTime() noexcept;
+    
+    /// Returns a human-readable name of the lock
+    static std::string GetLockName(LockID id);
+    
+    /**
+     * \brief Prints a summary of the scaling behaviour with the logger
+     * 
+     * The arguments are the total wall time of the processing (in seconds) and the activity of
+     * individual threads.
+     */
+    static void PrintSummary(double wallTime, std::vector<ThreadStats> const &threads);
+
+private:
+    /// Updates the counters for a lock acquired with the given waiting time
+    static void Record(LockID id, std::chrono::steady_clock::duration const &wait) noexcept;
+    
+    /// Updates the counters for a lock acquired without waiting
+    static void RecordUncontended(LockID id) noexcept;
+
+private:
+    /// Number of profiled locks
+    static unsigned const nLocks = 3;
+    
+    /// Indicates if the profiler is enabled
+    static std::atomic<bool> enabled;
+    
+    /// Counters for all the locks
+    static std::array<Counters, nLocks> counters;
+    
+    /// Total time the current thread has spent waiting for locks, in nanoseconds
+    static thread_local unsigned long long threadWaitTime;
+};
+
+
+template<typename Mutex>
+void ContentionProfiler::Acquire(LockID id, Mutex &mutex)
+{
+    if (not enabled.load(std::memory_order_relaxed))
+    {
+        mutex.lock();
+        return;
+    }
+    
+    
+    // Measure the time only if the lock cannot be acquired immediately
+    if (mutex.try_lock())
+    {
+        RecordUncontended(id);
+        return;
+    }
+    
+    auto const start = std::chrono::steady_clock::now();
+    mutex.lock();
+    Record(id, std::chrono::steady_clock::now() - start);
+}
@@ -8,27 +8,33 @@
 #pragma once
 
 #include <PhysicsObjects.hpp>
+#include <Arena.hpp>
 
-#include <list>
+#include <vector>
 #include <initializer_list>
 
 
 /**
  * \class GenParticle
  * \brief Describes a generator-level particle
+ * 
+ * Links to mothers and daughters can be stored in an Arena provided to the constructor. In this
+ * case the particle must not be used after the arena has been reset. Copies of the particle store
+ * the links in the heap.
  */
 class GenParticle: public Candidate
 {
     public:
         /// Type of the container to store the mothers and daughters
-        typedef std::list<GenParticle const *> collection_t;
+        typedef std::vector<GenParticle const *, ArenaAllocator<GenParticle const *>>
+         collection_t;
     
     public:
         /// Default constructor
         GenParticle();
         
-        /// Constructor with 4-momentum and PDG ID
-        GenParticle(TLorentzVector const &p4_, int pdgId_ = 0);
+        /// Constructor with 4-momentum, PDG ID, and an optional arena to store the links
+        GenParticle(TLorentzVector const &p4_, int pdgId_ = 0, Arena *arena = nullptr);
     
     public:
         /// Sets the PDG ID
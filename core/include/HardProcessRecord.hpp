@@ -0,0 +1,274 @@
+/**
+ * \file HardProcessRecord.hpp
+ * \author Andrey Popov
+ * 
+ * The module defines a flat, index-based record of generator particles from the hard interaction.
+ */
+
+#pragma once
+
+#include <TLorentzVector.h>
+
+#include <vector>
+#include <array>
+#include <initializer_list>
+
+
+/**
+ * \class HardProcessRecord
+ * \brief Stores generator particles from the hard interaction as a set of flat arrays
+ * 
+ * Properties of particles are kept in columns indexed by position of a particle in the record.
+ * Mothers and daughters are stored in the compressed sparse row (CSR) format: the indices of
+ * daughters of all the particles are kept in a single array, and an array of offsets delimits the
+ * ranges that correspond to individual particles. No pointers are stored, and the record can be
+ * refilled for every event without heap allocations once the arrays have reached their maximal
+ * size.
+ * 
+ * Individual particles are accessed via lightweight views (class ParticleView), whose interface
+ * mimics the one of class GenParticle. Several frequent queries are answered with lookup tables
+ * built when the record is finalized: the first particle with a given PDG ID and the decay
+ * products of W bosons.
+ * 
+ * The record is filled with method AddParticle, which must be followed by a call to method
+ * Finalize before the record is used. Mothers must be referenced by their indices in the record.
+ */
+class HardProcessRecord
+{
+public:
+    class ParticleView;
+    class ParticleRange;
+    
+    /// Decay products of a W boson
+    struct WDecay
+    {
+        /// Index of the W boson (the last one in a chain of W copies)
+        unsigned w;
+        
+        /// Indices of the first two daughters that are not W bosons (-1 if missing)
+        int daughters[2];
+    };
+
+public:
+    /// Constructor with no parameters
+    HardProcessRecord() noexcept;
+
+public:
+    /// Removes all the particles; the allocated memory is kept
+    void Clear() noexcept;
+    
+    /// Allocates memory for the given number of particles
+    void Reserve(unsigned nParticles);
+    
+    /**
+     * \brief Adds a new particle to the record
+     * 
+     * Indices of mothers that are negative or do not refer to particles in the record (after
+     * it has been finalized) are ignored. The second mother is only added if it differs from the
+     * first one.
+     */
+    void AddParticle(int pdgId, float pt, float eta, float phi, float mass, int firstMother,
+     int lastMother);
+    
+    /// Builds the daughter lists and the lookup tables
+    void Finalize();
+    
+    /// Returns the number of particles
+    unsigned GetNumParticles() const noexcept;
+    
+    /// Returns a view to the particle with the given index; no range checks are performed
+    ParticleView operator[](unsigned index) const noexcept;
+    
+    /// Returns a view to the particle with the given index; throws an exception if out of range
+    ParticleView At(unsigned index) const;
+    
+    /// Returns a range of views to all the particles
+    ParticleRange GetParticles() const noexcept;
+    
+    /// Returns the PDG ID of the particle with the given index
+    int GetPdgId(unsigned index) const noexcept;
+    
+    /// Returns the four-momentum of the particle with the given index
+    TLorentzVector GetP4(unsigned index) const;
+    
+    /// Returns the index of the first particle with the given PDG ID or -1 if there is none
+    int FindFirst(int pdgId) const noexcept;
+    
+    /**
+     * \brief Returns a view to the first top quark or antiquark
+     * 
+     * The returned view is invalid if there are no top quarks in the record.
+     */
+    ParticleView GetFirstTop() const noexcept;
+    
+    /// Returns decay products of all the W bosons in the record
+    std::vector<WDecay> const &GetWDecays() const noexcept;
+
+private:
+    /// Offset to convert a PDG ID into an index of the lookup table
+    static int const pdgIdOffset = 128;
+
+private:
+    /// PDG ID of the particles
+    std::vector<int> pdgIds;
+    
+    /// Transverse momenta, pseudorapidities, azimuthal angles, and masses of the particles
+    std::vector<float> pts, etas, phis, masses;
+    
+    /// Raw indices of mothers as given to AddParticle
+    std::vector<int> rawMothers;
+    
+    /// Indices of all the particles, i.e. 0, 1, ..., n - 1
+    std::vector<unsigned> allIndices;
+    
+    /// Mothers in the CSR format
+    std::vector<unsigned> motherOffsets, motherIndices;
+    
+    /// Daughters in the CSR format
+    std::vector<unsigned> daughterOffsets, daughterIndices;
+    
+    /// Index of the first particle for each PDG ID in the range [-pdgIdOffset, pdgIdOffset)
+    std::array<int, 2 * pdgIdOffset> firstByPdgId;
+    
+    /// Decay products of W bosons
+    std::vector<WDecay> wDecays;
+};
+
+
+/**
+ * \class HardProcessRecord::ParticleView
+ * \brief A view to a single particle in a HardProcessRecord
+ * 
+ * The view holds a pointer to the record and an index. It is invalidated when the record is
+ * cleared. A default-constructed view is invalid and evaluates to false in a boolean context; it
+ * plays the role of a null pointer in the interface of class GenParticle.
+ */
+class HardProcessRecord::ParticleView
+{
+public:
+    /// Constructs an invalid view
+    ParticleView() noexcept;
+    
+    /// Constructs a view to the particle with the given index
+    ParticleView(HardProcessRecord const *record, unsigned index) noexcept;
+
+public:
+    /// Checks if the view refers to a particle
+    explicit operator bool() const noexcept;
+    
+    /// Returns the index of the particle in the record
+    unsigned GetIndex() const noexcept;
+    
+    /// Returns the PDG ID
+    int GetPdgId() const noexcept;
+    
+    /// Returns the four-momentum
+    TLorentzVector P4() const;
+    
+    /// Returns the transverse momentum
+    double Pt() const noexcept;
+    
+    /// Returns the pseudorapidity
+    double Eta() const noexcept;
+    
+    /// Returns the azimuthal angle
+    double Phi() const noexcept;
+    
+    /// Returns the mass
+    double M() const noexcept;
+    
+    /// Returns the range of mother particles
+    ParticleRange GetMothers() const noexcept;
+    
+    /// Returns the first mother or an invalid view if there are no mothers
+    ParticleView GetFirstMother() const noexcept;
+    
+    /// Returns the PDG ID of the first mother or zero if there are no mothers
+    int GetFirstMotherPdgId() const noexcept;
+    
+    /// Returns the range of daughter particles
+    ParticleRange GetDaughters() const noexcept;
+    
+    /**
+     * \brief Returns the first daughter with one of the given PDG ID
+     * 
+     * If there is no such daughter, an invalid view is returned.
+     */
+    ParticleView FindFirstDaughter(std::initializer_list<int> const &pdgIds) const noexcept;
+    
+    /**
+     * \brief Recursively looks for a particle with one of the given PDG ID
+     * 
+     * This particle is checked first, and then its daughters are searched in the depth-first
+     * order. If there is no such particle, an invalid view is returned.
+     */
+    ParticleView FindFirstDaughterRecursive(std::initializer_list<int> const &pdgIds) const
+     noexcept;
+
+private:
+    /// Record the particle belongs to
+    HardProcessRecord const *record;
+    
+    /// Index of the particle
+    unsigned index;
+};
+
+
+/**
+ * \class HardProcessRecord::ParticleRange
+ * \brief A range of particles defined by an array of their indices
+ * 
+ * Supports iteration with range-based for loops. Dereferencing an iterator gives a ParticleView.
+ */
+class HardProcessRecord::ParticleRange
+{
+public:
+    /// Iterator over the range
+    class Iterator
+    {
+    public:
+        /// Constructor from a record and a position in an array of indices
+        Iterator(HardProcessRecord const *record, unsigned const *pos) noexcept;
+        
+        /// Returns a view to the current particle
+        ParticleView operator*() const noexcept;
+        
+        /// Moves to the next particle
+        Iterator &operator++() noexcept;
+        
+        /// Compares positions of two iterators
+        bool operator!=(Iterator const &rhs) const noexcept;
+    
+    private:
+        HardProcessRecord const *record;
+        unsigned const *pos;
+    };
+
+public:
+    /// Constructor from a record and an array of indices
+    ParticleRange(HardProcessRecord const *record, unsigned const *begin, unsigned const *end)
+     noexcept;
+
+public:
+    /// Returns an iterator to the first particle
+    Iterator begin() const noexcept;
+    
+    /// Returns an iterator past the last particle
+    Iterator end() const noexcept;
+    
+    /// Returns the number of particles
+    unsigned size() const noexcept;
+    
+    /// Checks if the range is empty
+    bool empty() const noexcept;
+    
+    /// Returns a view to the particle with the given position in the range
+    ParticleView operator[](unsigned i) const noexcept;
+    
+    /// Returns a view to the first particle in the range; the range must not be empty
+    ParticleView front() const noexcept;
+
+private:
+    HardProcessRecord const *record;
+    unsigned const *first, *last;
+};
@@ -0,0 +1,65 @@
+/**
+ * \file NeutrinoPzSolver.hpp
+ * \author Andrey Popov
+ * 
+ * The module defines a solver to reconstruct the longitudinal momentum of a neutrino from a W-boson
+ * decay.
+ */
+
+#pragma once
+
+
+/**
+ * \class NeutrinoPzSolver
+ * \brief Reconstructs the z-component of momentum of a neutrino from a W-boson decay
+ * 
+ * The class reproduces the algorithm implemented in function Nu4Momentum (see CalculatePzNu.hpp).
+ * The z-component of the neutrino momentum is found by imposing the W-boson mass constraint on
+ * the system of the charged lepton and the neutrino, whose transverse momentum is identified with
+ * MET. If the resulting quadratic equation has two real roots, the one with the smallest absolute
+ * value is chosen. Otherwise, the transverse momentum of the neutrino is adjusted to make the
+ * discriminant of the equation zero while being as close to MET as possible; the minimization
+ * reduces to two cubic equations, which are solved in a closed form.
+ * 
+ * Unlike the original routine, all the calculations are performed in double precision, no memory
+ * is allocated, and no objects are constructed. A version of the method that processes arrays of
+ * events is also provided.
+ */
+class NeutrinoPzSolver
+{
+public:
+    /// Constructor is deleted
+    NeutrinoPzSolver() = delete;
+
+public:
+    /**
+     * \brief Reconstructs the z-component of neutrino momentum
+     * 
+     * The arguments are the four-momentum of the charged lepton and the components of MET. Zero is
+     * returned if the reconstruction fails.
+     */
+    static double Solve(double lepPx, double lepPy, double lepPz, double lepE, double metPx,
+     double metPy) noexcept;
+    
+    /**
+     * \brief Reconstructs the z-component of neutrino momentum in a batch of events
+     * 
+     * The input and output arrays must contain n elements each. The arrays may not overlap.
+     */
+    static void Solve(unsigned n, double const *lepPx, double const *lepPy, double const *lepPz,
+     double const *lepE, double const *metPx, double const *metPy, double *nuPz) noexcept;
+
+private:
+    /**
+     * \brief Finds real roots of the cubic equation x^3 + b x^2 + c x + d = 0
+     * 
+     * Follows the acceptance criteria of the original routine: a root is reported if its imaginary
+     * part is smaller than 1e-4 in absolute value. The roots are written into the given array, and
+     * their number is returned.
+     */
+    static unsigned SolveCubic(double b, double c, double d, double roots[3]) noexcept;
+
+private:
+    /// Mass of the W boson, GeV/c^2
+    static double const mW;
+};
@@ -0,0 +1,65 @@
+/**
+ * \file NumaTopology.hpp
+ * \author Andrey Popov
+ * 
+ * The module defines a class that describes the NUMA layout of the CPUs available to the process.
+ */
+
+#pragma once
+
+#include <vector>
+#include <string>
+
+
+/**
+ * \class NumaTopology
+ * \brief Describes which of the CPUs available to the process belong to which NUMA node
+ * 
+ * The layout is read from the sysfs (/sys/devices/system/node) and is restricted to the CPUs
+ * allowed by the affinity mask of the process, so that restrictions imposed by the batch system
+ * (e.g. with taskset or cgroups) are respected. Nodes without allowed CPUs are dropped. If the
+ * layout cannot be read (e.g. the system is not NUMA-capable or is not Linux), all the CPUs are
+ * assigned to a single node.
+ * 
+ * The class also provides a method to pin the current thread to a CPU. Since Linux allocates
+ * memory on the node of the CPU that touches it first, objects created by a pinned thread are
+ * placed in its local memory.
+ */
+class NumaTopology
+{
+public:
+    /// Constructor; reads the layout
+    NumaTopology();
+
+public:
+    /// Returns the number of NUMA nodes with at least one available CPU
+    unsigned GetNumNodes() const noexcept;
+    
+    /// Returns indices of available CPUs in the given node
+    std::vector<unsigned> const &GetCPUs(unsigned node) const;
+    
+    /// Returns the total number of available CPUs
+    unsigned GetNumCPUs() const noexcept;
+    
+    /**
+     * \brief Pins the current thread to the given CPU
+     * 
+     * Returns false if the affinity cannot be set.
+     */
+    static bool PinCurrentThread(unsigned cpu) noexcept;
+
+private:
+    /**
+     * \brief Parses a list of CPUs in the format used by the kernel
+     * 
+     * The format is a comma-separated list of indices and ranges, e.g. "0-7,16-23".
+     */
+    static std::vector<unsigned> ParseCPUList(std::string const &list);
+    
+    /// Returns indices of CPUs allowed by the affinity mask of the process
+    static std::vector<unsigned> GetAllowedCPUs();
+
+private:
+    /// Available CPUs in each node
+    std::vector<std::vector<unsigned>> nodes;
+};
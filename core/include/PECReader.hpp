@@ -11,14 +11,18 @@
  
 #include <PECReaderConfigForward.hpp>
 #include <PhysicsObjects.hpp>
+#include <BTagger.hpp>
 #include <Dataset.hpp>
 #include <EventID.hpp>
 #include <GenParticle.hpp>
+#include <HardProcessRecord.hpp>
+#include <Arena.hpp>
 #include <TriggerSelectionInterface.hpp>
 #include <EventSelectionInterface.hpp>
 #include <WeightBTagInterface.hpp>
 #include <WeightPileUpInterface.hpp>
 #include <SystDefinition.hpp>
+#include <SyncTreeReader.hpp>
 
 #include <TFile.h>
 #include <TTree.h>
@@ -26,9 +30,11 @@
 #include <TVector2.h>
 
 #include <vector>
+#include <array>
 #include <list>
 #include <string>
 #include <memory>
+#include <functional>
 
 
 /**
@@ -56,10 +62,36 @@
  * Quality criteria to identify physics objects are hard-coded in the class and are not expected to
  * be accessed by the user; instead, they are fixed to CMS-wide recommendations.
  * 
+ * An instance of the class can be rebound to a different dataset with the help of method
+ * SetDataset. In this case the input buffers, capacities of the collections of physics objects, and
+ * the configuration are kept, which makes processing of a large number of small datasets cheaper.
+ * 
+ * Additional event filters can be registered with method AddEventFilter. They are evaluated at
+ * early stages of event reading, before the event is fully built and its weights are calculated,
+ * and thus events that are rejected by them are cheap.
+ * 
  * The class is non-copyable. No move constructor is implemented.
  */
 class PECReader
 {
+public:
+    /**
+     * \brief Stages of event reading at which additional event filters are evaluated
+     * 
+     * At the EventID stage only the event ID is available. At the MET stage MET is available as
+     * well. At the Jets stage leptons and jets have also been built, and the event has passed the
+     * event selection, but its weights have not yet been calculated.
+     */
+    enum class EventFilterStage: unsigned
+    {
+        EventID,
+        MET,
+        Jets
+    };
+    
+    /// Type of an additional event filter. It returns false if the event should be rejected
+    typedef std::function<bool(PECReader const &)> EventFilter;
+
 public:
     /**
      * \brief Constructor from a dataset
@@ -86,18 +118,48 @@ public:
     PECReader &operator=(PECReader const &) = delete;
     
     /// Destructor
-    ~PECReader() = default;
+    ~PECReader();
 
 public:
     /// Configures this from a configuration object
     void Configure(PECReaderConfig const &config);
     
+    /**
+     * \brief Rebinds this to a new dataset
+     * 
+     * The currently opened file (if any) is closed. The configuration is not changed, and the
+     * next call to NextSourceFile opens the first file of the new dataset. Warnings about missing
+     * configuration modules are not repeated.
+     */
+    void SetDataset(Dataset const &dataset);
+    
     /// Sets the trigger selection
     void SetTriggerSelection(TriggerSelectionInterface *triggerSelection);
     
     /// Sets event selection
     void SetEventSelection(EventSelectionInterface const *eventSelection);
     
+    /**
+     * \brief Registers an additional event filter to be evaluated at the given stage
+     * 
+     * The filter may only access the information that is available at the given stage (see
+     * documentation for EventFilterStage). Filters are evaluated in the order of registration.
+     */
+    void AddEventFilter(EventFilterStage stage, EventFilter const &filter);
+    
+    /// Removes all the additional event filters
+    void ClearEventFilters() noexcept;
+    
+    /**
+     * \brief Sets b-tagger to precompute b-tagging decisions
+     * 
+     * If the b-tagger is set, decisions for all its working points are evaluated once for each
+     * jet when the jet is built and are cached in the jet (see BTagger::CacheTagBits). The event
+     * selection, b-tagging reweighting, and plugins that use a b-tagger with the same algorithm
+     * then only read the cached bits.
+     */
+    void SetBTagger(BTagger const *bTagger);
+    
     /**
      * \brief Sets b-tagging configuration
      * 
@@ -156,6 +218,13 @@ public:
     /// See documentation for SetSystematics(SystType, int)
     void SetSystematics(SystVariation const &syst);
     
+    /**
+     * \brief Requests to read source files through an uncompressed column cache
+     * 
+     * Consult documentation for PECReaderConfig::SetColumnCache for details.
+     */
+    void SetColumnCache(bool enable, std::string const &directory = "");
+    
     /**
      * \brief Opens a new file in the dataset
      * 
@@ -204,9 +273,10 @@ public:
      * \brief Returns reconstructed neutrino
      * 
      * The neutrino is reconstructed under the hypothesis that it originates from W-boson decay.
-     * The accompanying charged lepton is identified with the leading tight lepton. The code
-     * will crash if there are no tight leptons. Transverse component of neutrino momentum is
+     * The accompanying charged lepton is identified with the leading tight lepton. An exception
+     * is thrown if there are no tight leptons. Transverse component of neutrino momentum is
      * not affected by the reconstruction and is exactly the same as returned by GetMET method.
+     * The reconstruction is performed when the method is called for the first time in an event.
      * 
      * \note The method will turn obsolete in near future.
      */
@@ -239,19 +309,61 @@ public:
      */
     std::vector<WeightPair> const &GetSystWeight(SystTypeWeight type) const;
     
-    /// Returns generator-level particles involved in the hard interaction
+    /**
+     * \brief Returns generator-level particles involved in the hard interaction
+     * 
+     * The collection is built from the record returned by GetHardProcessRecord when the method is
+     * called for the first time in an event. The record should be preferred in new code as it is
+     * cheaper to access.
+     */
     std::vector<GenParticle> const &GetHardGenParticles() const;
     
-    /// Returns generator-level jets
+    /**
+     * \brief Returns a flat record of generator-level particles involved in the hard interaction
+     * 
+     * The particles are read from the source file when the method is called for the first time
+     * in an event. For real data the record is empty.
+     */
+    HardProcessRecord const &GetHardProcessRecord() const;
+    
+    /**
+     * \brief Returns generator-level jets
+     * 
+     * The jets are read from the source file when the method is called for the first time in an
+     * event.
+     */
     std::vector<GenJet> const &GetGenJets() const;
     
     /**
      * \brief Returns partons from parton shower
      * 
      * Note that usually PEC samples keep only heavy-flavour partons if any. The method throws an
-     * exception if called for real data.
+     * exception if called for real data. The partons are read from the source file when the
+     * method is called for the first time in an event.
      */
     std::vector<ShowerParton> const &GetShowerPartons() const;
+    
+    /// Returns the number of entries in the current source file (zero if no file is opened)
+    unsigned long GetNumEntriesSourceFile() const noexcept;
+    
+    /**
+     * \brief Returns the number of entries of the current source file that have been read
+     * 
+     * Entries rejected by the trigger selection or by event filters are included.
+     */
+    unsigned long GetNumEntriesReadSourceFile() const noexcept;
+    
+    /// Returns the number of bytes read from the current source file (zero if no file is opened)
+    long long GetBytesReadSourceFile() const noexcept;
+    
+    /**
+     * \brief Returns the number of times an entry has been read from a branch of the current
+     * source file
+     * 
+     * Reads served by the column cache are included. Allows to check that collections built on
+     * demand are read once per event.
+     */
+    unsigned long long GetNumBranchReadsSourceFile() const noexcept;
 
 private:
     /**
@@ -259,7 +371,8 @@ private:
      * 
      * Motivation for this method is the fact that an instance of PECReader might not be fully
      * configured at construction time as the user might change some of parameters afterwards.
-     * This method is run before the first file is opened.
+     * This method is run before the first file is opened. It is not repeated when this is rebound
+     * to a new dataset.
      */
     void Initialize();
     
@@ -293,28 +406,46 @@ private:
      */
     void CalculateEventWeights();
     
-    /// Stores particles from the hard interaction in hardParticles collection
-    void ParseHardInteraction();
+    /// Evaluates all the additional event filters registered for the given stage
+    bool PassEventFilters(EventFilterStage stage) const;
+    
+    /// Reconstructs the neutrino (see documentation for GetNeutrino)
+    void BuildNeutrino() const;
+    
+    /**
+     * \brief Reads branches describing the hard interaction and stores the particles in
+     * hardProcess record
+     */
+    void ParseHardInteraction() const;
     
-    /// Stores generator-level jets in the dedicated vector
-    void BuildGenJets();
+    /// Builds hardParticles collection from hardProcess record
+    void BuildHardGenParticles() const;
+    
+    /// Reads generator-level jets and stores them in the dedicated vector
+    void BuildGenJets() const;
     
     /// Reads information on parton shower and stores the partons in the dedicated vector
-    void ReadPartonShower();
+    void ReadPartonShower() const;
 
 private:
     /// A copy of dataset to be processed
-    Dataset const dataset;
+    Dataset dataset;
     
     /// Specifies whether the object is fully configured
     bool isInitialized;
     
+    /// Indicates whether warnings specific to simulation have been printed
+    bool mcWarningsIssued;
+    
     /// Pointer to an object to perform trigger selection
     TriggerSelectionInterface *triggerSelection;
     
     /// Pointer to an object to perform event selection
     EventSelectionInterface const *eventSelection;
     
+    /// Pointer to a b-tagger to precompute b-tagging decisions (might be null)
+    BTagger const *bTagger;
+    
     /// An object to reweight event for b-tagging scale factors
     WeightBTagInterface *bTagReweighter;
     
@@ -334,6 +465,15 @@ private:
     /// Systematical variation
     SystVariation syst;
     
+    /// Additional event filters for each stage
+    std::array<std::vector<EventFilter>, 3> eventFilters;
+    
+    /// Indicates whether column cache should be used
+    bool useColumnCache;
+    
+    /// Directory for column cache files (empty or ending with a slash)
+    std::string columnCacheDirectory;
+    
     
     /// Central event weight (as opposed to systematical variations)
     double weightCentral;
@@ -355,12 +495,32 @@ private:
     std::list<Dataset::File>::const_iterator sourceFileIt;
     
     
+    /// Groups of trees that are read together
+    enum class TreeGroup: unsigned
+    {
+        EventID,
+        Trigger,
+        General,
+        HardInteraction,
+        GenJets,
+        PartonShower
+    };
+    
+    /// Total size of TTreeCache, in bytes, shared among the trees in a source file
+    static long long const treeCacheSize = 16 * 1024 * 1024;
+    
     TFile *sourceFile;   ///< The current source file
-    TTree *eventIDTree;  ///< The tree with the event ID information
-    TTree *triggerTree;  ///< The tree with the trigger information
-    TTree *generalTree;  ///< The tree with all the information but triggers and event ID
-    unsigned long nEventsTree;  ///< The total number of events in the trees
-    unsigned long curEventTree;  ///< The index of the current event in the trees
+    
+    /**
+     * \brief An object to read all the trees in the source file with a single cursor
+     * 
+     * It is mutable because the generator-level information is read on demand.
+     */
+    mutable SyncTreeReader treeReader;
+    
+    /// Index of the entry in the source trees that corresponds to the current event
+    unsigned long curEventEntry;
+    
     EventID eventID;  ///< An aggregate to store the event ID
     
     /// Maximal length to allocate buffers to read trees
@@ -422,35 +582,37 @@ private:
     
     Short_t processID;  // needed to split the inclusive W+jets
     
-    // Buffers to read the hard interaction
-    UChar_t hardPartSize;
-    Char_t hardPartPdgId[maxSize];
-    Char_t hardPartFirstMother[maxSize], hardPartLastMother[maxSize];
-    Float_t hardPartPt[maxSize];
-    Float_t hardPartEta[maxSize];
-    Float_t hardPartPhi[maxSize];
-    Float_t hardPartMass[maxSize];
+    // Buffers to read the hard interaction. They are filled on demand and thus are mutable
+    mutable UChar_t hardPartSize;
+    mutable Char_t hardPartPdgId[maxSize];
+    mutable Char_t hardPartFirstMother[maxSize], hardPartLastMother[maxSize];
+    mutable Float_t hardPartPt[maxSize];
+    mutable Float_t hardPartEta[maxSize];
+    mutable Float_t hardPartPhi[maxSize];
+    mutable Float_t hardPartMass[maxSize];
     
     
-    // Buffers to read generator jets
-    UChar_t genJetSize;
-    Float_t genJetPt[maxSize], genJetEta[maxSize], genJetPhi[maxSize], genJetMass[maxSize];
+    // Buffers to read generator jets (filled on demand)
+    mutable UChar_t genJetSize;
+    mutable Float_t genJetPt[maxSize], genJetEta[maxSize], genJetPhi[maxSize],
+     genJetMass[maxSize];
     //UChar_t genJetBMult[maxSize], genJetCMult[maxSize];
     
     
-    // Buffers for information on parton shower. Consult documentation for [1] for details
+    // Buffers for information on parton shower, filled on demand. Consult documentation for [1]
+    //for details
     //[1] https://github.com/andrey-popov/single-top/blob/master/plugins/PartonShowerOutcome.h
     // Number of partons stored
-    UChar_t psSize;
+    mutable UChar_t psSize;
     
     // PDG ID of partons
-    Short_t psPdgId[maxSize];
+    mutable Short_t psPdgId[maxSize];
     
     // Origin of partons
-    UChar_t psOrigin[maxSize];
+    mutable UChar_t psOrigin[maxSize];
     
     /// Three-momentum of partons
-    Float_t psPt[maxSize], psEta[maxSize], psPhi[maxSize];
+    mutable Float_t psPt[maxSize], psEta[maxSize], psPhi[maxSize];
     
     
     // Pile-up truth information
@@ -487,19 +649,54 @@ private:
     /// MET of the current event
     Candidate correctedMET;
     
-    /// The reconstructed neutrino
-    Candidate neutrino;
+    /// Index of MET used in the current event
+    unsigned curMetIndex;
     
-    /// The generator particles from the hard interaction
-    std::vector<GenParticle> hardParticles;
+    /// The reconstructed neutrino (built on demand)
+    mutable Candidate neutrino;
     
-    /// The generator-level jets
-    std::vector<GenJet> genJets;
+    /// Indicates whether the neutrino has been reconstructed in the current event
+    mutable bool neutrinoBuilt;
+    
+    /// The generator particles from the hard interaction (built on demand)
+    mutable HardProcessRecord hardProcess;
+    
+    /// Indicates whether hardProcess record corresponds to the current event
+    mutable bool hardProcessBuilt;
+    
+    /**
+     * \brief Memory for per-event objects of variable size
+     * 
+     * Currently it stores links between generator particles. The arena is reset for each event,
+     * and after the first few events no heap allocations are needed. Each instance of PECReader
+     * (and thus each Processor) has its own arena.
+     */
+    mutable Arena eventArena;
+    
+    /**
+     * \brief The generator particles from the hard interaction linked with pointers
+     * 
+     * The collection is built on demand from hardProcess record.
+     */
+    mutable std::vector<GenParticle> hardParticles;
+    
+    /// Indicates whether hardParticles collection corresponds to the current event
+    mutable bool hardParticlesBuilt;
+    
+    /// The generator-level jets (built on demand)
+    mutable std::vector<GenJet> genJets;
+    
+    /// Indicates whether genJets collection corresponds to the current event
+    mutable bool genJetsBuilt;
     
     /**
      * \brief Partons from parton shower
      * 
-     * They are read if only readPartonShower flag is set to true.
+     * They can be read if only readPartonShower flag is set to true. The collection is built on
+     * demand.
      */
-    std::vector<ShowerParton> psPartons;
+    mutable std::vector<ShowerParton> psPartons;
+    
+    /// Indicates whether psPartons collection corresponds to the current event
+    mutable bool psPartonsBuilt;
 };
@@ -87,7 +87,8 @@ class PECReaderConfig
         /**
          * \brief Provides b-tagging object
          * 
-         * The object is copied.
+         * The object is copied. PECReader uses it to cache b-tagging decisions in jets (consult
+         * documentation for PECReader::SetBTagger).
          */
         void SetBTagger(BTagger const *bTagger);
         
@@ -151,6 +152,15 @@ class PECReaderConfig
         /// Specifies desired systematical variation
         void SetSystematics(SystVariation const &syst);
         
+        /**
+         * \brief Requests to read source files through an uncompressed column cache
+         * 
+         * The cache files are created when a source file is read for the first time and reused
+         * afterwards (see class ColumnCache). They are placed in the given directory or, if it is
+         * empty, next to the source files. The cache is only used for local source files.
+         */
+        void SetColumnCache(bool enable, std::string const &directory = "");
+        
         
         /// Checks if a valid trigger selection is set
         bool IsSetTriggerSelection() const;
@@ -202,6 +212,12 @@ class PECReaderConfig
         
         /// Consult documentation for SetSystematics for details
         SystVariation const &GetSystematics() const;
+        
+        /// Consult documentation for SetColumnCache for details
+        bool GetColumnCache() const noexcept;
+        
+        /// Consult documentation for SetColumnCache for details
+        std::string const &GetColumnCacheDirectory() const noexcept;
     
     
     private:
@@ -251,4 +267,10 @@ class PECReaderConfig
         
         /// Requested systematical variation
         SystVariation syst;
+        
+        /// Specifies whether column cache should be used
+        bool useColumnCache;
+        
+        /// Directory to store column cache files (empty to place them next to source files)
+        std::string columnCacheDirectory;
 };
@@ -55,14 +55,15 @@ class PECReaderPlugin: public Plugin
         /**
          * \brief Called before processing of a new dataset is started
          * 
-         * Consult documentation of the base class.
+         * Consult documentation of the base class. An instance of PECReader is created when the
+         * method is called for the first time and is rebound to new datasets afterwards.
          */
         void BeginRun(Dataset const &dataset);
         
         /**
          * \brief Called after processing of a dataset is finished
          * 
-         * Consult documentation of the base class.
+         * Consult documentation of the base class. The instance of PECReader is not deleted.
          */
         void EndRun();
         
@@ -83,6 +84,14 @@ class PECReaderPlugin: public Plugin
         
         /// Returns a pointer to the underlying PECReader object
         PECReader const *operator->() const;
+        
+        /**
+         * \brief Returns a non-constant reference to the underlying PECReader object
+         * 
+         * It is used by Processor to register early event filters. If no valid object is
+         * associated to the plugin, an exception is thrown.
+         */
+        PECReader &GetReader();
     
     private:
         /// A pointer to a current instance of class PECReader
@@ -123,6 +123,22 @@ public:
     Jet(TLorentzVector const &p4) noexcept;
 
 public:
+    /**
+     * \brief Sets the 4-momentum
+     * 
+     * Hides the method of the base class in order to invalidate the cached b-tagging decisions
+     * (see SetBTagBits), which depend on the pseudorapidity. The same applies to the other two
+     * setters below. Since the methods of class Candidate are not virtual, the decisions are kept
+     * if the 4-momentum is changed via a reference to the base class.
+     */
+    void SetP4(TLorentzVector const &p4) noexcept;
+    
+    /// Sets the 4-momentum (see SetP4)
+    void SetPtEtaPhiM(double pt, double eta, double phi, double mass) noexcept;
+    
+    /// Sets the 4-momentum (see SetP4)
+    void SetPxPyPzE(double px, double py, double pz, double E) noexcept;
+    
     /// Sets the values of the b-tagging discriminators
     void SetBTags(double CSV, double JP, double TCHP) noexcept;
     
@@ -144,6 +160,16 @@ public:
     /// Sets jet pull angle
     void SetPullAngle(double pullAngle) noexcept;
     
+    /**
+     * \brief Stores b-tagging decisions for all working points of a b-tagger
+     * 
+     * The bit with index int(BTagger::WorkingPoint) is set if the jet is tagged at that working
+     * point. The code identifies the b-tagger configuration that has produced the decisions; the
+     * decisions are used by BTagger::IsTagged only if the code matches its own one. Normally, the
+     * method is called by PECReader when the jet is built.
+     */
+    void SetBTagBits(unsigned bits, int code) noexcept;
+    
     /// Gets the value of the CSV b-tagging discriminator
     double CSV() const noexcept;
     
@@ -153,6 +179,14 @@ public:
     /// Gets the value of the TCHP b-tagging discriminator
     double TCHP() const noexcept;
     
+    /**
+     * \brief Gets the value of a b-tagging discriminator by its index
+     * 
+     * Indices 0, 1, 2 correspond to CSV, JP, and TCHP discriminators respectively. The index is not
+     * checked. The method allows to choose the discriminator without branching.
+     */
+    double GetBTagDiscriminator(unsigned index) const noexcept;
+    
     /// Gets the parent's PDG ID
     int GetParentID() const noexcept;
     
@@ -161,14 +195,22 @@ public:
     
     /// Gets the pull angle
     double GetPullAngle() const noexcept;
+    
+    /// Returns cached b-tagging decisions (consult documentation for SetBTagBits)
+    unsigned GetBTagBits() const noexcept;
+    
+    /// Returns code of the b-tagger that produced the cached decisions (-1 if none)
+    int GetBTagBitsCode() const noexcept;
 
 private:
-    double CSVValue;   ///< CSV b-tagging discriminator
-    double JPValue;    ///< JP b-tagging discriminator
-    double TCHPValue;  ///< TCHP b-tagging discriminator
+    /// Values of b-tagging discriminators CSV, JP, and TCHP (in this order)
+    double bTagValues[3];
+    
     int parentPDGID;  ///< PDG ID of the parent
     double charge;  ///< Electric charge
     double pullAngle;  ///< "Pull angle" (characterises the colour flow)
+    unsigned bTagBits;  ///< Cached b-tagging decisions
+    int bTagBitsCode;  ///< Code of the b-tagger that produced the cached decisions
 };
 
 
@@ -10,6 +10,7 @@
 #include <PluginForward.hpp>
 
 #include <ProcessorForward.hpp>
+#include <PECReaderForward.hpp>
 #include <Dataset.hpp>
 
 #include <string>
@@ -34,9 +35,15 @@
  * members specific for a dataset or an event (e.g. handlers of output files). Such a functionality
  * is requered to multiplicate the plugin structure for each thread represented by class Processor.
  * 
- * A derived class must be capable of working in a multi-thread mode. The user should pay attention
- * to the fact that ROOT is not thread-safe. For this reason all the critical blocks (which include,
- * for example, creation of any ROOT objects) must be guarded with the help of class ROOTLock.
+ * A derived class must be capable of working in a multi-thread mode. ROOT is run in its thread-
+ * safety mode, so that ROOT objects owned by a single instance of the plugin can be used without
+ * additional synchronization. However, operations with ROOT objects shared among threads must be
+ * guarded with the help of class ROOTLock (consult its documentation for details).
+ * 
+ * A plugin that writes an output file for each dataset should create it under the name returned
+ * by GetTempFileName and call CommitOutputFile once the file has been closed. Then an interrupted
+ * job never leaves a truncated file under the final name, which is what allows to resume it (see
+ * RunManager::SetJournal).
  * 
  * A derived class must define a valid move constructor.
  */
@@ -105,6 +112,56 @@ class Plugin
          * true unless it suggests the event to be discarded.
          */
         virtual bool ProcessEvent() = 0;
+        
+        /**
+         * \brief Registers event filters to be evaluated by PECReader at early stages
+         * 
+         * A plugin whose ProcessEvent only decides whether the event should be kept, using the
+         * information available at one of the stages defined in PECReader::EventFilterStage, can
+         * reproduce this decision with filters registered in the reader. Then the rejected events
+         * are not built in full, and their weights are not calculated. The method must return true
+         * if the registered filters reject exactly the events for which ProcessEvent would return
+         * false, and the plugin does not need to see the rejected events otherwise.
+         * 
+         * The method is called by Processor after BeginRun for the plugins that follow the reader
+         * in the path, in order, until the first plugin that returns false. It is not called when
+         * a cut-flow is counted (in particular, by RunManager::ProcessDistributed) since events
+         * rejected by the filters would not be attributed to the plugins correctly. The default
+         * implementation does not register any filters and returns false.
+         */
+        virtual bool RegisterEarlyFilters(PECReader &reader) const;
+        
+        /**
+         * \brief Called once all the datasets in a call to RunManager::Process are processed
+         * 
+         * The method is called after all the threads have finished, for the plugins of the first
+         * processor only, which are the instances registered by the user. A plugin whose clones
+         * share results can write them here. All the threads are idle at this point, so no
+         * synchronization with the clones is needed. The method is not called in the distributed
+         * mode. The default implementation is trivial.
+         */
+        virtual void EndPass();
+        
+        /**
+         * \brief Tells whether the plugin can be used with RunManager::ProcessDistributed
+         * 
+         * In the distributed mode each worker process holds its own copy of the path, and only
+         * outputs written per dataset are preserved. A plugin that relies on EndPass to write its
+         * output must return false. The default implementation returns true.
+         */
+        virtual bool SupportsDistributedMode() const;
+    
+    protected:
+        /// Returns the name of a temporary file to write an output file with the given name
+        static std::string GetTempFileName(std::string const &fileName);
+        
+        /**
+         * \brief Renames the temporary file into the given output file
+         * 
+         * Rename is atomic within a file system, so the output file is either absent or complete.
+         * Throws an exception if the file cannot be renamed.
+         */
+        static void CommitOutputFile(std::string const &fileName);
     
     protected:
         /// Unique name to identify the plugin
@@ -11,6 +11,8 @@
 #include <PECReaderConfig.hpp>
 #include <PECReaderPlugin.hpp>
 #include <RunManagerForward.hpp>
+#include <ContentionProfiler.hpp>
+#include <ProgressMonitor.hpp>
 #include <Dataset.hpp>
 
 #include <vector>
@@ -31,7 +33,9 @@
  * beginning of the path. Its configuration is moved from the parent instance of class RunManager.
  * 
  * One instance of class Processor is expected to be run in a single (separate) thread. The class
- * is friend to class RunManager and pops up datasets from a queue RunManager::datasets.
+ * is friend to class RunManager and pops up datasets from the queues RunManager::datasetQueues.
+ * The queue with the given index (normally, the one of the NUMA node the thread runs on) is tried
+ * first; when it is exhausted, datasets are taken from the other queues.
  */
 class Processor
 {
@@ -54,7 +58,8 @@ class Processor
          * 
          * Configuration of plugins is copied only but not their states. Copying of an instance of
          * class Processor after it started processing a dataset is not foreseen and is not a well-
-         * defined operation.
+         * defined operation. The pointers to the thread statistics, the progress slot, and the
+         * cut-flow counters are not copied, nor is the placement of the thread.
          */
         Processor(Processor const &src);
         
@@ -75,6 +80,45 @@ class Processor
          */
         void RegisterPlugin(Plugin *plugin);
         
+        /**
+         * \brief Requests to record activity of the thread in the given object
+         * 
+         * The object is not owned by this and must outlive the processing. A null pointer disables
+         * the recording, which is the default.
+         */
+        void SetThreadStats(ContentionProfiler::ThreadStats *threadStats) noexcept;
+        
+        /**
+         * \brief Sets the CPU to run on and the index of the preferred queue of datasets
+         * 
+         * If the CPU index is not negative, the thread pins itself to the CPU before it processes
+         * the first dataset. Since all the buffers of PECReader are allocated when the first
+         * dataset is opened, they are then placed in the memory local to the CPU. By default the
+         * thread is not pinned, and the first queue is preferred.
+         */
+        void SetPlacement(int cpu, unsigned homeQueue) noexcept;
+        
+        /**
+         * \brief Requests to report progress in the given slot of a progress monitor
+         * 
+         * The slot is not owned by this and must outlive the processing. A null pointer disables
+         * the reporting, which is the default.
+         */
+        void SetProgressSlot(ProgressMonitor::ThreadSlot *progressSlot) noexcept;
+        
+        /**
+         * \brief Requests to count events accepted by each plugin in the given vector
+         * 
+         * Element i of the vector is incremented for each event accepted by the plugin with index
+         * i in the path (the reader has index 0) and all the preceding plugins. The vector is
+         * extended to the length of the path if needed. It is not owned by this and must outlive
+         * the processing. A null pointer disables the counting, which is the default. While the
+         * cut-flow is counted, plugins are not asked to register early filters in the reader (see
+         * Plugin::RegisterEarlyFilters), so that every event is rejected by the plugin that
+         * actually rejects it.
+         */
+        void SetCutFlow(std::vector<unsigned long> *cutFlow) noexcept;
+        
         /// Entry point for execution
         void operator()();
         
@@ -87,6 +131,19 @@ class Processor
          */
         void ProcessDataset(Dataset const &dataset);
         
+        /// Returns names of all the plugins in the path, in order, starting from the reader
+        std::vector<std::string> GetPluginNames() const;
+        
+        /// Calls method EndPass of all the plugins in the path, in order
+        void EndPass();
+        
+        /**
+         * \brief Checks that all the plugins in the path support the distributed mode
+         * 
+         * Throws an exception naming the first plugin that does not support it.
+         */
+        void CheckDistributedMode() const;
+        
         /**
          * \brief Returns a pointer to plugin with given name
          * 
@@ -132,6 +189,13 @@ class Processor
     private:
         /// Retuns index in the path of a plugin with given name. Throws an exception if not found
         unsigned GetPluginIndex(std::string const &name) const;
+        
+        /**
+         * \brief Pops a dataset from the queues in the parent RunManager
+         * 
+         * The home queue is tried first. Returns a null pointer if all the queues are empty.
+         */
+        std::unique_ptr<Dataset> PopDataset();
     
     private:
         /**
@@ -151,4 +215,19 @@ class Processor
         
         /// Mapping from plugin names to their indices in vector path
         std::unordered_map<std::string, unsigned> nameMap;
+        
+        /// Object to record activity of the thread (might be null)
+        ContentionProfiler::ThreadStats *threadStats;
+        
+        /// CPU to pin the thread to (negative if the thread should not be pinned)
+        int cpu;
+        
+        /// Index of the preferred queue of datasets in the parent RunManager
+        unsigned homeQueue;
+        
+        /// Slot to report progress of the processing (might be null)
+        ProgressMonitor::ThreadSlot *progressSlot;
+        
+        /// Counters of events accepted by each plugin in the path (might be null)
+        std::vector<unsigned long> *cutFlow;
 };
\ No newline at end of file
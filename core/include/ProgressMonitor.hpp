@@ -0,0 +1,214 @@
+/**
+ * \file ProgressMonitor.hpp
+ * \author Andrey Popov
+ * 
+ * The module defines a facility to report progress of a long processing job.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <string>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+
+/**
+ * \class ProgressMonitor
+ * \brief Aggregates progress of processing threads and reports it periodically
+ * 
+ * Each processing thread is given a slot (see class ThreadSlot), in which it stores its counters
+ * with relaxed atomic operations. The slots are padded so that they do not share cache lines, and
+ * no locks are taken by the processing threads. A separate reporter thread reads the slots
+ * periodically and prints a summary with the logger: numbers of processed files, rates of read
+ * and accepted events, the rate of reading from the input files in MB/s, utilisation of the
+ * processing threads over the last reporting interval, and an estimate of the remaining time.
+ * 
+ * The total number of events is not known in advance, as only the numbers of events in the
+ * parent datasets are stored in class Dataset. It is estimated from the files that have already
+ * been opened, assuming that the remaining files contain the same number of events on average.
+ * Read events include the ones rejected by the trigger selection and event filters in PECReader;
+ * accepted events are the ones that pass all the plugins in the path. Early filters registered by
+ * plugins in the reader (see Plugin::RegisterEarlyFilters) only reject events that the plugins
+ * would reject, so they do not change the number of accepted events.
+ * 
+ * Optionally, the same information is written into a status file after each report, which is
+ * meant to be polled by monitoring of batch jobs. The file contains a single JSON object. It is
+ * written to a temporary file first and then renamed, so that the reader never sees a partially
+ * written file.
+ */
+class ProgressMonitor
+{
+public:
+    /**
+     * \class ThreadSlot
+     * \brief Counters of a single processing thread
+     * 
+     * Methods that update the counters must only be called from the owning thread.
+     */
+    class ThreadSlot
+    {
+        friend class ProgressMonitor;
+    
+    public:
+        /// Constructor with no parameters; sets all counters to zero
+        ThreadSlot() noexcept;
+    
+    public:
+        /// Notifies that a new file with the given number of entries has been opened
+        void BeginFile(unsigned long nEntries) noexcept;
+        
+        /**
+         * \brief Notifies that an event has been processed
+         * 
+         * The arguments are the number of entries read from the current file so far, the number
+         * of bytes read from it, and the decision of the plugins.
+         */
+        void Update(unsigned long nEntriesRead, long long nBytesRead, bool accepted) noexcept;
+        
+        /**
+         * \brief Notifies that the current file has been processed
+         * 
+         * The number of bytes read from the file is taken from the last call to Update since the
+         * file might have already been closed.
+         */
+        void EndFile() noexcept;
+    
+    private:
+        /// Numbers of opened and finished files
+        std::atomic<unsigned long> nFilesOpened, nFilesDone;
+        
+        /// Total number of entries in the opened files and the number of read entries
+        std::atomic<unsigned long> nEntriesKnown, nEntriesRead;
+        
+        /// Number of accepted events
+        std::atomic<unsigned long> nAccepted;
+        
+        /// Number of bytes read from the input files
+        std::atomic<long long> nBytesRead;
+        
+        /**
+         * \brief Time spent processing the finished files and the start time of the current one
+         * 
+         * In nanoseconds; the latter is the time since the epoch of the steady clock, or zero if
+         * no file is being processed.
+         */
+        std::atomic<long long> busyTime, fileStart;
+        
+        /// Numbers of entries and bytes read from the finished files (used by the owner only)
+        unsigned long entriesBase;
+        long long bytesBase;
+        
+        /// Number of entries in the current file (used by the owner only)
+        unsigned long curFileEntries;
+        
+        /// Padding to prevent sharing of cache lines with the adjacent slots
+        char padding[64];
+    };
+
+private:
+    /// State of all the counters at a moment of time
+    struct Snapshot
+    {
+        double time;
+        unsigned long nFilesOpened, nFilesDone;
+        unsigned long nEntriesKnown, nEntriesRead, nAccepted;
+        long long nBytesRead;
+        std::vector<double> busyTime;
+    };
+
+public:
+    /// Constructor from the number of processing threads and the total number of files
+    ProgressMonitor(unsigned nThreads, unsigned long nFiles);
+    
+    /// Copy constructor is deleted
+    ProgressMonitor(ProgressMonitor const &) = delete;
+    
+    /// Assignment operator is deleted
+    ProgressMonitor &operator=(ProgressMonitor const &) = delete;
+    
+    /// Destructor; stops the reporter thread if it is running
+    ~ProgressMonitor();
+
+public:
+    /// Returns the slot for the processing thread with the given index
+    ThreadSlot &GetSlot(unsigned thread);
+    
+    /**
+     * \brief Starts the reporter thread
+     * 
+     * The interval between reports is given in seconds. If the name of the status file is empty,
+     * the file is not written.
+     */
+    void Start(double interval, std::string const &statusFileName = "");
+    
+    /// Stops the reporter thread and produces the final report
+    void Stop();
+
+private:
+    /// Main loop of the reporter thread
+    void RunReporter();
+    
+    /// Reads all the slots
+    Snapshot TakeSnapshot() const;
+    
+    /// Prints the report and writes the status file
+    void Report(Snapshot const &current, Snapshot const &previous, bool finished) const;
+    
+    /// Converts time in seconds into a human-readable string
+    static std::string FormatTime(double seconds);
+
+private:
+    /// Number of processing threads
+    unsigned nThreads;
+    
+    /// Total number of files to process
+    unsigned long nFiles;
+    
+    /// Slots of the processing threads
+    std::unique_ptr<ThreadSlot[]> slots;
+    
+    /// Start time of the processing
+    std::chrono::steady_clock::time_point startTime;
+    
+    /// Interval between reports, in seconds
+    double interval;
+    
+    /// Name of the status file
+    std::string statusFileName;
+    
+    /// Reporter thread
+    std::thread reporter;
+    
+    /// Mutex and condition variable to wake up the reporter thread when it must stop
+    std::mutex stopMutex;
+    std::condition_variable stopCondition;
+    
+    /// Indicates that the reporter thread must stop
+    bool stopRequested;
+};
+
+
+inline void ProgressMonitor::ThreadSlot::BeginFile(unsigned long nEntries) noexcept
+{
+    curFileEntries = nEntries;
+    fileStart.store(std::chrono::duration_cast<std::chrono::nanoseconds>(
+     std::chrono::steady_clock::now().time_since_epoch()).count(), std::memory_order_relaxed);
+    nEntriesKnown.fetch_add(nEntries, std::memory_order_relaxed);
+    nFilesOpened.fetch_add(1, std::memory_order_relaxed);
+}
+
+
+inline void ProgressMonitor::ThreadSlot::Update(unsigned long nEntriesRead_, long long nBytesRead_,
+ bool accepted) noexcept
+{
+    nEntriesRead.store(entriesBase + nEntriesRead_, std::memory_order_relaxed);
+    nBytesRead.store(bytesBase + nBytesRead_, std::memory_order_relaxed);
+    
+    if (accepted)
+        nAccepted.fetch_add(1, std::memory_order_relaxed);
+}
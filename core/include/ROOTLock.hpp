@@ -14,10 +14,14 @@
  * \class ROOTLock
  * \brief Provides a lock to protect thread-unsafe ROOT routines
  * 
- * The class is a simple wrapper around a static mutex. Since ROOT is not thread-safe, this lock
- * must be used to mark all the crical blocks of code that call ROOT routines. In particular,
- * creation of any ROOT objects must be guarded with the help of this class. The user should also
- * keep in mind that threads share the current ROOT directory object (gDirectory).
+ * The class is a simple wrapper around a static mutex. Before ROOT objects are used from several
+ * threads, the thread-safety mode of ROOT must be activated with method EnableThreadSafety (this
+ * is done by RunManager). In this mode ROOT protects its global lists internally, and the current
+ * directory (gDirectory) is specific to each thread. Consequently, ROOT objects owned by a single
+ * thread, such as an input file opened by PECReader together with its trees, can be created,
+ * read, and deleted without the lock. The lock must still be used to guard ROOT objects that are
+ * shared among threads, for instance a file with calibration histograms accessed by copies of a
+ * module that live in different threads.
  */
 class ROOTLock
 {
@@ -26,6 +30,15 @@ class ROOTLock
         ROOTLock() = delete;
     
     public:
+        /**
+         * \brief Activates the thread-safety mode of ROOT
+         * 
+         * Calls ROOT::EnableThreadSafety with ROOT 6 or TThread::Initialize with ROOT 5. The
+         * method is cheap to call repeatedly as the initialization is performed only once. It
+         * should be called before any additional threads are started.
+         */
+        static void EnableThreadSafety();
+        
         /// Locks
         static void Lock();
         
@@ -38,4 +51,7 @@ class ROOTLock
     private:
         /// Static mutex
         static std::mutex globalROOTMutex;
+        
+        /// Flag to activate the thread-safety mode only once
+        static std::once_flag threadSafetyFlag;
 };
\ No newline at end of file
@@ -0,0 +1,102 @@
+/**
+ * \file RunJournal.hpp
+ * \author Andrey Popov
+ * 
+ * The module defines a journal of processed input files that allows to resume an interrupted job.
+ */
+
+#pragma once
+
+#include <string>
+#include <unordered_set>
+#include <mutex>
+
+
+/**
+ * \class RunJournal
+ * \brief Records input files that have been processed completely
+ * 
+ * The journal is a plain text file with one record per line. A record consists of the index of
+ * the pass and the name of an input file separated with a space. A line is appended and flushed to
+ * the disk (with fsync) as soon as processing of the file has finished, i.e. after all the plugins
+ * have executed their EndRun methods. Thus, if the job is killed, the journal lists exactly the
+ * files whose outputs have been committed, while the outputs of the files being processed at that
+ * moment are left under temporary names (see Plugin::CommitOutputFile).
+ * 
+ * Passes are needed because RunManager can process the same files several times (e.g. with
+ * different plugins registered in between). A file is only reported as completed for the pass in
+ * which it has been processed, so that a resumed job skips the files of the interrupted pass but
+ * still processes them in the subsequent ones.
+ * 
+ * In the resume mode the existing journal is read, and the listed files are reported as completed
+ * so that they can be skipped. New entries are then appended to the same file. An incomplete last
+ * line, which might be left if the job was killed while writing it, is ignored, as well as a line
+ * that does not start with the index of a pass. Otherwise the journal is truncated when opened.
+ * 
+ * The methods are thread-safe.
+ */
+class RunJournal
+{
+public:
+    /**
+     * \brief Constructor
+     * 
+     * Opens the journal with the given name, reading it first if resume is true. Throws an
+     * exception if the file cannot be opened.
+     */
+    RunJournal(std::string const &fileName, bool resume);
+    
+    /// Copy constructor is deleted
+    RunJournal(RunJournal const &) = delete;
+    
+    /// Assignment operator is deleted
+    RunJournal &operator=(RunJournal const &) = delete;
+    
+    /// Destructor; closes the file
+    ~RunJournal();
+
+public:
+    /// Checks if the given input file has been processed completely in the given pass
+    bool IsCompleted(unsigned long pass, std::string const &sourceFileName) const;
+    
+    /**
+     * \brief Records that the given input file has been processed completely in the given pass
+     * 
+     * Throws an exception if the record cannot be written.
+     */
+    void MarkCompleted(unsigned long pass, std::string const &sourceFileName);
+    
+    /**
+     * \brief Returns the number of completed files
+     * 
+     * Files completed in different passes are counted separately. The records read from the
+     * existing journal are included.
+     */
+    unsigned long GetNumCompleted() const;
+    
+    /// Returns the name of the journal file
+    std::string const &GetFileName() const noexcept;
+
+private:
+    /// Builds a record for the given pass and input file, without the new-line character
+    static std::string MakeRecord(unsigned long pass, std::string const &sourceFileName);
+    
+    /// Reads the existing journal and returns true if it ends with a complete line
+    bool ReadJournal();
+    
+    /// Appends the given string to the file and flushes it to the disk
+    void Write(std::string const &text);
+
+private:
+    /// Name of the journal file
+    std::string fileName;
+    
+    /// File descriptor of the journal file
+    int fd;
+    
+    /// Records of completed input files (as built by MakeRecord)
+    std::unordered_set<std::string> completed;
+    
+    /// Mutex to protect the set of completed files and writing to the file
+    mutable std::mutex mutex;
+};
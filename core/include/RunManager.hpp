@@ -9,11 +9,16 @@
 
 #include <Dataset.hpp>
 #include <Plugin.hpp>
-#include <ProcessorForward.hpp>
+#include <Processor.hpp>
 #include <PECReaderConfig.hpp>
+#include <RunJournal.hpp>
 
+#include <string>
 #include <queue>
+#include <vector>
 #include <mutex>
+#include <condition_variable>
+#include <thread>
 #include <memory>
 
 
@@ -25,6 +30,21 @@
  * defined plugins and manages a thread pool that processes the datasets. It only forwards
  * parameters, and the actual processing is delegated to instances of dedicated class Processor.
  * 
+ * The pool is persistent. It is created by the first call to Process, and the threads wait for
+ * new work once all the datasets have been processed. Method Process can be called again after
+ * new datasets have been added with AddDatasets; the processors then reuse their plugins and the
+ * buffers of their readers. If more threads are requested than in the previous calls, the pool is
+ * extended with copies of the first processor; if fewer, the extra threads stay idle. The pool is
+ * shut down in the destructor.
+ * 
+ * Optionally, the threads can be pinned to CPUs, taking into account the NUMA layout of the
+ * machine (see class NumaTopology), and the datasets can be split into separate queues, one per
+ * NUMA node.
+ * 
+ * Alternatively, the datasets can be processed by separate worker processes, which is done by
+ * ProcessDistributed. The worker processes may run on the same machine or on other nodes (see
+ * RunWorkerProcess).
+ * 
  * Some of data members are accessed directly by the friend class Processor.
  */
 class RunManager
@@ -39,16 +59,28 @@ class RunManager
         
         /// Assignment operator is deleted
         RunManager &operator=(RunManager const &) = delete;
+        
+        /// Destructor; shuts down the thread pool
+        ~RunManager();
     
     public:
+        /**
+         * \brief Adds datasets to be processed by the next call to Process
+         * 
+         * The datasets are split into atomic ones, as in the constructor. The method must not be
+         * called while Process is being executed.
+         */
+        template<typename InputIt>
+        void AddDatasets(InputIt const &datasetsBegin, InputIt const &datasetsEnd);
+        
         /// Processes datasets with a pool of nThreads threads
         void Process(int nThreads);
         
         /**
          * \brief Processes datasets with a pool of threads
          * 
-         * Number of threads is determined by multiplying total supported number of concurrent
-         * threads by the given fraction.
+         * Number of threads is determined by multiplying the number of CPUs available to the
+         * process (which respects its affinity mask) by the given fraction.
          */
         void Process(double loadFraction);
         
@@ -56,7 +88,8 @@ class RunManager
          * \brief Returns a reference to local configuration object for PECReader
          * 
          * Method enables the user to adjust configuration that is forwarded to instances of class
-         * PECReader.
+         * PECReader. The configuration is moved to the thread pool when it is created; therefore,
+         * the method throws an exception if called after the first call to Process.
          */
         PECReaderConfig &GetPECReaderConfig();
         
@@ -66,26 +99,214 @@ class RunManager
          * The new plugin is inserted at the end of execution path. The plugin object is owned by
          * RunManager; therefore, the user might need to use std::move to transfer the ownship.
          * Note that a plugin wrapper for class PECReader is included automatically and executed
-         * first; it must not be registered explicitly.
+         * first; it must not be registered explicitly. If the thread pool already exists, the
+         * plugin is appended to the path of every processor in the pool with the next call to
+         * Process.
          */
         void RegisterPlugin(Plugin *plugin);
+        
+        /**
+         * \brief Requests profiling of lock contention and thread activity
+         * 
+         * If enabled, acquisitions of the global locks and the time spent waiting for them are
+         * counted (see class ContentionProfiler), the busy and idle time of each thread is
+         * measured, and a summary is printed at the end of Process. Disabled by default.
+         */
+        void SetContentionProfiling(bool enable = true) noexcept;
+        
+        /**
+         * \brief Configures placement of the processing threads
+         * 
+         * If pinThreads is true, each thread is pinned to a CPU. The threads are distributed over
+         * the NUMA nodes in a round-robin manner, and within a node they are assigned to
+         * different CPUs. Each thread allocates the buffers of its PECReader after it has been
+         * pinned, so that they are placed in the memory of its node. If perNodeQueues is true,
+         * the datasets are distributed among separate queues, one for each NUMA node with at
+         * least one thread; a thread takes datasets from the queue of its node and only turns to
+         * other queues when it is exhausted. This reduces traffic between the sockets due to the
+         * synchronization. Both options are disabled by default.
+         */
+        void SetThreadPlacement(bool pinThreads, bool perNodeQueues = true) noexcept;
+        
+        /**
+         * \brief Requests periodic reports on the progress of the processing
+         * 
+         * If the interval (in seconds) is positive, the rates of read and accepted events, the
+         * rate of reading from the input files, utilisation of the threads, and the estimated
+         * remaining time are printed with the given period (see class ProgressMonitor). If the
+         * name of the status file is not empty, the same information is also written into this
+         * file in JSON format. A non-positive interval disables the reports, which is the default.
+         */
+        void SetProgressReport(double interval, std::string const &statusFileName = "");
+        
+        /**
+         * \brief Requests a journal of processed files to allow resuming an interrupted job
+         * 
+         * Names of input files are appended to the journal with the given name as soon as their
+         * processing is finished (see class RunJournal). Each call to Process or
+         * ProcessDistributed is a separate pass, and the files are recorded together with the
+         * index of the pass. If resume is true and the journal exists, the files listed in it
+         * are skipped by the pass with the same index, and only the remaining ones are
+         * processed. Plugins are expected to write their outputs atomically (see
+         * Plugin::CommitOutputFile), so that outputs of the skipped files are complete while
+         * outputs of interrupted files are not mistaken for complete ones. Throws an exception if
+         * the journal cannot be opened. Disabled by default.
+         */
+        void SetJournal(std::string const &fileName, bool resume = true);
+        
+        /**
+         * \brief Processes datasets with worker processes coordinated by this
+         * 
+         * The calling process acts as a coordinator (see class TaskCoordinator). It listens at the
+         * given address and serves atomic datasets, one at a time, to the worker processes that
+         * connect to it. The given number of workers are forked locally; each of them runs a
+         * single Processor with the same path as in this. If pinning has been requested with
+         * SetThreadPlacement, the local workers are pinned to different CPUs, spread over NUMA
+         * nodes in the same way as threads in Process. More workers can be started on other
+         * nodes with RunWorkerProcess, in which case a TCP address ("host:port") must be used.
+         * If the address is empty, a Unix domain socket in /tmp is created.
+         * 
+         * Output files of the plugins are written by the workers directly, so a file system
+         * shared with the remote workers is needed. The workers report the processing time and
+         * the numbers of events accepted by each plugin, which are merged and printed at the end.
+         * A file whose worker has failed is reprocessed by another worker. If a journal has been
+         * requested, it is written by the coordinator. Throws an exception if a plugin does not
+         * support the distributed mode (see Plugin::SupportsDistributedMode) or if the processing
+         * cannot be completed.
+         */
+        void ProcessDistributed(unsigned nLocalWorkers, std::string const &address = "");
+        
+        /**
+         * \brief Runs this process as a worker for a coordinator at the given address
+         * 
+         * The instance must be configured in the same way as the one that runs the coordinator
+         * (in particular, it must contain the datasets that will be requested) since only names
+         * of the input files are communicated. Returns when the coordinator reports that all the
+         * datasets have been processed. The journal, if any, is not written by a worker.
+         */
+        void RunWorkerProcess(std::string const &address);
+        
+        /**
+         * \brief Returns the merged cut-flow of the last call to ProcessDistributed
+         * 
+         * The i-th element is the number of events accepted by the i-th plugin in the path (the
+         * reader comes first), summed over all the files. Only results of successful attempts to
+         * process a file are included. The vector is empty if ProcessDistributed has not been
+         * called. Early filters of plugins (see Plugin::RegisterEarlyFilters) are not used in the
+         * distributed mode, so the events are counted as if the filters did not exist.
+         */
+        std::vector<unsigned long> const &GetCutFlow() const noexcept;
     
     private:
         /// Implementation for famility public methods Process
         void ProcessImp(int nThreads);
+        
+        /**
+         * \brief Main loop of a thread in the pool
+         * 
+         * Waits for a new pass, runs the given processor if its index is smaller than the number
+         * of active processors in the pass, and reports completion. The last argument is the
+         * index of the pass that preceded the creation of the thread.
+         */
+        void RunWorker(Processor *processor, unsigned index, unsigned long lastPass);
+        
+        /**
+         * \brief Creates the first processor if needed and moves the registered plugins to it
+         * 
+         * The plugins are appended to the paths of the other processors in the pool as well.
+         */
+        void PreparePool();
+        
+        /// Removes all the datasets from the queues and returns them
+        std::vector<Dataset> TakeDatasets();
+        
+        /// Drops the datasets listed in the journal as processed
+        void SkipCompletedDatasets();
+        
+        /**
+         * \brief Processes datasets assigned by the coordinator at the given address
+         * 
+         * The given datasets are looked up by the names of the files in the tasks. The first
+         * processor of the pool is used. Its placement, which might be left from a multithreaded
+         * pass, is replaced with the given CPU (negative to disable pinning).
+         */
+        void ServeTasks(std::string const &address, std::vector<Dataset> const &datasets,
+         int cpu = -1);
     
     private:
-        /// Atomic (containing a single file each) datasets
-        std::queue<Dataset> datasets;
-        
-        /// A mutex to lock container with atomic datasets
-        std::mutex mutexDatasets;
+        /// A queue of atomic datasets together with a mutex to protect it
+        struct DatasetQueue
+        {
+            /// Atomic (containing a single file each) datasets
+            std::queue<Dataset> datasets;
+            
+            /// A mutex to lock the queue
+            std::mutex mutex;
+        };
+    
+    private:
+        /**
+         * \brief Queues of atomic datasets
+         * 
+         * All the datasets are put into the first queue in the constructor. They are redistributed
+         * among several queues in ProcessImp if requested.
+         */
+        std::vector<std::unique_ptr<DatasetQueue>> datasetQueues;
         
         /// Configuration for PECReader
         std::unique_ptr<PECReaderConfig> readerConfig;
         
         /// Vector of registered plugins
         std::vector<std::unique_ptr<Plugin>> plugins;
+        
+        /// Indicates if lock contention and thread activity should be profiled
+        bool profileContention;
+        
+        /// Indicates if the threads should be pinned to CPUs
+        bool pinThreads;
+        
+        /// Indicates if a separate queue of datasets should be used for each NUMA node
+        bool perNodeQueues;
+        
+        /// Interval between progress reports, in seconds (non-positive if disabled)
+        double progressInterval;
+        
+        /// Name of the status file to export the progress (empty if not requested)
+        std::string statusFileName;
+        
+        /// Journal of processed files (null if not requested)
+        std::unique_ptr<RunJournal> journal;
+        
+        /// Number of completed calls to Process and ProcessDistributed; identifies the pass in
+        //the journal
+        unsigned long journalPass;
+        
+        /// Merged cut-flow of the last distributed processing
+        std::vector<unsigned long> cutFlow;
+        
+        /// Processors in the persistent pool
+        std::vector<std::unique_ptr<Processor>> pool;
+        
+        /// Threads running the processors from the pool (in the same order)
+        std::vector<std::thread> workers;
+        
+        /// Mutex to protect the state of the pool described below
+        std::mutex poolMutex;
+        
+        /// Condition variables to notify the threads about a new pass and the manager about its end
+        std::condition_variable passStarted, passFinished;
+        
+        /// Index of the current pass (incremented for each call to Process)
+        unsigned long passIndex;
+        
+        /// Number of processors that take part in the current pass
+        unsigned nActiveWorkers;
+        
+        /// Number of threads that have not finished the current pass yet
+        unsigned nBusyWorkers;
+        
+        /// Indicates that the threads must terminate
+        bool stopWorkers;
     
     friend class Processor;
 };
@@ -93,9 +314,23 @@ class RunManager
 
 template<typename InputIt>
 RunManager::RunManager(InputIt const &datasetsBegin, InputIt const &datasetsEnd):
-    readerConfig(new PECReaderConfig)
+    readerConfig(new PECReaderConfig),
+    profileContention(false),
+    pinThreads(false), perNodeQueues(false),
+    progressInterval(0.), journalPass(0),
+    passIndex(0), nActiveWorkers(0), nBusyWorkers(0), stopWorkers(false)
+{
+    datasetQueues.emplace_back(new DatasetQueue);
+    AddDatasets(datasetsBegin, datasetsEnd);
+}
+
+
+template<typename InputIt>
+void RunManager::AddDatasets(InputIt const &datasetsBegin, InputIt const &datasetsEnd)
 {
     // Fill container with atomic datasets
+    auto &datasets = datasetQueues.front()->datasets;
+    
     for (InputIt d = datasetsBegin; d != datasetsEnd; ++d)
     {
         for (auto const &file: d->GetFiles())
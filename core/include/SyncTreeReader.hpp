@@ -0,0 +1,272 @@
+/**
+ * \file SyncTreeReader.hpp
+ * \author Andrey Popov
+ * 
+ * The module defines a class to read several aligned ROOT trees with a single cursor.
+ */
+
+#pragma once
+
+#include <ColumnCache.hpp>
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+
+// Forward declarations
+class TTree;
+class TBranch;
+
+
+/**
+ * \class SyncTreeReader
+ * \brief Reads a set of ROOT trees with identical numbers of entries as a single source
+ * 
+ * The trees are registered with method AddTree. Each tree is given an alias, which can be used to
+ * qualify names of branches, and an index of a group. All the trees share the same cursor, which
+ * points to the current entry. Method ReadGroup reads the current entry from all the branches bound
+ * in the trees of the given group. This allows a user to read different parts of an event at
+ * different moments, for instance, to read the bulk of the event only if it passes a preselection.
+ * An individual branch can be assigned to a group different from the one of its tree. A group can
+ * also be read for an entry other than the current one, which allows to postpone reading of some
+ * branches until they are actually needed.
+ * 
+ * Unlike friend trees, the registered trees are accessed directly, and no index lookup is performed
+ * when an entry is read. Branches that have not been bound with method SetBranchAddress are
+ * disabled, and the total size of TTreeCache is distributed among the trees in proportion to the
+ * number of bound branches.
+ * 
+ * Optionally, the bound branches can be served from an uncompressed column cache (see class
+ * ColumnCache) attached with method AttachCache. If no valid cache exists, it is created in a
+ * dedicated pass over all entries when the method is called. While a cache is attached, the
+ * trees with bound branches are not accessed at all, and no TTreeCache is allocated for them; the
+ * values are copied from the mapped cache file into the bound buffers. In
+ * order to store arrays of variable length in the cache, their count branches must be specified
+ * when the branches are bound.
+ * 
+ * The class does not own the trees. The user must call method Clear before the trees are deleted
+ * (which is normally done by closing the file they belong to).
+ * 
+ * The class is non-copyable.
+ */
+class SyncTreeReader
+{
+private:
+    /// An auxiliary structure to describe a registered tree
+    struct TreeInfo
+    {
+        /// Pointer to the tree
+        TTree *tree;
+        
+        /// Alias to identify the tree in qualified names of branches
+        std::string alias;
+        
+        /// Index of the group the tree belongs to
+        unsigned group;
+        
+        /// Indices of columns (bound branches) in this tree
+        std::vector<unsigned> columns;
+    };
+    
+    /// Trees and columns to be read for a group
+    struct GroupEntry
+    {
+        /// Index of the tree
+        unsigned tree;
+        
+        /// Indices of columns of this tree that belong to the group
+        std::vector<unsigned> columns;
+    };
+    
+    /// An auxiliary structure to describe a bound branch
+    struct Column
+    {
+        /// Name of the branch qualified with the alias of its tree
+        std::string name;
+        
+        /// Pointer to the branch
+        TBranch *branch;
+        
+        /// Buffer to read the branch
+        void *address;
+        
+        /// Size of a single element in bytes
+        unsigned elementSize;
+        
+        /// Maximal number of elements the buffer can hold
+        unsigned maxElements;
+        
+        /// Pointer to the number of elements for an array or null for a scalar
+        unsigned char const *count;
+        
+        /// Index of the group the branch belongs to
+        unsigned group;
+    };
+
+public:
+    /// A special value of group that means the group of the tree that contains the branch
+    static unsigned const treeGroup = unsigned(-1);
+
+public:
+    /// Constructor with no parameters
+    SyncTreeReader() noexcept;
+    
+    /// Copy constructor is deleted
+    SyncTreeReader(SyncTreeReader const &) = delete;
+    
+    /// Assignment operator is deleted
+    SyncTreeReader &operator=(SyncTreeReader const &) = delete;
+
+public:
+    /**
+     * \brief Registers a new tree
+     * 
+     * Throws an exception if the tree is null or its number of entries differs from the trees
+     * registered earlier. Resets the cursor.
+     */
+    void AddTree(TTree *tree, std::string const &alias, unsigned group);
+    
+    /**
+     * \brief Binds a branch with a scalar value to a buffer
+     * 
+     * The name can be qualified with an alias of a tree, as in "alias.branch". If it is not
+     * qualified, the branch is searched for in all the trees in the order they have been
+     * registered. Throws an exception if the branch is not found. Returns index of the column.
+     * By default, the branch is assigned to the group of its tree, but a different group can be
+     * specified.
+     */
+    template<typename T>
+    unsigned SetBranchAddress(std::string const &name, T *address, unsigned group = treeGroup);
+    
+    /**
+     * \brief Binds a branch with an array of variable length to a buffer
+     * 
+     * The last argument is the buffer into which the number of elements is read. The
+     * corresponding count branch must be bound as well. See also the overload for scalars.
+     */
+    template<typename T, std::size_t N>
+    unsigned SetBranchAddress(std::string const &name, T (&address)[N],
+     unsigned char const &count, unsigned group = treeGroup);
+    
+    /**
+     * \brief Sets the total size of TTreeCache (in bytes) shared among the trees
+     * 
+     * The value is taken into account when method Prepare is called. A zero value means that the
+     * cache settings of the trees are not changed.
+     */
+    void SetCacheSize(long long cacheSize) noexcept;
+    
+    /**
+     * \brief Finalizes the configuration
+     * 
+     * Disables unused branches and sets up TTreeCache. Must be called after all the branches
+     * have been bound and before the first entry is read. If a column cache has been attached,
+     * TTreeCache is only set up for the trees without bound branches.
+     */
+    void Prepare();
+    
+    /**
+     * \brief Attaches a column cache to be used instead of the trees
+     * 
+     * The cache is identified by the given path and is valid only if it was created for a source
+     * file with the given size and modification time and for the same set of bound branches.
+     * A cache whose layout is inconsistent (for instance, because the file has been truncated)
+     * is treated as invalid. If there is no valid cache, it is created. Must be called after all
+     * the branches have been bound and before method Prepare. Returns true if the cache is used;
+     * if it cannot be created, the trees are read as usual.
+     */
+    bool AttachCache(std::string const &path, std::uint64_t sourceSize,
+     std::int64_t sourceMTime);
+    
+    /// Forgets all the registered trees and detaches the cache
+    void Clear() noexcept;
+    
+    /// Returns the number of entries in the trees
+    unsigned long GetEntries() const noexcept;
+    
+    /// Returns the index of the current entry
+    unsigned long GetCurrentEntry() const noexcept;
+    
+    /// Checks if the cursor has passed the last entry
+    bool AtEnd() const noexcept;
+    
+    /// Moves the cursor to the next entry
+    void NextEntry() noexcept;
+    
+    /**
+     * \brief Returns the number of times an entry has been read from a branch
+     * 
+     * Reads served by the column cache are included. The counter is reset by method Clear.
+     */
+    unsigned long long GetNumBranchReads() const noexcept;
+    
+    /// Reads the current entry from all the branches of the given group
+    void ReadGroup(unsigned group);
+    
+    /**
+     * \brief Reads the given entry from all the branches of the given group
+     * 
+     * The cursor is not changed.
+     */
+    void ReadGroup(unsigned group, unsigned long entry);
+    
+    /// Returns the tree with the given alias or null if there is no such tree
+    TTree *GetTree(std::string const &alias) const noexcept;
+
+private:
+    /// Binds a branch to a buffer and returns index of the column
+    unsigned Bind(std::string const &name, void *address, unsigned elementSize,
+     unsigned maxElements, unsigned char const *count, unsigned group);
+    
+    /// Creates a cache file reading all the entries from the trees
+    bool BuildCache(std::string const &path, ColumnCacheKey const &key);
+    
+    /// Returns the number of shares in which the total size of TTreeCache is split
+    unsigned GetNumCacheShares() const noexcept;
+    
+    /// Sets up TTreeCache for the given tree and adds its bound branches to it
+    void SetUpTreeCache(TreeInfo const &tree, unsigned nShares);
+
+private:
+    /// Registered trees
+    std::vector<TreeInfo> trees;
+    
+    /// Bound branches
+    std::vector<Column> columns;
+    
+    /// Trees and branches to be read for each group (filled in method Prepare)
+    std::vector<std::vector<GroupEntry>> groups;
+    
+    /// Column cache (might be not opened)
+    ColumnCache cache;
+    
+    /// Total size of TTreeCache in bytes
+    long long cacheSize;
+    
+    /// Number of entries in each tree
+    unsigned long nEntries;
+    
+    /// Index of the current entry
+    unsigned long curEntry;
+    
+    /// Number of entries read from individual branches (see GetNumBranchReads)
+    unsigned long long nBranchReads;
+};
+
+
+template<typename T>
+unsigned SyncTreeReader::SetBranchAddress(std::string const &name, T *address,
+ unsigned group /*= treeGroup*/)
+{
+    return Bind(name, address, sizeof(T), 1, nullptr, group);
+}
+
+
+template<typename T, std::size_t N>
+unsigned SyncTreeReader::SetBranchAddress(std::string const &name, T (&address)[N],
+ unsigned char const &count, unsigned group /*= treeGroup*/)
+{
+    return Bind(name, address, sizeof(T), N, &count, group);
+}
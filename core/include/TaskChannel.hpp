@@ -0,0 +1,94 @@
+/**
+ * \file TaskChannel.hpp
+ * \author Andrey Popov
+ * 
+ * The module defines a line-oriented connection between a coordinator and a worker process.
+ */
+
+#pragma once
+
+#include <string>
+
+
+/**
+ * \class TaskChannel
+ * \brief A connected stream socket that exchanges text messages, one per line
+ * 
+ * Both local (Unix domain) and TCP sockets are supported. An address of the form "host:port" refers
+ * to a TCP socket (the host might be "*" to listen on all interfaces), while any other address is
+ * interpreted as the path to a Unix domain socket.
+ * 
+ * Incoming data are buffered. The coordinator, which serves many connections, calls Receive when
+ * poll reports that the socket is readable and then extracts the complete lines with PopLine. The
+ * worker uses the blocking method ReadLine instead.
+ */
+class TaskChannel
+{
+public:
+    /// Constructor from a connected socket; the channel takes the ownership of the descriptor
+    explicit TaskChannel(int fd) noexcept;
+    
+    /// Move constructor
+    TaskChannel(TaskChannel &&src) noexcept;
+    
+    /// Copy constructor is deleted
+    TaskChannel(TaskChannel const &) = delete;
+    
+    /// Assignment operator is deleted
+    TaskChannel &operator=(TaskChannel const &) = delete;
+    
+    /// Destructor; closes the socket
+    ~TaskChannel();
+
+public:
+    /**
+     * \brief Creates a socket listening at the given address and returns its descriptor
+     * 
+     * An existing Unix domain socket with the same path is removed. Throws an exception in case
+     * of failure.
+     */
+    static int Listen(std::string const &address);
+    
+    /**
+     * \brief Connects to the given address
+     * 
+     * If the connection is refused (e.g. the coordinator has not started yet), the attempt is
+     * repeated once per second until the timeout (in seconds) expires. Throws an exception in
+     * case of failure.
+     */
+    static TaskChannel Connect(std::string const &address, unsigned timeout = 30);
+    
+    /// Checks if the address refers to a Unix domain socket
+    static bool IsLocalAddress(std::string const &address);
+    
+    /// Returns the descriptor of the socket
+    int GetDescriptor() const noexcept;
+    
+    /**
+     * \brief Reads available data into the buffer
+     * 
+     * Blocks if no data are available. Returns false if the connection has been closed by the
+     * other side or has failed.
+     */
+    bool Receive();
+    
+    /// Extracts the next complete line from the buffer; returns false if there is none
+    bool PopLine(std::string &line);
+    
+    /// Reads the next line, blocking if needed; throws an exception if the connection is closed
+    std::string ReadLine();
+    
+    /// Sends the given line; a new-line character is appended. Throws an exception on failure
+    void WriteLine(std::string const &line);
+
+private:
+    /// Splits the address of a TCP socket into the host and the port; returns false if not TCP
+    static bool SplitTCPAddress(std::string const &address, std::string &host, std::string &port);
+
+private:
+    /// Descriptor of the socket (negative if the object has been moved from)
+    int fd;
+    
+    /// Received data that have not been extracted yet
+    std::string buffer;
+};
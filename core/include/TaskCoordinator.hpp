@@ -0,0 +1,170 @@
+/**
+ * \file TaskCoordinator.hpp
+ * \author Andrey Popov
+ * 
+ * The module defines a coordinator that distributes atomic datasets among worker processes.
+ */
+
+#pragma once
+
+#include <TaskChannel.hpp>
+
+#include <sys/types.h>
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <list>
+#include <map>
+#include <functional>
+
+
+/**
+ * \class TaskCoordinator
+ * \brief Serves tasks to worker processes over a socket and collects their results
+ * 
+ * A task is the processing of a single input file, identified by its name. Worker processes
+ * connect to the coordinator (see class TaskChannel for the format of the address) and exchange
+ * the following messages, one per line:
+ *   worker: HELLO <name>                     introduces the worker;
+ *   worker: GET                              requests a new task;
+ *   coordinator: TASK <index> <file>         assigns a task;
+ *   coordinator: DONE                        reports that there are no more tasks;
+ *   worker: RESULT <index> <time> <counts>   reports the processing time (in seconds) and the
+ *                                            cut-flow, i.e. the numbers of events accepted by
+ *                                            each plugin in the path.
+ * If there are no free tasks but some are being processed by other workers, a GET is answered
+ * once one of them fails or all of them have been completed. A task held by a worker that closes
+ * the connection or terminates before reporting the result is returned to the queue and served
+ * again. If the same task fails repeatedly, the processing is aborted.
+ * 
+ * The coordinator is single-threaded. Worker processes started locally must be registered with
+ * AddLocalWorker, so that their termination is detected. If all of them have terminated while
+ * some tasks are unfinished and no other workers are connected, an exception is thrown. Without
+ * local workers the coordinator waits for remote ones indefinitely.
+ */
+class TaskCoordinator
+{
+private:
+    /// A connection with a worker
+    struct Connection
+    {
+        /// Constructor from an accepted socket
+        Connection(int fd);
+        
+        /// Channel to communicate with the worker
+        TaskChannel channel;
+        
+        /// Name of the worker
+        std::string worker;
+        
+        /// Index of the task being processed by the worker (negative if none)
+        long task;
+        
+        /// Indicates that the worker waits for a task
+        bool waiting;
+    };
+    
+    /// Summary of tasks processed by a worker
+    struct WorkerStats
+    {
+        /// Constructor with no parameters; sets all counters to zero
+        WorkerStats() noexcept;
+        
+        unsigned nTasks;  ///< Number of completed tasks
+        unsigned long nEvents;  ///< Number of read events
+        double time;  ///< Processing time, in seconds
+    };
+
+public:
+    /**
+     * \brief Constructor
+     * 
+     * Starts listening at the given address. The tasks are defined by the names of the input
+     * files, and the names of the plugins are used to print the cut-flow.
+     */
+    TaskCoordinator(std::string const &address, std::vector<std::string> const &taskNames,
+     std::vector<std::string> const &pluginNames, unsigned maxAttempts = 3);
+    
+    /// Copy constructor is deleted
+    TaskCoordinator(TaskCoordinator const &) = delete;
+    
+    /// Assignment operator is deleted
+    TaskCoordinator &operator=(TaskCoordinator const &) = delete;
+    
+    /**
+     * \brief Destructor
+     * 
+     * Closes the socket and terminates the local worker processes that are still running.
+     */
+    ~TaskCoordinator();
+
+public:
+    /// Registers a worker process started on the local machine
+    void AddLocalWorker(pid_t pid);
+    
+    /**
+     * \brief Serves the tasks until all of them are completed
+     * 
+     * The given function is called with the index of a task as soon as its result is received.
+     * Returns when all the tasks have been completed, all the connected workers have been told to
+     * stop and have disconnected, and all the local workers have terminated. A worker that
+     * requests a task after the last one has been completed is answered with DONE.
+     */
+    void Run(std::function<void(unsigned long)> const &onCompleted);
+    
+    /// Returns the number of events accepted by each plugin, summed over all completed tasks
+    std::vector<unsigned long> const &GetCutFlow() const noexcept;
+    
+    /// Prints the merged cut-flow and statistics of the workers with the logger
+    void PrintSummary(double wallTime) const;
+
+private:
+    /// Handles a message from a worker; returns false if the connection must be closed
+    bool HandleMessage(Connection &connection, std::string const &message,
+     std::function<void(unsigned long)> const &onCompleted);
+    
+    /// Assigns tasks to waiting workers, or tells them to stop if everything has been completed
+    void ServeWaiting(std::list<Connection> &connections);
+    
+    /// Returns the task of a failed worker to the queue
+    void RequeueTask(Connection &connection);
+    
+    /// Checks which local workers have terminated
+    void ReapLocalWorkers();
+
+private:
+    /// Address to listen at
+    std::string address;
+    
+    /// Descriptor of the listening socket
+    int listenFD;
+    
+    /// Names of input files, one per task
+    std::vector<std::string> taskNames;
+    
+    /// Names of the plugins in the path
+    std::vector<std::string> pluginNames;
+    
+    /// Maximal number of attempts to process a task
+    unsigned maxAttempts;
+    
+    /// Tasks that have not been assigned yet
+    std::deque<unsigned long> pending;
+    
+    /// Number of attempts made for each task
+    std::vector<unsigned> nAttempts;
+    
+    /// Number of completed tasks
+    unsigned long nCompleted;
+    
+    /// Local worker processes that are still running and the total number of registered ones
+    std::vector<pid_t> localWorkers;
+    unsigned nLocalWorkersTotal;
+    
+    /// Cut-flow summed over all completed tasks
+    std::vector<unsigned long> cutFlow;
+    
+    /// Statistics for each worker, indexed by its name
+    std::map<std::string, WorkerStats> workerStats;
+};
@@ -107,6 +107,12 @@ class TriggerRange
          */
         bool InRange(EventID const &eventID) const;
         
+        /// Returns the beginning of the EventID range (included in the range)
+        EventID const &GetFirstEvent() const;
+        
+        /// Returns the end of the EventID range (included in the range)
+        EventID const &GetLastEvent() const;
+        
         /**
          * \brief Performs the additional event selection
          * 
@@ -88,6 +88,24 @@ class TriggerSelectionInterface
          */
         virtual bool ReadNextEvent(EventID const &eventID) = 0;
         
+        /**
+         * \brief Reads the given entry from the trigger tree
+         * 
+         * Allows PECReader to drive the trigger tree with the same cursor as the other trees in the
+         * source file, so that entries skipped by the reader are also skipped here. Default
+         * implementation moves the internal counter to the given entry and calls ReadNextEvent.
+         */
+        virtual bool ReadEvent(unsigned long entry, EventID const &eventID);
+        
+        /**
+         * \brief Checks whether the trigger decision depends on the event ID
+         * 
+         * If the method returns false, the PECReader is allowed to call ReadNextEvent and
+         * PassTrigger before the event ID is read, with an arbitrary value of the ID. This allows
+         * to reject events without touching any other branch. Default implementation returns true.
+         */
+        virtual bool RequiresEventID() const;
+        
         /**
          * \brief Performs the first step of trigger selection on the current event
          * 
@@ -0,0 +1,76 @@
+#include <Arena.hpp>
+
+#include <algorithm>
+
+
+using namespace std;
+
+
+Arena::Arena(size_t chunkSize_ /*= 64 * 1024*/) noexcept:
+    chunkSize(chunkSize_),
+    curChunk(0), curPos(0),
+    nChunkAllocations(0)
+{}
+
+
+Arena::~Arena()
+{
+    for (auto const &c: chunks)
+        ::operator delete(c.data);
+}
+
+
+void *Arena::Allocate(size_t nBytes, size_t alignment /*= alignof(long double)*/)
+{
+    // Try to fit the block in the current chunk or one of the chunks that follow it. The chunks
+    //are only left behind when a block does not fit, which is rare
+    for (; curChunk < chunks.size(); ++curChunk, curPos = 0)
+    {
+        Chunk const &c = chunks[curChunk];
+        size_t const start = (reinterpret_cast<size_t>(c.data + curPos) + alignment - 1) &
+         ~(alignment - 1);
+        size_t const offset = start - reinterpret_cast<size_t>(c.data);
+        
+        if (offset + nBytes <= c.size)
+        {
+            curPos = offset + nBytes;
+            return c.data + offset;
+        }
+    }
+    
+    
+    // No chunk has enough space. Allocate a new one. The memory returned by operator new is
+    //aligned suitably for any fundamental type
+    size_t const size = max(chunkSize, nBytes + alignment);
+    chunks.push_back({static_cast<char *>(::operator new(size)), size});
+    ++nChunkAllocations;
+    
+    curChunk = chunks.size() - 1;
+    curPos = 0;
+    
+    return Allocate(nBytes, alignment);
+}
+
+
+void Arena::Reset() noexcept
+{
+    curChunk = 0;
+    curPos = 0;
+}
+
+
+size_t Arena::GetCapacity() const noexcept
+{
+    size_t capacity = 0;
+    
+    for (auto const &c: chunks)
+        capacity += c.size;
+    
+    return capacity;
+}
+
+
+unsigned long Arena::GetNumChunkAllocations() const noexcept
+{
+    return nChunkAllocations;
+}
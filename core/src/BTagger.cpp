@@ -4,33 +4,53 @@
 
 #include <stdexcept>
 #include <sstream>
+#include <limits>
+#include <cmath>
 
 
 using namespace std;
 
 
+/// Returns the largest float value that does not exceed the given number
+static float RoundDownToFloat(double x)
+{
+    float const f = x;
+    return (f > x) ? nextafter(f, -numeric_limits<float>::infinity()) : f;
+}
+
+
 BTagger::BTagger(Algorithm algo_, WorkingPoint defaultWP_ /*= WorkingPoint::Tight*/):
     algo(algo_), defaultWP(defaultWP_),
-    bTagMethod(nullptr)
+    supportedMask(0),
+    discriminatorIndex(0),
+    maxAbsEta(BTagSFInterface::GetMaxPseudorapidity())
 {
-    // Set thresholds corresponding to official working points [1]
+    // Unsupported working points are given infinite thresholds so that no jet is ever tagged
+    thresholds.fill(numeric_limits<double>::infinity());
+    
+    
+    // Set thresholds corresponding to official working points [1] and indices of the
+    //discriminators as defined in Jet::GetBTagDiscriminator
     //[1] https://twiki.cern.ch/twiki/bin/viewauth/CMS/BTagPerformanceOP
     switch (algo)
     {
         case Algorithm::CSV:
-            thresholds[WorkingPoint::Tight] = 0.898;
-            thresholds[WorkingPoint::Medium] = 0.679;
-            thresholds[WorkingPoint::Loose] = 0.244;
+            thresholds[int(WorkingPoint::Tight)] = 0.898;
+            thresholds[int(WorkingPoint::Medium)] = 0.679;
+            thresholds[int(WorkingPoint::Loose)] = 0.244;
+            discriminatorIndex = 0;
             break;
         
         case Algorithm::JP:
-            thresholds[WorkingPoint::Tight] = 0.790;
-            thresholds[WorkingPoint::Medium] = 0.545;
-            thresholds[WorkingPoint::Loose] = 0.275;
+            thresholds[int(WorkingPoint::Tight)] = 0.790;
+            thresholds[int(WorkingPoint::Medium)] = 0.545;
+            thresholds[int(WorkingPoint::Loose)] = 0.275;
+            discriminatorIndex = 1;
             break;
         
         case Algorithm::TCHP:
-            thresholds[WorkingPoint::Tight] = 3.41;
+            thresholds[int(WorkingPoint::Tight)] = 3.41;
+            discriminatorIndex = 2;
             break;
         
         case Algorithm::CSVV1:
@@ -40,42 +60,37 @@ BTagger::BTagger(Algorithm algo_, WorkingPoint defaultWP_ /*= WorkingPoint::Tigh
     }
     
     
-    // Set the pointer to the method to assess the b-tagging discriminator's value
-    switch (algo)
-    {
-        case Algorithm::CSV:
-            bTagMethod = &Jet::CSV;
-            break;
-        
-        case Algorithm::JP:
-            bTagMethod = &Jet::JP;
-            break;
-        
-        case Algorithm::TCHP:
-            bTagMethod = &Jet::TCHP;
-            break;
-        
-        case Algorithm::CSVV1:
-        case Algorithm::CSVSLV1:
-            throw logic_error("BTagger::BTagger: Algorithms CSVV1 and CSVSLV1 are not supported "
-             "yet.");
-    }
+    // Mark the supported working points
+    for (unsigned i = 0; i < thresholds.size(); ++i)
+        if (thresholds[i] != numeric_limits<double>::infinity())
+            supportedMask |= 1u << i;
+    
+    
+    // Single-precision versions of the cuts for the batched evaluation
+    for (unsigned i = 0; i < thresholds.size(); ++i)
+        floatThresholds[i] = RoundDownToFloat(thresholds[i]);
+    
+    floatMaxAbsEta = RoundDownToFloat(maxAbsEta);
 }
 
 
 BTagger::BTagger(BTagger const &src):
     algo(src.algo),
     defaultWP(src.defaultWP),
-    thresholds(src.thresholds),
-    bTagMethod(src.bTagMethod)
+    thresholds(src.thresholds), floatThresholds(src.floatThresholds),
+    supportedMask(src.supportedMask),
+    discriminatorIndex(src.discriminatorIndex),
+    maxAbsEta(src.maxAbsEta), floatMaxAbsEta(src.floatMaxAbsEta)
 {}
 
 
 BTagger::BTagger(BTagger &&src):
     algo(src.algo),
     defaultWP(src.defaultWP),
-    thresholds(move(src.thresholds)),
-    bTagMethod(src.bTagMethod)
+    thresholds(src.thresholds), floatThresholds(src.floatThresholds),
+    supportedMask(src.supportedMask),
+    discriminatorIndex(src.discriminatorIndex),
+    maxAbsEta(src.maxAbsEta), floatMaxAbsEta(src.floatMaxAbsEta)
 {}
 
 
@@ -84,7 +99,11 @@ BTagger &BTagger::operator=(BTagger const &rhs)
     algo = rhs.algo;
     defaultWP = rhs.defaultWP;
     thresholds = rhs.thresholds;
-    bTagMethod = rhs.bTagMethod;
+    floatThresholds = rhs.floatThresholds;
+    supportedMask = rhs.supportedMask;
+    discriminatorIndex = rhs.discriminatorIndex;
+    maxAbsEta = rhs.maxAbsEta;
+    floatMaxAbsEta = rhs.floatMaxAbsEta;
     
     return *this;
 }
@@ -92,27 +111,19 @@ BTagger &BTagger::operator=(BTagger const &rhs)
 
 bool BTagger::IsTagged(WorkingPoint wp, Jet const &jet) const
 {
-    // First, check the jet pseudorapidity makes sense
-    if (fabs(jet.Eta()) > BTagSFInterface::GetMaxPseudorapidity())
-        // There is a very small number of tagged jets with |eta| just above 2.4
-        return false;
+    if (not (supportedMask & (1u << int(wp))))
+        ThrowUnsupportedWP(wp, "IsTagged");
     
     
-    // Find the threshold for the given working point
-    auto thresholdIt = thresholds.find(wp);
+    // If the jet carries decisions evaluated by a compatible b-tagger, just read the bit
+    if (jet.GetBTagBitsCode() == GetTagBitsCode())
+        return ((jet.GetBTagBits() >> int(wp)) & 1);
     
-    if (thresholdIt == thresholds.end())
-    {
-        ostringstream ost;
-        ost << "BTagger::IsTagged: Working point " << int(wp) << " is not supported for "
-         "b-tagger " << int(algo) << ".";
-        
-        throw runtime_error(ost.str());
-    }
     
-    
-    // Compare discriminator value with the threshold
-    return ((jet.*bTagMethod)() > thresholdIt->second);
+    // Otherwise compare the discriminator with the threshold. There is a very small number of
+    //tagged jets with |eta| just above 2.4, they are rejected
+    return ((fabs(jet.Eta()) <= maxAbsEta) &
+     (jet.GetBTagDiscriminator(discriminatorIndex) > thresholds[int(wp)]));
 }
 
 
@@ -134,6 +145,70 @@ bool BTagger::operator()(Jet const &jet) const
 }
 
 
+unsigned BTagger::ComputeTagBits(Jet const &jet) const
+{
+    double const discriminator = jet.GetBTagDiscriminator(discriminatorIndex);
+    unsigned const inAcceptance = (fabs(jet.Eta()) <= maxAbsEta);
+    
+    // Infinite thresholds of unsupported working points are never passed
+    return (unsigned(discriminator > thresholds[0]) | unsigned(discriminator > thresholds[1]) << 1 |
+     unsigned(discriminator > thresholds[2]) << 2) * inAcceptance;
+}
+
+
+void BTagger::CacheTagBits(Jet &jet) const
+{
+    jet.SetBTagBits(ComputeTagBits(jet), GetTagBitsCode());
+}
+
+
+void BTagger::TagJets(vector<Jet> &jets) const
+{
+    for (auto &jet: jets)
+        CacheTagBits(jet);
+}
+
+
+void BTagger::ComputeTagBits(unsigned n, float const *discriminators, float const *eta,
+ unsigned char *bits) const
+{
+    // All the comparisons are done in single precision so that the loop is vectorised over the
+    //full width of the registers
+    float const t0 = floatThresholds[0], t1 = floatThresholds[1], t2 = floatThresholds[2];
+    float const maxEta = floatMaxAbsEta;
+    
+    for (unsigned i = 0; i < n; ++i)
+    {
+        float const d = discriminators[i];
+        unsigned const inAcceptance = (fabs(eta[i]) <= maxEta);
+        
+        bits[i] = (unsigned(d > t0) | unsigned(d > t1) << 1 | unsigned(d > t2) << 2) * inAcceptance;
+    }
+}
+
+
+int BTagger::GetTagBitsCode() const
+{
+    // The thresholds and the discriminator are fully defined by the algorithm
+    return int(algo);
+}
+
+
+double BTagger::GetThreshold(WorkingPoint wp) const
+{
+    if (not (supportedMask & (1u << int(wp))))
+        ThrowUnsupportedWP(wp, "GetThreshold");
+    
+    return thresholds[int(wp)];
+}
+
+
+double BTagger::GetDiscriminator(Jet const &jet) const
+{
+    return jet.GetBTagDiscriminator(discriminatorIndex);
+}
+
+
 BTagger::Algorithm BTagger::GetAlgorithm() const
 {
     return algo;
@@ -196,3 +271,13 @@ string BTagger::GetTextCode() const
     
     return code;
 }
+
+
+void BTagger::ThrowUnsupportedWP(WorkingPoint wp, string const &method) const
+{
+    ostringstream ost;
+    ost << "BTagger::" << method << ": Working point " << int(wp) << " is not supported for "
+     "b-tagger " << int(algo) << ".";
+    
+    throw runtime_error(ost.str());
+}
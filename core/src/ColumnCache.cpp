@@ -0,0 +1,385 @@
+#include <ColumnCache.hpp>
+
+#include <cstring>
+#include <cstdio>
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+
+using namespace std;
+
+
+/// Rounds the given position up to a multiple of 8
+static uint64_t Align8(uint64_t pos)
+{
+    return (pos + 7) & ~uint64_t(7);
+}
+
+
+// Definitions of static data members
+char const ColumnCache::magic[8] = {'P', 'E', 'C', 'C', 'A', 'C', 'H', 'E'};
+uint32_t const ColumnCache::version;
+
+
+ColumnCache::ColumnCache() noexcept:
+    base(nullptr), size(0),
+    blockIndex(nullptr),
+    blockSize(0), nEntries(0)
+{}
+
+
+ColumnCache::~ColumnCache()
+{
+    Close();
+}
+
+
+bool ColumnCache::Open(string const &path, ColumnCacheKey const &key,
+ vector<unsigned> const &maxSizes)
+{
+    Close();
+    
+    
+    // Map the file into memory
+    int const fd = open(path.c_str(), O_RDONLY);
+    
+    if (fd < 0)
+        return false;
+    
+    struct stat fileStat;
+    
+    if (fstat(fd, &fileStat) != 0 or fileStat.st_size < off_t(sizeof(Header)))
+    {
+        close(fd);
+        return false;
+    }
+    
+    void *mapped = mmap(nullptr, fileStat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    //^ The mapping stays valid after the descriptor is closed
+    
+    if (mapped == MAP_FAILED)
+        return false;
+    
+    base = static_cast<char const *>(mapped);
+    size = fileStat.st_size;
+    
+    
+    // Validate the header
+    Header header;
+    memcpy(&header, base, sizeof(header));
+    
+    if (memcmp(header.magic, magic, sizeof(magic)) != 0 or header.version != version or
+     header.blockSize == 0 or header.key.sourceSize != key.sourceSize or
+     header.key.sourceMTime != key.sourceMTime or header.key.columnsHash != key.columnsHash or
+     header.key.nEntries != key.nEntries or header.key.nColumns != key.nColumns or
+     maxSizes.size() != key.nColumns)
+    {
+        Close();
+        return false;
+    }
+    
+    blockSize = header.blockSize;
+    nEntries = key.nEntries;
+    
+    
+    // Validate the layout of the data. The file might have been truncated or corrupted after the
+    //header was written
+    if (not Validate(header.blockIndexPos, key.nColumns, maxSizes))
+    {
+        Close();
+        return false;
+    }
+    
+    blockIndex = reinterpret_cast<uint64_t const *>(base + header.blockIndexPos);
+    
+    return true;
+}
+
+
+void ColumnCache::Close() noexcept
+{
+    if (base)
+        munmap(const_cast<char *>(base), size);
+    
+    base = nullptr;
+    size = 0;
+    blockIndex = nullptr;
+}
+
+
+bool ColumnCache::IsOpen() const noexcept
+{
+    return (base != nullptr);
+}
+
+
+void const *ColumnCache::GetData(unsigned column, unsigned long entry, unsigned &nBytes) const
+ noexcept
+{
+    unsigned long const block = entry / blockSize;
+    unsigned const entryInBlock = entry % blockSize;
+    unsigned const nEntriesBlock = min<unsigned long>(blockSize, nEntries - block * blockSize);
+    
+    char const *blockStart = base + blockIndex[block];
+    uint64_t const *columnPos = reinterpret_cast<uint64_t const *>(blockStart);
+    uint32_t const *offsets = reinterpret_cast<uint32_t const *>(blockStart + columnPos[column]);
+    char const *columnData = blockStart + Align8(columnPos[column] + 4 * (nEntriesBlock + 1));
+    
+    nBytes = offsets[entryInBlock + 1] - offsets[entryInBlock];
+    return columnData + offsets[entryInBlock];
+}
+
+
+bool ColumnCache::Validate(uint64_t blockIndexPos, unsigned nColumns,
+ vector<unsigned> const &maxSizes) const noexcept
+{
+    // All the positions are read from the file and might be arbitrary. The checks are written in
+    //such a way that they cannot overflow
+    uint64_t const nBlocks = (nEntries + blockSize - 1) / blockSize;
+    
+    if (blockIndexPos % 8 != 0 or blockIndexPos > size or (size - blockIndexPos) / 8 < nBlocks)
+        return false;
+    
+    uint64_t const *index = reinterpret_cast<uint64_t const *>(base + blockIndexPos);
+    
+    for (uint64_t block = 0; block < nBlocks; ++block)
+    {
+        uint64_t const blockStart = index[block];
+        uint64_t const nEntriesBlock = min<uint64_t>(blockSize, nEntries - block * blockSize);
+        
+        if (blockStart % 8 != 0 or blockStart > size or (size - blockStart) / 8 < nColumns)
+            return false;
+        
+        uint64_t const *columnPos = reinterpret_cast<uint64_t const *>(base + blockStart);
+        uint64_t const blockLength = size - blockStart;
+        
+        for (unsigned column = 0; column < nColumns; ++column)
+        {
+            // Check the array of offsets
+            uint64_t const pos = columnPos[column];
+            
+            if (pos % 8 != 0 or pos > blockLength or (blockLength - pos) / 4 < nEntriesBlock + 1)
+                return false;
+            
+            uint32_t const *offsets = reinterpret_cast<uint32_t const *>(base + blockStart + pos);
+            
+            if (offsets[0] != 0)
+                return false;
+            
+            for (uint64_t i = 0; i < nEntriesBlock; ++i)
+                if (offsets[i + 1] < offsets[i] or offsets[i + 1] - offsets[i] > maxSizes[column])
+                    return false;
+            
+            
+            // Check that the data fit in the file
+            uint64_t const dataPos = Align8(pos + 4 * (nEntriesBlock + 1));
+            
+            if (dataPos > blockLength or blockLength - dataPos < offsets[nEntriesBlock])
+                return false;
+        }
+    }
+    
+    return true;
+}
+
+
+ColumnCacheWriter::ColumnCacheWriter(string const &path_, ColumnCacheKey const &key_,
+ unsigned blockSize_ /*= 4096*/):
+    path(path_), key(key_), blockSize(blockSize_),
+    filePos(0), failed(false), finished(false),
+    nEntriesBlock(0), nEntriesTotal(0),
+    offsets(key.nColumns), data(key.nColumns)
+{
+    // Use a unique temporary name so that concurrent writers do not interfere
+    tmpPath = path + ".tmp" + to_string(getpid()) + "_" +
+     to_string(hash<thread::id>()(this_thread::get_id()));
+    
+    fd = open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    
+    if (fd < 0)
+    {
+        failed = true;
+        return;
+    }
+    
+    
+    // Reserve space for the header, which is written in Finish
+    vector<char> const placeholder(sizeof(ColumnCache::Header), 0);
+    Write(placeholder.data(), placeholder.size());
+    
+    for (auto &o: offsets)
+        o.push_back(0);
+}
+
+
+ColumnCacheWriter::~ColumnCacheWriter()
+{
+    if (fd >= 0)
+        close(fd);
+    
+    if (not finished)
+        unlink(tmpPath.c_str());
+}
+
+
+void ColumnCacheWriter::Append(unsigned column, void const *data_, unsigned nBytes)
+{
+    if (failed)
+        return;
+    
+    auto &d = data[column];
+    d.insert(d.end(), static_cast<char const *>(data_), static_cast<char const *>(data_) + nBytes);
+    offsets[column].push_back(d.size());
+}
+
+
+void ColumnCacheWriter::EndEntry()
+{
+    if (failed)
+        return;
+    
+    ++nEntriesBlock;
+    ++nEntriesTotal;
+    
+    if (nEntriesBlock == blockSize)
+        FlushBlock();
+}
+
+
+bool ColumnCacheWriter::Finish()
+{
+    if (failed)
+        return false;
+    
+    if (nEntriesBlock > 0)
+        FlushBlock();
+    
+    if (nEntriesTotal != key.nEntries)
+        failed = true;
+    
+    
+    // Write the block index and the header
+    filePos = Align8(filePos);
+    ColumnCache::Header header;
+    memcpy(header.magic, ColumnCache::magic, sizeof(header.magic));
+    header.version = ColumnCache::version;
+    header.blockSize = blockSize;
+    header.key = key;
+    header.blockIndexPos = filePos;
+    
+    if (not failed and (lseek(fd, filePos, SEEK_SET) < 0))
+        failed = true;
+    
+    Write(blockIndex.data(), blockIndex.size() * sizeof(uint64_t));
+    
+    if (not failed and (lseek(fd, 0, SEEK_SET) < 0))
+        failed = true;
+    
+    Write(&header, sizeof(header));
+    
+    
+    // Close the file and move it to the final location
+    if (close(fd) != 0)
+        failed = true;
+    
+    fd = -1;
+    
+    if (failed or rename(tmpPath.c_str(), path.c_str()) != 0)
+    {
+        failed = true;
+        return false;
+    }
+    
+    finished = true;
+    return true;
+}
+
+
+bool ColumnCacheWriter::Failed() const noexcept
+{
+    return failed;
+}
+
+
+void ColumnCacheWriter::FlushBlock()
+{
+    // Compute positions of the columns relative to the start of the block
+    uint64_t const blockStart = Align8(filePos);
+    vector<uint64_t> columnPos(key.nColumns);
+    uint64_t pos = key.nColumns * sizeof(uint64_t);
+    
+    for (unsigned c = 0; c < key.nColumns; ++c)
+    {
+        pos = Align8(pos);
+        columnPos[c] = pos;
+        pos = Align8(pos + offsets[c].size() * sizeof(uint32_t)) + data[c].size();
+    }
+    
+    
+    // Write the block
+    char const zeros[8] = {};
+    
+    if (blockStart > filePos)
+        Write(zeros, blockStart - filePos);
+    
+    Write(columnPos.data(), columnPos.size() * sizeof(uint64_t));
+    
+    for (unsigned c = 0; c < key.nColumns; ++c)
+    {
+        uint64_t const curPos = filePos - blockStart;
+        
+        if (columnPos[c] > curPos)
+            Write(zeros, columnPos[c] - curPos);
+        
+        Write(offsets[c].data(), offsets[c].size() * sizeof(uint32_t));
+        
+        uint64_t const dataPos = Align8(filePos - blockStart);
+        
+        if (dataPos > filePos - blockStart)
+            Write(zeros, dataPos - (filePos - blockStart));
+        
+        Write(data[c].data(), data[c].size());
+    }
+    
+    blockIndex.push_back(blockStart);
+    
+    
+    // Reset the buffers, keeping their capacities
+    for (unsigned c = 0; c < key.nColumns; ++c)
+    {
+        offsets[c].resize(1);
+        data[c].clear();
+    }
+    
+    nEntriesBlock = 0;
+}
+
+
+void ColumnCacheWriter::Write(void const *buffer, size_t nBytes)
+{
+    if (failed)
+        return;
+    
+    char const *p = static_cast<char const *>(buffer);
+    
+    while (nBytes > 0)
+    {
+        ssize_t const n = write(fd, p, nBytes);
+        
+        if (n <= 0)
+        {
+            failed = true;
+            return;
+        }
+        
+        p += n;
+        nBytes -= n;
+        filePos += n;
+    }
+}
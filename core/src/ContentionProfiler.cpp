@@ -0,0 +1,159 @@
+#include <ContentionProfiler.hpp>
+
+#include <Logger.hpp>
+
+#include <stdexcept>
+#include <sstream>
+#include <iomanip>
+
+
+using namespace std;
+using namespace logging;
+
+
+// Definitions of static data members
+atomic<bool> ContentionProfiler::enabled(false);
+array<ContentionProfiler::Counters, ContentionProfiler::nLocks> ContentionProfiler::counters;
+thread_local unsigned long long ContentionProfiler::threadWaitTime = 0;
+
+
+ContentionProfiler::ThreadStats::ThreadStats() noexcept:
+    wallTime(0.), busyTime(0.), lockWaitTime(0.),
+    nFiles(0), nEvents(0)
+{}
+
+
+void ContentionProfiler::Enable(bool enable /*= true*/) noexcept
+{
+    enabled = enable;
+}
+
+
+bool ContentionProfiler::IsEnabled() noexcept
+{
+    return enabled;
+}
+
+
+void ContentionProfiler::Reset() noexcept
+{
+    for (auto &c: counters)
+    {
+        c.nAcquisitions = 0;
+        c.nContended = 0;
+        c.waitTime = 0;
+        c.maxWaitTime = 0;
+    }
+}
+
+
+ContentionProfiler::LockStats ContentionProfiler::GetLockStats(LockID id) noexcept
+{
+    Counters const &c = counters[unsigned(id)];
+    
+    return LockStats{c.nAcquisitions.load(), c.nContended.load(), c.waitTime.load() * 1e-9,
+     c.maxWaitTime.load() * 1e-9};
+}
+
+
+double ContentionProfiler::GetThreadLockWaitTime() noexcept
+{
+    return threadWaitTime * 1e-9;
+}
+
+
+string ContentionProfiler::GetLockName(LockID id)
+{
+    switch (id)
+    {
+        case LockID::Datasets:
+            return "datasets";
+        
+        case LockID::ROOT:
+            return "ROOT";
+        
+        case LockID::Logger:
+            return "logger";
+    }
+    
+    throw logic_error("ContentionProfiler::GetLockName: Unknown lock.");
+}
+
+
+void ContentionProfiler::PrintSummary(double wallTime, vector<ThreadStats> const &threads)
+{
+    // The lines are formatted in separate streams so that the state of the standard output stream
+    //used by the logger is not altered
+    ostringstream ost;
+    ost << fixed;
+    
+    
+    // Summary for the whole run
+    unsigned long nEventsTotal = 0;
+    double busyTimeTotal = 0.;
+    
+    for (auto const &t: threads)
+    {
+        nEventsTotal += t.nEvents;
+        busyTimeTotal += t.busyTime;
+    }
+    
+    ost << setprecision(2) << "Scaling summary: " << threads.size() << " thread(s), wall time " <<
+     wallTime << " s, " << nEventsTotal << " events (" << setprecision(0) <<
+     nEventsTotal / wallTime << " events/s), mean utilisation " << setprecision(1) <<
+     100. * busyTimeTotal / (wallTime * threads.size()) << "%.";
+    logger << ost.str() << eom;
+    
+    
+    // Activity of individual threads. The waiting time is included in the busy time if the lock
+    //was requested while processing a dataset
+    for (unsigned i = 0; i < threads.size(); ++i)
+    {
+        auto const &t = threads[i];
+        
+        ost.str("");
+        ost << setprecision(2) << "  Thread " << i << ": " << t.nFiles << " file(s), " <<
+         t.nEvents << " events, busy " << t.busyTime << " s (" << setprecision(1) <<
+         100. * t.busyTime / wallTime << "%), waiting for locks " << setprecision(3) <<
+         t.lockWaitTime << " s, idle " << setprecision(2) << t.wallTime - t.busyTime << " s.";
+        logger << ost.str() << eom;
+    }
+    
+    
+    // Statistics for the locks
+    for (unsigned l = 0; l < nLocks; ++l)
+    {
+        LockStats const stats = GetLockStats(LockID(l));
+        
+        ost.str("");
+        ost << "  Lock \"" << GetLockName(LockID(l)) << "\": " << stats.nAcquisitions <<
+         " acquisitions, " << stats.nContended << " contended, total wait " << setprecision(3) <<
+         stats.waitTime << " s, maximal wait " << setprecision(1) << stats.maxWaitTime * 1e3 <<
+         " ms.";
+        logger << ost.str() << eom;
+    }
+}
+
+
+void ContentionProfiler::Record(LockID id, chrono::steady_clock::duration const &wait) noexcept
+{
+    unsigned long long const waitNs = chrono::duration_cast<chrono::nanoseconds>(wait).count();
+    Counters &c = counters[unsigned(id)];
+    
+    c.nAcquisitions.fetch_add(1, memory_order_relaxed);
+    c.nContended.fetch_add(1, memory_order_relaxed);
+    c.waitTime.fetch_add(waitNs, memory_order_relaxed);
+    
+    unsigned long long prevMax = c.maxWaitTime.load(memory_order_relaxed);
+    
+    while (waitNs > prevMax and
+     not c.maxWaitTime.compare_exchange_weak(prevMax, waitNs, memory_order_relaxed));
+    
+    threadWaitTime += waitNs;
+}
+
+
+void ContentionProfiler::RecordUncontended(LockID id) noexcept
+{
+    counters[unsigned(id)].nAcquisitions.fetch_add(1, memory_order_relaxed);
+}
@@ -12,9 +12,12 @@ GenParticle::GenParticle():
 {}
 
 
-GenParticle::GenParticle(TLorentzVector const &p4_, int pdgId_ /*= 0*/):
+GenParticle::GenParticle(TLorentzVector const &p4_, int pdgId_ /*= 0*/,
+ Arena *arena /*= nullptr*/):
     Candidate(p4_),
-    pdgId(pdgId_)
+    pdgId(pdgId_),
+    mothers(ArenaAllocator<GenParticle const *>(arena)),
+    daughters(ArenaAllocator<GenParticle const *>(arena))
 {}
 
 
@@ -0,0 +1,444 @@
+#include <HardProcessRecord.hpp>
+
+#include <stdexcept>
+#include <sstream>
+#include <algorithm>
+#include <cstdlib>
+
+
+using namespace std;
+
+
+HardProcessRecord::HardProcessRecord() noexcept
+{
+    firstByPdgId.fill(-1);
+}
+
+
+void HardProcessRecord::Clear() noexcept
+{
+    pdgIds.clear();
+    pts.clear();
+    etas.clear();
+    phis.clear();
+    masses.clear();
+    rawMothers.clear();
+    allIndices.clear();
+    motherOffsets.clear();
+    motherIndices.clear();
+    daughterOffsets.clear();
+    daughterIndices.clear();
+    firstByPdgId.fill(-1);
+    wDecays.clear();
+}
+
+
+void HardProcessRecord::Reserve(unsigned nParticles)
+{
+    pdgIds.reserve(nParticles);
+    pts.reserve(nParticles);
+    etas.reserve(nParticles);
+    phis.reserve(nParticles);
+    masses.reserve(nParticles);
+    rawMothers.reserve(2 * nParticles);
+    allIndices.reserve(nParticles);
+    motherOffsets.reserve(nParticles + 1);
+    motherIndices.reserve(2 * nParticles);
+    daughterOffsets.reserve(nParticles + 1);
+    daughterIndices.reserve(2 * nParticles);
+    wDecays.reserve(nParticles);
+}
+
+
+void HardProcessRecord::AddParticle(int pdgId, float pt, float eta, float phi, float mass,
+ int firstMother, int lastMother)
+{
+    pdgIds.push_back(pdgId);
+    pts.push_back(pt);
+    etas.push_back(eta);
+    phis.push_back(phi);
+    masses.push_back(mass);
+    
+    rawMothers.push_back(firstMother);
+    rawMothers.push_back((lastMother != firstMother) ? lastMother : -1);
+}
+
+
+void HardProcessRecord::Finalize()
+{
+    unsigned const n = pdgIds.size();
+    
+    
+    // Build the list of mothers and count daughters of each particle
+    motherOffsets.assign(1, 0);
+    motherIndices.clear();
+    daughterOffsets.assign(n + 1, 0);
+    
+    for (unsigned i = 0; i < n; ++i)
+    {
+        for (unsigned k = 0; k < 2; ++k)
+        {
+            int const m = rawMothers[2 * i + k];
+            
+            if (m >= 0 and unsigned(m) < n)
+            {
+                motherIndices.push_back(m);
+                ++daughterOffsets[m + 1];
+            }
+        }
+        
+        motherOffsets.push_back(motherIndices.size());
+    }
+    
+    
+    // Convert the numbers of daughters into offsets and fill the daughters. Particles are
+    //visited in the order of increasing index, and so are the daughters of each particle
+    for (unsigned i = 0; i < n; ++i)
+        daughterOffsets[i + 1] += daughterOffsets[i];
+    
+    daughterIndices.resize(daughterOffsets[n]);
+    
+    for (unsigned i = 0; i < n; ++i)
+    {
+        for (unsigned p = motherOffsets[i]; p < motherOffsets[i + 1]; ++p)
+        {
+            unsigned const m = motherIndices[p];
+            daughterIndices[daughterOffsets[m]] = i;
+            ++daughterOffsets[m];
+        }
+    }
+    
+    // The offsets have been shifted by one position while filling the daughters
+    for (unsigned i = n; i > 0; --i)
+        daughterOffsets[i] = daughterOffsets[i - 1];
+    
+    daughterOffsets[0] = 0;
+    
+    
+    // Build the lookup tables
+    allIndices.resize(n);
+    firstByPdgId.fill(-1);
+    wDecays.clear();
+    
+    for (unsigned i = 0; i < n; ++i)
+    {
+        allIndices[i] = i;
+        
+        int const pdgId = pdgIds[i];
+        
+        if (pdgId >= -pdgIdOffset and pdgId < pdgIdOffset and
+         firstByPdgId[pdgId + pdgIdOffset] == -1)
+            firstByPdgId[pdgId + pdgIdOffset] = i;
+        
+        
+        // Decays of W bosons. Copies of a W boson are skipped, and only the last one in the chain
+        //is considered
+        if (abs(pdgId) == 24)
+        {
+            WDecay decay{i, {-1, -1}};
+            unsigned nDaughters = 0;
+            bool isCopy = false;
+            
+            for (unsigned p = daughterOffsets[i]; p < daughterOffsets[i + 1]; ++p)
+            {
+                unsigned const d = daughterIndices[p];
+                
+                if (abs(pdgIds[d]) == 24)
+                {
+                    isCopy = true;
+                    break;
+                }
+                
+                if (nDaughters < 2)
+                {
+                    decay.daughters[nDaughters] = d;
+                    ++nDaughters;
+                }
+            }
+            
+            if (not isCopy and nDaughters > 0)
+                wDecays.push_back(decay);
+        }
+    }
+}
+
+
+unsigned HardProcessRecord::GetNumParticles() const noexcept
+{
+    return pdgIds.size();
+}
+
+
+HardProcessRecord::ParticleView HardProcessRecord::operator[](unsigned index) const noexcept
+{
+    return ParticleView(this, index);
+}
+
+
+HardProcessRecord::ParticleView HardProcessRecord::At(unsigned index) const
+{
+    if (index >= pdgIds.size())
+    {
+        ostringstream ost;
+        ost << "HardProcessRecord::At: Index " << index << " is out of range (the record contains "
+         << pdgIds.size() << " particles).";
+        
+        throw out_of_range(ost.str());
+    }
+    
+    return ParticleView(this, index);
+}
+
+
+HardProcessRecord::ParticleRange HardProcessRecord::GetParticles() const noexcept
+{
+    return ParticleRange(this, allIndices.data(), allIndices.data() + allIndices.size());
+}
+
+
+int HardProcessRecord::GetPdgId(unsigned index) const noexcept
+{
+    return pdgIds[index];
+}
+
+
+TLorentzVector HardProcessRecord::GetP4(unsigned index) const
+{
+    TLorentzVector p4;
+    p4.SetPtEtaPhiM(pts[index], etas[index], phis[index], masses[index]);
+    
+    return p4;
+}
+
+
+int HardProcessRecord::FindFirst(int pdgId) const noexcept
+{
+    if (pdgId >= -pdgIdOffset and pdgId < pdgIdOffset)
+        return firstByPdgId[pdgId + pdgIdOffset];
+    
+    
+    // PDG ID is outside the range of the lookup table
+    auto const res = find(pdgIds.begin(), pdgIds.end(), pdgId);
+    return (res != pdgIds.end()) ? res - pdgIds.begin() : -1;
+}
+
+
+HardProcessRecord::ParticleView HardProcessRecord::GetFirstTop() const noexcept
+{
+    int const iTop = firstByPdgId[6 + pdgIdOffset];
+    int const iAntiTop = firstByPdgId[-6 + pdgIdOffset];
+    
+    if (iTop == -1 and iAntiTop == -1)
+        return ParticleView();
+    
+    if (iTop == -1 or (iAntiTop != -1 and iAntiTop < iTop))
+        return ParticleView(this, iAntiTop);
+    else
+        return ParticleView(this, iTop);
+}
+
+
+vector<HardProcessRecord::WDecay> const &HardProcessRecord::GetWDecays() const noexcept
+{
+    return wDecays;
+}
+
+
+HardProcessRecord::ParticleView::ParticleView() noexcept:
+    record(nullptr), index(0)
+{}
+
+
+HardProcessRecord::ParticleView::ParticleView(HardProcessRecord const *record_, unsigned index_)
+ noexcept:
+    record(record_), index(index_)
+{}
+
+
+HardProcessRecord::ParticleView::operator bool() const noexcept
+{
+    return (record != nullptr);
+}
+
+
+unsigned HardProcessRecord::ParticleView::GetIndex() const noexcept
+{
+    return index;
+}
+
+
+int HardProcessRecord::ParticleView::GetPdgId() const noexcept
+{
+    return record->pdgIds[index];
+}
+
+
+TLorentzVector HardProcessRecord::ParticleView::P4() const
+{
+    return record->GetP4(index);
+}
+
+
+double HardProcessRecord::ParticleView::Pt() const noexcept
+{
+    return record->pts[index];
+}
+
+
+double HardProcessRecord::ParticleView::Eta() const noexcept
+{
+    return record->etas[index];
+}
+
+
+double HardProcessRecord::ParticleView::Phi() const noexcept
+{
+    return record->phis[index];
+}
+
+
+double HardProcessRecord::ParticleView::M() const noexcept
+{
+    return record->masses[index];
+}
+
+
+HardProcessRecord::ParticleRange HardProcessRecord::ParticleView::GetMothers() const noexcept
+{
+    unsigned const *indices = record->motherIndices.data();
+    return ParticleRange(record, indices + record->motherOffsets[index],
+     indices + record->motherOffsets[index + 1]);
+}
+
+
+HardProcessRecord::ParticleView HardProcessRecord::ParticleView::GetFirstMother() const noexcept
+{
+    if (record->motherOffsets[index] == record->motherOffsets[index + 1])
+        return ParticleView();
+    else
+        return ParticleView(record, record->motherIndices[record->motherOffsets[index]]);
+}
+
+
+int HardProcessRecord::ParticleView::GetFirstMotherPdgId() const noexcept
+{
+    ParticleView const mother = GetFirstMother();
+    return (mother) ? mother.GetPdgId() : 0;
+}
+
+
+HardProcessRecord::ParticleRange HardProcessRecord::ParticleView::GetDaughters() const noexcept
+{
+    unsigned const *indices = record->daughterIndices.data();
+    return ParticleRange(record, indices + record->daughterOffsets[index],
+     indices + record->daughterOffsets[index + 1]);
+}
+
+
+HardProcessRecord::ParticleView HardProcessRecord::ParticleView::FindFirstDaughter(
+ initializer_list<int> const &pdgIds) const noexcept
+{
+    for (auto const &d: GetDaughters())
+    {
+        int const pdgId = d.GetPdgId();
+        
+        if (any_of(pdgIds.begin(), pdgIds.end(), [pdgId](int id){return (id == pdgId);}))
+            return d;
+    }
+    
+    return ParticleView();
+}
+
+
+HardProcessRecord::ParticleView HardProcessRecord::ParticleView::FindFirstDaughterRecursive(
+ initializer_list<int> const &pdgIds) const noexcept
+{
+    // First check PDG ID of this particle
+    int const pdgId = GetPdgId();
+    
+    if (any_of(pdgIds.begin(), pdgIds.end(), [pdgId](int id){return (id == pdgId);}))
+        return *this;
+    
+    // If this is not the particle that is being looked for, check all the daughters
+    for (auto const &d: GetDaughters())
+    {
+        ParticleView const p = d.FindFirstDaughterRecursive(pdgIds);
+        
+        if (p)
+            return p;
+    }
+    
+    // If the control reaches this point, no particle with a specified PDG ID has been found
+    return ParticleView();
+}
+
+
+HardProcessRecord::ParticleRange::Iterator::Iterator(HardProcessRecord const *record_,
+ unsigned const *pos_) noexcept:
+    record(record_), pos(pos_)
+{}
+
+
+HardProcessRecord::ParticleView HardProcessRecord::ParticleRange::Iterator::operator*() const
+ noexcept
+{
+    return ParticleView(record, *pos);
+}
+
+
+HardProcessRecord::ParticleRange::Iterator &HardProcessRecord::ParticleRange::Iterator::
+ operator++() noexcept
+{
+    ++pos;
+    return *this;
+}
+
+
+bool HardProcessRecord::ParticleRange::Iterator::operator!=(Iterator const &rhs) const noexcept
+{
+    return (pos != rhs.pos);
+}
+
+
+HardProcessRecord::ParticleRange::ParticleRange(HardProcessRecord const *record_,
+ unsigned const *begin, unsigned const *end) noexcept:
+    record(record_), first(begin), last(end)
+{}
+
+
+HardProcessRecord::ParticleRange::Iterator HardProcessRecord::ParticleRange::begin() const
+ noexcept
+{
+    return Iterator(record, first);
+}
+
+
+HardProcessRecord::ParticleRange::Iterator HardProcessRecord::ParticleRange::end() const noexcept
+{
+    return Iterator(record, last);
+}
+
+
+unsigned HardProcessRecord::ParticleRange::size() const noexcept
+{
+    return last - first;
+}
+
+
+bool HardProcessRecord::ParticleRange::empty() const noexcept
+{
+    return (first == last);
+}
+
+
+HardProcessRecord::ParticleView HardProcessRecord::ParticleRange::operator[](unsigned i) const
+ noexcept
+{
+    return ParticleView(record, first[i]);
+}
+
+
+HardProcessRecord::ParticleView HardProcessRecord::ParticleRange::front() const noexcept
+{
+    return ParticleView(record, *first);
+}
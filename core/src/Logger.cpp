@@ -1,5 +1,7 @@
 #include <Logger.hpp>
 
+#include <ContentionProfiler.hpp>
+
 #include <stdexcept>
 #include <ctime>
 #include <string>
@@ -63,7 +65,7 @@ Logger &Logger::operator<<(_TimeStamp (*)())
 void Logger::VerifyLock()
 {
     // First lock the mutex
-    outputMutex.lock();
+    ContentionProfiler::Acquire(ContentionProfiler::LockID::Logger, outputMutex);
     
     // Check if it has already been locked by the current thread
     if (isLocked)
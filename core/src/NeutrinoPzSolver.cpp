@@ -0,0 +1,150 @@
+#include <NeutrinoPzSolver.hpp>
+
+#include <cmath>
+#include <algorithm>
+
+
+using namespace std;
+
+
+// Definition of static data members
+double const NeutrinoPzSolver::mW = 80.38;
+
+
+double NeutrinoPzSolver::Solve(double lepPx, double lepPy, double lepPz, double lepE,
+ double metPx, double metPy) noexcept
+{
+    double const mW2 = mW * mW;
+    double const lepET2 = lepE * lepE - lepPz * lepPz;
+    
+    
+    // Solve the quadratic equation for the z-component of neutrino momentum
+    double const mu = mW2 / 2 + metPx * lepPx + metPy * lepPy;
+    double const a = mu * lepPz / lepET2;
+    double const b = (lepE * lepE * (metPx * metPx + metPy * metPy) - mu * mu) / lepET2;
+    double const discriminant = a * a - b;
+    
+    if (discriminant > 0.)
+    {
+        double const root = sqrt(discriminant);
+        double const pz1 = a + root, pz2 = a - root;
+        
+        return (fabs(pz1) > fabs(pz2)) ? pz2 : pz1;
+    }
+    
+    
+    // The discriminant is negative. Find the transverse momentum of neutrino that makes it zero
+    //and is the closest to MET. The candidates are given by positive roots of two cubic
+    //equations, which differ in signs of the odd coefficients
+    double const lepPt = sqrt(lepPx * lepPx + lepPy * lepPy);
+    double const lepPt2 = lepPt * lepPt;
+    
+    double const coeffB = -3 * lepPy * mW / lepPt;
+    double const coeffC = mW2 * (2 * lepPy * lepPy) / lepPt2 + mW2 -
+     4 * lepPx * lepPx * lepPx * metPx / lepPt2 - 4 * lepPx * lepPx * lepPy * metPy / lepPt2;
+    double const coeffD = 4 * lepPx * lepPx * mW * metPy / lepPt - lepPy * mW2 * mW / lepPt;
+    
+    double deltaMin = 14000. * 14000.;  // the same initial value as in the original routine
+    bool found = false;
+    double minPx = 0., minPy = 0.;
+    
+    for (int sign: {-1, +1})
+    {
+        double roots[3];
+        unsigned const nRoots = SolveCubic(sign * -coeffB, coeffC, sign * -coeffD, roots);
+        //^ For sign = -1 the coefficients are the original ones
+        
+        for (unsigned i = 0; i < nRoots; ++i)
+        {
+            double const x = roots[i];
+            
+            if (x < 0.)
+                continue;
+            
+            double const px = (x * x - mW2) / (4 * lepPx);
+            double const py = (mW2 * lepPy + 2 * lepPx * lepPy * px + sign * mW * lepPt * x) /
+             (2 * lepPx * lepPx);
+            double const delta2 = (px - metPx) * (px - metPx) + (py - metPy) * (py - metPy);
+            
+            if (delta2 > 0. and delta2 < deltaMin)
+            {
+                deltaMin = delta2;
+                minPx = px;
+                minPy = py;
+                found = true;
+            }
+        }
+    }
+    
+    if (not found)
+        return 0.;
+    
+    
+    // Also consider the point at which the neutrino px is such that the W-boson mass constraint is
+    //trivially satisfied. The expression for py is kept exactly as in the original routine
+    double const zeroValue = -mW2 / (4 * lepPx);
+    double const pyZeroValue = mW2 * lepPx + 2 * lepPx * lepPy * zeroValue;
+    double const delta2ZeroValue = (zeroValue - metPx) * (zeroValue - metPx) +
+     (pyZeroValue - metPy) * (pyZeroValue - metPy);
+    
+    if (delta2ZeroValue < deltaMin)
+    {
+        minPx = zeroValue;
+        minPy = pyZeroValue;
+    }
+    
+    
+    // With the adjusted transverse momentum the discriminant is zero, and the solution is unique
+    double const muMinimum = mW2 / 2 + minPx * lepPx + minPy * lepPy;
+    return muMinimum * lepPz / lepET2;
+}
+
+
+void NeutrinoPzSolver::Solve(unsigned n, double const *lepPx, double const *lepPy,
+ double const *lepPz, double const *lepE, double const *metPx, double const *metPy, double *nuPz)
+ noexcept
+{
+    for (unsigned i = 0; i < n; ++i)
+        nuPz[i] = Solve(lepPx[i], lepPy[i], lepPz[i], lepE[i], metPx[i], metPy[i]);
+}
+
+
+unsigned NeutrinoPzSolver::SolveCubic(double b, double c, double d, double roots[3]) noexcept
+{
+    // Reduce the equation to the depressed form
+    double const q = (3 * c - b * b) / 9;
+    double const r = (9 * b * c - 27 * d - 2 * b * b * b) / 54;
+    double const discriminant = q * q * q + r * r;
+    double const shift = -b / 3;
+    
+    if (discriminant <= 0.)
+    {
+        // There are three real roots. Use the trigonometric form. The argument of acos is clamped
+        //to protect against rounding errors
+        double const sqrtMinusQ = sqrt(-q);
+        double const theta = acos(max(-1., min(1., r / sqrt(-(q * q * q)))));
+        double const cosine = cos(theta / 3), sine = sin(theta / 3);
+        
+        roots[0] = 2 * sqrtMinusQ * cosine + shift;
+        roots[1] = -sqrtMinusQ * cosine + shift - sqrt(3.) * sqrtMinusQ * sine;
+        roots[2] = -sqrtMinusQ * cosine + shift + sqrt(3.) * sqrtMinusQ * sine;
+        
+        return 3;
+    }
+    
+    
+    // There is a single real root. The complex conjugate pair is accepted if only it is almost
+    //degenerate, as in the original routine
+    double const sqrtDiscriminant = sqrt(discriminant);
+    double const s = cbrt(r + sqrtDiscriminant), t = cbrt(r - sqrtDiscriminant);
+    
+    roots[0] = s + t + shift;
+    
+    if (fabs(s - t) * sqrt(3.) / 2 < 1e-4)
+    {
+        roots[1] = roots[2] = -0.5 * (s + t) + shift;
+        return 3;
+    }
+    
+    return 1;
+}
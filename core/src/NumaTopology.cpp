@@ -0,0 +1,151 @@
+#include <NumaTopology.hpp>
+
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <thread>
+#include <stdexcept>
+
+#ifdef __linux__
+#include <sched.h>
+#include <pthread.h>
+#endif
+
+
+using namespace std;
+
+
+NumaTopology::NumaTopology()
+{
+    vector<unsigned> const allowedCPUs(GetAllowedCPUs());
+    
+    
+    // Read the CPUs of each node. The nodes are numbered consecutively in the sysfs, but a node
+    //with no CPUs or with only disallowed CPUs is skipped
+    for (unsigned node = 0; ; ++node)
+    {
+        ostringstream path;
+        path << "/sys/devices/system/node/node" << node << "/cpulist";
+        ifstream cpuListFile(path.str());
+        
+        if (not cpuListFile)
+            break;
+        
+        string cpuList;
+        getline(cpuListFile, cpuList);
+        
+        vector<unsigned> cpus;
+        
+        for (unsigned const cpu: ParseCPUList(cpuList))
+        {
+            if (binary_search(allowedCPUs.begin(), allowedCPUs.end(), cpu))
+                cpus.push_back(cpu);
+        }
+        
+        if (not cpus.empty())
+            nodes.emplace_back(move(cpus));
+    }
+    
+    
+    // Fall back to a single node if the layout is not available
+    if (nodes.empty())
+        nodes.emplace_back(allowedCPUs);
+}
+
+
+unsigned NumaTopology::GetNumNodes() const noexcept
+{
+    return nodes.size();
+}
+
+
+vector<unsigned> const &NumaTopology::GetCPUs(unsigned node) const
+{
+    if (node >= nodes.size())
+        throw out_of_range("NumaTopology::GetCPUs: Node index is out of range.");
+    
+    return nodes[node];
+}
+
+
+unsigned NumaTopology::GetNumCPUs() const noexcept
+{
+    unsigned n = 0;
+    
+    for (auto const &cpus: nodes)
+        n += cpus.size();
+    
+    return n;
+}
+
+
+bool NumaTopology::PinCurrentThread(unsigned cpu) noexcept
+{
+#ifdef __linux__
+    if (cpu >= CPU_SETSIZE)
+        return false;
+    
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    CPU_SET(cpu, &cpuSet);
+    
+    return (pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet) == 0);
+#else
+    return false;
+#endif
+}
+
+
+vector<unsigned> NumaTopology::ParseCPUList(string const &list)
+{
+    vector<unsigned> cpus;
+    istringstream ist(list);
+    string range;
+    
+    while (getline(ist, range, ','))
+    {
+        if (range.empty())
+            continue;
+        
+        auto const dashPos = range.find('-');
+        unsigned const first = stoul(range.substr(0, dashPos));
+        unsigned const last = (dashPos == string::npos) ? first : stoul(range.substr(dashPos + 1));
+        
+        for (unsigned cpu = first; cpu <= last; ++cpu)
+            cpus.push_back(cpu);
+    }
+    
+    return cpus;
+}
+
+
+vector<unsigned> NumaTopology::GetAllowedCPUs()
+{
+    vector<unsigned> cpus;
+    
+#ifdef __linux__
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    
+    if (sched_getaffinity(0, sizeof(cpuSet), &cpuSet) == 0)
+    {
+        for (unsigned cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+        {
+            if (CPU_ISSET(cpu, &cpuSet))
+                cpus.push_back(cpu);
+        }
+    }
+#endif
+    
+    
+    // If the affinity mask is not available, assume all the CPUs can be used
+    if (cpus.empty())
+    {
+        unsigned const nCPUs = max(thread::hardware_concurrency(), 1u);
+        
+        for (unsigned cpu = 0; cpu < nCPUs; ++cpu)
+            cpus.push_back(cpu);
+    }
+    
+    return cpus;
+}
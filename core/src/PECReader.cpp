@@ -2,8 +2,7 @@
 
 #include <PECReaderConfig.hpp>
 
-#include <CalculatePzNu.hpp>
-#include <ROOTLock.hpp>
+#include <NeutrinoPzSolver.hpp>
 #include <Logger.hpp>
 
 #include <TVector3.h>
@@ -13,6 +12,7 @@
 #include <iostream>
 #include <algorithm>
 #include <stdexcept>
+#include <sys/stat.h>
 
 
 using namespace std;
@@ -21,17 +21,33 @@ using namespace logging;
 
 // Definition of a static data member
 unsigned const PECReader::maxSize;
+long long const PECReader::treeCacheSize;
 
 
 PECReader::PECReader(Dataset const &dataset_):
     dataset(dataset_),
-    isInitialized(false),
-    triggerSelection(nullptr), eventSelection(nullptr),
+    isInitialized(false), mcWarningsIssued(false),
+    triggerSelection(nullptr), eventSelection(nullptr), bTagger(nullptr),
     bTagReweighter(nullptr), puReweighter(nullptr),
     readHardParticles(false), readGenJets(false), readPartonShower(false),
+    useColumnCache(false),
     sourceFile(nullptr),
-    eventIDTree(nullptr), triggerTree(nullptr), generalTree(nullptr)
-{}
+    curEventEntry(0),
+    curMetIndex(1), neutrinoBuilt(false),
+    hardProcessBuilt(false), hardParticlesBuilt(false), genJetsBuilt(false),
+    psPartonsBuilt(false)
+{
+    // Reserve the collections of physics objects for the maximal number of objects that can be
+    //read from the buffers so that they are never reallocated in the event loop
+    tightLeptons.reserve(2 * maxSize);
+    looseLeptons.reserve(2 * maxSize);
+    goodJets.reserve(maxSize);
+    additionalJets.reserve(maxSize);
+    hardProcess.Reserve(maxSize);
+    hardParticles.reserve(maxSize);
+    genJets.reserve(maxSize);
+    psPartons.reserve(maxSize);
+}
 
 
 PECReader::PECReader(Dataset const &dataset, PECReaderConfig const &config):
@@ -41,6 +57,12 @@ PECReader::PECReader(Dataset const &dataset, PECReaderConfig const &config):
 }
 
 
+PECReader::~PECReader()
+{
+    CloseSourceFile();
+}
+
+
 void PECReader::Configure(PECReaderConfig const &config)
 {
     if (config.IsSetTriggerSelection())
@@ -49,6 +71,9 @@ void PECReader::Configure(PECReaderConfig const &config)
     if (config.IsSetEventSelection())
         SetEventSelection(config.GetEventSelection());
     
+    if (config.IsSetBTagger())
+        SetBTagger(config.GetBTagger());
+    
     if (config.IsSetBTagReweighter())
         SetBTagReweighter(config.GetBTagReweighter());
     
@@ -59,6 +84,19 @@ void PECReader::Configure(PECReaderConfig const &config)
     SetReadGenJets(config.GetReadGenJets());
     SetReadPartonShower(config.GetReadPartonShower());
     SetSystematics(config.GetSystematics());
+    SetColumnCache(config.GetColumnCache(), config.GetColumnCacheDirectory());
+}
+
+
+void PECReader::SetDataset(Dataset const &dataset_)
+{
+    CloseSourceFile();
+    dataset = dataset_;
+    
+    // The iterator to the current file refers to the old dataset and must be reset. It will be
+    //done in Initialize, which is called when the first file is requested
+    if (isInitialized)
+        sourceFileIt = dataset.GetFiles().begin();
 }
 
 
@@ -74,6 +112,25 @@ void PECReader::SetEventSelection(EventSelectionInterface const *eventSelection_
 }
 
 
+void PECReader::AddEventFilter(EventFilterStage stage, EventFilter const &filter)
+{
+    eventFilters.at(unsigned(stage)).push_back(filter);
+}
+
+
+void PECReader::ClearEventFilters() noexcept
+{
+    for (auto &filters: eventFilters)
+        filters.clear();
+}
+
+
+void PECReader::SetBTagger(BTagger const *bTagger_)
+{
+    bTagger = bTagger_;
+}
+
+
 void PECReader::SetBTagReweighter(WeightBTagInterface *bTagReweighter_)
 {
     bTagReweighter = bTagReweighter_;
@@ -116,6 +173,16 @@ void PECReader::SetSystematics(SystVariation const &syst_)
 }
 
 
+void PECReader::SetColumnCache(bool enable, string const &directory /*= ""*/)
+{
+    useColumnCache = enable;
+    columnCacheDirectory = directory;
+    
+    if (not columnCacheDirectory.empty() and columnCacheDirectory.back() != '/')
+        columnCacheDirectory += '/';
+}
+
+
 bool PECReader::NextSourceFile()
 {
     // Perform initialization
@@ -123,6 +190,24 @@ bool PECReader::NextSourceFile()
         Initialize();
     
     
+    // Warnings specific to simulation are printed for the first simulated dataset only, which
+    //might not be the first dataset if this object has been rebound
+    if (dataset.IsMC() and not mcWarningsIssued)
+    {
+        if (not bTagReweighter)
+            logger << "Warning in PECReader::NextSourceFile: No object to propagate b-tagging " <<
+             "scale factors has been specified. Simulation will not be reweighted for this " <<
+             "effect." << eom;
+        
+        if (not puReweighter)
+            logger << "Warning in PECReader::NextSourceFile: No object to reweight simulation " <<
+             "for pile-up has been specified. Simulation will not be reweighted for this effect." <<
+             eom;
+        
+        mcWarningsIssued = true;
+    }
+    
+    
     // Close the currently opened file
     CloseSourceFile();
     
@@ -151,51 +236,71 @@ bool PECReader::NextEvent()
     
     while (true)
     {
-        if (curEventTree == nEventsTree)  // there are no more events in the source files
+        if (treeReader.AtEnd())  // there are no more events in the source files
             return false;
         
         
-        // Read the event ID
-        eventIDTree->GetEntry(curEventTree);
-        eventID.Set(runNumber, lumiSection, eventNumber);
+        // Read the event ID unless the trigger selection does not need it. In the latter case the
+        //ID is only read for events that pass the trigger, and the trigger branches are the first
+        //ones to be touched
+        bool const readIDFirst = (not triggerSelection or triggerSelection->RequiresEventID());
+        
+        if (readIDFirst)
+        {
+            treeReader.ReadGroup(unsigned(TreeGroup::EventID));
+            eventID.Set(runNumber, lumiSection, eventNumber);
+        }
         
         
-        // Update the event in the trigger-selection object and check if it passes the selection
+        // Update the event in the trigger-selection object and check if it passes the selection.
+        //The trigger tree is read by the trigger-selection object at the common cursor
         if (triggerSelection)
         {
-            triggerSelection->ReadNextEvent(eventID);
+            treeReader.ReadGroup(unsigned(TreeGroup::Trigger));
+            triggerSelection->ReadEvent(treeReader.GetCurrentEntry(), eventID);
             
             if (not triggerSelection->PassTrigger())
             {
-                ++curEventTree;
+                treeReader.NextEntry();
                 continue;
             }
         }
         
+        if (not readIDFirst)
+        {
+            treeReader.ReadGroup(unsigned(TreeGroup::EventID));
+            eventID.Set(runNumber, lumiSection, eventNumber);
+        }
+        
+        
+        // Apply the additional filters that only need the event ID
+        if (not PassEventFilters(EventFilterStage::EventID))
+        {
+            treeReader.NextEntry();
+            continue;
+        }
         
-        // Read the rest of event
-        generalTree->GetEntry(curEventTree);
         
+        // Read the rest of event. The generator-level information is read only when it is
+        //requested for the first time
+        treeReader.ReadGroup(unsigned(TreeGroup::General));
         
-        ++curEventTree;
+        curEventEntry = treeReader.GetCurrentEntry();
+        treeReader.NextEntry();
+        
+        // The generator-level collections built on demand belong to the previous entry. They
+        //are invalidated before the event selection and the weights, which might request them
+        hardProcessBuilt = false;
+        hardParticlesBuilt = false;
+        genJetsBuilt = false;
+        psPartonsBuilt = false;
         
         if (BuildAndSelectEvent())  // an appropriate event has been read
         {
             CalculateEventWeights();
             
             if (weightCentral not_eq 0.)
-            {
-                if (readHardParticles)
-                    ParseHardInteraction();
-                
-                if (readGenJets and dataset.IsMC())
-                    BuildGenJets();
-                
-                if (readPartonShower and dataset.IsMC())
-                    ReadPartonShower();
-                
                 break;
-            }
         }
     }
     
@@ -233,8 +338,21 @@ Candidate const &PECReader::GetMET() const
 }
 
 
+bool PECReader::PassEventFilters(EventFilterStage stage) const
+{
+    for (auto const &filter: eventFilters[unsigned(stage)])
+        if (not filter(*this))
+            return false;
+    
+    return true;
+}
+
+
 Candidate const &PECReader::GetNeutrino() const
 {
+    if (not neutrinoBuilt)
+        BuildNeutrino();
+    
     return neutrino;
 }
 
@@ -287,10 +405,32 @@ vector<GenParticle> const &PECReader::GetHardGenParticles() const
          "generator particles associated to the hard interaction, this functionality must first "
          "be requested via PECReader::SetReadHardInteraction.");
     
+    if (not hardParticlesBuilt)
+    {
+        if (not hardProcessBuilt)
+            ParseHardInteraction();
+        
+        BuildHardGenParticles();
+    }
+    
     return hardParticles;
 }
 
 
+HardProcessRecord const &PECReader::GetHardProcessRecord() const
+{
+    if (not readHardParticles)
+        throw runtime_error("PECReader::GetHardProcessRecord: In order to access the record of "
+         "generator particles associated to the hard interaction, this functionality must first "
+         "be requested via PECReader::SetReadHardInteraction.");
+    
+    if (not hardProcessBuilt)
+        ParseHardInteraction();
+    
+    return hardProcess;
+}
+
+
 vector<GenJet> const &PECReader::GetGenJets() const
 {
     if (not readGenJets)
@@ -301,6 +441,9 @@ vector<GenJet> const &PECReader::GetGenJets() const
         throw runtime_error("PECReader::GetGenJets: Trying to get generatol-level jets in a "
          "real collision event.");
     
+    if (not genJetsBuilt)
+        BuildGenJets();
+    
     return genJets;
 }
 
@@ -315,10 +458,37 @@ vector<ShowerParton> const &PECReader::GetShowerPartons() const
         throw runtime_error("PECReader::GetShowerPartons: Trying to read partons from parton "
          "shower  for a real collision event.");
     
+    if (not psPartonsBuilt)
+        ReadPartonShower();
+    
     return psPartons;
 }
 
 
+unsigned long PECReader::GetNumEntriesSourceFile() const noexcept
+{
+    return (sourceFile) ? treeReader.GetEntries() : 0;
+}
+
+
+unsigned long PECReader::GetNumEntriesReadSourceFile() const noexcept
+{
+    return (sourceFile) ? treeReader.GetCurrentEntry() : 0;
+}
+
+
+long long PECReader::GetBytesReadSourceFile() const noexcept
+{
+    return (sourceFile) ? sourceFile->GetBytesRead() : 0;
+}
+
+
+unsigned long long PECReader::GetNumBranchReadsSourceFile() const noexcept
+{
+    return (sourceFile) ? treeReader.GetNumBranchReads() : 0;
+}
+
+
 void PECReader::Initialize()
 {
     // Verify that all the needed configuration modules have been specified
@@ -329,19 +499,6 @@ void PECReader::Initialize()
     if (not eventSelection)
         logger << "Warning in PECReader::Initialize: No event selection has been specified." << eom;
     
-    if (dataset.IsMC())
-    {
-        if (not bTagReweighter)
-            logger << "Warning in PECReader::Initialize: No object to propagate b-tagging scale " <<
-             "factors has been specified. Simulation will not be reweighted for this effect." <<
-             eom;
-        
-        if (not puReweighter)
-            logger << "Warning in PECReader::Initialize: No object to reweight simulation for " <<
-             "pile-up has been specified. Simulation will not be reweighted for this effect." <<
-             eom;
-    }
-    
     
     // Perform remaining initialization
     sourceFileIt = dataset.GetFiles().begin();
@@ -361,10 +518,9 @@ void PECReader::OpenSourceFile()
         weightCrossSection = 1.;
     
     
-    // Start of a critical ROOT block
-    ROOTLock::Lock();
-    
-    // Open the source file
+    // Open the source file. The file and its trees are owned by this object and are only accessed
+    //from the current thread; therefore, with the thread-safety mode of ROOT activated by
+    //RunManager, no global lock is needed
     sourceFile = TFile::Open(sourceFileIt->name.c_str());
     
     if (not sourceFile)
@@ -372,162 +528,154 @@ void PECReader::OpenSourceFile()
          "\" does not exist or is not a valid ROOT file.");
     
     
-    // Get the trees
-    eventIDTree = dynamic_cast<TTree *>(sourceFile->Get("eventContent/EventID"));
+    // Get the trees. They are read as a single source with a common cursor; the trees that used
+    //to be friends of the general tree are registered separately so that no index lookup is
+    //needed to read an entry
+    auto getTree = [this](string const &name)
+    {
+        return dynamic_cast<TTree *>(sourceFile->Get(name.c_str()));
+    };
+    
+    treeReader.AddTree(getTree("eventContent/EventID"), "eventContent/EventID",
+     unsigned(TreeGroup::EventID));
     
     if (triggerSelection)
     {
-        triggerTree = dynamic_cast<TTree *>(sourceFile->Get("trigger/TriggerInfo"));
+        TTree *triggerTree = getTree("trigger/TriggerInfo");
+        treeReader.AddTree(triggerTree, "trigger/TriggerInfo", unsigned(TreeGroup::Trigger));
         triggerSelection->UpdateTree(triggerTree, not dataset.IsMC());
     }
     
-    generalTree = dynamic_cast<TTree *>(sourceFile->Get("eventContent/BasicInfo"));
-    //generalTree->AddFriend("eventContent/IntegralProperties");
-    generalTree->AddFriend("eventContent/BasicInfo");
-    generalTree->AddFriend("eventContent/PUInfo");
+    treeReader.AddTree(getTree("eventContent/BasicInfo"), "eventContent/BasicInfo",
+     unsigned(TreeGroup::General));
+    treeReader.AddTree(getTree("eventContent/PUInfo"), "eventContent/PUInfo",
+     unsigned(TreeGroup::General));
     
     
-    // Add the MC-truth information and MC weights
+    // Add the MC-truth information
     if (dataset.IsMC())
     {
-        generalTree->AddFriend("eventContent/GeneratorInfo");
+        treeReader.AddTree(getTree("eventContent/GeneratorInfo"), "eventContent/GeneratorInfo",
+         unsigned(TreeGroup::General));
         
         if (readGenJets)
-            generalTree->AddFriend("genJets/GenJets");
+            treeReader.AddTree(getTree("genJets/GenJets"), "genJets/GenJets",
+             unsigned(TreeGroup::GenJets));
         
         if (readPartonShower)
-            generalTree->AddFriend("heavyFlavours/PartonShowerInfo");
-        
-        /*
-        // Determine name of the corresponding file with weights
-        string weightsFileName;
+            treeReader.AddTree(getTree("heavyFlavours/PartonShowerInfo"),
+             "heavyFlavours/PartonShowerInfo", unsigned(TreeGroup::PartonShower));
         
-        if (config.IsSetWeightFilesLocation())
-            weightsFileName = config.GetWeightFilesLocation() + sourceFileIt->GetBaseName() +
-             "_weights.root";
-        else
-            weightsFileName = sourceFileIt->name.substr(0,
-             sourceFileIt->name.find_last_of('.')) + "_weights.root";
-        
-        // Add trees from the file with weights
-        generalTree->AddFriend(config.GetPileUpTreeName().c_str(), weightsFileName.c_str());
-        */
+        //^ Trees with weights stored in a separate file (e.g. for pile-up) can be registered in
+        //the same way after the file is opened
     }
     
-    // The file is opened, all the trees are got. Can end the ROOT critical block
-    ROOTLock::Unlock();
-    
-    
-    // Initialize the counters
-    nEventsTree = generalTree->GetEntries();  // all the trees have the same number of events
-    curEventTree = 0;
-    
     
     // Assign the branches to read
-    eventIDTree->SetBranchAddress("run", &runNumber);
-    eventIDTree->SetBranchAddress("lumi", &lumiSection);
-    eventIDTree->SetBranchAddress("event", &eventNumber);
-    
-    generalTree->SetBranchAddress("eleSize", &eleSize);
-    generalTree->SetBranchAddress("elePt", elePt);
-    generalTree->SetBranchAddress("eleEta", eleEta);
-    generalTree->SetBranchAddress("elePhi", elePhi);
-    generalTree->SetBranchAddress("eleRelIso", eleRelIso);
-    generalTree->SetBranchAddress("eleDB", eleDB);
-    generalTree->SetBranchAddress("eleTriggerPreselection", eleTriggerPreselection);
-    generalTree->SetBranchAddress("eleMVAID", eleMVAID);
-    generalTree->SetBranchAddress("elePassConversion", elePassConversion);
-    generalTree->SetBranchAddress("eleSelectionA", eleQuality);
-    generalTree->SetBranchAddress("eleCharge", eleCharge);
-    
-    generalTree->SetBranchAddress("muSize", &muSize);
-    generalTree->SetBranchAddress("muPt", muPt);
-    generalTree->SetBranchAddress("muEta", muEta);
-    generalTree->SetBranchAddress("muPhi", muPhi);
-    generalTree->SetBranchAddress("muRelIso", muRelIso);
-    generalTree->SetBranchAddress("muDB", muDB);
-    generalTree->SetBranchAddress("muQualityTight", muQualityTight);
-    generalTree->SetBranchAddress("muCharge", muCharge);
-    
-    generalTree->SetBranchAddress("jetSize", &jetSize);
-    generalTree->SetBranchAddress("jetPt", jetPt);
-    generalTree->SetBranchAddress("jetEta", jetEta);
-    generalTree->SetBranchAddress("jetPhi", jetPhi);
-    generalTree->SetBranchAddress("jetMass", jetMass);
+    treeReader.SetBranchAddress("run", &runNumber);
+    treeReader.SetBranchAddress("lumi", &lumiSection);
+    treeReader.SetBranchAddress("event", &eventNumber);
+    
+    treeReader.SetBranchAddress("eleSize", &eleSize);
+    treeReader.SetBranchAddress("elePt", elePt, eleSize);
+    treeReader.SetBranchAddress("eleEta", eleEta, eleSize);
+    treeReader.SetBranchAddress("elePhi", elePhi, eleSize);
+    treeReader.SetBranchAddress("eleRelIso", eleRelIso, eleSize);
+    treeReader.SetBranchAddress("eleDB", eleDB, eleSize);
+    treeReader.SetBranchAddress("eleTriggerPreselection", eleTriggerPreselection, eleSize);
+    treeReader.SetBranchAddress("eleMVAID", eleMVAID, eleSize);
+    treeReader.SetBranchAddress("elePassConversion", elePassConversion, eleSize);
+    treeReader.SetBranchAddress("eleSelectionA", eleQuality, eleSize);
+    treeReader.SetBranchAddress("eleCharge", eleCharge, eleSize);
+    
+    treeReader.SetBranchAddress("muSize", &muSize);
+    treeReader.SetBranchAddress("muPt", muPt, muSize);
+    treeReader.SetBranchAddress("muEta", muEta, muSize);
+    treeReader.SetBranchAddress("muPhi", muPhi, muSize);
+    treeReader.SetBranchAddress("muRelIso", muRelIso, muSize);
+    treeReader.SetBranchAddress("muDB", muDB, muSize);
+    treeReader.SetBranchAddress("muQualityTight", muQualityTight, muSize);
+    treeReader.SetBranchAddress("muCharge", muCharge, muSize);
+    
+    treeReader.SetBranchAddress("jetSize", &jetSize);
+    treeReader.SetBranchAddress("jetPt", jetPt, jetSize);
+    treeReader.SetBranchAddress("jetEta", jetEta, jetSize);
+    treeReader.SetBranchAddress("jetPhi", jetPhi, jetSize);
+    treeReader.SetBranchAddress("jetMass", jetMass, jetSize);
     
     if (dataset.IsMC() and syst.type == SystTypeAlgo::JER)
     {
         if (syst.direction > 0)
-            generalTree->SetBranchAddress("jerFactorUp", jerFactor);
+            treeReader.SetBranchAddress("jerFactorUp", jerFactor, jetSize);
         else
-            generalTree->SetBranchAddress("jerFactorDown", jerFactor);
+            treeReader.SetBranchAddress("jerFactorDown", jerFactor, jetSize);
     }
     
     /*
-    generalTree->SetBranchAddress("softJetPt", &softJetPt);
-    generalTree->SetBranchAddress("softJetEta", &softJetEta);
-    generalTree->SetBranchAddress("softJetPhi", &softJetPhi);
-    generalTree->SetBranchAddress("softJetMass", &softJetMass);
-    generalTree->SetBranchAddress("softJetHt", &softJetHt);
+    treeReader.SetBranchAddress("softJetPt", &softJetPt);
+    treeReader.SetBranchAddress("softJetEta", &softJetEta);
+    treeReader.SetBranchAddress("softJetPhi", &softJetPhi);
+    treeReader.SetBranchAddress("softJetMass", &softJetMass);
+    treeReader.SetBranchAddress("softJetHt", &softJetHt);
     
     if (dataset.IsMC() and syst.type == SystTypeAlgo::JER)
     {
         if (systDir > 0)
         {
-            generalTree->SetBranchAddress("softJetPtJERUp", &softJetPt);
-            generalTree->SetBranchAddress("softJetEtaJERUp", &softJetEta);
-            generalTree->SetBranchAddress("softJetPhiJERUp", &softJetPhi);
-            generalTree->SetBranchAddress("softJetMassJERUp", &softJetMass);
-            generalTree->SetBranchAddress("softJetHtJERUp", &softJetHt);
+            treeReader.SetBranchAddress("softJetPtJERUp", &softJetPt);
+            treeReader.SetBranchAddress("softJetEtaJERUp", &softJetEta);
+            treeReader.SetBranchAddress("softJetPhiJERUp", &softJetPhi);
+            treeReader.SetBranchAddress("softJetMassJERUp", &softJetMass);
+            treeReader.SetBranchAddress("softJetHtJERUp", &softJetHt);
         }
         else
         {
-            generalTree->SetBranchAddress("softJetPtJERDown", &softJetPt);
-            generalTree->SetBranchAddress("softJetEtaJERDown", &softJetEta);
-            generalTree->SetBranchAddress("softJetPhiJERDown", &softJetPhi);
-            generalTree->SetBranchAddress("softJetMassJERDown", &softJetMass);
-            generalTree->SetBranchAddress("softJetHtJERDown", &softJetHt);
+            treeReader.SetBranchAddress("softJetPtJERDown", &softJetPt);
+            treeReader.SetBranchAddress("softJetEtaJERDown", &softJetEta);
+            treeReader.SetBranchAddress("softJetPhiJERDown", &softJetPhi);
+            treeReader.SetBranchAddress("softJetMassJERDown", &softJetMass);
+            treeReader.SetBranchAddress("softJetHtJERDown", &softJetHt);
         }
     */
     
-    generalTree->SetBranchAddress("jetCSV", jetCSV);
-    generalTree->SetBranchAddress("jetTCHP", jetTCHP);
+    treeReader.SetBranchAddress("jetCSV", jetCSV, jetSize);
+    treeReader.SetBranchAddress("jetTCHP", jetTCHP, jetSize);
     
-    generalTree->SetBranchAddress("jetCharge", jetCharge);
-    generalTree->SetBranchAddress("jetPullAngle", jetPullAngle);
+    treeReader.SetBranchAddress("jetCharge", jetCharge, jetSize);
+    treeReader.SetBranchAddress("jetPullAngle", jetPullAngle, jetSize);
     
-    generalTree->SetBranchAddress("metSize", &metSize);
-    generalTree->SetBranchAddress("metPt", metPt);
-    generalTree->SetBranchAddress("metPhi", metPhi);
+    treeReader.SetBranchAddress("metSize", &metSize);
+    treeReader.SetBranchAddress("metPt", metPt, metSize);
+    treeReader.SetBranchAddress("metPhi", metPhi, metSize);
     
-    generalTree->SetBranchAddress("pvSize", &pvSize);
-    generalTree->SetBranchAddress("rho", &puRho);
+    treeReader.SetBranchAddress("pvSize", &pvSize);
+    treeReader.SetBranchAddress("rho", &puRho);
     
     
     if (dataset.IsMC())
     {
-        generalTree->SetBranchAddress("jetFlavour", jetFlavour);
-        generalTree->SetBranchAddress("processID", &processID);
+        treeReader.SetBranchAddress("jetFlavour", jetFlavour, jetSize);
+        treeReader.SetBranchAddress("processID", &processID);
         
         // Some systematics is encoded in weights only. These are added to the central samples only
         /*
         if (syst == Systematics::None)
         {
-            generalTree->SetBranchAddress("PDF.nVars", &nWeight_PDF);
-            generalTree->SetBranchAddress("PDF.up", weight_PDFUp);
+            treeReader.SetBranchAddress("PDF.nVars", &nWeight_PDF);
+            treeReader.SetBranchAddress("PDF.up", weight_PDFUp);
         }
         */
         
         if (syst.type == SystTypeAlgo::JEC)
         {
-            generalTree->SetBranchAddress("jecUncertainty", jecUncertainty);
+            treeReader.SetBranchAddress("jecUncertainty", jecUncertainty, jetSize);
             
             /*
-            generalTree->SetBranchAddress("softJetPtJECUnc", &softJetPtJECUnc);
-            generalTree->SetBranchAddress("softJetEtaJECUnc", &softJetEtaJECUnc);
-            generalTree->SetBranchAddress("softJetPhiJECUnc", &softJetPhiJECUnc);
-            generalTree->SetBranchAddress("softJetMassJECUnc", &softJetMassJECUnc);
-            generalTree->SetBranchAddress("softJetHtJECUnc", &softJetHtJECUnc);
+            treeReader.SetBranchAddress("softJetPtJECUnc", &softJetPtJECUnc);
+            treeReader.SetBranchAddress("softJetEtaJECUnc", &softJetEtaJECUnc);
+            treeReader.SetBranchAddress("softJetPhiJECUnc", &softJetPhiJECUnc);
+            treeReader.SetBranchAddress("softJetMassJECUnc", &softJetMassJECUnc);
+            treeReader.SetBranchAddress("softJetHtJECUnc", &softJetHtJECUnc);
             */
         }
         
@@ -535,62 +683,91 @@ void PECReader::OpenSourceFile()
         // Generator jets
         if (readGenJets)
         {
-            generalTree->SetBranchAddress("genJets/GenJets.jetSize", &genJetSize);
-            generalTree->SetBranchAddress("genJets/GenJets.jetPt", &genJetPt);
-            generalTree->SetBranchAddress("genJets/GenJets.jetEta", &genJetEta);
-            generalTree->SetBranchAddress("genJets/GenJets.jetPhi", &genJetPhi);
-            generalTree->SetBranchAddress("genJets/GenJets.jetMass", &genJetMass);
-            //generalTree->SetBranchAddress("genJets/GenJets.bMult", &genJetBMult);
-            //generalTree->SetBranchAddress("genJets/GenJets.cMult", &genJetCMult);
+            treeReader.SetBranchAddress("genJets/GenJets.jetSize", &genJetSize);
+            treeReader.SetBranchAddress("genJets/GenJets.jetPt", genJetPt, genJetSize);
+            treeReader.SetBranchAddress("genJets/GenJets.jetEta", genJetEta, genJetSize);
+            treeReader.SetBranchAddress("genJets/GenJets.jetPhi", genJetPhi, genJetSize);
+            treeReader.SetBranchAddress("genJets/GenJets.jetMass", genJetMass, genJetSize);
+            //treeReader.SetBranchAddress("genJets/GenJets.bMult", &genJetBMult);
+            //treeReader.SetBranchAddress("genJets/GenJets.cMult", &genJetCMult);
         }
         
         
         // Partons from parton shower
         if (readPartonShower)
         {
-            generalTree->SetBranchAddress("psSize", &psSize);
-            generalTree->SetBranchAddress("psPdgId", psPdgId);
-            generalTree->SetBranchAddress("psOrigin", psOrigin);
-            generalTree->SetBranchAddress("psPt", psPt);
-            generalTree->SetBranchAddress("psEta", psEta);
-            generalTree->SetBranchAddress("psPhi", psPhi);
+            treeReader.SetBranchAddress("psSize", &psSize);
+            treeReader.SetBranchAddress("psPdgId", psPdgId, psSize);
+            treeReader.SetBranchAddress("psOrigin", psOrigin, psSize);
+            treeReader.SetBranchAddress("psPt", psPt, psSize);
+            treeReader.SetBranchAddress("psEta", psEta, psSize);
+            treeReader.SetBranchAddress("psPhi", psPhi, psSize);
         }
         
         
         // Pile-up information
-        generalTree->SetBranchAddress("puTrueNumInteractions", &puTrueNumInteractions);
+        treeReader.SetBranchAddress("puTrueNumInteractions", &puTrueNumInteractions);
     }
     
     if (dataset.IsMC() and readHardParticles)
     {
-        generalTree->SetBranchAddress("hardPartSize", &hardPartSize);
-        generalTree->SetBranchAddress("hardPartPdgId", hardPartPdgId);
-        generalTree->SetBranchAddress("hardPartFirstMother", hardPartFirstMother);
-        generalTree->SetBranchAddress("hardPartLastMother", hardPartLastMother);
-        generalTree->SetBranchAddress("hardPartPt", hardPartPt);
-        generalTree->SetBranchAddress("hardPartEta", hardPartEta);
-        generalTree->SetBranchAddress("hardPartPhi", hardPartPhi);
-        generalTree->SetBranchAddress("hardPartMass", hardPartMass);
+        // The branches share the tree with the ones needed for every event but are only read on
+        //demand
+        unsigned const group = unsigned(TreeGroup::HardInteraction);
+        
+        treeReader.SetBranchAddress("hardPartSize", &hardPartSize, group);
+        treeReader.SetBranchAddress("hardPartPdgId", hardPartPdgId, hardPartSize, group);
+        treeReader.SetBranchAddress("hardPartFirstMother", hardPartFirstMother, hardPartSize,
+         group);
+        treeReader.SetBranchAddress("hardPartLastMother", hardPartLastMother, hardPartSize,
+         group);
+        treeReader.SetBranchAddress("hardPartPt", hardPartPt, hardPartSize, group);
+        treeReader.SetBranchAddress("hardPartEta", hardPartEta, hardPartSize, group);
+        treeReader.SetBranchAddress("hardPartPhi", hardPartPhi, hardPartSize, group);
+        treeReader.SetBranchAddress("hardPartMass", hardPartMass, hardPartSize, group);
+    }
+    
+    
+    // Attach the column cache if requested. Its validity is determined by the size and
+    //modification time of the source file, which are only available for local files. The size of
+    //TTreeCache is needed already here since the trees are read if the column cache is built
+    treeReader.SetCacheSize(treeCacheSize);
+    
+    if (useColumnCache)
+    {
+        struct stat sourceStat;
+        
+        if (stat(sourceFileIt->name.c_str(), &sourceStat) == 0)
+        {
+            string const cachePath = (columnCacheDirectory.empty()) ?
+             sourceFileIt->name + ".colcache" :
+             columnCacheDirectory + sourceFileIt->GetBaseName() + ".colcache";
+            
+            treeReader.AttachCache(cachePath, sourceStat.st_size, sourceStat.st_mtime);
+        }
+        else
+            logger << "Warning in PECReader::OpenSourceFile: Column cache cannot be used for " <<
+             "file \"" << sourceFileIt->name << "\" as it is not a local file." << eom;
     }
+    
+    
+    // Disable unused branches and set up TTreeCache for the trees that are read directly
+    treeReader.Prepare();
 }
 
 
 void PECReader::CloseSourceFile()
 {
-    // Delete the source file and trees (it is a critical section)
-    ROOTLock::Lock();
+    // Forget the trees. They are owned by the file and are deleted together with it
+    treeReader.Clear();
     
-    delete eventIDTree;
-    delete triggerTree;
-    delete generalTree;
-    delete sourceFile;
     
-    ROOTLock::Unlock();
+    // Delete the source file. It is owned by the current thread, so no lock is needed
+    delete sourceFile;
     
     
-    // Set the above pointers to nulls to indicate that the file has been closed
+    // Set the pointer to null to indicate that the file has been closed
     sourceFile = nullptr;
-    eventIDTree = triggerTree = generalTree = nullptr;
 }
 
 
@@ -602,6 +779,50 @@ bool PECReader::BuildAndSelectEvent()
         return false;
     
     
+    // Several versions of MET are stored in a PEC file
+    unsigned metIndex = 1;  // index of a corrected MET that is not varied for some systematics
+    
+    switch (syst.type)
+    {
+        case SystTypeAlgo::JEC:
+            // Check [1] and around that line
+            //[1] https://svnweb.cern.ch/trac/singletop/browser/tags/2012Alpha_v2/CMSSW/SingleTop/python/ObjectsDefinitions_cff.py#L342
+            metIndex = (syst.direction > 0) ? 2 : 3;
+            break;
+        
+        case SystTypeAlgo::JER:
+            metIndex = (syst.direction > 0) ? 4 : 5;
+            break;
+        
+        case SystTypeAlgo::METUnclustered:
+            metIndex = (syst.direction > 0) ? 6 : 7;
+            break;
+        
+        default:
+            break;
+    }
+    
+    
+    // Save MET to the dedicated variable
+    correctedMET.SetPtEtaPhiM(metPt[metIndex], 0., metPhi[metIndex], 0.);
+    
+    
+    // The neutrino is reconstructed only if requested by a plugin
+    curMetIndex = metIndex;
+    neutrinoBuilt = false;
+    
+    
+    // For unknown reason extremely rarely MET can be NaN. Such an event is rejected, but only after
+    //the event selection so that the warning is not issued for events that would be rejected
+    //anyway. The filters are not evaluated for it since they are meant to run after the reader
+    bool const metIsNaN = (isnan(metPt[metIndex]) or isnan(metPhi[metIndex]));
+    
+    
+    // Apply the additional filters that need MET
+    if (not metIsNaN and not PassEventFilters(EventFilterStage::MET))
+        return false;
+    
+    
     // Reset the containers used in the compact event description
     tightLeptons.clear();
     looseLeptons.clear();
@@ -710,64 +931,63 @@ bool PECReader::BuildAndSelectEvent()
             additionalJets.push_back(jet);
     }
     
-        
+    
     // Make sure the jets are ordered in pt (in decreasing order). The ordering might have been
     //broken after the JER smearing was performed
     sort(goodJets.rbegin(), goodJets.rend());
     sort(additionalJets.rbegin(), additionalJets.rend());
     
+    // Evaluate b-tagging decisions once so that all the consumers only need to read them
+    if (bTagger)
+    {
+        bTagger->TagJets(goodJets);
+        bTagger->TagJets(additionalJets);
+    }
+    
     // Event selection on the number of jets and tags
     if (eventSelection and not eventSelection->PassJetStep(goodJets))
         return false;
     
     
-    // Several versions of MET are stored in a PEC file
-    unsigned metIndex = 1;  // index of a corrected MET that is not varied for some systematics
-    
-    switch (syst.type)
+    // The event is accepted by the selection. Skip it if MET is NaN
+    if (metIsNaN)
     {
-        case SystTypeAlgo::JEC:
-            // Check [1] and around that line
-            //[1] https://svnweb.cern.ch/trac/singletop/browser/tags/2012Alpha_v2/CMSSW/SingleTop/python/ObjectsDefinitions_cff.py#L342
-            metIndex = (syst.direction > 0) ? 2 : 3;
-            break;
-        
-        case SystTypeAlgo::JER:
-            metIndex = (syst.direction > 0) ? 4 : 5;
-            break;
-        
-        case SystTypeAlgo::METUnclustered:
-            metIndex = (syst.direction > 0) ? 6 : 7;
-            break;
-        
-        default:
-            break;
+        logger << "Warning: MET is NaN in event #" << curEventEntry <<
+         " in file \"" << sourceFile->GetName() << "\" (ID " << runNumber << ":" << lumiSection <<
+         ":" << eventNumber << "). The event is skipped." << eom;
+        return false;
     }
     
     
-    // For unknown reason extremely rarely MET can be NaN. Check for it
-    if (isnan(metPt[metIndex]) or isnan(metPhi[metIndex]))
-    {
-        logger << "Warning: MET is NaN in event #" << curEventTree << " in file \"" <<
-         sourceFile->GetName() << "\" (ID " << runNumber << ":" << lumiSection << ":" <<
-         eventNumber << "). The event is skipped." << eom;
+    // Apply the additional filters that need leptons and jets
+    if (not PassEventFilters(EventFilterStage::Jets))
         return false;
-    }
     
     
-    // Save MET to the dedicated variable
-    correctedMET.SetPtEtaPhiM(metPt[metIndex], 0., metPhi[metIndex], 0.);
+    return true;
+}
+
+
+void PECReader::BuildNeutrino() const
+{
+    if (tightLeptons.empty())
+        throw logic_error("PECReader::GetNeutrino: The neutrino cannot be reconstructed as the "
+         "event contains no tight leptons.");
+    
     
+    // Reconstruct the neutrino with the leading tight lepton. MET components are computed in
+    //single precision as in function Nu4Momentum used previously
+    TLorentzVector const &lepP4 = tightLeptons.front().P4();
+    float const metX = metPt[curMetIndex] * cos(metPhi[curMetIndex]);
+    float const metY = metPt[curMetIndex] * sin(metPhi[curMetIndex]);
     
-    // Reconstruct the neutrino with the leading tight lepton
     double const nuPz =
-     Nu4Momentum(tightLeptons.front().P4(), metPt[metIndex], metPhi[metIndex]).Pz();
-    double const nuEnergy = sqrt(metPt[metIndex] * metPt[metIndex] + nuPz * nuPz);
-    neutrino.SetPtEtaPhiM(metPt[metIndex], 0.5 * log((nuEnergy + nuPz) / (nuEnergy - nuPz)),
-     metPhi[metIndex], 0.);
+     NeutrinoPzSolver::Solve(lepP4.Px(), lepP4.Py(), lepP4.Pz(), lepP4.E(), metX, metY);
+    double const nuEnergy = sqrt(metPt[curMetIndex] * metPt[curMetIndex] + nuPz * nuPz);
+    neutrino.SetPtEtaPhiM(metPt[curMetIndex], 0.5 * log((nuEnergy + nuPz) / (nuEnergy - nuPz)),
+     metPhi[curMetIndex], 0.);
     
-        
-    return true;
+    neutrinoBuilt = true;
 }
 
 
@@ -839,51 +1059,57 @@ void PECReader::CalculateEventWeights()
 }
 
 
-void PECReader::ParseHardInteraction()
+void PECReader::ParseHardInteraction() const
+{
+    // For real data the hard interaction is not available, and the record is left empty
+    hardProcess.Clear();
+    
+    if (dataset.IsMC())
+        treeReader.ReadGroup(unsigned(TreeGroup::HardInteraction), curEventEntry);
+    else
+        hardPartSize = 0;
+    
+    for (unsigned i = 0; i < unsigned(hardPartSize); ++i)
+        hardProcess.AddParticle(hardPartPdgId[i], hardPartPt[i], hardPartEta[i], hardPartPhi[i],
+         hardPartMass[i], hardPartFirstMother[i], hardPartLastMother[i]);
+    
+    hardProcess.Finalize();
+    hardProcessBuilt = true;
+}
+
+
+void PECReader::BuildHardGenParticles() const
 {
-    // Reset the vector
+    // Reset the vector and the memory used by the links between the particles
     hardParticles.clear();
+    eventArena.Reset();
     
     // Make sure the vector will not be reallocated (otherwise the pointers will be broken)
-    hardParticles.reserve(hardPartSize);
+    unsigned const nParticles = hardProcess.GetNumParticles();
+    hardParticles.reserve(nParticles);
     
+    for (unsigned i = 0; i < nParticles; ++i)
+        hardParticles.emplace_back(hardProcess.GetP4(i), hardProcess.GetPdgId(i), &eventArena);
     
-    // Loop over the arrays with properties of the particles from the hard interaction
-    for (unsigned i = 0; i < unsigned(hardPartSize); ++i)
+    
+    // Set pointers to mothers and daughters. The order of links is the same as in the record
+    for (auto const &p: hardProcess.GetParticles())
     {
-        TLorentzVector p4;
-        p4.SetPtEtaPhiM(hardPartPt[i], hardPartEta[i], hardPartPhi[i], hardPartMass[i]);
+        for (auto const &m: p.GetMothers())
+            hardParticles[p.GetIndex()].AddMother(&hardParticles[m.GetIndex()]);
         
-        hardParticles.emplace_back(p4, hardPartPdgId[i]);
-        
-        
-        // Set pointers to mothers and daughters
-        int iMother = hardPartFirstMother[i];
-        
-        if (iMother >= 0 and iMother < hardPartSize)
-        {
-            hardParticles.at(i).AddMother(&hardParticles.at(iMother));
-            hardParticles.at(iMother).AddDaughter(&hardParticles.at(i));
-        }
-        
-        if (hardPartFirstMother[i] != hardPartLastMother[i])
-        //^ Second mother is added if only it is different from the first one
-        {
-            int iMother = hardPartLastMother[i];
-            
-            if (iMother >= 0 and iMother < hardPartSize)
-            {
-                hardParticles.at(i).AddMother(&hardParticles.at(iMother));
-                hardParticles.at(iMother).AddDaughter(&hardParticles.at(i));
-            }
-        }
+        for (auto const &d: p.GetDaughters())
+            hardParticles[p.GetIndex()].AddDaughter(&hardParticles[d.GetIndex()]);
     }
+    
+    hardParticlesBuilt = true;
 }
 
 
-void PECReader::BuildGenJets()
+void PECReader::BuildGenJets() const
 {
-    // Reset the vector
+    // Read the branches and reset the vector
+    treeReader.ReadGroup(unsigned(TreeGroup::GenJets), curEventEntry);
     genJets.clear();
     
     
@@ -896,12 +1122,15 @@ void PECReader::BuildGenJets()
         genJets.emplace_back(p4);
         //genJets.back().SetMultiplicities(genJetBMult[i], genJetCMult[i]);
     }
+    
+    genJetsBuilt = true;
 }
 
 
-void PECReader::ReadPartonShower()
+void PECReader::ReadPartonShower() const
 {
-    // Reset the vector
+    // Read the branches and reset the vector
+    treeReader.ReadGroup(unsigned(TreeGroup::PartonShower), curEventEntry);
     psPartons.clear();
     
     
@@ -920,4 +1149,6 @@ void PECReader::ReadPartonShower()
         
         psPartons.emplace_back(psPt[i], psEta[i], psPhi[i], psPdgId[i], origin);
     }
+    
+    psPartonsBuilt = true;
 }
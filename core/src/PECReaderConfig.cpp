@@ -8,7 +8,8 @@ using namespace std;
 
 PECReaderConfig::PECReaderConfig():
     readHardInteraction(false), readGenJets(false), readPartonShower(false),
-    syst()
+    syst(),
+    useColumnCache(false)
 {}
 
 
@@ -22,7 +23,8 @@ PECReaderConfig::PECReaderConfig(PECReaderConfig const &src):
     readHardInteraction(src.readHardInteraction),
     readGenJets(src.readGenJets),
     readPartonShower(src.readPartonShower),
-    syst(src.syst)
+    syst(src.syst),
+    useColumnCache(src.useColumnCache), columnCacheDirectory(src.columnCacheDirectory)
 {}
 
 
@@ -36,7 +38,8 @@ PECReaderConfig::PECReaderConfig(PECReaderConfig &&src):
     readHardInteraction(src.readHardInteraction),
     readGenJets(src.readGenJets),
     readPartonShower(src.readPartonShower),
-    syst(src.syst)
+    syst(src.syst),
+    useColumnCache(src.useColumnCache), columnCacheDirectory(move(src.columnCacheDirectory))
 {}
 
 
@@ -146,6 +149,17 @@ void PECReaderConfig::SetSystematics(SystVariation const &syst_)
 }
 
 
+void PECReaderConfig::SetColumnCache(bool enable, string const &directory /*= ""*/)
+{
+    useColumnCache = enable;
+    columnCacheDirectory = directory;
+    
+    // Make sure the last symbol is a slash
+    if (not columnCacheDirectory.empty() and columnCacheDirectory.back() != '/')
+        columnCacheDirectory += '/';
+}
+
+
 bool PECReaderConfig::IsSetTriggerSelection() const
 {
     return bool(triggerSelection);
@@ -274,3 +288,15 @@ SystVariation const &PECReaderConfig::GetSystematics() const
 {
     return syst;
 }
+
+
+bool PECReaderConfig::GetColumnCache() const noexcept
+{
+    return useColumnCache;
+}
+
+
+string const &PECReaderConfig::GetColumnCacheDirectory() const noexcept
+{
+    return columnCacheDirectory;
+}
@@ -47,8 +47,12 @@ void PECReaderPlugin::BeginRun(Dataset const &dataset)
         readerConfig->GetPileUpReweighter()->SetDataset(dataset);
     
     
-    // Create a new instance of PECReader
-    reader = new PECReader(dataset, *readerConfig.get());
+    // Create an instance of PECReader for the first dataset and rebind it for the subsequent ones.
+    //This way the reader keeps its buffers and the capacities of its collections
+    if (not reader)
+        reader = new PECReader(dataset, *readerConfig.get());
+    else
+        reader->SetDataset(dataset);
     
     
     // Open the first file in the dataset
@@ -58,9 +62,8 @@ void PECReaderPlugin::BeginRun(Dataset const &dataset)
 
 void PECReaderPlugin::EndRun()
 {
-    // Delete the current instance of PECReader
-    delete reader;
-    reader = nullptr;
+    // The reader is kept to be reused with the next dataset and is deleted in the destructor. The
+    //last source file has already been closed by PECReader::NextSourceFile
 }
 
 
@@ -98,4 +101,14 @@ PECReader const &PECReaderPlugin::operator*() const
 PECReader const *PECReaderPlugin::operator->() const
 {
     return reader;
-}
\ No newline at end of file
+}
+
+
+PECReader &PECReaderPlugin::GetReader()
+{
+    if (not reader)
+        throw runtime_error("PECReaderPlugin::GetReader: No valid PECReader object is associated "
+         "to the plugin.");
+    
+    return *reader;
+}
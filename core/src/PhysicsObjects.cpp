@@ -130,47 +130,86 @@ int Lepton::Charge() const noexcept
 // Methods of class Jet
 Jet::Jet() noexcept:
     Candidate(),
-    CSVValue(-numeric_limits<double>::infinity()),
-    JPValue(-numeric_limits<double>::infinity()),
-    TCHPValue(-numeric_limits<double>::infinity()),
+    bTagValues{-numeric_limits<double>::infinity(), -numeric_limits<double>::infinity(),
+     -numeric_limits<double>::infinity()},
     parentPDGID(0),
-    charge(-10.), pullAngle(-10.)
+    charge(-10.), pullAngle(-10.),
+    bTagBits(0), bTagBitsCode(-1)
 {}
 
 
 Jet::Jet(TLorentzVector const &p4) noexcept:
     Candidate(p4),
-    CSVValue(-numeric_limits<double>::infinity()),
-    JPValue(-numeric_limits<double>::infinity()),
-    TCHPValue(-numeric_limits<double>::infinity()),
+    bTagValues{-numeric_limits<double>::infinity(), -numeric_limits<double>::infinity(),
+     -numeric_limits<double>::infinity()},
     parentPDGID(0),
-    charge(-10.), pullAngle(-10.)
+    charge(-10.), pullAngle(-10.),
+    bTagBits(0), bTagBitsCode(-1)
 {}
 
 
+void Jet::SetP4(TLorentzVector const &p4) noexcept
+{
+    Candidate::SetP4(p4);
+    
+    // Cached b-tagging decisions are no longer valid
+    bTagBitsCode = -1;
+}
+
+
+void Jet::SetPtEtaPhiM(double pt, double eta, double phi, double mass) noexcept
+{
+    Candidate::SetPtEtaPhiM(pt, eta, phi, mass);
+    
+    // Cached b-tagging decisions are no longer valid
+    bTagBitsCode = -1;
+}
+
+
+void Jet::SetPxPyPzE(double px, double py, double pz, double E) noexcept
+{
+    Candidate::SetPxPyPzE(px, py, pz, E);
+    
+    // Cached b-tagging decisions are no longer valid
+    bTagBitsCode = -1;
+}
+
+
 void Jet::SetBTags(double CSV, double JP, double TCHP) noexcept
 {
-    CSVValue = CSV;
-    JPValue = JP;
-    TCHPValue = TCHP;
+    bTagValues[0] = CSV;
+    bTagValues[1] = JP;
+    bTagValues[2] = TCHP;
+    
+    // Cached b-tagging decisions are no longer valid
+    bTagBitsCode = -1;
 }
 
 
 void Jet::SetCSV(double CSV) noexcept
 {
-    CSVValue = CSV;
+    bTagValues[0] = CSV;
+    
+    // Cached b-tagging decisions are no longer valid
+    bTagBitsCode = -1;
 }
 
 
 void Jet::SetJP(double JP) noexcept
 {
-    JPValue = JP;
+    bTagValues[1] = JP;
+    
+    // Cached b-tagging decisions are no longer valid
+    bTagBitsCode = -1;
 }
 
 
 void Jet::SetTCHP(double TCHP) noexcept
 {
-    TCHPValue = TCHP;
+    bTagValues[2] = TCHP;
+    
+    // Cached b-tagging decisions are no longer valid
+    bTagBitsCode = -1;
 }
 
 
@@ -192,21 +231,34 @@ void Jet::SetPullAngle(double pullAngle_) noexcept
 }
 
 
+void Jet::SetBTagBits(unsigned bits, int code) noexcept
+{
+    bTagBits = bits;
+    bTagBitsCode = code;
+}
+
+
 double Jet::CSV() const noexcept
 {
-    return CSVValue;
+    return bTagValues[0];
 }
 
 
 double Jet::JP() const noexcept
 {
-    return JPValue;
+    return bTagValues[1];
 }
 
 
 double Jet::TCHP() const noexcept
 {
-    return TCHPValue;
+    return bTagValues[2];
+}
+
+
+double Jet::GetBTagDiscriminator(unsigned index) const noexcept
+{
+    return bTagValues[index];
 }
 
 
@@ -228,6 +280,18 @@ double Jet::GetPullAngle() const noexcept
 }
 
 
+unsigned Jet::GetBTagBits() const noexcept
+{
+    return bTagBits;
+}
+
+
+int Jet::GetBTagBitsCode() const noexcept
+{
+    return bTagBitsCode;
+}
+
+
 // Methods of class GenJet
 GenJet::GenJet() noexcept:
     Candidate(),
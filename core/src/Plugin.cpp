@@ -1,5 +1,8 @@
 #include <Plugin.hpp>
 
+#include <stdexcept>
+#include <cstdio>
+
 
 using namespace std;
 
@@ -31,3 +34,33 @@ void Plugin::BeginRun(Dataset const &)
 
 void Plugin::EndRun()
 {}
+
+
+bool Plugin::RegisterEarlyFilters(PECReader &) const
+{
+    return false;
+}
+
+
+void Plugin::EndPass()
+{}
+
+
+bool Plugin::SupportsDistributedMode() const
+{
+    return true;
+}
+
+
+string Plugin::GetTempFileName(string const &fileName)
+{
+    return fileName + ".tmp";
+}
+
+
+void Plugin::CommitOutputFile(string const &fileName)
+{
+    if (rename(GetTempFileName(fileName).c_str(), fileName.c_str()) != 0)
+        throw runtime_error("Plugin::CommitOutputFile: Failed to rename the temporary file into \""
+         + fileName + "\".");
+}
@@ -3,10 +3,12 @@
 #include <RunManager.hpp>
 #include <Plugin.hpp>
 #include <ROOTLock.hpp>
+#include <NumaTopology.hpp>
 #include <Logger.hpp>
 
 #include <thread>
 #include <mutex>
+#include <chrono>
 #include <stdexcept>
 #include <iostream>
 
@@ -16,12 +18,20 @@ using namespace logging;
 
 
 Processor::Processor() noexcept:
-    manager(nullptr)
+    manager(nullptr),
+    threadStats(nullptr),
+    cpu(-1), homeQueue(0),
+    progressSlot(nullptr),
+    cutFlow(nullptr)
 {}
 
 
 Processor::Processor(RunManager *manager_):
-    manager(manager_)
+    manager(manager_),
+    threadStats(nullptr),
+    cpu(-1), homeQueue(0),
+    progressSlot(nullptr),
+    cutFlow(nullptr)
 {
     // Create the reader plugin
     RegisterPlugin(new PECReaderPlugin(move(manager->readerConfig)));
@@ -31,7 +41,11 @@ Processor::Processor(RunManager *manager_):
 Processor::Processor(Processor &&src) noexcept:
     manager(src.manager),
     path(move(src.path)),
-    nameMap(move(src.nameMap))
+    nameMap(move(src.nameMap)),
+    threadStats(src.threadStats),
+    cpu(src.cpu), homeQueue(src.homeQueue),
+    progressSlot(src.progressSlot),
+    cutFlow(src.cutFlow)
 {
     // Prevent the source object from deleting the plugins
     src.path.clear();
@@ -40,7 +54,11 @@ Processor::Processor(Processor &&src) noexcept:
 
 Processor::Processor(Processor const &src):
     manager(src.manager),
-    nameMap(src.nameMap)
+    nameMap(src.nameMap),
+    threadStats(nullptr),
+    cpu(-1), homeQueue(0),
+    progressSlot(nullptr),
+    cutFlow(nullptr)
 {
     for (auto const &p: src.path)
         path.emplace_back(p->Clone());
@@ -72,32 +90,88 @@ void Processor::RegisterPlugin(Plugin *plugin)
 }
 
 
+void Processor::SetThreadStats(ContentionProfiler::ThreadStats *threadStats_) noexcept
+{
+    threadStats = threadStats_;
+}
+
+
+void Processor::SetPlacement(int cpu_, unsigned homeQueue_) noexcept
+{
+    cpu = cpu_;
+    homeQueue = homeQueue_;
+}
+
+
+void Processor::SetProgressSlot(ProgressMonitor::ThreadSlot *progressSlot_) noexcept
+{
+    progressSlot = progressSlot_;
+}
+
+
+void Processor::SetCutFlow(vector<unsigned long> *cutFlow_) noexcept
+{
+    cutFlow = cutFlow_;
+}
+
+
 void Processor::operator()()
 {
+    // Pin the thread if requested. It is done before any dataset is opened so that buffers of the
+    //reader and the plugins are allocated in the memory local to the CPU
+    if (cpu >= 0 and not NumaTopology::PinCurrentThread(cpu))
+        logger << "Warning in Processor::operator(): Failed to pin the thread to CPU " << cpu <<
+         "." << eom;
+    
+    
     // Set parent for the plugins
     for (auto &p: path)
         p->SetParent(this);
     
     
-    // Read datasets from the queue in the manager one by one
+    // Starting point to measure activity of the thread
+    auto const startTime = chrono::steady_clock::now();
+    double const startLockWaitTime = ContentionProfiler::GetThreadLockWaitTime();
+    
+    
+    // Read datasets from the queues in the manager one by one
     while (true)
     {
-        // Safely pop a dataset from the queue
-        manager->mutexDatasets.lock();
+        unique_ptr<Dataset> const dataset(PopDataset());
+        
+        if (not dataset)  // no more datasets to process
+            break;
         
-        if (manager->datasets.empty())  // no more datasets to process
+        
+        // Process the dataset
+        if (threadStats)
         {
-            manager->mutexDatasets.unlock();
-            return;
+            auto const start = chrono::steady_clock::now();
+            ProcessDataset(*dataset);
+            
+            threadStats->busyTime +=
+             chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            ++threadStats->nFiles;
         }
+        else
+            ProcessDataset(*dataset);
         
-        Dataset dataset(manager->datasets.front());
-        manager->datasets.pop();
-        manager->mutexDatasets.unlock();
         
-        
-        // Process the dataset
-        ProcessDataset(dataset);
+        // Record that the dataset has been processed. All the plugins have finished their EndRun
+        //by now, so their outputs have been committed
+        if (manager->journal)
+            manager->journal->MarkCompleted(manager->journalPass,
+             dataset->GetFiles().front().name);
+    }
+    
+    
+    // Save the overall activity
+    if (threadStats)
+    {
+        threadStats->wallTime =
+         chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+        threadStats->lockWaitTime =
+         ContentionProfiler::GetThreadLockWaitTime() - startLockWaitTime;
     }
 }
 
@@ -115,6 +189,27 @@ void Processor::ProcessDataset(Dataset const &dataset)
         (*pIt)->BeginRun(dataset);
     
     
+    // Let the filtering plugins that immediately follow the reader register their selection in
+    //it so that rejected events are not built in full. The first plugin that cannot do it stops
+    //the chain since the plugins after it must not affect the events it sees. This is not done if
+    //the cut-flow is counted: the filters can reject an event before the selection of the reader
+    //is evaluated, so the event could not be attributed to the right step
+    PECReader &reader = dynamic_cast<PECReaderPlugin &>(*path.at(0)).GetReader();
+    reader.ClearEventFilters();
+    
+    for (unsigned i = 1; i < path.size() and not cutFlow; ++i)
+    {
+        if (not path.at(i)->RegisterEarlyFilters(reader))
+            break;
+    }
+    
+    if (progressSlot)
+        progressSlot->BeginFile(reader.GetNumEntriesSourceFile());
+    
+    if (cutFlow)
+        cutFlow->resize(path.size(), 0);
+    
+    
     // Process all the events in the dataset
     while (true)
     {
@@ -122,16 +217,36 @@ void Processor::ProcessDataset(Dataset const &dataset)
         if (not path.at(0)->ProcessEvent())  // the first plugin in the path is always PECReader
             break;
         
+        if (threadStats)
+            ++threadStats->nEvents;
+        
         
         // Run the remainin plugins. If one of them returns false, the following plugins in the path
         //are not executed for the current event
-        for (unsigned i = 1; i < path.size(); ++i)
+        unsigned nPassed = 1;
+        
+        for (; nPassed < path.size(); ++nPassed)
         {
-            if (not path.at(i)->ProcessEvent())
+            if (not path.at(nPassed)->ProcessEvent())
                 break;
         }
+        
+        bool const accepted = (nPassed == path.size());
+        
+        if (cutFlow)
+        {
+            for (unsigned i = 0; i < nPassed; ++i)
+                ++(*cutFlow)[i];
+        }
+        
+        if (progressSlot)
+            progressSlot->Update(reader.GetNumEntriesReadSourceFile(),
+             reader.GetBytesReadSourceFile(), accepted);
     }
     
+    if (progressSlot)
+        progressSlot->EndFile();
+    
     
     // Declare end of the dataset for all the plugins (reversed order)
     for (auto pIt = path.rbegin(); pIt != path.rend(); ++pIt)
@@ -139,6 +254,35 @@ void Processor::ProcessDataset(Dataset const &dataset)
 }
 
 
+vector<string> Processor::GetPluginNames() const
+{
+    vector<string> names;
+    
+    for (auto const &p: path)
+        names.emplace_back(p->GetName());
+    
+    return names;
+}
+
+
+void Processor::EndPass()
+{
+    for (auto &p: path)
+        p->EndPass();
+}
+
+
+void Processor::CheckDistributedMode() const
+{
+    for (auto const &p: path)
+    {
+        if (not p->SupportsDistributedMode())
+            throw logic_error(string("Processor::CheckDistributedMode: Plugin \"") +
+             p->GetName() + "\" does not support the distributed mode.");
+    }
+}
+
+
 Plugin const *Processor::GetPlugin(string const &name) const
 {
     return path.at(GetPluginIndex(name)).get();
@@ -201,4 +345,32 @@ unsigned Processor::GetPluginIndex(string const &name) const
     }
     
     return index;
+}
+
+
+unique_ptr<Dataset> Processor::PopDataset()
+{
+    auto &queues = manager->datasetQueues;
+    
+    for (unsigned i = 0; i < queues.size(); ++i)
+    {
+        // Safely pop a dataset from the queue. Start from the home queue
+        auto &queue = *queues[(homeQueue + i) % queues.size()];
+        ContentionProfiler::Acquire(ContentionProfiler::LockID::Datasets, queue.mutex);
+        
+        if (not queue.datasets.empty())
+        {
+            unique_ptr<Dataset> dataset(new Dataset(move(queue.datasets.front())));
+            queue.datasets.pop();
+            queue.mutex.unlock();
+            
+            return dataset;
+        }
+        
+        queue.mutex.unlock();
+    }
+    
+    
+    // All the queues are empty
+    return nullptr;
 }
\ No newline at end of file
@@ -0,0 +1,286 @@
+#include <ProgressMonitor.hpp>
+
+#include <Logger.hpp>
+
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdio>
+
+
+using namespace std;
+using namespace logging;
+
+
+ProgressMonitor::ThreadSlot::ThreadSlot() noexcept:
+    nFilesOpened(0), nFilesDone(0),
+    nEntriesKnown(0), nEntriesRead(0),
+    nAccepted(0),
+    nBytesRead(0),
+    busyTime(0), fileStart(0),
+    entriesBase(0), bytesBase(0),
+    curFileEntries(0)
+{}
+
+
+void ProgressMonitor::ThreadSlot::EndFile() noexcept
+{
+    long long const now = chrono::duration_cast<chrono::nanoseconds>(
+     chrono::steady_clock::now().time_since_epoch()).count();
+    
+    entriesBase += curFileEntries;
+    bytesBase = nBytesRead.load(memory_order_relaxed);
+    
+    nEntriesRead.store(entriesBase, memory_order_relaxed);
+    busyTime.fetch_add(now - fileStart.load(memory_order_relaxed), memory_order_relaxed);
+    fileStart.store(0, memory_order_relaxed);
+    nFilesDone.fetch_add(1, memory_order_relaxed);
+}
+
+
+ProgressMonitor::ProgressMonitor(unsigned nThreads_, unsigned long nFiles_):
+    nThreads(nThreads_), nFiles(nFiles_),
+    slots(new ThreadSlot[nThreads_]),
+    startTime(chrono::steady_clock::now()),
+    interval(0.),
+    stopRequested(false)
+{}
+
+
+ProgressMonitor::~ProgressMonitor()
+{
+    if (reporter.joinable())
+        Stop();
+}
+
+
+ProgressMonitor::ThreadSlot &ProgressMonitor::GetSlot(unsigned thread)
+{
+    if (thread >= nThreads)
+        throw out_of_range("ProgressMonitor::GetSlot: Thread index is out of range.");
+    
+    return slots[thread];
+}
+
+
+void ProgressMonitor::Start(double interval_, string const &statusFileName_ /*= ""*/)
+{
+    if (reporter.joinable())
+        throw logic_error("ProgressMonitor::Start: The reporter thread is already running.");
+    
+    if (interval_ <= 0.)
+        throw logic_error("ProgressMonitor::Start: The interval between reports must be positive.");
+    
+    interval = interval_;
+    statusFileName = statusFileName_;
+    startTime = chrono::steady_clock::now();
+    stopRequested = false;
+    
+    reporter = thread(&ProgressMonitor::RunReporter, this);
+}
+
+
+void ProgressMonitor::Stop()
+{
+    {
+        lock_guard<mutex> lock(stopMutex);
+        stopRequested = true;
+    }
+    
+    stopCondition.notify_all();
+    reporter.join();
+}
+
+
+void ProgressMonitor::RunReporter()
+{
+    Snapshot previous(TakeSnapshot());
+    auto const period = chrono::duration_cast<chrono::steady_clock::duration>(
+     chrono::duration<double>(interval));
+    auto nextReport = chrono::steady_clock::now() + period;
+    
+    while (true)
+    {
+        // Sleep until the next report is due or the monitor is stopped
+        bool stopped;
+        
+        {
+            unique_lock<mutex> lock(stopMutex);
+            stopped = stopCondition.wait_until(lock, nextReport, [this](){return stopRequested;});
+        }
+        
+        
+        // Produce the report
+        Snapshot const current(TakeSnapshot());
+        Report(current, previous, stopped);
+        
+        if (stopped)
+            break;
+        
+        previous = current;
+        nextReport += period;
+    }
+}
+
+
+ProgressMonitor::Snapshot ProgressMonitor::TakeSnapshot() const
+{
+    auto const now = chrono::steady_clock::now();
+    long long const nowNs =
+     chrono::duration_cast<chrono::nanoseconds>(now.time_since_epoch()).count();
+    
+    Snapshot s;
+    s.time = chrono::duration<double>(now - startTime).count();
+    s.nFilesOpened = s.nFilesDone = 0;
+    s.nEntriesKnown = s.nEntriesRead = s.nAccepted = 0;
+    s.nBytesRead = 0;
+    s.busyTime.resize(nThreads);
+    
+    for (unsigned i = 0; i < nThreads; ++i)
+    {
+        ThreadSlot const &slot = slots[i];
+        
+        s.nFilesOpened += slot.nFilesOpened.load(memory_order_relaxed);
+        s.nFilesDone += slot.nFilesDone.load(memory_order_relaxed);
+        s.nEntriesKnown += slot.nEntriesKnown.load(memory_order_relaxed);
+        s.nEntriesRead += slot.nEntriesRead.load(memory_order_relaxed);
+        s.nAccepted += slot.nAccepted.load(memory_order_relaxed);
+        s.nBytesRead += slot.nBytesRead.load(memory_order_relaxed);
+        
+        
+        // Include the time spent on the file being processed
+        long long busy = slot.busyTime.load(memory_order_relaxed);
+        long long const fileStart = slot.fileStart.load(memory_order_relaxed);
+        
+        if (fileStart > 0)
+            busy += max(nowNs - fileStart, 0LL);
+        
+        s.busyTime[i] = busy * 1e-9;
+    }
+    
+    return s;
+}
+
+
+void ProgressMonitor::Report(Snapshot const &current, Snapshot const &previous, bool finished)
+ const
+{
+    // Average rates since the start
+    double const elapsed = max(current.time, 1e-9);
+    double const readRate = current.nEntriesRead / elapsed;
+    double const acceptRate = current.nAccepted / elapsed;
+    double const mbRate = current.nBytesRead / 1048576. / elapsed;
+    
+    
+    // Utilisation of the threads over the last interval
+    double const dt = current.time - previous.time;
+    vector<double> utilisation(nThreads, 0.);
+    
+    if (dt > 0.)
+    {
+        for (unsigned i = 0; i < nThreads; ++i)
+            utilisation[i] = min((current.busyTime[i] - previous.busyTime[i]) / dt, 1.);
+    }
+    
+    double meanUtilisation = 0., minUtilisation = 1.;
+    
+    for (double const u: utilisation)
+    {
+        meanUtilisation += u / nThreads;
+        minUtilisation = min(minUtilisation, u);
+    }
+    
+    
+    // Estimate the total number of events and the remaining time. It is only possible once at
+    //least one file has been opened
+    double eventsEstimated = 0., eta = -1.;
+    
+    if (current.nFilesOpened > 0)
+    {
+        eventsEstimated = current.nEntriesKnown + double(current.nEntriesKnown) /
+         current.nFilesOpened * (nFiles - min(current.nFilesOpened, nFiles));
+        
+        if (finished)
+            eta = 0.;
+        else if (readRate > 0.)
+            eta = max(eventsEstimated - current.nEntriesRead, 0.) / readRate;
+    }
+    
+    
+    // Print the report
+    ostringstream ost;
+    ost << fixed << setprecision(0) << ((finished) ? "Final progress: " : "Progress: ") <<
+     current.nFilesDone << "/" << nFiles << " files, " << current.nEntriesRead <<
+     " events read (" << readRate << " ev/s), " << current.nAccepted << " accepted (" <<
+     acceptRate << " ev/s), " << setprecision(1) << mbRate << " MB/s, utilisation " <<
+     100. * meanUtilisation << "% (min " << 100. * minUtilisation << "%), ";
+    
+    if (finished)
+        ost << "elapsed " << FormatTime(current.time) << ".";
+    else
+        ost << "ETA " << ((eta >= 0.) ? FormatTime(eta) : string("unknown")) << ".";
+    
+    logger << timestamp << ost.str() << eom;
+    
+    
+    // Write the status file
+    if (statusFileName.empty())
+        return;
+    
+    string const tmpFileName(statusFileName + ".tmp");
+    ofstream statusFile(tmpFileName);
+    
+    if (not statusFile)
+    {
+        logger << "Warning in ProgressMonitor::Report: Cannot write file \"" << tmpFileName <<
+         "\"." << eom;
+        return;
+    }
+    
+    statusFile << fixed << setprecision(3) << "{\n";
+    statusFile << "  \"state\": \"" << ((finished) ? "finished" : "running") << "\",\n";
+    statusFile << "  \"elapsed\": " << current.time << ",\n";
+    statusFile << "  \"filesTotal\": " << nFiles << ",\n";
+    statusFile << "  \"filesDone\": " << current.nFilesDone << ",\n";
+    statusFile << "  \"eventsRead\": " << current.nEntriesRead << ",\n";
+    statusFile << "  \"eventsAccepted\": " << current.nAccepted << ",\n";
+    statusFile << "  \"eventsEstimated\": " << setprecision(0) << eventsEstimated << ",\n";
+    statusFile << setprecision(3);
+    statusFile << "  \"readRate\": " << readRate << ",\n";
+    statusFile << "  \"acceptRate\": " << acceptRate << ",\n";
+    statusFile << "  \"megabytesRead\": " << current.nBytesRead / 1048576. << ",\n";
+    statusFile << "  \"megabytesRate\": " << mbRate << ",\n";
+    statusFile << "  \"eta\": " << eta << ",\n";
+    statusFile << "  \"threadUtilisation\": [";
+    
+    for (unsigned i = 0; i < nThreads; ++i)
+        statusFile << ((i > 0) ? ", " : "") << utilisation[i];
+    
+    statusFile << "]\n}\n";
+    statusFile.close();
+    
+    if (not statusFile or rename(tmpFileName.c_str(), statusFileName.c_str()) != 0)
+        logger << "Warning in ProgressMonitor::Report: Failed to update file \"" <<
+         statusFileName << "\"." << eom;
+}
+
+
+string ProgressMonitor::FormatTime(double seconds)
+{
+    unsigned long const total = seconds + 0.5;
+    
+    ostringstream ost;
+    ost << setfill('0');
+    
+    if (total >= 3600)
+        ost << total / 3600 << "h " << setw(2) << (total % 3600) / 60 << "m " << setw(2) <<
+         total % 60 << "s";
+    else if (total >= 60)
+        ost << total / 60 << "m " << setw(2) << total % 60 << "s";
+    else
+        ost << total << "s";
+    
+    return ost.str();
+}
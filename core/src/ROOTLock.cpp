@@ -1,12 +1,36 @@
 #include <ROOTLock.hpp>
 
+#include <ContentionProfiler.hpp>
+
+#include <RVersion.h>
+
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6, 0, 0)
+#include <TROOT.h>
+#else
+#include <TThread.h>
+#endif
+
 
 std::mutex ROOTLock::globalROOTMutex;
+std::once_flag ROOTLock::threadSafetyFlag;
+
+
+void ROOTLock::EnableThreadSafety()
+{
+    std::call_once(threadSafetyFlag, []()
+    {
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6, 0, 0)
+        ROOT::EnableThreadSafety();
+#else
+        TThread::Initialize();
+#endif
+    });
+}
 
 
 void ROOTLock::Lock()
 {
-    globalROOTMutex.lock();
+    ContentionProfiler::Acquire(ContentionProfiler::LockID::ROOT, globalROOTMutex);
 }
 
 
@@ -0,0 +1,140 @@
+#include <RunJournal.hpp>
+
+#include <fstream>
+#include <stdexcept>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+
+using namespace std;
+
+
+RunJournal::RunJournal(string const &fileName_, bool resume):
+    fileName(fileName_), fd(-1)
+{
+    // Read the existing journal if requested
+    bool endsWithNewLine = true;
+    
+    if (resume)
+        endsWithNewLine = ReadJournal();
+    
+    
+    // Open the file for appending. It is truncated unless the job is resumed
+    fd = open(fileName.c_str(), O_WRONLY | O_CREAT | O_APPEND | ((resume) ? 0 : O_TRUNC), 0644);
+    
+    if (fd < 0)
+        throw runtime_error(string("RunJournal::RunJournal: Cannot open file \"") + fileName +
+         "\": " + strerror(errno) + ".");
+    
+    
+    // Terminate an incomplete last line so that it does not spoil the next record
+    if (not endsWithNewLine)
+        Write("\n");
+}
+
+
+RunJournal::~RunJournal()
+{
+    if (fd >= 0)
+        close(fd);
+}
+
+
+bool RunJournal::IsCompleted(unsigned long pass, string const &sourceFileName) const
+{
+    string const record(MakeRecord(pass, sourceFileName));
+    
+    lock_guard<std::mutex> lock(mutex);
+    return (completed.count(record) > 0);
+}
+
+
+void RunJournal::MarkCompleted(unsigned long pass, string const &sourceFileName)
+{
+    string const record(MakeRecord(pass, sourceFileName));
+    
+    lock_guard<std::mutex> lock(mutex);
+    
+    Write(record + "\n");
+    completed.insert(record);
+}
+
+
+unsigned long RunJournal::GetNumCompleted() const
+{
+    lock_guard<std::mutex> lock(mutex);
+    return completed.size();
+}
+
+
+string const &RunJournal::GetFileName() const noexcept
+{
+    return fileName;
+}
+
+
+string RunJournal::MakeRecord(unsigned long pass, string const &sourceFileName)
+{
+    return to_string(pass) + " " + sourceFileName;
+}
+
+
+bool RunJournal::ReadJournal()
+{
+    ifstream journalFile(fileName);
+    
+    if (not journalFile)  // there is no journal yet
+        return true;
+    
+    string line;
+    
+    while (getline(journalFile, line))
+    {
+        // The last line is incomplete if it is not terminated with the new-line character. It
+        //is skipped as the record might have been cut
+        if (journalFile.eof())
+            return false;
+        
+        // Only accept records that start with the index of a pass
+        auto const sep = line.find(' ');
+        
+        if (sep == 0 or sep == string::npos or sep + 1 == line.size() or
+         line.find_first_not_of("0123456789") != sep)
+            continue;
+        
+        completed.insert(line);
+    }
+    
+    return true;
+}
+
+
+void RunJournal::Write(string const &text)
+{
+    char const *data = text.c_str();
+    size_t nLeft = text.size();
+    
+    while (nLeft > 0)
+    {
+        ssize_t const nWritten = write(fd, data, nLeft);
+        
+        if (nWritten < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            
+            throw runtime_error(string("RunJournal::Write: Failed to write to file \"") +
+             fileName + "\": " + strerror(errno) + ".");
+        }
+        
+        data += nWritten;
+        nLeft -= nWritten;
+    }
+    
+    if (fsync(fd) != 0)
+        throw runtime_error(string("RunJournal::Write: Failed to flush file \"") + fileName +
+         "\": " + strerror(errno) + ".");
+}
@@ -1,15 +1,27 @@
 #include <RunManager.hpp>
 
 #include <Processor.hpp>
+#include <ContentionProfiler.hpp>
+#include <ROOTLock.hpp>
+#include <NumaTopology.hpp>
+#include <ProgressMonitor.hpp>
+#include <TaskChannel.hpp>
+#include <TaskCoordinator.hpp>
 #include <Logger.hpp>
 
 #include <thread>
 #include <vector>
 #include <functional>
+#include <chrono>
+#include <algorithm>
+#include <unordered_map>
+#include <sstream>
 #include <stdexcept>
 
 #include <iostream>
 
+#include <unistd.h>
+
 
 using namespace std;
 using namespace logging;
@@ -19,6 +31,21 @@ using namespace logging;
 //^ Described in the header file
 
 
+RunManager::~RunManager()
+{
+    // Ask the threads in the pool to terminate and wait for them
+    {
+        lock_guard<mutex> lock(poolMutex);
+        stopWorkers = true;
+    }
+    
+    passStarted.notify_all();
+    
+    for (auto &t: workers)
+        t.join();
+}
+
+
 void RunManager::Process(int nThreads)
 {
     // Simply forward to the implementation
@@ -28,8 +55,8 @@ void RunManager::Process(int nThreads)
 
 void RunManager::Process(double loadFraction)
 {
-    // Number of supported concurrent threads (note that it is only a hint)
-    unsigned const nMaxThreads = thread::hardware_concurrency();
+    // Number of CPUs the process is allowed to run on
+    unsigned const nMaxThreads = NumaTopology().GetNumCPUs();
     
     // Call the implementation
     ProcessImp(loadFraction * nMaxThreads);
@@ -38,6 +65,10 @@ void RunManager::Process(double loadFraction)
 
 PECReaderConfig &RunManager::GetPECReaderConfig()
 {
+    if (not readerConfig)
+        throw logic_error("RunManager::GetPECReaderConfig: The configuration has already been "
+         "moved to the thread pool.");
+    
     return *readerConfig.get();
 }
 
@@ -48,6 +79,139 @@ void RunManager::RegisterPlugin(Plugin *plugin)
 }
 
 
+void RunManager::SetContentionProfiling(bool enable /*= true*/) noexcept
+{
+    profileContention = enable;
+}
+
+
+void RunManager::SetThreadPlacement(bool pinThreads_, bool perNodeQueues_ /*= true*/) noexcept
+{
+    pinThreads = pinThreads_;
+    perNodeQueues = perNodeQueues_;
+}
+
+
+void RunManager::SetProgressReport(double interval, string const &statusFileName_ /*= ""*/)
+{
+    progressInterval = interval;
+    statusFileName = statusFileName_;
+}
+
+
+void RunManager::SetJournal(string const &fileName, bool resume /*= true*/)
+{
+    journal.reset(new RunJournal(fileName, resume));
+    
+    if (resume and journal->GetNumCompleted() > 0)
+        logger << timestamp << "Journal \"" << fileName << "\" lists " <<
+         journal->GetNumCompleted() << " processed file(s), which will be skipped." << eom;
+}
+
+
+void RunManager::ProcessDistributed(unsigned nLocalWorkers, string const &address /*= ""*/)
+{
+    if (nLocalWorkers == 0 and address.empty())
+        throw logic_error("RunManager::ProcessDistributed: No local workers are requested, and no "
+         "address is given for remote ones.");
+    
+    string socketAddress(address);
+    
+    if (socketAddress.empty())
+        socketAddress = "/tmp/pecfwk-" + to_string(getpid()) + ".sock";
+    
+    
+    // Collect the datasets to be processed. They are served by the names of their files
+    SkipCompletedDatasets();
+    vector<Dataset> const datasets(TakeDatasets());
+    vector<string> taskNames;
+    
+    for (auto const &d: datasets)
+        taskNames.emplace_back(d.GetFiles().front().name);
+    
+    
+    // Prepare the path. The local workers inherit it when forked
+    PreparePool();
+    pool.front()->CheckDistributedMode();
+    
+    
+    // Start the coordinator and the local workers. The workers only communicate with the
+    //coordinator via the socket; they never return from this block
+    TaskCoordinator coordinator(socketAddress, taskNames, pool.front()->GetPluginNames());
+    
+    logger << timestamp << "Coordinator is listening at \"" << socketAddress << "\", " <<
+     datasets.size() << " file(s) to process." << eom;
+    cout.flush();
+    
+    NumaTopology const topology;
+    unsigned const nNodes = topology.GetNumNodes();
+    
+    for (unsigned i = 0; i < nLocalWorkers; ++i)
+    {
+        // Local workers are spread over NUMA nodes as threads are in ProcessImp
+        auto const &cpus = topology.GetCPUs(i % nNodes);
+        int const cpu = (pinThreads) ? int(cpus[(i / nNodes) % cpus.size()]) : -1;
+        
+        pid_t const pid = fork();
+        
+        if (pid < 0)
+            throw runtime_error("RunManager::ProcessDistributed: Failed to fork a worker "
+             "process.");
+        
+        if (pid == 0)
+        {
+            int status = 0;
+            
+            try
+            {
+                ServeTasks(socketAddress, datasets, cpu);
+            }
+            catch (exception const &e)
+            {
+                logger << "Error in worker process " << getpid() << ": " << e.what() << eom;
+                status = 1;
+            }
+            
+            cout.flush();
+            _exit(status);
+        }
+        
+        coordinator.AddLocalWorker(pid);
+    }
+    
+    
+    // Serve the datasets. Completed files are recorded in the journal
+    auto const startTime = chrono::steady_clock::now();
+    
+    coordinator.Run([this, &taskNames](unsigned long index)
+    {
+        if (journal)
+            journal->MarkCompleted(journalPass, taskNames[index]);
+    });
+    
+    cutFlow = coordinator.GetCutFlow();
+    ++journalPass;
+    
+    logger << timestamp << "All files have been processed." << eom;
+    coordinator.PrintSummary(
+     chrono::duration<double>(chrono::steady_clock::now() - startTime).count());
+}
+
+
+void RunManager::RunWorkerProcess(string const &address)
+{
+    PreparePool();
+    pool.front()->CheckDistributedMode();
+    ServeTasks(address, TakeDatasets());
+}
+
+
+vector<unsigned long> const &RunManager::GetCutFlow() const noexcept
+{
+    return cutFlow;
+}
+
+
 void RunManager::ProcessImp(int nThreads)
 {
     // Check number of threads for adequacy
@@ -55,33 +219,303 @@ void RunManager::ProcessImp(int nThreads)
         throw runtime_error("RunManager::ProcessImp: Requested number of threads is less than "
          "one.");
     
-    if (nThreads > int(datasets.size()))
-        nThreads = datasets.size();
+    // Drop the datasets that have been processed according to the journal
+    SkipCompletedDatasets();
     
+    unsigned nDatasets = 0;
     
-    // Create processing objects. The first one is constructed from this, others are copy-
-    //constructed from the first one
-    vector<Processor> processors;
-    processors.reserve(nThreads);
-    processors.emplace_back(this);
+    for (auto const &q: datasetQueues)
+        nDatasets += q->datasets.size();
     
-    for (auto &p: plugins)
-        processors.front().RegisterPlugin(p.release());
+    // There is no point in more threads than datasets. If no datasets remain (for instance, all
+    //of them are listed in the journal), the pass is still run with a single thread so that the
+    //newly registered plugins are added to the pool and the pass is counted in the journal
+    if (nThreads > int(nDatasets))
+        nThreads = max<int>(nDatasets, 1);
     
-    for (int i = 1; i < nThreads; ++i)
-        processors.emplace_back(processors.front());
     
+    // Input files are opened and closed by the processors without the global ROOT lock, which
+    //relies on the thread-safety mode of ROOT
+    ROOTLock::EnableThreadSafety();
     
-    // Put the processors into separate threads
-    vector<thread> threads;
     
-    for (auto &p: processors)
-        threads.emplace_back(move(p));
+    // Create the pool if it does not exist yet and give it the newly registered plugins. There is
+    //no need to lock the pool since the threads are waiting for a new pass
+    PreparePool();
     
     
-    // Wait for them to finish
-    for (auto &t: threads)
-        t.join();
+    // Extend the pool if needed. Additional processors are copy-constructed from the first one
+    while (pool.size() < unsigned(nThreads))
+        pool.emplace_back(new Processor(*pool.front()));
+    
+    for (unsigned i = workers.size(); i < pool.size(); ++i)
+        workers.emplace_back(&RunManager::RunWorker, this, pool[i].get(), i, passIndex);
+    
+    
+    // Distribute the threads over NUMA nodes if requested. A thread with index i is assigned to
+    //node (i % nNodes), and consecutive threads on the same node get different CPUs
+    if (pinThreads or perNodeQueues)
+    {
+        NumaTopology const topology;
+        unsigned const nNodes = topology.GetNumNodes();
+        unsigned const nQueues = (perNodeQueues) ? max(min<unsigned>(nNodes, nThreads), 1u) : 1;
+        
+        
+        // Redistribute the datasets among the queues in a round-robin manner
+        vector<Dataset> allDatasets(TakeDatasets());
+        datasetQueues.clear();
+        
+        for (unsigned i = 0; i < nQueues; ++i)
+            datasetQueues.emplace_back(new DatasetQueue);
+        
+        for (unsigned i = 0; i < allDatasets.size(); ++i)
+            datasetQueues[i % nQueues]->datasets.push(move(allDatasets[i]));
+        
+        
+        // Assign CPUs and home queues to the processors
+        for (int i = 0; i < nThreads; ++i)
+        {
+            unsigned const node = i % nNodes;
+            auto const &cpus = topology.GetCPUs(node);
+            int const cpu = (pinThreads) ? int(cpus[(i / nNodes) % cpus.size()]) : -1;
+            
+            pool[i]->SetPlacement(cpu, node % nQueues);
+        }
+        
+        logger << timestamp << "Threads are distributed over " << min<unsigned>(nNodes, nThreads) <<
+         " NUMA node(s)" << ((pinThreads) ? " and pinned to CPUs" : "") << ", " << nQueues <<
+         " queue(s) of datasets are used." << eom;
+    }
+    
+    
+    // Set up profiling and progress reports if requested. The statistics are written by the
+    //processors, each one updating its own entry. The pointers are reset otherwise since the
+    //processors outlive this call
+    vector<ContentionProfiler::ThreadStats> threadStats;
+    unique_ptr<ProgressMonitor> progress;
+    
+    if (profileContention)
+    {
+        threadStats.resize(nThreads);
+        ContentionProfiler::Reset();
+        ContentionProfiler::Enable();
+    }
+    
+    if (progressInterval > 0.)
+        progress.reset(new ProgressMonitor(nThreads, nDatasets));
+    
+    for (unsigned i = 0; i < pool.size(); ++i)
+    {
+        bool const active = (i < unsigned(nThreads));
+        pool[i]->SetThreadStats((profileContention and active) ? &threadStats[i] : nullptr);
+        pool[i]->SetProgressSlot((progress and active) ? &progress->GetSlot(i) : nullptr);
+    }
+    
+    if (progress)
+        progress->Start(progressInterval, statusFileName);
+    
+    auto const startTime = chrono::steady_clock::now();
+    
+    
+    // Start a new pass
+    {
+        lock_guard<mutex> lock(poolMutex);
+        nActiveWorkers = nThreads;
+        nBusyWorkers = workers.size();
+        ++passIndex;
+    }
+    
+    passStarted.notify_all();
+    
+    
+    // Wait for all the threads to finish it
+    {
+        unique_lock<mutex> lock(poolMutex);
+        passFinished.wait(lock, [this](){return (nBusyWorkers == 0);});
+    }
+    
+    if (progress)
+        progress->Stop();
     
     logger << timestamp << "All files have been processed." << eom;
-}
\ No newline at end of file
+    
+    
+    // Let the plugins finalize the pass. Only the instances registered by the user are notified
+    pool.front()->EndPass();
+    ++journalPass;
+    
+    
+    // Report the scaling behaviour
+    if (profileContention)
+    {
+        ContentionProfiler::Enable(false);
+        ContentionProfiler::PrintSummary(
+         chrono::duration<double>(chrono::steady_clock::now() - startTime).count(), threadStats);
+    }
+}
+
+
+void RunManager::RunWorker(Processor *processor, unsigned index, unsigned long lastPass)
+{
+    while (true)
+    {
+        // Wait for a new pass or a request to terminate
+        unique_lock<mutex> lock(poolMutex);
+        passStarted.wait(lock, [this, lastPass](){return (stopWorkers or passIndex != lastPass);});
+        
+        if (stopWorkers)
+            return;
+        
+        lastPass = passIndex;
+        bool const active = (index < nActiveWorkers);
+        lock.unlock();
+        
+        
+        // Process datasets until the queues are exhausted
+        if (active)
+            (*processor)();
+        
+        
+        // Report the end of the pass
+        lock.lock();
+        
+        if (--nBusyWorkers == 0)
+            passFinished.notify_all();
+    }
+}
+
+
+void RunManager::PreparePool()
+{
+    // The first processor takes the reader configuration from this
+    if (pool.empty())
+        pool.emplace_back(new Processor(this));
+    
+    
+    // Append the newly registered plugins to the path of every processor
+    for (auto &p: plugins)
+    {
+        for (unsigned i = 1; i < pool.size(); ++i)
+            pool[i]->RegisterPlugin(p->Clone());
+        
+        pool.front()->RegisterPlugin(p.release());
+    }
+    
+    plugins.clear();
+}
+
+
+vector<Dataset> RunManager::TakeDatasets()
+{
+    vector<Dataset> datasets;
+    
+    for (auto &q: datasetQueues)
+    {
+        for (; not q->datasets.empty(); q->datasets.pop())
+            datasets.emplace_back(move(q->datasets.front()));
+    }
+    
+    return datasets;
+}
+
+
+void RunManager::SkipCompletedDatasets()
+{
+    if (not journal)
+        return;
+    
+    unsigned long nSkipped = 0;
+    
+    for (auto &q: datasetQueues)
+    {
+        queue<Dataset> remaining;
+        
+        for (; not q->datasets.empty(); q->datasets.pop())
+        {
+            if (journal->IsCompleted(journalPass, q->datasets.front().GetFiles().front().name))
+                ++nSkipped;
+            else
+                remaining.emplace(move(q->datasets.front()));
+        }
+        
+        q->datasets.swap(remaining);
+    }
+    
+    if (nSkipped > 0)
+        logger << timestamp << nSkipped << " file(s) are skipped as they are listed in " <<
+         "journal \"" << journal->GetFileName() << "\"." << eom;
+}
+
+
+void RunManager::ServeTasks(string const &address, vector<Dataset> const &datasets,
+ int cpu /*= -1*/)
+{
+    // The journal is written by the coordinator only
+    journal.reset();
+    
+    
+    // Index the datasets by the names of their files
+    unordered_map<string, Dataset const *> datasetMap;
+    
+    for (auto const &d: datasets)
+        datasetMap[d.GetFiles().front().name] = &d;
+    
+    
+    // Introduce this worker to the coordinator
+    char hostName[256] = "";
+    gethostname(hostName, sizeof(hostName) - 1);
+    
+    TaskChannel channel(TaskChannel::Connect(address));
+    channel.WriteLine(string("HELLO ") + hostName + ":" + to_string(getpid()));
+    
+    
+    // Process the tasks one by one with the first processor. A task is put in the queue and then
+    //picked up by the processor as in the multithreaded mode
+    Processor &processor = *pool.front();
+    processor.SetPlacement(cpu, 0);
+    
+    vector<unsigned long> taskCutFlow;
+    processor.SetCutFlow(&taskCutFlow);
+    
+    while (true)
+    {
+        channel.WriteLine("GET");
+        string const reply(channel.ReadLine());
+        
+        if (reply == "DONE")
+            break;
+        
+        istringstream ist(reply);
+        string command, fileName;
+        unsigned long index;
+        ist >> command >> index >> ws;
+        getline(ist, fileName);
+        
+        auto const d = datasetMap.find(fileName);
+        
+        if (command != "TASK" or d == datasetMap.end())
+            throw runtime_error("RunManager::ServeTasks: Unexpected task \"" + reply + "\". "
+             "Check that the worker is configured in the same way as the coordinator.");
+        
+        
+        // Process the dataset
+        datasetQueues.front()->datasets.push(*d->second);
+        taskCutFlow.assign(taskCutFlow.size(), 0);
+        
+        auto const start = chrono::steady_clock::now();
+        processor();
+        double const time = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        
+        
+        // Report the result
+        ostringstream ost;
+        ost << "RESULT " << index << " " << time;
+        
+        for (unsigned long const n: taskCutFlow)
+            ost << " " << n;
+        
+        channel.WriteLine(ost.str());
+    }
+    
+    processor.SetCutFlow(nullptr);
+}
@@ -0,0 +1,372 @@
+#include <SyncTreeReader.hpp>
+
+#include <Logger.hpp>
+
+#include <TTree.h>
+#include <TBranch.h>
+
+#include <stdexcept>
+#include <sstream>
+#include <algorithm>
+#include <cstring>
+
+
+using namespace std;
+using namespace logging;
+
+
+SyncTreeReader::SyncTreeReader() noexcept:
+    cacheSize(0),
+    nEntries(0), curEntry(0),
+    nBranchReads(0)
+{}
+
+
+void SyncTreeReader::AddTree(TTree *tree, string const &alias, unsigned group)
+{
+    if (not tree)
+        throw runtime_error(string("SyncTreeReader::AddTree: Tree \"") + alias +
+         "\" is not available.");
+    
+    unsigned long const nEntriesTree = tree->GetEntries();
+    
+    if (not trees.empty() and nEntriesTree != nEntries)
+    {
+        ostringstream ost;
+        ost << "SyncTreeReader::AddTree: Tree \"" << alias << "\" contains " << nEntriesTree <<
+         " entries while the trees registered earlier contain " << nEntries << " entries.";
+        
+        throw runtime_error(ost.str());
+    }
+    
+    trees.push_back({tree, alias, group, {}});
+    nEntries = nEntriesTree;
+    curEntry = 0;
+}
+
+
+unsigned SyncTreeReader::Bind(string const &name, void *address, unsigned elementSize,
+ unsigned maxElements, unsigned char const *count, unsigned group)
+{
+    // Check if the name is qualified with an alias of a tree. Note that the aliases might contain
+    //dots themselves
+    auto const dotPos = name.find_last_of('.');
+    TBranch *branch = nullptr;
+    TreeInfo *treeInfo = nullptr;
+    
+    if (dotPos != string::npos)
+    {
+        string const alias(name.substr(0, dotPos));
+        
+        for (auto &t: trees)
+            if (t.alias == alias)
+            {
+                treeInfo = &t;
+                branch = t.tree->GetBranch(name.substr(dotPos + 1).c_str());
+                break;
+            }
+    }
+    
+    
+    // If the name is not qualified, search for the branch in all the trees
+    if (not treeInfo)
+    {
+        for (auto &t: trees)
+        {
+            branch = t.tree->GetBranch(name.c_str());
+            
+            if (branch)
+            {
+                treeInfo = &t;
+                break;
+            }
+        }
+    }
+    
+    if (not branch)
+        throw runtime_error(string("SyncTreeReader::SetBranchAddress: Branch \"") + name +
+         "\" is not found in the registered trees.");
+    
+    
+    branch->SetAddress(address);
+    
+    columns.push_back({treeInfo->alias + "." + branch->GetName(), branch, address, elementSize,
+     maxElements, count, (group == treeGroup) ? treeInfo->group : group});
+    treeInfo->columns.push_back(columns.size() - 1);
+    
+    return columns.size() - 1;
+}
+
+
+void SyncTreeReader::SetCacheSize(long long cacheSize_) noexcept
+{
+    cacheSize = cacheSize_;
+}
+
+
+void SyncTreeReader::Prepare()
+{
+    // Split the branches into groups. A tree without bound branches is included in its group so
+    //that it is notified about the entry being read
+    groups.clear();
+    
+    for (unsigned iTree = 0; iTree < trees.size(); ++iTree)
+    {
+        auto const &t = trees[iTree];
+        
+        auto addToGroup = [this, iTree](unsigned group) -> GroupEntry &
+        {
+            if (group >= groups.size())
+                groups.resize(group + 1);
+            
+            for (auto &entry: groups[group])
+                if (entry.tree == iTree)
+                    return entry;
+            
+            groups[group].push_back({iTree, {}});
+            return groups[group].back();
+        };
+        
+        if (t.columns.empty())
+            addToGroup(t.group);
+        
+        for (unsigned c: t.columns)
+            addToGroup(columns[c].group).columns.push_back(c);
+    }
+    
+    
+    for (auto &t: trees)
+    {
+        // Trees without bound branches are left untouched because their branches are managed
+        //elsewhere
+        if (not t.columns.empty())
+        {
+            t.tree->SetBranchStatus("*", false);
+            
+            for (unsigned c: t.columns)
+                columns[c].branch->SetStatus(true);
+        }
+        
+        // Trees with bound branches are not read when the column cache is attached, so they do
+        //not need TTreeCache
+        if (cacheSize > 0 and (t.columns.empty() or not cache.IsOpen()))
+            SetUpTreeCache(t, GetNumCacheShares());
+    }
+}
+
+
+bool SyncTreeReader::AttachCache(string const &path, uint64_t sourceSize, int64_t sourceMTime)
+{
+    // Compute the hash of the set of columns (FNV-1a). It includes names of the branches and
+    //sizes of the buffers
+    uint64_t hash = 14695981039346656037ULL;
+    
+    auto addToHash = [&hash](void const *data, unsigned nBytes)
+    {
+        for (unsigned i = 0; i < nBytes; ++i)
+        {
+            hash ^= static_cast<unsigned char const *>(data)[i];
+            hash *= 1099511628211ULL;
+        }
+    };
+    
+    for (auto const &c: columns)
+    {
+        addToHash(c.name.c_str(), c.name.size() + 1);
+        addToHash(&c.elementSize, sizeof(c.elementSize));
+        addToHash(&c.maxElements, sizeof(c.maxElements));
+        
+        bool const isArray = (c.count != nullptr);
+        addToHash(&isArray, sizeof(isArray));
+    }
+    
+    ColumnCacheKey const key{sourceSize, sourceMTime, hash, nEntries, unsigned(columns.size())};
+    
+    
+    // Maximal sizes of values, which are the sizes of the buffers
+    vector<unsigned> maxSizes;
+    
+    for (auto const &c: columns)
+        maxSizes.push_back(c.elementSize * c.maxElements);
+    
+    
+    // Try to use an existing cache. If it does not exist, is outdated, or is corrupted, create it
+    if (cache.Open(path, key, maxSizes))
+        return true;
+    
+    if (not BuildCache(path, key) or not cache.Open(path, key, maxSizes))
+    {
+        logger << "Warning in SyncTreeReader::AttachCache: Failed to create column cache \"" <<
+         path << "\". The source trees will be read directly." << eom;
+        return false;
+    }
+    
+    return true;
+}
+
+
+void SyncTreeReader::Clear() noexcept
+{
+    cache.Close();
+    groups.clear();
+    columns.clear();
+    trees.clear();
+    nEntries = curEntry = 0;
+    nBranchReads = 0;
+}
+
+
+unsigned long SyncTreeReader::GetEntries() const noexcept
+{
+    return nEntries;
+}
+
+
+unsigned long SyncTreeReader::GetCurrentEntry() const noexcept
+{
+    return curEntry;
+}
+
+
+bool SyncTreeReader::AtEnd() const noexcept
+{
+    return (curEntry >= nEntries);
+}
+
+
+void SyncTreeReader::NextEntry() noexcept
+{
+    ++curEntry;
+}
+
+
+unsigned long long SyncTreeReader::GetNumBranchReads() const noexcept
+{
+    return nBranchReads;
+}
+
+
+void SyncTreeReader::ReadGroup(unsigned group)
+{
+    ReadGroup(group, curEntry);
+}
+
+
+void SyncTreeReader::ReadGroup(unsigned group, unsigned long entry)
+{
+    if (group >= groups.size())
+        return;
+    
+    for (auto const &g: groups[group])
+    {
+        nBranchReads += g.columns.size();
+        
+        if (cache.IsOpen() and not g.columns.empty())
+        {
+            // Copy the values from the mapped cache file
+            for (unsigned c: g.columns)
+            {
+                unsigned nBytes;
+                void const *data = cache.GetData(c, entry, nBytes);
+                memcpy(columns[c].address, data, nBytes);
+            }
+        }
+        else
+        {
+            // Notify the tree about the entry being read so that TTreeCache can prefetch the
+            //baskets
+            trees[g.tree].tree->LoadTree(entry);
+            
+            for (unsigned c: g.columns)
+                columns[c].branch->GetEntry(entry);
+        }
+    }
+}
+
+
+TTree *SyncTreeReader::GetTree(string const &alias) const noexcept
+{
+    for (auto const &t: trees)
+        if (t.alias == alias)
+            return t.tree;
+    
+    return nullptr;
+}
+
+
+bool SyncTreeReader::BuildCache(string const &path, ColumnCacheKey const &key)
+{
+    logger << "Creating column cache \"" << path << "\"..." << eom;
+    ColumnCacheWriter writer(path, key);
+    
+    
+    // The trees are read through TTreeCache while the cache is being built. It is released
+    //afterwards and set up again in Prepare if the column cache turns out to be unusable
+    unsigned const nShares = GetNumCacheShares();
+    
+    if (cacheSize > 0)
+        for (auto const &t: trees)
+            if (not t.columns.empty())
+                SetUpTreeCache(t, nShares);
+    
+    
+    // Copy all the entries
+    for (unsigned long entry = 0; entry < nEntries and not writer.Failed(); ++entry)
+    {
+        // Read all the bound branches
+        for (auto &t: trees)
+        {
+            if (t.columns.empty())
+                continue;
+            
+            t.tree->LoadTree(entry);
+            
+            for (unsigned c: t.columns)
+                columns[c].branch->GetEntry(entry);
+        }
+        
+        
+        // Store their values. Elements beyond the capacity of a buffer are never available to the
+        //user and are not stored
+        for (unsigned c = 0; c < columns.size(); ++c)
+        {
+            auto const &col = columns[c];
+            unsigned const nElements =
+             (col.count) ? min<unsigned>(*col.count, col.maxElements) : 1;
+            
+            writer.Append(c, col.address, nElements * col.elementSize);
+        }
+        
+        writer.EndEntry();
+    }
+    
+    if (cacheSize > 0)
+        for (auto const &t: trees)
+            if (not t.columns.empty())
+                t.tree->SetCacheSize(0);
+    
+    return writer.Finish();
+}
+
+
+unsigned SyncTreeReader::GetNumCacheShares() const noexcept
+{
+    // A tree without bound branches (for instance, a tree read by a different object) is given
+    //a share as if it had one branch
+    unsigned nShares = 0;
+    
+    for (auto const &t: trees)
+        nShares += (t.columns.empty()) ? 1 : t.columns.size();
+    
+    return nShares;
+}
+
+
+void SyncTreeReader::SetUpTreeCache(TreeInfo const &tree, unsigned nShares)
+{
+    tree.tree->SetCacheSize(cacheSize * ((tree.columns.empty()) ? 1 : tree.columns.size()) /
+     nShares);
+    
+    for (unsigned c: tree.columns)
+        tree.tree->AddBranchToCache(columns[c].branch);
+}
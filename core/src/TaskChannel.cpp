@@ -0,0 +1,276 @@
+#include <TaskChannel.hpp>
+
+#include <stdexcept>
+#include <thread>
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+
+using namespace std;
+
+
+TaskChannel::TaskChannel(int fd_) noexcept:
+    fd(fd_)
+{}
+
+
+TaskChannel::TaskChannel(TaskChannel &&src) noexcept:
+    fd(src.fd),
+    buffer(move(src.buffer))
+{
+    src.fd = -1;
+}
+
+
+TaskChannel::~TaskChannel()
+{
+    if (fd >= 0)
+        close(fd);
+}
+
+
+int TaskChannel::Listen(string const &address)
+{
+    string host, port;
+    int listenFD = -1;
+    
+    if (SplitTCPAddress(address, host, port))
+    {
+        // Resolve the address and bind to the first suitable one
+        addrinfo hints;
+        memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        hints.ai_flags = AI_PASSIVE;
+        
+        addrinfo *result;
+        int const error = getaddrinfo((host == "*") ? nullptr : host.c_str(), port.c_str(), &hints,
+         &result);
+        
+        if (error != 0)
+            throw runtime_error(string("TaskChannel::Listen: Cannot resolve address \"") +
+             address + "\": " + gai_strerror(error) + ".");
+        
+        for (addrinfo *a = result; a; a = a->ai_next)
+        {
+            listenFD = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+            
+            if (listenFD < 0)
+                continue;
+            
+            int const reuse = 1;
+            setsockopt(listenFD, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+            
+            if (bind(listenFD, a->ai_addr, a->ai_addrlen) == 0)
+                break;
+            
+            close(listenFD);
+            listenFD = -1;
+        }
+        
+        freeaddrinfo(result);
+    }
+    else
+    {
+        sockaddr_un sockAddr;
+        memset(&sockAddr, 0, sizeof(sockAddr));
+        sockAddr.sun_family = AF_UNIX;
+        
+        if (address.length() >= sizeof(sockAddr.sun_path))
+            throw runtime_error(string("TaskChannel::Listen: Path \"") + address + "\" is too "
+             "long for a socket.");
+        
+        strcpy(sockAddr.sun_path, address.c_str());
+        unlink(address.c_str());
+        
+        listenFD = socket(AF_UNIX, SOCK_STREAM, 0);
+        
+        if (listenFD >= 0 and bind(listenFD, (sockaddr *)&sockAddr, sizeof(sockAddr)) != 0)
+        {
+            close(listenFD);
+            listenFD = -1;
+        }
+    }
+    
+    if (listenFD < 0 or listen(listenFD, SOMAXCONN) != 0)
+    {
+        if (listenFD >= 0)
+            close(listenFD);
+        
+        throw runtime_error(string("TaskChannel::Listen: Cannot listen at address \"") + address +
+         "\": " + strerror(errno) + ".");
+    }
+    
+    return listenFD;
+}
+
+
+TaskChannel TaskChannel::Connect(string const &address, unsigned timeout /*= 30*/)
+{
+    string host, port;
+    bool const isTCP = SplitTCPAddress(address, host, port);
+    
+    for (unsigned attempt = 0; ; ++attempt)
+    {
+        int connFD = -1;
+        
+        if (isTCP)
+        {
+            addrinfo hints;
+            memset(&hints, 0, sizeof(hints));
+            hints.ai_family = AF_UNSPEC;
+            hints.ai_socktype = SOCK_STREAM;
+            
+            addrinfo *result;
+            int const error = getaddrinfo(host.c_str(), port.c_str(), &hints, &result);
+            
+            if (error != 0)
+                throw runtime_error(string("TaskChannel::Connect: Cannot resolve address \"") +
+                 address + "\": " + gai_strerror(error) + ".");
+            
+            for (addrinfo *a = result; a; a = a->ai_next)
+            {
+                connFD = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+                
+                if (connFD < 0)
+                    continue;
+                
+                if (connect(connFD, a->ai_addr, a->ai_addrlen) == 0)
+                    break;
+                
+                close(connFD);
+                connFD = -1;
+            }
+            
+            freeaddrinfo(result);
+        }
+        else
+        {
+            sockaddr_un sockAddr;
+            memset(&sockAddr, 0, sizeof(sockAddr));
+            sockAddr.sun_family = AF_UNIX;
+            strncpy(sockAddr.sun_path, address.c_str(), sizeof(sockAddr.sun_path) - 1);
+            
+            connFD = socket(AF_UNIX, SOCK_STREAM, 0);
+            
+            if (connFD >= 0 and connect(connFD, (sockaddr *)&sockAddr, sizeof(sockAddr)) != 0)
+            {
+                close(connFD);
+                connFD = -1;
+            }
+        }
+        
+        if (connFD >= 0)
+            return TaskChannel(connFD);
+        
+        if (attempt >= timeout)
+            throw runtime_error(string("TaskChannel::Connect: Cannot connect to address \"") +
+             address + "\".");
+        
+        this_thread::sleep_for(chrono::seconds(1));
+    }
+}
+
+
+bool TaskChannel::IsLocalAddress(string const &address)
+{
+    string host, port;
+    return not SplitTCPAddress(address, host, port);
+}
+
+
+int TaskChannel::GetDescriptor() const noexcept
+{
+    return fd;
+}
+
+
+bool TaskChannel::Receive()
+{
+    char chunk[4096];
+    ssize_t n;
+    
+    do
+        n = read(fd, chunk, sizeof(chunk));
+    while (n < 0 and errno == EINTR);
+    
+    if (n <= 0)
+        return false;
+    
+    buffer.append(chunk, n);
+    return true;
+}
+
+
+bool TaskChannel::PopLine(string &line)
+{
+    auto const pos = buffer.find('\n');
+    
+    if (pos == string::npos)
+        return false;
+    
+    line = buffer.substr(0, pos);
+    buffer.erase(0, pos + 1);
+    return true;
+}
+
+
+string TaskChannel::ReadLine()
+{
+    string line;
+    
+    while (not PopLine(line))
+    {
+        if (not Receive())
+            throw runtime_error("TaskChannel::ReadLine: The connection has been closed.");
+    }
+    
+    return line;
+}
+
+
+void TaskChannel::WriteLine(string const &line)
+{
+    string const message(line + "\n");
+    char const *data = message.c_str();
+    size_t nLeft = message.size();
+    
+    while (nLeft > 0)
+    {
+        // The flag prevents SIGPIPE if the other side has closed the connection
+        ssize_t const n = send(fd, data, nLeft, MSG_NOSIGNAL);
+        
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            
+            throw runtime_error(string("TaskChannel::WriteLine: Failed to send a message: ") +
+             strerror(errno) + ".");
+        }
+        
+        data += n;
+        nLeft -= n;
+    }
+}
+
+
+bool TaskChannel::SplitTCPAddress(string const &address, string &host, string &port)
+{
+    // A path to a Unix domain socket might contain a colon, but then it also contains a slash
+    auto const pos = address.rfind(':');
+    
+    if (pos == string::npos or address.find('/') != string::npos)
+        return false;
+    
+    host = address.substr(0, pos);
+    port = address.substr(pos + 1);
+    return true;
+}
@@ -0,0 +1,339 @@
+#include <TaskCoordinator.hpp>
+
+#include <Logger.hpp>
+
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <stdexcept>
+#include <cerrno>
+#include <cstring>
+
+#include <unistd.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+
+using namespace std;
+using namespace logging;
+
+
+TaskCoordinator::Connection::Connection(int fd):
+    channel(fd),
+    worker("unknown"),
+    task(-1),
+    waiting(false)
+{}
+
+
+TaskCoordinator::WorkerStats::WorkerStats() noexcept:
+    nTasks(0), nEvents(0), time(0.)
+{}
+
+
+TaskCoordinator::TaskCoordinator(string const &address_, vector<string> const &taskNames_,
+ vector<string> const &pluginNames_, unsigned maxAttempts_ /*= 3*/):
+    address(address_),
+    listenFD(TaskChannel::Listen(address_)),
+    taskNames(taskNames_), pluginNames(pluginNames_),
+    maxAttempts(maxAttempts_),
+    nAttempts(taskNames_.size(), 0),
+    nCompleted(0),
+    nLocalWorkersTotal(0),
+    cutFlow(pluginNames_.size(), 0)
+{
+    for (unsigned long i = 0; i < taskNames.size(); ++i)
+        pending.push_back(i);
+}
+
+
+TaskCoordinator::~TaskCoordinator()
+{
+    close(listenFD);
+    
+    if (TaskChannel::IsLocalAddress(address))
+        unlink(address.c_str());
+    
+    
+    // Local workers might still be running if the processing has been aborted
+    for (pid_t const pid: localWorkers)
+    {
+        kill(pid, SIGTERM);
+        waitpid(pid, nullptr, 0);
+    }
+}
+
+
+void TaskCoordinator::AddLocalWorker(pid_t pid)
+{
+    localWorkers.push_back(pid);
+    ++nLocalWorkersTotal;
+}
+
+
+void TaskCoordinator::Run(function<void(unsigned long)> const &onCompleted)
+{
+    list<Connection> connections;
+    
+    // The loop continues after all the tasks have been completed until every local worker has
+    //terminated. A local worker might connect only at this point (e.g. if there were no tasks at
+    //all), and it must still be told to stop
+    ReapLocalWorkers();
+    
+    while (nCompleted < taskNames.size() or not connections.empty() or not localWorkers.empty())
+    {
+        // Without local workers and connected ones the remaining tasks can never be completed
+        if (nCompleted < taskNames.size() and nLocalWorkersTotal > 0 and localWorkers.empty() and
+         connections.empty())
+            throw runtime_error("TaskCoordinator::Run: All worker processes have terminated while "
+             "some files have not been processed.");
+        
+        
+        // Wait for new connections or messages. The timeout allows to check the local workers
+        vector<pollfd> fds(1 + connections.size());
+        fds[0].fd = listenFD;
+        fds[0].events = POLLIN;
+        
+        unsigned i = 1;
+        
+        for (auto const &c: connections)
+        {
+            fds[i].fd = c.channel.GetDescriptor();
+            fds[i].events = POLLIN;
+            ++i;
+        }
+        
+        if (poll(fds.data(), fds.size(), 1000) < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            
+            throw runtime_error(string("TaskCoordinator::Run: Call to poll has failed: ") +
+             strerror(errno) + ".");
+        }
+        
+        
+        // Read the messages. A connection that has been closed or has sent an invalid message is
+        //dropped, and its task is returned to the queue
+        i = 1;
+        
+        for (auto c = connections.begin(); c != connections.end(); ++i)
+        {
+            bool alive = true;
+            
+            if (fds[i].revents != 0)
+            {
+                alive = c->channel.Receive();
+                string message;
+                
+                while (alive and c->channel.PopLine(message))
+                    alive = HandleMessage(*c, message, onCompleted);
+            }
+            
+            if (alive)
+                ++c;
+            else
+            {
+                RequeueTask(*c);
+                c = connections.erase(c);
+            }
+        }
+        
+        
+        // Accept a new connection
+        if (fds[0].revents & POLLIN)
+        {
+            int const fd = accept(listenFD, nullptr, nullptr);
+            
+            if (fd >= 0)
+                connections.emplace_back(fd);
+        }
+        
+        
+        ServeWaiting(connections);
+        ReapLocalWorkers();
+    }
+}
+
+
+vector<unsigned long> const &TaskCoordinator::GetCutFlow() const noexcept
+{
+    return cutFlow;
+}
+
+
+void TaskCoordinator::PrintSummary(double wallTime) const
+{
+    // The lines are formatted in separate streams so that the state of the standard output stream
+    //used by the logger is not altered
+    ostringstream ost;
+    ost << fixed;
+    
+    
+    // Summary for the whole run
+    unsigned long const nEventsTotal = (cutFlow.empty()) ? 0 : cutFlow.front();
+    
+    ost << setprecision(2) << "Distributed processing summary: " << nCompleted << " file(s), " <<
+     workerStats.size() << " worker(s), wall time " << wallTime << " s, " << nEventsTotal <<
+     " events (" << setprecision(0) << nEventsTotal / wallTime << " events/s).";
+    logger << ost.str() << eom;
+    
+    
+    // Merged cut-flow
+    unsigned nameWidth = 0;
+    
+    for (auto const &name: pluginNames)
+        nameWidth = max<unsigned>(nameWidth, name.length());
+    
+    for (unsigned i = 0; i < cutFlow.size(); ++i)
+    {
+        ost.str("");
+        ost << "  " << left << setw(nameWidth) <<
+         ((i < pluginNames.size()) ? pluginNames[i] : string("?")) << right << setw(14) <<
+         cutFlow[i];
+        logger << ost.str() << eom;
+    }
+    
+    
+    // Activity of individual workers
+    for (auto const &w: workerStats)
+    {
+        ost.str("");
+        ost << setprecision(2) << "  Worker " << w.first << ": " << w.second.nTasks <<
+         " file(s), " << w.second.nEvents << " events, busy " << w.second.time << " s.";
+        logger << ost.str() << eom;
+    }
+}
+
+
+bool TaskCoordinator::HandleMessage(Connection &connection, string const &message,
+ function<void(unsigned long)> const &onCompleted)
+{
+    istringstream ist(message);
+    string command;
+    ist >> command;
+    
+    if (command == "HELLO")
+    {
+        ist >> ws;
+        getline(ist, connection.worker);
+        
+        logger << timestamp << "Worker " << connection.worker << " has connected." << eom;
+        return true;
+    }
+    else if (command == "GET")
+    {
+        connection.waiting = true;
+        return true;
+    }
+    else if (command == "RESULT")
+    {
+        long index;
+        double time;
+        ist >> index >> time;
+        
+        vector<unsigned long> counts;
+        unsigned long count;
+        
+        while (ist >> count)
+            counts.push_back(count);
+        
+        if (ist.eof() and index == connection.task and counts.size() == cutFlow.size())
+        {
+            // Merge the result
+            for (unsigned i = 0; i < counts.size(); ++i)
+                cutFlow[i] += counts[i];
+            
+            WorkerStats &stats = workerStats[connection.worker];
+            ++stats.nTasks;
+            stats.nEvents += (counts.empty()) ? 0 : counts.front();
+            stats.time += time;
+            
+            ++nCompleted;
+            connection.task = -1;
+            
+            onCompleted(index);
+            return true;
+        }
+    }
+    
+    logger << "Warning in TaskCoordinator::HandleMessage: Unexpected message \"" << message <<
+     "\" from worker " << connection.worker << ". The connection is closed." << eom;
+    return false;
+}
+
+
+void TaskCoordinator::ServeWaiting(list<Connection> &connections)
+{
+    for (auto &c: connections)
+    {
+        if (not c.waiting)
+            continue;
+        
+        try
+        {
+            if (not pending.empty())
+            {
+                c.task = pending.front();
+                pending.pop_front();
+                ++nAttempts[c.task];
+                c.waiting = false;
+                
+                ostringstream ost;
+                ost << "TASK " << c.task << " " << taskNames[c.task];
+                c.channel.WriteLine(ost.str());
+            }
+            else if (nCompleted == taskNames.size())
+            {
+                c.waiting = false;
+                c.channel.WriteLine("DONE");
+            }
+        }
+        catch (runtime_error const &)
+        {
+            // The worker has disconnected. This is detected when the socket is polled next time,
+            //and the task is then returned to the queue
+        }
+    }
+}
+
+
+void TaskCoordinator::RequeueTask(Connection &connection)
+{
+    if (connection.task < 0)
+        return;
+    
+    string const &fileName = taskNames[connection.task];
+    
+    if (nAttempts[connection.task] >= maxAttempts)
+        throw runtime_error(string("TaskCoordinator::RequeueTask: Processing of file \"") +
+         fileName + "\" has failed " + to_string(nAttempts[connection.task]) + " times.");
+    
+    logger << "Warning in TaskCoordinator::RequeueTask: Worker " << connection.worker <<
+     " has failed to process file \"" << fileName << "\". The file will be reprocessed." << eom;
+    
+    pending.push_front(connection.task);
+    connection.task = -1;
+}
+
+
+void TaskCoordinator::ReapLocalWorkers()
+{
+    for (auto it = localWorkers.begin(); it != localWorkers.end(); )
+    {
+        int status;
+        
+        if (waitpid(*it, &status, WNOHANG) == *it)
+        {
+            if (not WIFEXITED(status) or WEXITSTATUS(status) != 0)
+                logger << "Warning in TaskCoordinator::ReapLocalWorkers: Worker process " << *it <<
+                 " has terminated abnormally." << eom;
+            
+            it = localWorkers.erase(it);
+        }
+        else
+            ++it;
+    }
+}
@@ -46,6 +46,18 @@ bool TriggerRange::InRange(EventID const &eventID) const
 }
 
 
+EventID const &TriggerRange::GetFirstEvent() const
+{
+    return firstEvent;
+}
+
+
+EventID const &TriggerRange::GetLastEvent() const
+{
+    return lastEvent;
+}
+
+
 bool TriggerRange::PassEventSelection(PECReader const &reader) const
 {
     if (eventSelection)  // i.e. there is a valid event selection defined
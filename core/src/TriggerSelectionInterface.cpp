@@ -36,3 +36,16 @@ TriggerSelectionInterface &TriggerSelectionInterface::operator=(TriggerSelection
     
     return *this;
 }
+
+
+bool TriggerSelectionInterface::ReadEvent(unsigned long entry, EventID const &eventID)
+{
+    nextEntryTree = entry;
+    return ReadNextEvent(eventID);
+}
+
+
+bool TriggerSelectionInterface::RequiresEventID() const
+{
+    return true;
+}
@@ -65,6 +65,9 @@ class BasicKinematicsPlugin: public Plugin
         /// Directory to store output files
         std::string outDirectory;
         
+        /// Name of the current output file
+        std::string outFileName;
+        
         /// Current output file
         TFile *file;
         
@@ -0,0 +1,137 @@
+/**
+ * \file EventShapes.hpp
+ * \author Andrey Popov
+ * 
+ * The module defines a class to calculate event-shape variables.
+ */
+
+#pragma once
+
+#include <TLorentzVector.h>
+
+#include <array>
+
+
+/**
+ * \class EventShapes
+ * \brief Calculates event-shape variables for a set of three-momenta
+ * 
+ * The user adds momenta with the help of method AddMomentum and then reads the variables. The
+ * following variables are supported:
+ *   - sphericity and aplanarity, which are built from eigenvalues of the quadratic momentum tensor
+ *     S_ab = sum p_a p_b / sum |p|^2;
+ *   - C and D parameters, which are built from eigenvalues of the linearised momentum tensor
+ *     Theta_ab = sum p_a p_b / |p| / sum |p|;
+ *   - thrust, T = max_n sum |p.n| / sum |p|.
+ * 
+ * Eigenvalues of the symmetric 3x3 tensors are found with a closed-form trigonometric solution.
+ * They are calculated on the first access to a variable and cached until the set of momenta is
+ * changed. Thrust is found exactly by examining all the partitions of the momenta induced by planes
+ * spanned by pairs of momenta; the complexity is cubic in the number of momenta, which is
+ * acceptable for typical jet multiplicities. Momenta and tensors are stored in fixed-size arrays,
+ * and the class performs no dynamic memory allocations. It is intended to be used as a local
+ * variable or a member of a plugin and reused from event to event.
+ * 
+ * The class is copyable. It is not thread-safe.
+ */
+class EventShapes
+{
+public:
+    /// Maximal number of momenta that can be added
+    static unsigned const maxMomenta = 64;
+
+public:
+    /// Constructor with no parameters
+    EventShapes() noexcept;
+
+public:
+    /// Removes all the momenta
+    void Reset() noexcept;
+    
+    /**
+     * \brief Adds a three-momentum
+     * 
+     * Throws an exception if the maximal number of momenta is exceeded. Null momenta are ignored.
+     */
+    void AddMomentum(double px, double py, double pz);
+    
+    /// Adds the spatial part of the given four-momentum
+    void AddMomentum(TLorentzVector const &p4);
+    
+    /// Returns the number of momenta added
+    unsigned GetNumMomenta() const noexcept;
+    
+    /// Returns sphericity, 1.5 (lambda2 + lambda3)
+    double Sphericity() const noexcept;
+    
+    /// Returns aplanarity, 1.5 lambda3
+    double Aplanarity() const noexcept;
+    
+    /// Returns the C parameter, 3 (lambda1 lambda2 + lambda1 lambda3 + lambda2 lambda3)
+    double C() const noexcept;
+    
+    /// Returns the D parameter, 27 lambda1 lambda2 lambda3
+    double D() const noexcept;
+    
+    /// Returns thrust
+    double Thrust() const noexcept;
+    
+    /**
+     * \brief Returns eigenvalues of the normalised quadratic momentum tensor
+     * 
+     * The eigenvalues are sorted in the decreasing order.
+     */
+    std::array<double, 3> const &GetSphericityEigenvalues() const noexcept;
+    
+    /**
+     * \brief Returns eigenvalues of the normalised linearised momentum tensor
+     * 
+     * The eigenvalues are sorted in the decreasing order.
+     */
+    std::array<double, 3> const &GetLinearEigenvalues() const noexcept;
+    
+    /**
+     * \brief Calculates eigenvalues of a symmetric 3x3 matrix
+     * 
+     * The matrix is given by its independent elements (a00, a11, a22, a01, a02, a12). The
+     * eigenvalues are sorted in the decreasing order. The method can be used independently of the
+     * rest of the class.
+     */
+    static std::array<double, 3> SymmetricEigenvalues(std::array<double, 6> const &a) noexcept;
+
+private:
+    /// Calculates the eigenvalues if they are not up to date
+    void UpdateEigenvalues() const noexcept;
+
+private:
+    /// Number of momenta added
+    unsigned nMomenta;
+    
+    /// Components of the added momenta
+    std::array<double, maxMomenta> px, py, pz;
+    
+    /// Sum of |p|^2 over all the momenta
+    double sumP2;
+    
+    /// Sum of |p| over all the momenta
+    double sumP;
+    
+    /**
+     * \brief Independent elements of the (unnormalised) quadratic momentum tensor
+     * 
+     * The order is xx, yy, zz, xy, xz, yz.
+     */
+    std::array<double, 6> quadraticTensor;
+    
+    /// Independent elements of the (unnormalised) linearised momentum tensor in the same order
+    std::array<double, 6> linearTensor;
+    
+    /// Indicates whether the eigenvalues below correspond to the current set of momenta
+    mutable bool eigenvaluesValid;
+    
+    /// Eigenvalues of the normalised quadratic tensor in the decreasing order
+    mutable std::array<double, 3> quadraticEigenvalues;
+    
+    /// Eigenvalues of the normalised linearised tensor in the decreasing order
+    mutable std::array<double, 3> linearEigenvalues;
+};
@@ -65,6 +65,17 @@ public:
      * Consult documentation of the overriden method for details.
      */
     bool ProcessEvent();
+    
+    /**
+     * \brief Registers the selection in the reader to be evaluated right after the event ID is read
+     * 
+     * Consult documentation of the overriden method for details.
+     */
+    bool RegisterEarlyFilters(PECReader &reader) const;
+
+private:
+    /// Checks if the event in the given reader passes the selection
+    bool IsAccepted(PECReader const &r) const;
 
 private:
     /// Pointer to PECReaderPlugin
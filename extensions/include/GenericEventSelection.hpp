@@ -10,10 +10,10 @@
 #include <EventSelectionInterface.hpp>
 #include <BTagger.hpp>
 
-#include <list>
+#include <vector>
 #include <array>
-#include <map>
 #include <memory>
+#include <cstdint>
 
 
 /**
@@ -26,29 +26,19 @@
  * Each instance of class PECReader must exploit its own copy of class GenericEventSelection, which
  * can be achieved with the help of method Clone.
  * 
+ * The configuration is stored in flat arrays: lepton thresholds are kept in sorted vectors, and the
+ * allowed jet-tag bins are encoded as bit masks indexed with the jet multiplicity. B-tagging
+ * decisions for the default working point are read from the jets, in which PECReader caches them
+ * (see BTagger::TagJets). Thus, the selection performs no allocations and no look-ups in
+ * associative containers. If the numbers of leptons are known
+ * at compile time, consider StaticEventSelection instead.
+ * 
  * Consult documentation for the base class for details of the interface.
  * 
  * The class is copyable.
  */
 class GenericEventSelection: public EventSelectionInterface
 {
-    private:
-        /**
-         * \struct JetTagBin
-         * \brief Defines a single bin for jet selection
-         */
-        struct JetTagBin
-        {
-            /// Default constructor
-            JetTagBin() = default;
-            
-            /// Constructor with parameters
-            JetTagBin(unsigned nJets_, unsigned nTags_);
-            
-            unsigned nJets;  ///< Number of jets
-            unsigned nTags;  ///< Number of b-tagged jets
-        };
-    
     public:
         /**
          * \brief Constructor
@@ -110,12 +100,16 @@ class GenericEventSelection: public EventSelectionInterface
          * The method increases the number of required leptons of the given flavour by one and
          * sets the pt threshold for the new lepton.
          * 
-         * \note The method is implemented in such a way that the underlying lists of thresholds
+         * \note The method is implemented in such a way that the underlying vectors of thresholds
          * are ordered at every moment.
          */
         void AddLeptonThreshold(Lepton::Flavour flavour, double ptThreshold);
         
-        /// Extends the selection on jets with a given jet-tag bin
+        /**
+         * \brief Extends the selection on jets with a given jet-tag bin
+         * 
+         * The number of tags must be smaller than 64, otherwise an exception is thrown.
+         */
         void AddJetTagBin(unsigned nJets, unsigned nTags);
         
         /**
@@ -126,16 +120,32 @@ class GenericEventSelection: public EventSelectionInterface
         EventSelectionInterface *Clone() const;
     
     private:
-        /// Map from lepton flavours to integers starting from zero
-        std::map<Lepton::Flavour, unsigned> flavourMap;
-        
-        /// Iterators of the current positions in the lists of lepton pt thresholds
-        mutable std::array<std::list<double>::const_iterator, 3> leptonThresholdIts;
+        /**
+         * \brief Maps a lepton flavour to an index in leptonPtThresholds
+         * 
+         * Throws an exception if the flavour is unknown.
+         */
+        static unsigned FlavourIndex(Lepton::Flavour flavour);
+    
+    private:
+        /**
+         * \brief Pt thresholds for leptons of each flavour
+         * 
+         * The vectors are indexed with FlavourIndex. Each one is sorted in the decreasing order.
+         */
+        std::array<std::vector<double>, 3> leptonPtThresholds;
         
-        /// The three lists of lepton pt thresholds (one for each lepton flavour)
-        std::array<std::list<double>, 3> leptonPtThresholds;
+        /// Total number of required leptons of all flavours
+        unsigned nLeptonsRequired;
         
         double jetPtThreshold;  ///< Minimum pt for analysis-level jets
         std::shared_ptr<BTagger const> bTagger;  ///< The b-tagging object
-        std::list<JetTagBin> jetBins;  ///< List of allowed jet-tag bins
+        
+        /**
+         * \brief Allowed jet-tag bins
+         * 
+         * The vector is indexed with the number of jets. The bit with index n is set if the bin
+         * with n b-tagged jets is allowed.
+         */
+        std::vector<std::uint64_t> jetTagMasks;
 };
\ No newline at end of file
@@ -0,0 +1,226 @@
+/**
+ * \file HistogramPlugin.hpp
+ * \author Andrey Popov
+ * 
+ * The module defines a plugin to fill histograms of expressions over the event.
+ */
+
+#pragma once
+
+#include <Plugin.hpp>
+#include <PECReaderPlugin.hpp>
+#include <SystDefinition.hpp>
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <functional>
+
+
+/**
+ * \class HistogramPlugin
+ * \brief A plugin to fill 1D and 2D histograms with uniform binning
+ * 
+ * Each histogram is booked with a name, binning, and functions that compute the filled quantities
+ * from the current event. Every histogram is filled with the central weight and, optionally, with
+ * systematical variations of the weight as returned by PECReader::GetSystWeight for the sources
+ * registered with method AddSystWeights. Varied histograms are named "<name>_<label>Up" and
+ * "<name>_<label>Down", with the index of the variation appended to the label if the source
+ * provides more than one pair.
+ * 
+ * No ROOT objects are involved in the filling. Each clone of the plugin (i.e. each thread)
+ * accumulates sums of weights and of squared weights in a flat array of its own, allocated when
+ * the first dataset is opened so that it is placed in the memory local to the thread. Bins of all
+ * the histograms are stored one after another, each one with its under- and overflows following
+ * the global numbering of bins in ROOT, and for every bin the values for all the weights are
+ * adjacent. Filling of an event thus updates a short contiguous block in each of the two arrays
+ * per histogram.
+ * 
+ * The content accumulated by a clone is added to a merged array shared by all the clones at the
+ * end of each dataset, which is the only place where a lock is taken. The merged histograms are
+ * converted into ROOT objects and written into a single file in EndPass, i.e. at the end of each
+ * call to RunManager::Process. If the manager processes several passes, the file is rewritten
+ * each time and includes all the datasets processed so far. The file is created under a temporary
+ * name and renamed once complete.
+ * 
+ * The plugin does not support RunManager::ProcessDistributed since the worker processes would
+ * accumulate the histograms separately and none of them would write the output.
+ * 
+ * The functions are copied when the plugin is cloned and must not depend on the state of a
+ * particular clone. Histograms and sources of variations must be booked before the processing
+ * starts.
+ */
+class HistogramPlugin: public Plugin
+{
+public:
+    /// Function to compute a filled quantity from the current event
+    typedef std::function<double(PECReader const &)> Expression;
+
+private:
+    /// Description of a histogram
+    struct Histogram
+    {
+        std::string name, title;
+        
+        /// Numbers of bins and ranges along the axes (nBinsY is zero for a 1D histogram)
+        unsigned nBinsX, nBinsY;
+        double minX, maxX, minY, maxY;
+        
+        /// Inverse widths of bins, precomputed to locate the bins
+        double invWidthX, invWidthY;
+        
+        /// Functions to compute the filled quantities
+        Expression x, y;
+        
+        /// Index of the first cell (the underflow bin) of this histogram in the flat arrays
+        unsigned long offset;
+        
+        /// Number of cells, including the under- and overflows
+        unsigned long nCells;
+    };
+    
+    /// A source of systematical variations of the weight
+    struct SystSource
+    {
+        SystTypeWeight type;
+        std::string label;
+        unsigned nPairs;
+    };
+    
+    /// Configuration and merged content of the histograms, shared among all the clones
+    struct Accumulator
+    {
+        /// Constructor
+        Accumulator(std::string const &outFileName);
+        
+        /// Creates ROOT histograms and writes them into the output file
+        void Write() const;
+        
+        /// Name of the output file
+        std::string outFileName;
+        
+        /// Booked histograms and sources of weight variations
+        std::vector<Histogram> histograms;
+        std::vector<SystSource> systSources;
+        
+        /// Total number of cells in all the histograms and number of weights per cell
+        unsigned long nCells;
+        unsigned nWeights;
+        
+        /// Indicates that the processing has started, so no more bookings are allowed
+        bool frozen;
+        
+        /// Merged sums of weights and squared weights and numbers of entries in the histograms
+        std::vector<double> sumW, sumW2;
+        std::vector<unsigned long> nEntries;
+        
+        /// Mutex to protect the merged content
+        std::mutex mutex;
+    };
+
+public:
+    /**
+     * \brief Constructor
+     * 
+     * The name must be unique among plugins in the same path.
+     */
+    HistogramPlugin(std::string const &outFileName, std::string const &name = "Histograms");
+
+public:
+    /**
+     * \brief Creates a newly-initialized copy
+     * 
+     * The copy shares the booked histograms and the merged content with this.
+     */
+    Plugin *Clone() const;
+    
+    /**
+     * \brief Notifies this that a dataset has been opened
+     * 
+     * Prevents further bookings and allocates the arrays of this clone when called for the first
+     * time.
+     */
+    void BeginRun(Dataset const &dataset);
+    
+    /**
+     * \brief Notifies this that a dataset has been closed
+     * 
+     * Adds the content accumulated by this clone to the merged histograms.
+     */
+    void EndRun();
+    
+    /**
+     * \brief Processes the current event
+     * 
+     * Fills all the histograms. Always returns true.
+     */
+    bool ProcessEvent();
+    
+    /**
+     * \brief Writes the merged histograms
+     * 
+     * Nothing is written if no dataset has been processed. Throws an exception if the output
+     * file cannot be written.
+     */
+    void EndPass();
+    
+    /// Returns false since the histograms are only written in EndPass
+    bool SupportsDistributedMode() const;
+    
+    /**
+     * \brief Books a 1D histogram
+     * 
+     * Throws an exception if a histogram with the same name has already been booked or the
+     * processing has already started.
+     */
+    void Book1D(std::string const &name, std::string const &title, unsigned nBins, double min,
+     double max, Expression const &x);
+    
+    /**
+     * \brief Books a 2D histogram
+     * 
+     * Throws an exception if a histogram with the same name has already been booked or the
+     * processing has already started.
+     */
+    void Book2D(std::string const &name, std::string const &title, unsigned nBinsX, double minX,
+     double maxX, unsigned nBinsY, double minY, double maxY, Expression const &x,
+     Expression const &y);
+    
+    /**
+     * \brief Requests histograms filled with systematical variations of the weight
+     * 
+     * The given number of pairs of variations is taken from PECReader::GetSystWeight for the
+     * given source. If the reader provides fewer pairs (e.g. the corresponding module is not
+     * configured) or the dataset is real data, the central weight is used for the missing ones.
+     * The user must instruct PECReader to calculate the variations. Throws an exception if the
+     * processing has already started.
+     */
+    void AddSystWeights(SystTypeWeight type, std::string const &label, unsigned nPairs = 1);
+
+private:
+    /// Finds the global index of the bin in a histogram, including under- and overflows
+    static unsigned long FindBin(Histogram const &h, double x, double y);
+    
+    /// Throws an exception if the processing has started
+    void CheckNotFrozen(std::string const &method) const;
+
+private:
+    /// Pointer to PECReaderPlugin
+    PECReaderPlugin const *reader;
+    
+    /// Configuration and merged content shared among the clones
+    std::shared_ptr<Accumulator> accumulator;
+    
+    /// Indicates if the current dataset is simulation
+    bool isMC;
+    
+    /// Sums of weights and squared weights accumulated by this clone
+    std::vector<double> sumW, sumW2;
+    
+    /// Numbers of entries accumulated by this clone
+    std::vector<unsigned long> nEntries;
+    
+    /// Weights of the current event (the central one goes first)
+    std::vector<double> weights;
+};
@@ -62,6 +62,17 @@ public:
     /// Peforms filtering
     virtual bool ProcessEvent();
     
+    /**
+     * \brief Registers the selection in the reader to be evaluated at the jet stage
+     * 
+     * Consult documentation of the overriden method for details.
+     */
+    virtual bool RegisterEarlyFilters(PECReader &reader) const;
+    
+private:
+    /// Checks if the event in the given reader passes the selection
+    bool IsAccepted(PECReader const &r) const;
+    
 private:
     /// Generic selection on jets
     std::function<bool(Jet const &)> const &selection;
@@ -45,6 +45,17 @@ public:
     /// Peforms filtering
     bool ProcessEvent();
     
+    /**
+     * \brief Registers the selection in the reader to be evaluated at the jet stage
+     * 
+     * Consult documentation of the overriden method for details.
+     */
+    bool RegisterEarlyFilters(PECReader &reader) const;
+    
+private:
+    /// Checks if the event in the given reader passes the selection
+    bool IsAccepted(PECReader const &r) const;
+    
 private:
     /// Pointer to the reader plugin
     PECReaderPlugin const *reader;
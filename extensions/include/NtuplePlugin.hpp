@@ -0,0 +1,279 @@
+/**
+ * \file NtuplePlugin.hpp
+ * \author Andrey Popov
+ * 
+ * The module defines a plugin to store a configurable set of variables in a ROOT tree.
+ */
+
+#pragma once
+
+#include <Plugin.hpp>
+#include <PECReaderPlugin.hpp>
+
+#include <TFile.h>
+#include <TTree.h>
+#include <TLorentzVector.h>
+
+#include <string>
+#include <vector>
+#include <functional>
+
+
+/**
+ * \class NtuplePlugin
+ * \brief A plugin to store variables defined as expressions over the current event
+ * 
+ * Each output variable is registered with a name and a function that computes its value from
+ * the current event. Quantities shared between several variables (for instance, four-momentum of
+ * the reconstructed W boson) are registered as named intermediates with methods DefineScalar and
+ * DefineP4. Variables access them through the evaluation context with the help of returned
+ * handles. An intermediate is evaluated at most once per event and only if some variable or
+ * another intermediate requests it, so that dependencies are resolved on demand.
+ * 
+ * By default all the registered variables are written. With method RequestVariables the user can
+ * restrict the output to a subset of them; variables that are not requested are not evaluated,
+ * and neither are intermediates needed only for them.
+ * 
+ * A common set of kinematical variables, which covers BasicKinematicsPlugin and most of
+ * SingleTopTChanPlugin, is registered with the help of method AddStandardVariables.
+ * 
+ * The plugin writes one file per dataset, named after the first file of the dataset, with a tree
+ * "Vars". Functions provided by the user are copied when the plugin is cloned and must therefore
+ * not depend on the state of a particular clone; all per-event information should be obtained
+ * from the context.
+ */
+class NtuplePlugin: public Plugin
+{
+public:
+    class Context;
+    
+    /// Function to compute a scalar quantity
+    typedef std::function<double(Context &)> ScalarFunction;
+    
+    /// Function to compute a four-momentum
+    typedef std::function<TLorentzVector(Context &)> P4Function;
+    
+    /// Function to decide if an event should be stored
+    typedef std::function<bool(Context &)> EventFilter;
+    
+    /// Handle to access a scalar intermediate quantity
+    struct ScalarHandle
+    {
+        unsigned index;
+    };
+    
+    /// Handle to access a four-momentum intermediate quantity
+    struct P4Handle
+    {
+        unsigned index;
+    };
+    
+    /// Supported types of output branches
+    enum class Type
+    {
+        Float,
+        Int,
+        ULong64
+    };
+    
+    /**
+     * \class Context
+     * \brief Provides access to the current event and memoised intermediate quantities
+     */
+    class Context
+    {
+        friend class NtuplePlugin;
+    
+    public:
+        /// Constructor with no parameters
+        Context() noexcept;
+    
+    public:
+        /// Provides access to the reader
+        PECReader const *operator->() const;
+        
+        /// Provides access to the reader
+        PECReader const &operator*() const;
+        
+        /// Returns value of a scalar intermediate quantity, evaluating it if needed
+        double Get(ScalarHandle handle);
+        
+        /// Returns value of a four-momentum intermediate quantity, evaluating it if needed
+        TLorentzVector const &Get(P4Handle handle);
+    
+    private:
+        /// Sets the reader for the current event and invalidates all memoised values
+        void NewEvent(PECReader const *reader);
+    
+    private:
+        /// Reader of the current event
+        PECReader const *reader;
+        
+        /**
+         * \brief Index of the current event
+         * 
+         * A memoised value is valid if its generation coincides with this number.
+         */
+        unsigned long generation;
+        
+        /// Definitions and memoised values of scalar intermediate quantities
+        std::vector<ScalarFunction> scalarFunctions;
+        std::vector<double> scalarValues;
+        std::vector<unsigned long> scalarGenerations;
+        
+        /// Definitions and memoised values of four-momentum intermediate quantities
+        std::vector<P4Function> p4Functions;
+        std::vector<TLorentzVector> p4Values;
+        std::vector<unsigned long> p4Generations;
+    };
+
+private:
+    /// Description of an output variable
+    struct Variable
+    {
+        std::string name;
+        ScalarFunction function;
+        Type type;
+        bool mcOnly;
+    };
+    
+    /// Buffer to store value of an output variable
+    union Buffer
+    {
+        Float_t f;
+        Int_t i;
+        ULong64_t ul;
+    };
+
+public:
+    /**
+     * \brief Constructor
+     * 
+     * The name must be unique among plugins in the same path.
+     */
+    NtuplePlugin(std::string const &outDirectory, std::string const &name = "Ntuple");
+
+public:
+    /**
+     * \brief Creates a newly-initialized copy
+     * 
+     * Consult documentation of the overriden method for details.
+     */
+    Plugin *Clone() const;
+    
+    /**
+     * \brief Notifies this that a dataset has been opened
+     * 
+     * Creates the output file and the tree with branches for the requested variables. Throws an
+     * exception if a requested variable has not been registered.
+     */
+    void BeginRun(Dataset const &dataset);
+    
+    /**
+     * \brief Notifies this that a dataset has been closed
+     * 
+     * Consult documentation of the overriden method for details.
+     */
+    void EndRun();
+    
+    /**
+     * \brief Processes the current event
+     * 
+     * Evaluates the requested variables and fills the tree. Returns false if the event is rejected
+     * by the filter.
+     */
+    bool ProcessEvent();
+    
+    /**
+     * \brief Registers a named scalar intermediate quantity
+     * 
+     * Throws an exception if an intermediate with the same name has already been registered.
+     */
+    ScalarHandle DefineScalar(std::string const &name, ScalarFunction const &function);
+    
+    /**
+     * \brief Registers a named four-momentum intermediate quantity
+     * 
+     * Throws an exception if an intermediate with the same name has already been registered.
+     */
+    P4Handle DefineP4(std::string const &name, P4Function const &function);
+    
+    /// Returns handle of a registered scalar intermediate; throws an exception if not found
+    ScalarHandle GetScalarHandle(std::string const &name) const;
+    
+    /// Returns handle of a registered four-momentum intermediate; throws an exception if not found
+    P4Handle GetP4Handle(std::string const &name) const;
+    
+    /**
+     * \brief Registers an output variable
+     * 
+     * If mcOnly is true, the variable is not stored for real data. Throws an exception if a
+     * variable with the same name has already been registered.
+     */
+    void AddVariable(std::string const &name, ScalarFunction const &function,
+     Type type = Type::Float, bool mcOnly = false);
+    
+    /**
+     * \brief Restricts the output to the given variables
+     * 
+     * Repeated calls extend the list. If the method is never called, all the registered variables
+     * are stored.
+     */
+    void RequestVariables(std::vector<std::string> const &names);
+    
+    /// Sets a filter to select events to be stored
+    void SetEventFilter(EventFilter const &filter);
+    
+    /**
+     * \brief Registers a common set of kinematical variables and intermediates
+     * 
+     * The variables are event ID (run, event, lumiSection), properties of the leading lepton
+     * (Pt_Lep, Eta_Lep), MET (MET, Phi_MET, MtW), properties of the two leading jets (Pt_J1,
+     * Eta_J1, Pt_J2, Eta_J2, M_J1J2, DR_J1J2, Pt_J1J2), multijet variables (Ht, M_JW),
+     * sphericity (Sphericity), nPV, and the central weight (weight, MC only). Variables that
+     * cannot be calculated in an event are set to zero. The intermediates are four-momenta "p4W",
+     * "p4J1J2", and "p4AllJets".
+     */
+    void AddStandardVariables();
+
+private:
+    /// Finds index of a variable with the given name; returns -1 if not found
+    int FindVariable(std::string const &name) const;
+
+private:
+    /// Pointer to PECReaderPlugin
+    PECReaderPlugin const *reader;
+    
+    /// Directory to store output files
+    std::string outDirectory;
+    
+    /// Names of scalar and four-momentum intermediates
+    std::vector<std::string> scalarNames, p4Names;
+    
+    /// Evaluation context, which also holds definitions of intermediates
+    Context context;
+    
+    /// Registered output variables
+    std::vector<Variable> variables;
+    
+    /// Names of requested variables (empty if all variables are requested)
+    std::vector<std::string> requestedNames;
+    
+    /// Filter to select events (may be empty)
+    EventFilter filter;
+    
+    /// Indices of variables that are evaluated in the current dataset
+    std::vector<unsigned> activeVariables;
+    
+    /// Output buffers, one per registered variable
+    std::vector<Buffer> buffers;
+    
+    /// Name of the current output file
+    std::string outFileName;
+    
+    /// Current output file
+    TFile *file;
+    
+    /// Current output tree
+    TTree *tree;
+};
@@ -70,6 +70,9 @@ class SingleTopTChanPlugin: public Plugin
         /// Directory to store output files
         std::string outDirectory;
         
+        /// Name of the current output file
+        std::string outFileName;
+        
         /// Current output file
         TFile *file;
         
@@ -0,0 +1,260 @@
+/**
+ * \file StaticEventSelection.hpp
+ * \author Andrey Popov
+ * 
+ * The module defines a class template to implement an event selection with the lepton content
+ * fixed at compile time.
+ */
+
+#pragma once
+
+#include <EventSelectionInterface.hpp>
+#include <BTagger.hpp>
+
+#include <array>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <sstream>
+#include <cstdint>
+
+
+/**
+ * \class StaticEventSelection
+ * \brief An event selection whose lepton content and maximal jet multiplicity are fixed at compile
+ * time
+ * 
+ * The class is a specialised alternative to GenericEventSelection, intended for high-rate skims.
+ * The numbers of required electrons and muons are template parameters, and their pt thresholds are
+ * stored in arrays of fixed size. Events with tau leptons or leptons of unknown flavour are
+ * rejected. The allowed jet-tag bins are encoded in an array of bit masks indexed with the jet
+ * multiplicity, which cannot exceed the template parameter maxJets. B-tagging decisions for the
+ * default working point of the given b-tagger are read from the jets, in which PECReader caches
+ * them (see BTagger::TagJets).
+ * 
+ * The selection functions PassLeptons and PassJets are non-virtual and perform no allocations. They
+ * can be called directly when the type of the selection is known. The virtual methods of the
+ * interface forward to them.
+ * 
+ * Consult documentation for the base class for details of the interface. The class is copyable.
+ */
+template<unsigned nElectrons, unsigned nMuons, unsigned maxJets = 15>
+class StaticEventSelection: public EventSelectionInterface
+{
+    static_assert(maxJets < 64, "StaticEventSelection: Too large maximal number of jets.");
+
+public:
+    /**
+     * \brief Constructor
+     * 
+     * The first two arguments are pt thresholds for electrons and muons. They need not be ordered.
+     * Other parameters are jet pt threshold and b-tagging object. The latter is copied and can
+     * be destroyed after the constructor returns.
+     */
+    StaticEventSelection(std::array<double, nElectrons> const &electronPtThresholds,
+     std::array<double, nMuons> const &muonPtThresholds, double jetPtThreshold,
+     BTagger const &bTagger);
+
+public:
+    /**
+     * \brief Performs the event selection on leptons
+     * 
+     * Semantics is identical to GenericEventSelection::PassLeptonStep.
+     */
+    bool PassLeptons(std::vector<Lepton> const &tightLeptons,
+     std::vector<Lepton> const &looseLeptons) const;
+    
+    /**
+     * \brief Performs the event selection on jets
+     * 
+     * Semantics is identical to GenericEventSelection::PassJetStep.
+     */
+    bool PassJets(std::vector<Jet> const &jets) const;
+    
+    /// Calls PassLeptons
+    virtual bool PassLeptonStep(std::vector<Lepton> const &tightLeptons,
+     std::vector<Lepton> const &looseLeptons) const;
+    
+    /// Calls PassJets
+    virtual bool PassJetStep(std::vector<Jet> const &jets) const;
+    
+    /**
+     * \brief Checks if a jet is to be used in high-level analysis
+     * 
+     * See also documentation of the overridden method in the base class.
+     */
+    virtual bool IsAnalysisJet(Jet const &jet) const;
+    
+    /**
+     * \brief Extends the selection on jets with a given jet-tag bin
+     * 
+     * Throws an exception if the number of jets exceeds maxJets or the number of tags exceeds the
+     * number of jets.
+     */
+    void AddJetTagBin(unsigned nJets, unsigned nTags);
+    
+    /**
+     * \brief Creates a newly-initialized copy of this
+     * 
+     * Consult documentation for the base class for details.
+     */
+    virtual EventSelectionInterface *Clone() const;
+
+private:
+    /// Pt thresholds for electrons sorted in the decreasing order
+    std::array<double, nElectrons> electronPtThresholds;
+    
+    /// Pt thresholds for muons sorted in the decreasing order
+    std::array<double, nMuons> muonPtThresholds;
+    
+    double jetPtThreshold;  ///< Minimum pt for analysis-level jets
+    
+    /**
+     * \brief A copy of the b-tagging object
+     * 
+     * It is used to evaluate b-tagging decisions for the default working point.
+     */
+    BTagger bTagger;
+    
+    /**
+     * \brief Allowed jet-tag bins
+     * 
+     * The array is indexed with the number of jets. The bit with index n is set if the bin with n
+     * b-tagged jets is allowed.
+     */
+    std::array<std::uint64_t, maxJets + 1> jetTagMasks;
+};
+
+
+template<unsigned nElectrons, unsigned nMuons, unsigned maxJets>
+StaticEventSelection<nElectrons, nMuons, maxJets>::StaticEventSelection(
+ std::array<double, nElectrons> const &electronPtThresholds_,
+ std::array<double, nMuons> const &muonPtThresholds_, double jetPtThreshold_,
+ BTagger const &bTagger_):
+    EventSelectionInterface(),
+    electronPtThresholds(electronPtThresholds_), muonPtThresholds(muonPtThresholds_),
+    jetPtThreshold(jetPtThreshold_),
+    bTagger(bTagger_)
+{
+    // Sort the thresholds in the decreasing order as it is done in GenericEventSelection
+    std::sort(electronPtThresholds.begin(), electronPtThresholds.end(), std::greater<double>());
+    std::sort(muonPtThresholds.begin(), muonPtThresholds.end(), std::greater<double>());
+    
+    jetTagMasks.fill(0);
+}
+
+
+template<unsigned nElectrons, unsigned nMuons, unsigned maxJets>
+bool StaticEventSelection<nElectrons, nMuons, maxJets>::PassLeptons(
+ std::vector<Lepton> const &tightLeptons, std::vector<Lepton> const &looseLeptons) const
+{
+    // The total number of tight leptons must match the number of thresholds, and there must be no
+    //additional loose leptons. See GenericEventSelection::PassLeptonStep for the reasoning
+    if (tightLeptons.size() != nElectrons + nMuons or looseLeptons.size() != nElectrons + nMuons)
+        return false;
+    
+    
+    // Check the leptons of each flavour against the corresponding thresholds. Both the leptons and
+    //the thresholds are ordered in pt
+    unsigned nEle = 0, nMu = 0;
+    
+    for (auto const &lep: tightLeptons)
+    {
+        switch (lep.GetFlavour())
+        {
+            case Lepton::Flavour::Electron:
+                if (nEle == nElectrons or lep.Pt() < electronPtThresholds[nEle])
+                    return false;
+                
+                ++nEle;
+                break;
+            
+            case Lepton::Flavour::Muon:
+                if (nMu == nMuons or lep.Pt() < muonPtThresholds[nMu])
+                    return false;
+                
+                ++nMu;
+                break;
+            
+            default:
+                return false;
+        }
+    }
+    
+    
+    // Since the total number of leptons is correct and no flavour has too many leptons, the event
+    //passes the selection
+    return true;
+}
+
+
+template<unsigned nElectrons, unsigned nMuons, unsigned maxJets>
+bool StaticEventSelection<nElectrons, nMuons, maxJets>::PassJets(std::vector<Jet> const &jets)
+ const
+{
+    // Reject the event immediately if no bin with the given jet multiplicity is allowed
+    unsigned const nJets = jets.size();
+    
+    if (nJets > maxJets or jetTagMasks[nJets] == 0)
+        return false;
+    
+    
+    // Count b-tagged jets. The decisions cached in the jets by PECReader are read when they have
+    //been evaluated by a compatible b-tagger
+    unsigned nTags = 0;
+    
+    for (auto const &j: jets)
+        if (bTagger.IsTagged(j))
+            ++nTags;
+    
+    
+    return ((jetTagMasks[nJets] >> nTags) & 1);
+}
+
+
+template<unsigned nElectrons, unsigned nMuons, unsigned maxJets>
+bool StaticEventSelection<nElectrons, nMuons, maxJets>::PassLeptonStep(
+ std::vector<Lepton> const &tightLeptons, std::vector<Lepton> const &looseLeptons) const
+{
+    return PassLeptons(tightLeptons, looseLeptons);
+}
+
+
+template<unsigned nElectrons, unsigned nMuons, unsigned maxJets>
+bool StaticEventSelection<nElectrons, nMuons, maxJets>::PassJetStep(std::vector<Jet> const &jets)
+ const
+{
+    return PassJets(jets);
+}
+
+
+template<unsigned nElectrons, unsigned nMuons, unsigned maxJets>
+bool StaticEventSelection<nElectrons, nMuons, maxJets>::IsAnalysisJet(Jet const &jet) const
+{
+    return (jet.Pt() > jetPtThreshold);
+}
+
+
+template<unsigned nElectrons, unsigned nMuons, unsigned maxJets>
+void StaticEventSelection<nElectrons, nMuons, maxJets>::AddJetTagBin(unsigned nJets,
+ unsigned nTags)
+{
+    if (nJets > maxJets or nTags > nJets)
+    {
+        std::ostringstream ost;
+        ost << "StaticEventSelection::AddJetTagBin: Jet-tag bin (" << nJets << ", " << nTags <<
+         ") is not supported. Maximal number of jets is " << maxJets << ".";
+        
+        throw std::logic_error(ost.str());
+    }
+    
+    jetTagMasks[nJets] |= std::uint64_t(1) << nTags;
+}
+
+
+template<unsigned nElectrons, unsigned nMuons, unsigned maxJets>
+EventSelectionInterface *StaticEventSelection<nElectrons, nMuons, maxJets>::Clone() const
+{
+    return new StaticEventSelection<nElectrons, nMuons, maxJets>(*this);
+}
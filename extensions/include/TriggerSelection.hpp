@@ -16,9 +16,14 @@
 #include <map>
 #include <memory>
 #include <utility>
+#include <cstdint>
 #include <stdexcept>
 
 
+// Forward declarations
+class TBranch;
+
+
 /**
  * \class TriggerSelectionData
  * \brief Implements a generic trigger selection for real data
@@ -31,6 +36,12 @@
  * (optinal) event selection specified in the corresponding TriggerRange object; thus, the weight
  * returned is either 0. or 1.
  * 
+ * The trigger ranges are kept sorted by their first event, and the range that contains a given
+ * event is found with a binary search. Branches of all the trigger ranges are resolved once when
+ * a new trigger tree is set. The decision is read with TBranch::GetEntry from the only branch
+ * needed for the current range, bypassing the generic machinery of TTree::GetEntry. Optionally,
+ * the branch can be read for all entries in one bulk pass (see SetPreloadTriggerBits).
+ * 
  * The class is not thread-safe.
  */
 class TriggerSelectionData: public TriggerSelectionInterface
@@ -45,7 +56,7 @@ class TriggerSelectionData: public TriggerSelectionInterface
          * by this.
          * 
          * The trigger ranges given to the constructor are expected not to overlap. Otherwise the
-         * behaviour of trigger selection is undefined.
+         * behaviour of trigger selection is undefined. The ranges need not be ordered.
          */
         template<typename C>
         TriggerSelectionData(C const &ranges);
@@ -54,17 +65,31 @@ class TriggerSelectionData: public TriggerSelectionInterface
          * \brief Constructs an instance from a vector of pointers to TriggerRange objets
          * 
          * The objects must be available during the lifetime of this. They are not owned by this.
+         * The ranges need not be ordered.
          */
         TriggerSelectionData(std::vector<TriggerRange const *> const &ranges);
     
     public:
+        /**
+         * \brief Requests that trigger decisions are preloaded
+         * 
+         * If the flag is true, decisions of a trigger are read for all entries of the trigger tree
+         * in one bulk pass when the trigger is needed for the first time in the current file. They
+         * are stored in a packed bitset, and no further reading is performed for the file. By
+         * default the decisions are read event by event.
+         */
+        void SetPreloadTriggerBits(bool preload = true);
+        
         /**
          * \brief Resets the pointer to the trigger tree
          * 
          * Consult documentation of the overridden method in the base class for a description of
          * the purpose of this method. The value of second argument is ignored.
          * 
-         * Implimentation in this class simply updates the pointer and corresponding counters.
+         * Implimentation in this class updates the pointer and corresponding counters and looks up
+         * branches for all the trigger ranges. Only the found branches are enabled in the tree,
+         * and their buffer addresses are set. If a branch is missing, no exception is thrown at
+         * this point since the corresponding range might be irrelevant for the file.
          */
         virtual void UpdateTree(TTree *triggerTree, bool);
         
@@ -76,7 +101,9 @@ class TriggerSelectionData: public TriggerSelectionInterface
          * 
          * Before reading the next entry from the tree, the method checks if the trigger range
          * corresponding to the given event ID is different from the one used with previous event.
-         * If it is the case, it changes the branch which is read from the tree.
+         * If it is the case, it changes the branch which is read from the tree. An exception is
+         * thrown if the branch of the new range is not stored in the tree. Only this branch is
+         * read, unless the decisions have been preloaded.
          */
         virtual bool ReadNextEvent(EventID const &eventID);
         
@@ -106,22 +133,63 @@ class TriggerSelectionData: public TriggerSelectionInterface
          */
         virtual TriggerSelectionInterface *Clone() const;
     
+    private:
+        /// Sorts the trigger ranges by their first event
+        void SortRanges();
+        
+        /**
+         * \brief Finds the trigger range that contains the given event
+         * 
+         * Performs a binary search in the sorted collection of ranges. Returns the index of the
+         * found range or -1 if no range contains the event.
+         */
+        int FindRange(EventID const &eventID) const;
+    
     private:
         /**
          * \brief Pointers to TriggerRange objects that define the trigger selection
          * 
          * The pointed-to objects must be available during the lifetime of this. They are not owned
-         * by this.
+         * by this. The vector is sorted by the first event of the ranges.
          */
         std::vector<TriggerRange const *> ranges;
         
         /**
-         * \brief Pointer to the current TriggerRange object
+         * \brief Distinct branches of the trigger tree used by the trigger ranges
+         * 
+         * The vector is filled anew whenever a trigger tree is set.
+         */
+        std::vector<TBranch *> branches;
+        
+        /**
+         * \brief Indices of branches for the trigger ranges
+         * 
+         * The vector is parallel to ranges. Its elements are indices in the vector branches. If
+         * the trigger of a range is not stored in the current tree, the index is -1.
+         */
+        std::vector<int> branchIndices;
+        
+        /// Indicates whether the trigger decisions should be preloaded
+        bool preloadBits;
+        
+        /**
+         * \brief Preloaded decisions of the triggers
+         * 
+         * The vector is parallel to branches. Each element is a packed bitset indexed with the
+         * entry number in the trigger tree. It is empty until the branch is needed.
+         */
+        std::vector<std::vector<std::uint64_t>> preloadedBits;
+        
+        /**
+         * \brief Index of the current TriggerRange object
          * 
          * If the current event does not match any TriggerRange object or no attempt to find the
-         * corresponding range has been made yet, the poiter is null.
+         * corresponding range has been made yet, the index is -1.
          */
-        TriggerRange const *currentRange;
+        int currentRangeIndex;
+        
+        /// Index of the branch that corresponds to the current range
+        int currentBranchIndex;
         
         /// The buffer into which results of the selected trigger are read
         Bool_t eventAccepted;
@@ -131,7 +199,8 @@ class TriggerSelectionData: public TriggerSelectionInterface
 template<typename C>
 TriggerSelectionData::TriggerSelectionData(C const &ranges_):
     TriggerSelectionInterface(),
-    currentRange(nullptr)
+    preloadBits(false),
+    currentRangeIndex(-1), currentBranchIndex(-1)
 {
     // First a sanity check
     if (ranges_.size() == 0)
@@ -144,6 +213,8 @@ TriggerSelectionData::TriggerSelectionData(C const &ranges_):
     
     for (typename C::const_iterator it = ranges_.cbegin(); it != ranges_.cend(); ++it)
         ranges.push_back(&*it);
+    
+    SortRanges();
 }
 
 
@@ -187,15 +258,26 @@ class TriggerSelectionMC: public TriggerSelectionInterface
         ~TriggerSelectionMC();
     
     public:
+        /**
+         * \brief Requests that trigger decisions are preloaded
+         * 
+         * If the flag is true, decisions of all the needed triggers are read for all entries of
+         * the trigger tree in one bulk pass when the tree is set. They are stored in packed
+         * bitsets, and no further reading is performed for the file. By default the decisions are
+         * read event by event.
+         */
+        void SetPreloadTriggerBits(bool preload = true);
+        
         /**
          * \brief Resets the pointer to the trigger tree
          * 
          * Consult documentation of the overridden method in the base class for a description of
          * the purpose of this method. The value of second argument is ignored.
          * 
-         * Updates the pointer and corresponding counters. Sets addresses for branches of the
-         * new trigger tree containining information about all the MC triggers specified in the
-         * TriggerRange objects. The second argument is ignored.
+         * Updates the pointer and corresponding counters. Enables and sets addresses for branches
+         * of the new trigger tree containining information about all the MC triggers specified in
+         * the TriggerRange objects; all other branches are disabled. The second argument is
+         * ignored.
          */
         virtual void UpdateTree(TTree *triggerTree, bool);
         
@@ -205,11 +287,23 @@ class TriggerSelectionMC: public TriggerSelectionInterface
          * Consult documentation of the overridden method in the base class for a description of
          * the purpose of this method.
          * 
-         * Reads all the active branches to the corresponding buffers. Throws an exception in case
-         * the tree has not been specified. The argument is ignored.
+         * Reads the branches with decisions of the needed triggers to the corresponding buffers
+         * using TBranch::GetEntry (or takes the decisions from the preloaded bitsets). Throws an
+         * exception in case the tree has not been specified. The argument is ignored.
          */
         virtual bool ReadNextEvent(EventID const &);
         
+        /**
+         * \brief Checks whether the trigger decision depends on the event ID
+         * 
+         * Consult documentation of the overridden method in the base class for a description of
+         * the purpose of this method.
+         * 
+         * The selection in simulation does not depend on the event ID, and the method returns
+         * false.
+         */
+        virtual bool RequiresEventID() const;
+        
         /**
          * \brief Checks if the current event is accepted by the corresponding triggers
          * 
@@ -273,16 +367,35 @@ class TriggerSelectionMC: public TriggerSelectionInterface
          * 
          * Points to a dinamycally allocated array. The buffers are normally accessed via pointers
          * in ranges::value_type::second. This variable is only used to initialise them and set
-         * branches' addresses.
+         * branches' addresses. The array is allocated once and reused for all trigger trees.
          */
         Bool_t *buffer;
+        
+        /**
+         * \brief Distinct branches of the trigger tree that are read
+         * 
+         * The decision stored in the i-th branch is read into buffer[i].
+         */
+        std::vector<TBranch *> branches;
+        
+        /// Indicates whether the trigger decisions should be preloaded
+        bool preloadBits;
+        
+        /**
+         * \brief Preloaded decisions of the triggers
+         * 
+         * The vector is parallel to branches. Each element is a packed bitset indexed with the
+         * entry number in the trigger tree. It is only filled if preloading is requested.
+         */
+        std::vector<std::vector<std::uint64_t>> preloadedBits;
 };
 
 
 template<typename C>
 TriggerSelectionMC::TriggerSelectionMC(C const &ranges_):
     TriggerSelectionInterface(),
-    buffer(nullptr)
+    buffer(nullptr),
+    preloadBits(false)
 {
     // First a sanity check
     if (ranges_.size() == 0)
@@ -330,6 +443,15 @@ class TriggerSelection: public TriggerSelectionInterface
         TriggerSelection(std::vector<TriggerRange const *> const &ranges);
     
     public:
+        /**
+         * \brief Requests that trigger decisions are preloaded
+         * 
+         * The flag is forwarded to the selection object. Consult documentation of methods
+         * TriggerSelectionData::SetPreloadTriggerBits and TriggerSelectionMC::SetPreloadTriggerBits
+         * for details.
+         */
+        void SetPreloadTriggerBits(bool preload = true);
+        
         /**
          * \brief Resets the pointer to the trigger tree
          * 
@@ -337,7 +459,8 @@ class TriggerSelection: public TriggerSelectionInterface
          * the purpose of this method. The value of second argument is ignored.
          * 
          * Creates an object to perform the trigger selection on data or on simulation depending on
-         * the provided flag.
+         * the provided flag. If an object of the right type has already been created for a
+         * previous file, it is reused.
          */
         virtual void UpdateTree(TTree *triggerTree, bool isData);
         
@@ -351,6 +474,27 @@ class TriggerSelection: public TriggerSelectionInterface
          */
         virtual bool ReadNextEvent(EventID const &eventID);
         
+        /**
+         * \brief Reads the given entry from the trigger tree
+         * 
+         * Consult documentation of the overridden method in the base class for a description of
+         * the purpose of this method.
+         * 
+         * Simply calls ReadEvent of the selection object.
+         */
+        virtual bool ReadEvent(unsigned long entry, EventID const &eventID);
+        
+        /**
+         * \brief Checks whether the trigger decision depends on the event ID
+         * 
+         * Consult documentation of the overridden method in the base class for a description of
+         * the purpose of this method.
+         * 
+         * Calls RequiresEventID of the selection object. Returns true if the object has not been
+         * created yet.
+         */
+        virtual bool RequiresEventID() const;
+        
         /**
          * \brief Checks if the current event is accepted by the corresponding triggers
          * 
@@ -397,12 +541,19 @@ class TriggerSelection: public TriggerSelectionInterface
          * It is an instance of either TriggerSelectionMC or TriggerSelectionData.
          */
         std::unique_ptr<TriggerSelectionInterface> selection;
+        
+        /// Indicates whether the selection object has been created for real data
+        bool selectionForData;
+        
+        /// Indicates whether the trigger decisions should be preloaded
+        bool preloadBits;
 };
 
 
 template<typename C>
 TriggerSelection::TriggerSelection(C const &ranges_):
-    TriggerSelectionInterface()
+    TriggerSelectionInterface(),
+    selectionForData(false), preloadBits(false)
 {
     // First a sanity check
     if (ranges_.size() == 0)
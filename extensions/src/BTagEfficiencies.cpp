@@ -164,7 +164,8 @@ void BTagEfficiencies::LoadPayload(Dataset const &dataset)
         string const wpCode(WorkingPointToText(wp));
         
         
-        // Read histograms for all jet flavours. This is not a thread-safe operation
+        // Read histograms for all jet flavours. The source file is shared among all copies of this
+        //object, which can be used in different threads, so the reading must be guarded
         ROOTLock::Lock();
         
         shared_ptr<TH2> bHist(dynamic_cast<TH2 *>(srcFile->Get(
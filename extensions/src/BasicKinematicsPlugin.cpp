@@ -40,9 +40,9 @@ void BasicKinematicsPlugin::BeginRun(Dataset const &dataset)
     // Creation of ROOT objects is not thread-safe and must be protected
     ROOTLock::Lock();
     
-    // Create the output file
-    file = new TFile((outDirectory + dataset.GetFiles().front().GetBaseName() + ".root").c_str(),
-     "recreate");
+    // Create the output file. It is written under a temporary name and renamed in EndRun
+    outFileName = outDirectory + dataset.GetFiles().front().GetBaseName() + ".root";
+    file = new TFile(GetTempFileName(outFileName).c_str(), "recreate");
     
     // Create the tree
     tree = new TTree("Vars", "Basic kinematical variables");
@@ -83,6 +83,9 @@ void BasicKinematicsPlugin::EndRun()
     delete file;
     
     ROOTLock::Unlock();
+    
+    // The output file is complete now and can be given its final name
+    CommitOutputFile(outFileName);
 }
 
 
@@ -0,0 +1,258 @@
+#include <EventShapes.hpp>
+
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+
+
+using namespace std;
+
+
+// Definition of a static data member
+unsigned const EventShapes::maxMomenta;
+
+
+EventShapes::EventShapes() noexcept
+{
+    Reset();
+}
+
+
+void EventShapes::Reset() noexcept
+{
+    nMomenta = 0;
+    sumP2 = sumP = 0.;
+    quadraticTensor.fill(0.);
+    linearTensor.fill(0.);
+    eigenvaluesValid = false;
+}
+
+
+void EventShapes::AddMomentum(double px_, double py_, double pz_)
+{
+    double const p2 = px_ * px_ + py_ * py_ + pz_ * pz_;
+    
+    if (p2 == 0.)
+        return;
+    
+    if (nMomenta == maxMomenta)
+        throw length_error("EventShapes::AddMomentum: Maximal number of momenta is exceeded.");
+    
+    
+    // Store the momentum (needed for thrust)
+    px[nMomenta] = px_;
+    py[nMomenta] = py_;
+    pz[nMomenta] = pz_;
+    ++nMomenta;
+    
+    
+    // Update the tensors and the normalisations
+    double const p = sqrt(p2);
+    sumP2 += p2;
+    sumP += p;
+    
+    array<double, 6> const products{{px_ * px_, py_ * py_, pz_ * pz_, px_ * py_, px_ * pz_,
+     py_ * pz_}};
+    
+    for (unsigned i = 0; i < 6; ++i)
+    {
+        quadraticTensor[i] += products[i];
+        linearTensor[i] += products[i] / p;
+    }
+    
+    eigenvaluesValid = false;
+}
+
+
+void EventShapes::AddMomentum(TLorentzVector const &p4)
+{
+    AddMomentum(p4.Px(), p4.Py(), p4.Pz());
+}
+
+
+unsigned EventShapes::GetNumMomenta() const noexcept
+{
+    return nMomenta;
+}
+
+
+double EventShapes::Sphericity() const noexcept
+{
+    UpdateEigenvalues();
+    return 1.5 * (quadraticEigenvalues[1] + quadraticEigenvalues[2]);
+}
+
+
+double EventShapes::Aplanarity() const noexcept
+{
+    UpdateEigenvalues();
+    return 1.5 * quadraticEigenvalues[2];
+}
+
+
+double EventShapes::C() const noexcept
+{
+    UpdateEigenvalues();
+    auto const &l = linearEigenvalues;
+    
+    return 3. * (l[0] * l[1] + l[0] * l[2] + l[1] * l[2]);
+}
+
+
+double EventShapes::D() const noexcept
+{
+    UpdateEigenvalues();
+    auto const &l = linearEigenvalues;
+    
+    return 27. * l[0] * l[1] * l[2];
+}
+
+
+double EventShapes::Thrust() const noexcept
+{
+    if (nMomenta == 0)
+        return 0.;
+    
+    
+    // The thrust axis is parallel to a sum of momenta taken with signs +1 or -1. The signs are
+    //determined by the hemisphere defined by a plane orthogonal to the axis. It is sufficient to
+    //consider planes that contain two of the momenta (with all four sign choices for these two
+    //momenta) [1]. Planes orthogonal to each of the momenta are also tested to cover configurations
+    //in which all the momenta are collinear
+    //[1] S. Brandt, H.D. Dahmen, Z. Phys. C 1 (1979) 61
+    double maxSumP2 = 0.;
+    
+    for (unsigned i = 0; i < nMomenta; ++i)
+    {
+        double sx = 0., sy = 0., sz = 0.;
+        
+        for (unsigned k = 0; k < nMomenta; ++k)
+        {
+            double const sign =
+             (px[k] * px[i] + py[k] * py[i] + pz[k] * pz[i] >= 0.) ? 1. : -1.;
+            sx += sign * px[k];
+            sy += sign * py[k];
+            sz += sign * pz[k];
+        }
+        
+        maxSumP2 = max(maxSumP2, sx * sx + sy * sy + sz * sz);
+    }
+    
+    for (unsigned i = 0; i < nMomenta; ++i)
+        for (unsigned j = i + 1; j < nMomenta; ++j)
+        {
+            // Normal to the plane spanned by the two momenta
+            double const nx = py[i] * pz[j] - pz[i] * py[j];
+            double const ny = pz[i] * px[j] - px[i] * pz[j];
+            double const nz = px[i] * py[j] - py[i] * px[j];
+            
+            if (nx == 0. and ny == 0. and nz == 0.)
+                continue;
+            
+            
+            // Sum of momenta other than i and j taken with signs defined by the plane
+            double sx = 0., sy = 0., sz = 0.;
+            
+            for (unsigned k = 0; k < nMomenta; ++k)
+            {
+                if (k == i or k == j)
+                    continue;
+                
+                double const sign = (px[k] * nx + py[k] * ny + pz[k] * nz >= 0.) ? 1. : -1.;
+                sx += sign * px[k];
+                sy += sign * py[k];
+                sz += sign * pz[k];
+            }
+            
+            
+            // Try all the sign combinations for the momenta in the plane
+            for (double si: {1., -1.})
+                for (double sj: {1., -1.})
+                {
+                    double const tx = sx + si * px[i] + sj * px[j];
+                    double const ty = sy + si * py[i] + sj * py[j];
+                    double const tz = sz + si * pz[i] + sj * pz[j];
+                    
+                    maxSumP2 = max(maxSumP2, tx * tx + ty * ty + tz * tz);
+                }
+        }
+    
+    
+    return sqrt(maxSumP2) / sumP;
+}
+
+
+array<double, 3> const &EventShapes::GetSphericityEigenvalues() const noexcept
+{
+    UpdateEigenvalues();
+    return quadraticEigenvalues;
+}
+
+
+array<double, 3> const &EventShapes::GetLinearEigenvalues() const noexcept
+{
+    UpdateEigenvalues();
+    return linearEigenvalues;
+}
+
+
+array<double, 3> EventShapes::SymmetricEigenvalues(array<double, 6> const &a) noexcept
+{
+    // The trigonometric solution of the characteristic equation is used [1]. The matrix is shifted
+    //by a multiple of the identity matrix and rescaled so that the equation takes the form
+    //4 cos^3(phi) - 3 cos(phi) = r
+    //[1] O.K. Smith, Commun. ACM 4 (1961) 168
+    double const offDiagonal = a[3] * a[3] + a[4] * a[4] + a[5] * a[5];
+    double const q = (a[0] + a[1] + a[2]) / 3.;
+    double const d0 = a[0] - q, d1 = a[1] - q, d2 = a[2] - q;
+    double const p = sqrt((d0 * d0 + d1 * d1 + d2 * d2 + 2. * offDiagonal) / 6.);
+    
+    if (p == 0.)
+    //^ The matrix is proportional to the identity matrix
+        return array<double, 3>{{q, q, q}};
+    
+    
+    // Half of the determinant of the matrix (A - q I) / p
+    double const r = (d0 * (d1 * d2 - a[5] * a[5]) - a[3] * (a[3] * d2 - a[5] * a[4]) +
+     a[4] * (a[3] * a[5] - d1 * a[4])) / (2. * p * p * p);
+    
+    // Rounding errors can put r slightly outside the range [-1, 1]
+    double const phi = (r <= -1.) ? M_PI / 3. : ((r >= 1.) ? 0. : acos(r) / 3.);
+    
+    
+    // The eigenvalues are ordered by construction
+    double const lambda1 = q + 2. * p * cos(phi);
+    double const lambda3 = q + 2. * p * cos(phi + 2. * M_PI / 3.);
+    double const lambda2 = 3. * q - lambda1 - lambda3;
+    
+    return array<double, 3>{{lambda1, lambda2, lambda3}};
+}
+
+
+void EventShapes::UpdateEigenvalues() const noexcept
+{
+    if (eigenvaluesValid)
+        return;
+    
+    if (nMomenta == 0)
+    {
+        quadraticEigenvalues.fill(0.);
+        linearEigenvalues.fill(0.);
+    }
+    else
+    {
+        array<double, 6> normalisedTensor;
+        
+        for (unsigned i = 0; i < 6; ++i)
+            normalisedTensor[i] = quadraticTensor[i] / sumP2;
+        
+        quadraticEigenvalues = SymmetricEigenvalues(normalisedTensor);
+        
+        for (unsigned i = 0; i < 6; ++i)
+            normalisedTensor[i] = linearTensor[i] / sumP;
+        
+        linearEigenvalues = SymmetricEigenvalues(normalisedTensor);
+    }
+    
+    eigenvaluesValid = true;
+}
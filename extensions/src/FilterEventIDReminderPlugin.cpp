@@ -36,7 +36,21 @@ void FilterEventIDReminderPlugin::EndRun()
 
 bool FilterEventIDReminderPlugin::ProcessEvent()
 {
-    auto const &id = (*reader)->GetEventID();
+    return IsAccepted(**reader);
+}
+
+
+bool FilterEventIDReminderPlugin::RegisterEarlyFilters(PECReader &r) const
+{
+    r.AddEventFilter(PECReader::EventFilterStage::EventID,
+     [this](PECReader const &ev){return IsAccepted(ev);});
+    return true;
+}
+
+
+bool FilterEventIDReminderPlugin::IsAccepted(PECReader const &r) const
+{
+    auto const &id = r.GetEventID();
     bool const res = ((id.Event() % denominator) <= maxReminder);
     
     return (isReversed) ? not res : res;
@@ -1,38 +1,27 @@
 #include <GenericEventSelection.hpp>
 
 #include <algorithm>
+#include <stdexcept>
+#include <sstream>
 
 
 using namespace std;
 
 
-GenericEventSelection::JetTagBin::JetTagBin(unsigned nJets_, unsigned nTags_):
-    nJets(nJets_), nTags(nTags_)
-{}
-
-
 GenericEventSelection::GenericEventSelection(double jetPtThreshold_,
  shared_ptr<BTagger const> const &bTagger_):
     EventSelectionInterface(),
+    nLeptonsRequired(0),
     jetPtThreshold(jetPtThreshold_), bTagger(bTagger_)
-{
-    // Fill the lepton-flavour map
-    flavourMap[Lepton::Flavour::Electron] = 0;
-    flavourMap[Lepton::Flavour::Muon] = 1;
-    flavourMap[Lepton::Flavour::Tau] = 2;
-}
+{}
 
 
 GenericEventSelection::GenericEventSelection(double jetPtThreshold_,
  shared_ptr<BTagger const> &&bTagger_):
     EventSelectionInterface(),
+    nLeptonsRequired(0),
     jetPtThreshold(jetPtThreshold_), bTagger(bTagger_)
-{
-    // Fill the lepton-flavour map
-    flavourMap[Lepton::Flavour::Electron] = 0;
-    flavourMap[Lepton::Flavour::Muon] = 1;
-    flavourMap[Lepton::Flavour::Tau] = 2;
-}
+{}
 
 
 GenericEventSelection::GenericEventSelection(double jetPtThreshold_, BTagger const &bTagger_):
@@ -52,77 +41,68 @@ bool GenericEventSelection::PassLeptonStep(vector<Lepton> const &tightLeptons,
     //the other hand, if the number of leptons is smaller than the number of thresholds, the event
     //lacks tight leptons and must be rejected, too.
     
-    // Initialize the iterators for all the lepton flavours
-    for (unsigned i = 0; i < 3; ++i)
-        leptonThresholdIts.at(i) = leptonPtThresholds.at(i).cbegin();
+    // Thus, the total number of tight leptons must match the number of thresholds. Veto also the
+    //additional loose leptons. Since they are required to include the tight leptons, it is
+    //sufficient to simply check their number
+    if (tightLeptons.size() != nLeptonsRequired or looseLeptons.size() != nLeptonsRequired)
+        return false;
+    
     
+    // Loop over the tight leptons counting them separately for each flavour
+    array<unsigned, 3> nLeptons{{0, 0, 0}};
     
-    // Loop over the tight leptons
     for (auto const &lep: tightLeptons)
     {
-        // Choose the iterator corresponding to the flavour of the current lepton
-        unsigned const flavourIndex = flavourMap.at(lep.GetFlavour());
-        auto &thresholdIt = leptonThresholdIts.at(flavourIndex);
+        // Choose the thresholds and the counter corresponding to the flavour of the current lepton
+        unsigned const flavourIndex = FlavourIndex(lep.GetFlavour());
+        vector<double> const &thresholds = leptonPtThresholds[flavourIndex];
+        unsigned &n = nLeptons[flavourIndex];
         
         // Make sure we have not yet exhausted the allowed number of tight leptons of such flavour.
         //However, remember that PECReader fills the collection of tight leptons with the same pt
         //treshold as for loose leptons. For this reason the condition below can be satisfied either
         //because there are, indeed, too many high-pt leptons or because there are additional
         //leptons that should be vetoed. In any case the event should be rejected
-        if (thresholdIt == leptonPtThresholds.at(flavourIndex).cend())
+        if (n == thresholds.size())
             return false;
         
         // Compare the lepton's pt to the threshold. For the valid logic of this comparison both the
         //tight leptons and the thresholds must be sorted in the decreasing order in pt
-        if (lep.Pt() < *thresholdIt)
+        if (lep.Pt() < thresholds[n])
             return false;
         
-        // Move this iterator to the next (lower) threshold
-        ++thresholdIt;
+        // Move to the next (lower) threshold
+        ++n;
     }
     
     
-    // Make sure all the iterators have reached the ends of the corresponding lists. If it is not
-    //the case, the event contains fewer leptons than requested
-    for (unsigned i = 0; i < 3; ++i)
-        if (leptonThresholdIts.at(i) != leptonPtThresholds.at(i).cend())
-            return false;
-    
-    
-    // Veto the additional loose leptons. Since they are required to include the tight leptons, it
-    //is sufficient to simply check their number
-    if (tightLeptons.size() != looseLeptons.size())
-        return false;
-    
-    
-    // If the algorithm has reached this point, the event-selection requirements are satisfied
+    // Since the total number of leptons matches the total number of thresholds and no flavour has
+    //more leptons than thresholds, the numbers of leptons of each flavour are as requested
     return true;
 }
 
 
 bool GenericEventSelection::PassJetStep(vector<Jet> const &jets) const
 {
-    // Calculate the jet and the b-tagged jet multiplicities
-    unsigned nJets = 0, nTags = 0;
+    // Reject the event immediately if no bin with the given jet multiplicity is allowed. The input
+    //collection is required to be already filtered with IsAnalysisJet
+    unsigned const nJets = jets.size();
+    
+    if (nJets >= jetTagMasks.size() or jetTagMasks[nJets] == 0)
+        return false;
+    
+    
+    // Calculate the b-tagged jet multiplicity. The decisions cached in the jets by PECReader are
+    //read when they have been evaluated by a compatible b-tagger
+    unsigned nTags = 0;
     
     for (auto const &j: jets)
-        //if (IsAnalysisJet(j))  // the input collection is required to be already filtered
-        {
-            ++nJets;
-            
-            if (bTagger->IsTagged(j))
-                ++nTags;
-        }
+        if (bTagger->IsTagged(j))
+            ++nTags;
     
     
     // Check against the allowed jet-tag bins
-    for (auto const &bin: jetBins)
-        if (bin.nJets == nJets and bin.nTags == nTags)
-            return true;
-    //^ The brute-force looping over the allowed bins is employed as their number is small, and the
-    //effect of an overhead from an optimization will probably be bigger than the possible gain in
-    //performance
-    return false;
+    return ((jetTagMasks[nJets] >> nTags) & 1);
 }
 
 
@@ -134,21 +114,34 @@ bool GenericEventSelection::IsAnalysisJet(Jet const &jet) const
 
 void GenericEventSelection::AddLeptonThreshold(Lepton::Flavour flavour, double ptThreshold)
 {
-    unsigned const i = flavourMap.at(flavour);
+    vector<double> &thresholds = leptonPtThresholds.at(FlavourIndex(flavour));
     
     // Find the first element that is smaller than the new threshold. It might be end().
-    auto const it = find_if(leptonPtThresholds.at(i).begin(), leptonPtThresholds.at(i).end(),
+    auto const it = find_if(thresholds.begin(), thresholds.end(),
      [ptThreshold](double pt){return (pt < ptThreshold);});
     
-    // Insert the new threshold just before the found element. Thanks to this, the list is always
+    // Insert the new threshold just before the found element. Thanks to this, the vector is always
     //sorted in the decreasing order
-    leptonPtThresholds.at(i).insert(it, ptThreshold);
+    thresholds.insert(it, ptThreshold);
+    ++nLeptonsRequired;
 }
 
 
 void GenericEventSelection::AddJetTagBin(unsigned nJets, unsigned nTags)
 {
-    jetBins.emplace_back(nJets, nTags);
+    if (nTags >= 64)
+    {
+        ostringstream ost;
+        ost << "GenericEventSelection::AddJetTagBin: Number of b-tagged jets " << nTags <<
+         " is not supported.";
+        
+        throw logic_error(ost.str());
+    }
+    
+    if (jetTagMasks.size() <= nJets)
+        jetTagMasks.resize(nJets + 1, 0);
+    
+    jetTagMasks[nJets] |= uint64_t(1) << nTags;
 }
 
 
@@ -156,3 +149,22 @@ EventSelectionInterface *GenericEventSelection::Clone() const
 {
     return new GenericEventSelection(*this);
 }
+
+
+unsigned GenericEventSelection::FlavourIndex(Lepton::Flavour flavour)
+{
+    switch (flavour)
+    {
+        case Lepton::Flavour::Electron:
+            return 0;
+        
+        case Lepton::Flavour::Muon:
+            return 1;
+        
+        case Lepton::Flavour::Tau:
+            return 2;
+        
+        default:
+            throw logic_error("GenericEventSelection::FlavourIndex: Lepton flavour is unknown.");
+    }
+}
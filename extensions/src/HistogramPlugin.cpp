@@ -0,0 +1,339 @@
+#include <HistogramPlugin.hpp>
+
+#include <Processor.hpp>
+#include <ROOTLock.hpp>
+#include <Logger.hpp>
+
+#include <TFile.h>
+#include <TH1D.h>
+#include <TH2D.h>
+
+#include <stdexcept>
+#include <memory>
+#include <algorithm>
+#include <sstream>
+#include <cmath>
+
+
+using namespace std;
+using namespace logging;
+
+
+HistogramPlugin::Accumulator::Accumulator(string const &outFileName_):
+    outFileName(outFileName_),
+    nCells(0), nWeights(1),
+    frozen(false)
+{}
+
+
+void HistogramPlugin::Accumulator::Write() const
+{
+    // Build names of the weight variations
+    vector<string> suffixes{""};
+    
+    for (auto const &syst: systSources)
+    {
+        for (unsigned i = 0; i < syst.nPairs; ++i)
+        {
+            string const label("_" + syst.label + ((syst.nPairs > 1) ? to_string(i) : ""));
+            suffixes.emplace_back(label + "Up");
+            suffixes.emplace_back(label + "Down");
+        }
+    }
+    
+    
+    // Operations with ROOT objects performed here are not thread-safe and must be guarded. The
+    //file is destroyed before the lock is released
+    ROOTLock::Lock();
+    
+    unique_ptr<TFile> file(new TFile(GetTempFileName(outFileName).c_str(), "recreate"));
+    
+    if (file->IsZombie())
+    {
+        file.reset();
+        ROOTLock::Unlock();
+        
+        throw runtime_error(string("HistogramPlugin::EndPass: Cannot create file \"") +
+         GetTempFileName(outFileName) + "\" to write the histograms.");
+    }
+    
+    for (unsigned iHist = 0; iHist < histograms.size(); ++iHist)
+    {
+        Histogram const &h = histograms[iHist];
+        
+        for (unsigned w = 0; w < nWeights; ++w)
+        {
+            string const histName(h.name + suffixes[w]);
+            unique_ptr<TH1> hist;
+            
+            if (h.nBinsY == 0)
+                hist.reset(new TH1D(histName.c_str(), h.title.c_str(), h.nBinsX, h.minX, h.maxX));
+            else
+                hist.reset(new TH2D(histName.c_str(), h.title.c_str(), h.nBinsX, h.minX, h.maxX,
+                 h.nBinsY, h.minY, h.maxY));
+            
+            // The histogram is owned here rather than by the file
+            hist->SetDirectory(nullptr);
+            hist->Sumw2();
+            
+            
+            // The cells follow the global numbering of bins in ROOT
+            for (unsigned long bin = 0; bin < h.nCells; ++bin)
+            {
+                unsigned long const index = (h.offset + bin) * nWeights + w;
+                hist->SetBinContent(bin, sumW[index]);
+                hist->SetBinError(bin, sqrt(sumW2[index]));
+            }
+            
+            hist->SetEntries(nEntries[iHist]);
+            
+            file->cd();
+            hist->Write("", TObject::kOverwrite);
+        }
+    }
+    
+    file->Close();
+    file.reset();
+    
+    ROOTLock::Unlock();
+    
+    
+    // The output file is complete now and can be given its final name
+    CommitOutputFile(outFileName);
+    
+    logger << timestamp << "Histograms have been written into file \"" << outFileName << "\"." <<
+     eom;
+}
+
+
+HistogramPlugin::HistogramPlugin(string const &outFileName, string const &name_ /*= "Histograms"*/):
+    Plugin(name_),
+    accumulator(new Accumulator(outFileName))
+{}
+
+
+Plugin *HistogramPlugin::Clone() const
+{
+    // The clone shares the accumulator with this, and its own arrays are allocated in BeginRun
+    HistogramPlugin *clone = new HistogramPlugin(*this);
+    clone->sumW.clear();
+    clone->sumW2.clear();
+    clone->nEntries.clear();
+    
+    return clone;
+}
+
+
+void HistogramPlugin::BeginRun(Dataset const &dataset)
+{
+    // Save pointer to the reader plugin
+    reader = dynamic_cast<PECReaderPlugin const *>(processor->GetPluginBefore("Reader", name));
+    isMC = dataset.IsMC();
+    
+    
+    // Prevent further bookings and allocate the merged arrays once
+    {
+        lock_guard<mutex> lock(accumulator->mutex);
+        
+        if (not accumulator->frozen)
+        {
+            accumulator->frozen = true;
+            accumulator->sumW.assign(accumulator->nCells * accumulator->nWeights, 0.);
+            accumulator->sumW2.assign(accumulator->nCells * accumulator->nWeights, 0.);
+            accumulator->nEntries.assign(accumulator->histograms.size(), 0);
+        }
+    }
+    
+    
+    // Allocate the arrays of this clone. It is done by the thread that fills them, so that they
+    //are placed in its local memory
+    if (sumW.empty())
+    {
+        sumW.assign(accumulator->nCells * accumulator->nWeights, 0.);
+        sumW2.assign(accumulator->nCells * accumulator->nWeights, 0.);
+        nEntries.assign(accumulator->histograms.size(), 0);
+        weights.resize(accumulator->nWeights);
+    }
+}
+
+
+void HistogramPlugin::EndRun()
+{
+    // Add the content to the merged histograms and reset it
+    lock_guard<mutex> lock(accumulator->mutex);
+    
+    for (unsigned long i = 0; i < sumW.size(); ++i)
+    {
+        accumulator->sumW[i] += sumW[i];
+        accumulator->sumW2[i] += sumW2[i];
+    }
+    
+    for (unsigned i = 0; i < nEntries.size(); ++i)
+        accumulator->nEntries[i] += nEntries[i];
+    
+    fill(sumW.begin(), sumW.end(), 0.);
+    fill(sumW2.begin(), sumW2.end(), 0.);
+    fill(nEntries.begin(), nEntries.end(), 0);
+}
+
+
+bool HistogramPlugin::ProcessEvent()
+{
+    PECReader const &event = **reader;
+    unsigned const nWeights = weights.size();
+    
+    
+    // Collect the weights. Variations that are not available are replaced by the central weight
+    weights[0] = (isMC) ? event.GetCentralWeight() : 1.;
+    unsigned w = 1;
+    
+    for (auto const &syst: accumulator->systSources)
+    {
+        unsigned nAvailable = 0;
+        
+        if (isMC)
+        {
+            auto const &pairs = event.GetSystWeight(syst.type);
+            nAvailable = min<unsigned>(pairs.size(), syst.nPairs);
+            
+            for (unsigned i = 0; i < nAvailable; ++i)
+            {
+                weights[w++] = pairs[i].up;
+                weights[w++] = pairs[i].down;
+            }
+        }
+        
+        for (unsigned i = nAvailable; i < syst.nPairs; ++i)
+        {
+            weights[w++] = weights[0];
+            weights[w++] = weights[0];
+        }
+    }
+    
+    
+    // Fill the histograms. All the weights of a bin are stored contiguously
+    auto const &histograms = accumulator->histograms;
+    
+    for (unsigned iHist = 0; iHist < histograms.size(); ++iHist)
+    {
+        Histogram const &h = histograms[iHist];
+        double const x = h.x(event);
+        double const y = (h.nBinsY > 0) ? h.y(event) : 0.;
+        
+        unsigned long const index = (h.offset + FindBin(h, x, y)) * nWeights;
+        double *sumWBin = &sumW[index];
+        double *sumW2Bin = &sumW2[index];
+        
+        for (unsigned i = 0; i < nWeights; ++i)
+        {
+            sumWBin[i] += weights[i];
+            sumW2Bin[i] += weights[i] * weights[i];
+        }
+        
+        ++nEntries[iHist];
+    }
+    
+    return true;
+}
+
+
+void HistogramPlugin::EndPass()
+{
+    // All the clones are idle, and their content has been merged at the end of each dataset
+    if (accumulator->frozen)
+        accumulator->Write();
+}
+
+
+bool HistogramPlugin::SupportsDistributedMode() const
+{
+    return false;
+}
+
+
+void HistogramPlugin::Book1D(string const &name, string const &title, unsigned nBins, double min,
+ double max, Expression const &x)
+{
+    Book2D(name, title, nBins, min, max, 0, 0., 0., x, Expression());
+}
+
+
+void HistogramPlugin::Book2D(string const &name, string const &title, unsigned nBinsX,
+ double minX, double maxX, unsigned nBinsY, double minY, double maxY, Expression const &x,
+ Expression const &y)
+{
+    CheckNotFrozen("Book");
+    
+    auto &histograms = accumulator->histograms;
+    
+    if (find_if(histograms.begin(), histograms.end(),
+     [&name](Histogram const &h){return (h.name == name);}) != histograms.end())
+        throw logic_error(string("HistogramPlugin::Book: Histogram \"") + name + "\" has already "
+         "been booked.");
+    
+    if (nBinsX == 0 or maxX <= minX or (nBinsY > 0 and maxY <= minY))
+        throw logic_error(string("HistogramPlugin::Book: Binning of histogram \"") + name +
+         "\" is invalid.");
+    
+    Histogram h;
+    h.name = name;
+    h.title = title;
+    h.nBinsX = nBinsX;
+    h.nBinsY = nBinsY;
+    h.minX = minX;
+    h.maxX = maxX;
+    h.minY = minY;
+    h.maxY = maxY;
+    h.invWidthX = nBinsX / (maxX - minX);
+    h.invWidthY = (nBinsY > 0) ? nBinsY / (maxY - minY) : 0.;
+    h.x = x;
+    h.y = y;
+    h.offset = accumulator->nCells;
+    h.nCells = (nBinsX + 2) * ((nBinsY > 0) ? nBinsY + 2 : 1);
+    
+    histograms.emplace_back(h);
+    accumulator->nCells += h.nCells;
+}
+
+
+void HistogramPlugin::AddSystWeights(SystTypeWeight type, string const &label,
+ unsigned nPairs /*= 1*/)
+{
+    CheckNotFrozen("AddSystWeights");
+    
+    accumulator->systSources.push_back({type, label, nPairs});
+    accumulator->nWeights += 2 * nPairs;
+}
+
+
+unsigned long HistogramPlugin::FindBin(Histogram const &h, double x, double y)
+{
+    // Under- and overflows are included. NaN is put into the underflow
+    auto const findAxisBin = [](double value, double min, double max, unsigned nBins,
+     double invWidth) -> unsigned long
+    {
+        if (not (value >= min))
+            return 0;
+        
+        if (value >= max)
+            return nBins + 1;
+        
+        return std::min<unsigned long>(1 + (unsigned long)((value - min) * invWidth), nBins);
+    };
+    
+    unsigned long const binX = findAxisBin(x, h.minX, h.maxX, h.nBinsX, h.invWidthX);
+    
+    if (h.nBinsY == 0)
+        return binX;
+    
+    unsigned long const binY = findAxisBin(y, h.minY, h.maxY, h.nBinsY, h.invWidthY);
+    return binX + (h.nBinsX + 2) * binY;
+}
+
+
+void HistogramPlugin::CheckNotFrozen(string const &method) const
+{
+    if (accumulator->frozen)
+        throw logic_error(string("HistogramPlugin::") + method + ": Histograms cannot be booked "
+         "after the processing has started.");
+}
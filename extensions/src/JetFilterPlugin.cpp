@@ -62,7 +62,21 @@ void JetFilterPlugin::BeginRun(Dataset const &)
 
 bool JetFilterPlugin::ProcessEvent()
 {
-    auto const &jets = (*reader)->GetJets();
+    return IsAccepted(**reader);
+}
+
+
+bool JetFilterPlugin::RegisterEarlyFilters(PECReader &r) const
+{
+    r.AddEventFilter(PECReader::EventFilterStage::Jets,
+     [this](PECReader const &ev){return IsAccepted(ev);});
+    return true;
+}
+
+
+bool JetFilterPlugin::IsAccepted(PECReader const &r) const
+{
+    auto const &jets = r.GetJets();
     
     
     // Count the number of jets that pass the selection
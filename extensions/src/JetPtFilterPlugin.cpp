@@ -49,8 +49,22 @@ void JetPtFilterPlugin::BeginRun(Dataset const &)
 
 bool JetPtFilterPlugin::ProcessEvent()
 {
-    auto const &jets = (*reader)->GetJets();
-    auto const &softJets = (*reader)->GetAdditionalJets();
+    return IsAccepted(**reader);
+}
+
+
+bool JetPtFilterPlugin::RegisterEarlyFilters(PECReader &r) const
+{
+    r.AddEventFilter(PECReader::EventFilterStage::Jets,
+     [this](PECReader const &ev){return IsAccepted(ev);});
+    return true;
+}
+
+
+bool JetPtFilterPlugin::IsAccepted(PECReader const &r) const
+{
+    auto const &jets = r.GetJets();
+    auto const &softJets = r.GetAdditionalJets();
     
     
     if (minNumJets - 1 < jets.size())
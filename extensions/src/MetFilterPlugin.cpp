@@ -44,7 +44,21 @@ void MetFilterPlugin::BeginRun(Dataset const &)
 
 bool MetFilterPlugin::ProcessEvent()
 {
-    Candidate const &met = (*reader)->GetMET();
+    return IsAccepted(**reader);
+}
+
+
+bool MetFilterPlugin::RegisterEarlyFilters(PECReader &r) const
+{
+    r.AddEventFilter(PECReader::EventFilterStage::MET,
+     [this](PECReader const &ev){return IsAccepted(ev);});
+    return true;
+}
+
+
+bool MetFilterPlugin::IsAccepted(PECReader const &r) const
+{
+    Candidate const &met = r.GetMET();
     
     return (met.Pt() > threshold);
 }
@@ -0,0 +1,435 @@
+#include <NtuplePlugin.hpp>
+
+#include <Processor.hpp>
+#include <ROOTLock.hpp>
+#include <EventShapes.hpp>
+
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+#include <sys/stat.h>
+
+
+using namespace std;
+
+
+NtuplePlugin::Context::Context() noexcept:
+    reader(nullptr), generation(0)
+{}
+
+
+PECReader const *NtuplePlugin::Context::operator->() const
+{
+    return reader;
+}
+
+
+PECReader const &NtuplePlugin::Context::operator*() const
+{
+    return *reader;
+}
+
+
+double NtuplePlugin::Context::Get(ScalarHandle handle)
+{
+    unsigned const i = handle.index;
+    
+    if (scalarGenerations.at(i) != generation)
+    {
+        scalarValues[i] = scalarFunctions[i](*this);
+        scalarGenerations[i] = generation;
+    }
+    
+    return scalarValues[i];
+}
+
+
+TLorentzVector const &NtuplePlugin::Context::Get(P4Handle handle)
+{
+    unsigned const i = handle.index;
+    
+    if (p4Generations.at(i) != generation)
+    {
+        p4Values[i] = p4Functions[i](*this);
+        p4Generations[i] = generation;
+    }
+    
+    return p4Values[i];
+}
+
+
+void NtuplePlugin::Context::NewEvent(PECReader const *reader_)
+{
+    reader = reader_;
+    ++generation;
+}
+
+
+NtuplePlugin::NtuplePlugin(string const &outDirectory_, string const &name_ /*= "Ntuple"*/):
+    Plugin(name_),
+    outDirectory(outDirectory_),
+    file(nullptr), tree(nullptr)
+{
+    // Make sure the directory path ends with a slash
+    if (outDirectory.back() != '/')
+        outDirectory += '/';
+    
+    // Create the output directory if it does not exist
+    struct stat dirStat;
+    
+    if (stat(outDirectory.c_str(), &dirStat) != 0)  // the directory does not exist
+        mkdir(outDirectory.c_str(), 0755);
+}
+
+
+Plugin *NtuplePlugin::Clone() const
+{
+    // All the data members can be copied. The output file and tree are recreated in BeginRun
+    return new NtuplePlugin(*this);
+}
+
+
+void NtuplePlugin::BeginRun(Dataset const &dataset)
+{
+    // Save pointer to the reader plugin
+    reader = dynamic_cast<PECReaderPlugin const *>(processor->GetPluginBefore("Reader", name));
+    
+    
+    // Find variables to be evaluated in this dataset
+    activeVariables.clear();
+    
+    if (requestedNames.empty())
+    {
+        for (unsigned i = 0; i < variables.size(); ++i)
+            activeVariables.push_back(i);
+    }
+    else
+    {
+        for (auto const &varName: requestedNames)
+        {
+            int const index = FindVariable(varName);
+            
+            if (index == -1)
+                throw logic_error(string("NtuplePlugin::BeginRun: Requested variable \"") +
+                 varName + "\" has not been registered.");
+            
+            if (find(activeVariables.begin(), activeVariables.end(), unsigned(index)) ==
+             activeVariables.end())
+                activeVariables.push_back(index);
+        }
+    }
+    
+    if (not dataset.IsMC())
+        activeVariables.erase(remove_if(activeVariables.begin(), activeVariables.end(),
+         [this](unsigned i){return variables[i].mcOnly;}), activeVariables.end());
+    
+    
+    // The buffers must not be reallocated after the branches have been created
+    buffers.resize(variables.size());
+    
+    
+    // Creation of ROOT objects is not thread-safe and must be protected
+    ROOTLock::Lock();
+    
+    // Create the output file. It is written under a temporary name and renamed in EndRun
+    outFileName = outDirectory + dataset.GetFiles().front().GetBaseName() + ".root";
+    file = new TFile(GetTempFileName(outFileName).c_str(), "recreate");
+    
+    // Create the tree
+    tree = new TTree("Vars", "Kinematical variables");
+    
+    // End of critical block
+    ROOTLock::Unlock();
+    
+    
+    // Assign branch addresses
+    for (unsigned i: activeVariables)
+    {
+        auto const &var = variables[i];
+        
+        switch (var.type)
+        {
+            case Type::Float:
+                tree->Branch(var.name.c_str(), &buffers[i].f, (var.name + "/F").c_str());
+                break;
+            
+            case Type::Int:
+                tree->Branch(var.name.c_str(), &buffers[i].i, (var.name + "/I").c_str());
+                break;
+            
+            case Type::ULong64:
+                tree->Branch(var.name.c_str(), &buffers[i].ul, (var.name + "/l").c_str());
+                break;
+        }
+    }
+}
+
+
+void NtuplePlugin::EndRun()
+{
+    // Operations with ROOT objects performed here are not thread-safe and must be guarded
+    ROOTLock::Lock();
+    
+    // Write the tree and close the file
+    file->cd();
+    tree->Write("", TObject::kOverwrite);
+    
+    // Delete the objects
+    delete tree;
+    delete file;
+    
+    ROOTLock::Unlock();
+    
+    // The output file is complete now and can be given its final name
+    CommitOutputFile(outFileName);
+    
+    tree = nullptr;
+    file = nullptr;
+}
+
+
+bool NtuplePlugin::ProcessEvent()
+{
+    // Invalidate the intermediates computed for the previous event
+    context.NewEvent(&**reader);
+    
+    if (filter and not filter(context))
+        return false;
+    
+    
+    // Evaluate the requested variables
+    for (unsigned i: activeVariables)
+    {
+        auto const &var = variables[i];
+        double const value = var.function(context);
+        
+        switch (var.type)
+        {
+            case Type::Float:
+                buffers[i].f = value;
+                break;
+            
+            case Type::Int:
+                buffers[i].i = lround(value);
+                break;
+            
+            case Type::ULong64:
+                buffers[i].ul = llround(value);
+                break;
+        }
+    }
+    
+    
+    tree->Fill();
+    return true;
+}
+
+
+NtuplePlugin::ScalarHandle NtuplePlugin::DefineScalar(string const &name,
+ ScalarFunction const &function)
+{
+    if (find(scalarNames.begin(), scalarNames.end(), name) != scalarNames.end())
+        throw logic_error(string("NtuplePlugin::DefineScalar: Intermediate \"") + name +
+         "\" has already been defined.");
+    
+    scalarNames.push_back(name);
+    context.scalarFunctions.push_back(function);
+    context.scalarValues.push_back(0.);
+    context.scalarGenerations.push_back(0);
+    
+    return ScalarHandle{unsigned(scalarNames.size() - 1)};
+}
+
+
+NtuplePlugin::P4Handle NtuplePlugin::DefineP4(string const &name, P4Function const &function)
+{
+    if (find(p4Names.begin(), p4Names.end(), name) != p4Names.end())
+        throw logic_error(string("NtuplePlugin::DefineP4: Intermediate \"") + name +
+         "\" has already been defined.");
+    
+    p4Names.push_back(name);
+    context.p4Functions.push_back(function);
+    context.p4Values.emplace_back();
+    context.p4Generations.push_back(0);
+    
+    return P4Handle{unsigned(p4Names.size() - 1)};
+}
+
+
+NtuplePlugin::ScalarHandle NtuplePlugin::GetScalarHandle(string const &name) const
+{
+    auto const it = find(scalarNames.begin(), scalarNames.end(), name);
+    
+    if (it == scalarNames.end())
+        throw logic_error(string("NtuplePlugin::GetScalarHandle: Intermediate \"") + name +
+         "\" has not been defined.");
+    
+    return ScalarHandle{unsigned(it - scalarNames.begin())};
+}
+
+
+NtuplePlugin::P4Handle NtuplePlugin::GetP4Handle(string const &name) const
+{
+    auto const it = find(p4Names.begin(), p4Names.end(), name);
+    
+    if (it == p4Names.end())
+        throw logic_error(string("NtuplePlugin::GetP4Handle: Intermediate \"") + name +
+         "\" has not been defined.");
+    
+    return P4Handle{unsigned(it - p4Names.begin())};
+}
+
+
+void NtuplePlugin::AddVariable(string const &name, ScalarFunction const &function,
+ Type type /*= Type::Float*/, bool mcOnly /*= false*/)
+{
+    if (FindVariable(name) != -1)
+        throw logic_error(string("NtuplePlugin::AddVariable: Variable \"") + name +
+         "\" has already been registered.");
+    
+    variables.push_back({name, function, type, mcOnly});
+}
+
+
+void NtuplePlugin::RequestVariables(vector<string> const &names)
+{
+    requestedNames.insert(requestedNames.end(), names.begin(), names.end());
+}
+
+
+void NtuplePlugin::SetEventFilter(EventFilter const &filter_)
+{
+    filter = filter_;
+}
+
+
+void NtuplePlugin::AddStandardVariables()
+{
+    // Event ID
+    AddVariable("run", [](Context &c){return c->GetEventID().Run();}, Type::ULong64);
+    AddVariable("event", [](Context &c){return c->GetEventID().Event();}, Type::ULong64);
+    AddVariable("lumiSection", [](Context &c){return c->GetEventID().LumiBlock();},
+     Type::ULong64);
+    
+    
+    // Intermediates shared between several variables. Note that the handles are captured by
+    //value, which keeps the functions valid in clones
+    P4Handle const p4W = DefineP4("p4W", [](Context &c)
+    {
+        if (c->GetLeptons().empty())
+            return TLorentzVector();
+        
+        return TLorentzVector(c->GetLeptons().front().P4() + c->GetNeutrino().P4());
+    });
+    
+    P4Handle const p4J1J2 = DefineP4("p4J1J2", [](Context &c)
+    {
+        auto const &jets = c->GetJets();
+        
+        if (jets.size() < 2)
+            return TLorentzVector();
+        
+        return TLorentzVector(jets[0].P4() + jets[1].P4());
+    });
+    
+    P4Handle const p4AllJets = DefineP4("p4AllJets", [](Context &c)
+    {
+        TLorentzVector p4;
+        
+        for (auto const &j: c->GetJets())
+            p4 += j.P4();
+        
+        for (auto const &j: c->GetAdditionalJets())
+            p4 += j.P4();
+        
+        return p4;
+    });
+    
+    
+    // Lepton and MET
+    AddVariable("Pt_Lep", [](Context &c)
+     {return (c->GetLeptons().empty()) ? 0. : c->GetLeptons().front().Pt();});
+    AddVariable("Eta_Lep", [](Context &c)
+     {return (c->GetLeptons().empty()) ? 0. : c->GetLeptons().front().Eta();});
+    AddVariable("MET", [](Context &c){return c->GetMET().Pt();});
+    AddVariable("Phi_MET", [](Context &c){return c->GetMET().Phi();});
+    AddVariable("MtW", [](Context &c)
+    {
+        if (c->GetLeptons().empty())
+            return 0.;
+        
+        auto const &lep = c->GetLeptons().front().P4();
+        auto const &met = c->GetMET().P4();
+        
+        return sqrt(pow(lep.Pt() + met.Pt(), 2) - pow(lep.Px() + met.Px(), 2) -
+         pow(lep.Py() + met.Py(), 2));
+    });
+    
+    
+    // Leading jets
+    AddVariable("Pt_J1", [](Context &c)
+     {return (c->GetJets().size() < 1) ? 0. : c->GetJets()[0].Pt();});
+    AddVariable("Eta_J1", [](Context &c)
+     {return (c->GetJets().size() < 1) ? 0. : c->GetJets()[0].Eta();});
+    AddVariable("Pt_J2", [](Context &c)
+     {return (c->GetJets().size() < 2) ? 0. : c->GetJets()[1].Pt();});
+    AddVariable("Eta_J2", [](Context &c)
+     {return (c->GetJets().size() < 2) ? 0. : c->GetJets()[1].Eta();});
+    
+    AddVariable("M_J1J2", [p4J1J2](Context &c)
+     {return (c->GetJets().size() < 2) ? 0. : c.Get(p4J1J2).M();});
+    AddVariable("Pt_J1J2", [p4J1J2](Context &c)
+     {return (c->GetJets().size() < 2) ? 0. : c.Get(p4J1J2).Pt();});
+    AddVariable("DR_J1J2", [](Context &c)
+    {
+        auto const &jets = c->GetJets();
+        return (jets.size() < 2) ? 0. : jets[0].P4().DeltaR(jets[1].P4());
+    });
+    
+    
+    // Multijet variables
+    AddVariable("Ht", [](Context &c)
+    {
+        double ht = 0.;
+        
+        for (auto const &j: c->GetJets())
+            ht += j.Pt();
+        
+        for (auto const &j: c->GetAdditionalJets())
+            ht += j.Pt();
+        
+        return ht;
+    });
+    
+    AddVariable("M_JW", [p4W, p4AllJets](Context &c)
+     {return (c->GetLeptons().empty()) ? 0. : (c.Get(p4W) + c.Get(p4AllJets)).M();});
+    
+    AddVariable("Sphericity", [p4W](Context &c)
+    {
+        if (c->GetLeptons().empty())
+            return 0.;
+        
+        EventShapes eventShapes;
+        eventShapes.AddMomentum(c.Get(p4W));
+        
+        for (auto const &j: c->GetJets())
+            eventShapes.AddMomentum(j.P4());
+        
+        return eventShapes.Sphericity();
+    });
+    
+    
+    // Miscellaneous
+    AddVariable("nPV", [](Context &c){return c->GetNPrimaryVertices();}, Type::Int);
+    AddVariable("weight", [](Context &c){return c->GetCentralWeight();}, Type::Float, true);
+}
+
+
+int NtuplePlugin::FindVariable(string const &name) const
+{
+    for (unsigned i = 0; i < variables.size(); ++i)
+        if (variables[i].name == name)
+            return i;
+    
+    return -1;
+}
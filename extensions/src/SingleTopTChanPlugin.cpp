@@ -2,17 +2,36 @@
 
 #include <Processor.hpp>
 #include <ROOTLock.hpp>
+#include <EventShapes.hpp>
 
 #include <TVector3.h>
-#include <TMatrixDSym.h>
-#include <TMatrixDSymEigen.h>
 
 #include <sys/stat.h>
+#include <cmath>
 
 
 using namespace std;
 
 
+/**
+ * \brief Returns three-momentum of a particle in the rest frame of a system with given momentum
+ * 
+ * Reproduces the spatial part of TLorentzVector::Boost(-frame.BoostVector()) without creating
+ * temporary objects.
+ */
+static TVector3 RestFrameMomentum(TLorentzVector const &p4, TLorentzVector const &frame)
+{
+    double const bx = frame.Px() / frame.E(), by = frame.Py() / frame.E(),
+     bz = frame.Pz() / frame.E();
+    double const b2 = bx * bx + by * by + bz * bz;
+    double const gamma = 1. / sqrt(1. - b2);
+    double const bp = bx * p4.Px() + by * p4.Py() + bz * p4.Pz();
+    double const factor = ((b2 > 0.) ? (gamma - 1.) * bp / b2 : 0.) - gamma * p4.E();
+    
+    return TVector3(p4.Px() + factor * bx, p4.Py() + factor * by, p4.Pz() + factor * bz);
+}
+
+
 SingleTopTChanPlugin::SingleTopTChanPlugin(string const &outDirectory_, BTagger const &bTagger_):
     Plugin("SingleTop"),
     bTagger(bTagger_), outDirectory(outDirectory_)
@@ -44,9 +63,9 @@ void SingleTopTChanPlugin::BeginRun(Dataset const &dataset)
     // Creation of ROOT objects is not thread-safe and must be protected
     ROOTLock::Lock();
     
-    // Create the output file
-    file = new TFile((outDirectory + dataset.GetFiles().front().GetBaseName() + ".root").c_str(),
-     "recreate");
+    // Create the output file. It is written under a temporary name and renamed in EndRun
+    outFileName = outDirectory + dataset.GetFiles().front().GetBaseName() + ".root";
+    file = new TFile(GetTempFileName(outFileName).c_str(), "recreate");
     
     // Create the tree
     tree = new TTree("Vars", "Basic kinematical variables");
@@ -107,6 +126,9 @@ void SingleTopTChanPlugin::EndRun()
     delete file;
     
     ROOTLock::Unlock();
+    
+    // The output file is complete now and can be given its final name
+    CommitOutputFile(outFileName);
 }
 
 
@@ -218,46 +240,20 @@ bool SingleTopTChanPlugin::ProcessEvent()
     
     
     // Calculate cos(theta)
-    TVector3 b(p4Top.BoostVector());
-    
-    TLorentzVector boostedLepton(lepton.P4());
-    boostedLepton.Boost(-b);
-    TVector3 const p3Lepton(boostedLepton.Vect());
-    
-    TLorentzVector boostedLJet(lJet.P4());
-    boostedLJet.Boost(-b);
-    TVector3 const p3LJet(boostedLJet.Vect());
+    TVector3 const p3Lepton(RestFrameMomentum(lepton.P4(), p4Top));
+    TVector3 const p3LJet(RestFrameMomentum(lJet.P4(), p4Top));
     
     Cos_LepLJ_BJ1 = p3Lepton.Dot(p3LJet) / (p3Lepton.Mag() * p3LJet.Mag());
     
     
     // Calculate sphericity
-    TMatrixDSym sphericityTensor(3);
-    double norm = 0.;
-    
-    TVector3 p3(p4W.Vect());
-    norm += p3.Mag2();
-    
-    for (unsigned i = 0; i < 3; ++i)
-        for (unsigned j = 0; j < 3; ++j)
-            sphericityTensor(i, j) = p3[i] * p3[j];
+    EventShapes eventShapes;
+    eventShapes.AddMomentum(p4W);
     
     for (auto const &j: jets)
-    {
-        p3 = j.P4().Vect();
-        norm += p3.Mag2();
-        
-        for (unsigned i = 0; i < 3; ++i)
-            for (unsigned j = 0; j < 3; ++j)
-                sphericityTensor(i, j) += p3[i] * p3[j];
-    }
-    
-    sphericityTensor *= 1. / norm;
-    
-    TMatrixDSymEigen eigenValCalc(sphericityTensor);
-    TVectorD eigenVals(eigenValCalc.GetEigenValues());
+        eventShapes.AddMomentum(j.P4());
     
-    Sphericity = 1.5 * (eigenVals[1] + eigenVals[2]);
+    Sphericity = eventShapes.Sphericity();
     
     
     // Number of reconstructed primary vertices
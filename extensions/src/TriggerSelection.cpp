@@ -1,22 +1,62 @@
 #include <TriggerSelection.hpp>
 
 #include <TTree.h>
+#include <TBranch.h>
 
 #include <algorithm>
+#include <map>
 
 
 using namespace std;
 
 
+/**
+ * \brief Reads decisions of a trigger for all entries of the tree and packs them into a bitset
+ * 
+ * The decisions are read with TBranch::GetEntry into the buffer whose address has been assigned
+ * to the branch, which must be enabled. The bit with index i in the resulting bitset corresponds
+ * to the i-th entry.
+ */
+static void PreloadTriggerBits(TBranch *branch, unsigned long nEntries, Bool_t const *buffer,
+ vector<uint64_t> &bits)
+{
+    bits.assign((nEntries + 63) / 64, 0);
+    
+    for (unsigned long entry = 0; entry < nEntries; ++entry)
+    {
+        branch->GetEntry(entry);
+        
+        if (*buffer)
+            bits[entry / 64] |= uint64_t(1) << (entry % 64);
+    }
+}
+
+
+/// Extracts the decision for the given entry from a bitset filled by PreloadTriggerBits
+static inline bool TestTriggerBit(vector<uint64_t> const &bits, unsigned long entry)
+{
+    return ((bits[entry / 64] >> (entry % 64)) & 1);
+}
+
+
 TriggerSelectionData::TriggerSelectionData(vector<TriggerRange const *> const &ranges_):
     TriggerSelectionInterface(),
     ranges(ranges_),
-    currentRange(nullptr)
+    preloadBits(false),
+    currentRangeIndex(-1), currentBranchIndex(-1)
 {
     // A sanity check
     if (ranges_.size() == 0)
         throw std::logic_error("TriggerSelectionData::TriggerSelectionData: The provided "
          "collection of pointers to TriggerRange objects is empty.");
+    
+    SortRanges();
+}
+
+
+void TriggerSelectionData::SetPreloadTriggerBits(bool preload /*= true*/)
+{
+    preloadBits = preload;
 }
 
 
@@ -30,8 +70,48 @@ void TriggerSelectionData::UpdateTree(TTree *triggerTree_, bool)
     triggerTree->SetBranchStatus("*", false);
     
     
+    // Find branches for all the trigger ranges. The same trigger is often used in many ranges,
+    //therefore already resolved branches are remembered to avoid repeated look-ups in the tree.
+    //The found branches are enabled again because TBranch::GetEntry does not read a disabled
+    //branch; all other branches stay disabled
+    branches.clear();
+    branchIndices.clear();
+    branchIndices.reserve(ranges.size());
+    map<string, int> resolvedBranches;
+    
+    for (auto const &r: ranges)
+    {
+        string const branchName(r->GetDataTriggerPattern() + "__accept");
+        auto res = resolvedBranches.find(branchName);
+        
+        if (res == resolvedBranches.end())
+        {
+            TBranch *branch = triggerTree->GetBranch(branchName.c_str());
+            int index = -1;
+            
+            if (branch)
+            {
+                branch->SetStatus(true);
+                branch->SetAddress(&eventAccepted);
+                index = branches.size();
+                branches.push_back(branch);
+            }
+            
+            res = resolvedBranches.emplace(branchName, index).first;
+        }
+        
+        branchIndices.push_back(res->second);
+    }
+    
+    
+    // Drop decisions preloaded from the previous file
+    preloadedBits.clear();
+    preloadedBits.resize(branches.size());
+    
+    
     // Invalidate the current range
-    currentRange = nullptr;
+    currentRangeIndex = -1;
+    currentBranchIndex = -1;
 }
 
 
@@ -49,17 +129,15 @@ bool TriggerSelectionData::ReadNextEvent(EventID const &eventID)
     
     
     // Check if the current trigger range accommodates the given event ID and update it if needed
-    if (not currentRange or not currentRange->InRange(eventID))
+    if (currentRangeIndex == -1 or not ranges[currentRangeIndex]->InRange(eventID))
     {
         // Find the range that contains the event with the given ID
-        auto res = find_if(ranges.begin(), ranges.end(),
-         [&eventID](TriggerRange const *r){return (r->InRange(eventID));});
+        currentRangeIndex = FindRange(eventID);
         
-        if (res == ranges.end())
+        if (currentRangeIndex == -1)
         // No range contains the given event ID
         {
             // Set the state of the object such that the event will be rejected
-            currentRange = nullptr;
             eventAccepted = false;
             
             // There is no need to actually read the event. Just update the counter
@@ -68,26 +146,29 @@ bool TriggerSelectionData::ReadNextEvent(EventID const &eventID)
         }
         
         
-        // A valid trigger range has been found. Get the corresponding branch of the tree and assign
-        //the buffer to it
-        currentRange = *res;
-        triggerTree->SetBranchStatus("*", false);
+        // A valid trigger range has been found. Switch to the corresponding branch of the tree. Its
+        //address has already been set in UpdateTree
+        currentBranchIndex = branchIndices[currentRangeIndex];
         
-        TBranch *branch =
-         triggerTree->GetBranch((currentRange->GetDataTriggerPattern() + "__accept").c_str());
-        
-        if (not branch)
+        if (currentBranchIndex == -1)
             throw runtime_error(string("TriggerSelectionData::ReadNextEvent: State of the "
-             "trigger \"HLT_") + currentRange->GetDataTriggerPattern() + "_v*\" is not stored in "
-             "the source tree.");
+             "trigger \"HLT_") + ranges[currentRangeIndex]->GetDataTriggerPattern() +
+             "_v*\" is not stored in the source tree.");
+        
         
-        branch->SetStatus(true);
-        branch->SetAddress(&eventAccepted);
+        // Read decisions for the whole file if requested and not done yet
+        if (preloadBits and preloadedBits[currentBranchIndex].empty())
+            PreloadTriggerBits(branches[currentBranchIndex], nEntriesTree, &eventAccepted,
+             preloadedBits[currentBranchIndex]);
     }
     
     
-    // Finally, read the event
-    triggerTree->GetEntry(nextEntryTree);
+    // Finally, read the decision. Only the branch of the current trigger is touched
+    if (preloadBits)
+        eventAccepted = TestTriggerBit(preloadedBits[currentBranchIndex], nextEntryTree);
+    else
+        branches[currentBranchIndex]->GetEntry(nextEntryTree);
+    
     ++nextEntryTree;
     
     return true;
@@ -103,20 +184,50 @@ bool TriggerSelectionData::PassTrigger() const
 
 double TriggerSelectionData::GetWeight(PECReader const &reader) const
 {
-    return (currentRange->PassEventSelection(reader)) ? 1. : 0.;
+    return (ranges[currentRangeIndex]->PassEventSelection(reader)) ? 1. : 0.;
 }
 
 
 TriggerSelectionInterface *TriggerSelectionData::Clone() const
 {
-    return new TriggerSelectionData(ranges);
+    TriggerSelectionData *clone = new TriggerSelectionData(ranges);
+    clone->SetPreloadTriggerBits(preloadBits);
+    
+    return clone;
+}
+
+
+void TriggerSelectionData::SortRanges()
+{
+    sort(ranges.begin(), ranges.end(), [](TriggerRange const *lhs, TriggerRange const *rhs)
+     {return (lhs->GetFirstEvent() < rhs->GetFirstEvent());});
+}
+
+
+int TriggerSelectionData::FindRange(EventID const &eventID) const
+{
+    // Find the first range that starts after the given event. Since the ranges do not overlap, the
+    //only candidate to contain the event is the range just before it
+    auto res = upper_bound(ranges.begin(), ranges.end(), eventID,
+     [](EventID const &id, TriggerRange const *r){return (id < r->GetFirstEvent());});
+    
+    if (res == ranges.begin())
+        return -1;
+    
+    --res;
+    
+    if (not (*res)->InRange(eventID))
+        return -1;
+    
+    return res - ranges.begin();
 }
 
 
 
 TriggerSelectionMC::TriggerSelectionMC(std::vector<TriggerRange const *> const &ranges_):
     TriggerSelectionInterface(),
-    buffer(nullptr)
+    buffer(nullptr),
+    preloadBits(false)
 {
     // A sanity check
     if (ranges_.size() == 0)
@@ -138,6 +249,12 @@ TriggerSelectionMC::~TriggerSelectionMC()
 }
 
 
+void TriggerSelectionMC::SetPreloadTriggerBits(bool preload /*= true*/)
+{
+    preloadBits = preload;
+}
+
+
 void TriggerSelectionMC::UpdateTree(TTree *triggerTree_, bool)
 {
     // Update the tree pointer and counters
@@ -150,13 +267,16 @@ void TriggerSelectionMC::UpdateTree(TTree *triggerTree_, bool)
     //block. The number of buffers cannot exceed ranges.size(), but it might be smaller if some
     //MC triggers are repeated in several TriggerRange objects. For the sake of simplicity and
     //performance, no attempt to count distinctive triggers is made, and an array of size
-    //ranges.size() is allocated.
-    buffer = new Bool_t[ranges.size()];
+    //ranges.size() is allocated. It is reused for all the subsequent trees
+    if (not buffer)
+        buffer = new Bool_t[ranges.size()];
     
     
     // Set statuses and addresses of relevant branches of the trigger tree. A certain complication
-    //is caused by the fact that the same trigger might be specified in several trigger ranges
+    //is caused by the fact that the same trigger might be specified in several trigger ranges.
+    //Only the needed branches are enabled since TBranch::GetEntry does not read disabled ones
     triggerTree->SetBranchStatus("*", false);
+    branches.clear();
     unsigned curBufferIndex = 0;
     
     for (unsigned i = 0; i < ranges.size(); ++i)
@@ -184,9 +304,10 @@ void TriggerSelectionMC::UpdateTree(TTree *triggerTree_, bool)
                  "trigger \"HLT_") + curTriggerName + "_v*\" is not stored in the source tree.");
             
             
-            // Set the status and address of the branch
+            // Enable the branch, set its address, and remember it
             branch->SetStatus(true);
             branch->SetAddress(buffer + curBufferIndex);
+            branches.push_back(branch);
             
             // Store the address also in ranges
             ranges.at(i).second = buffer + curBufferIndex;
@@ -202,6 +323,16 @@ void TriggerSelectionMC::UpdateTree(TTree *triggerTree_, bool)
             ranges.at(i).second = ranges.at(iPrev).second;
         }
     }
+    
+    
+    // Read decisions of all the triggers for the whole file if requested
+    preloadedBits.resize(branches.size());
+    
+    if (preloadBits)
+    {
+        for (unsigned i = 0; i < branches.size(); ++i)
+            PreloadTriggerBits(branches[i], nEntriesTree, buffer + i, preloadedBits[i]);
+    }
 }
 
 
@@ -218,14 +349,30 @@ bool TriggerSelectionMC::ReadNextEvent(EventID const &)
         return false;
     
     
-    // Read the next entry
-    triggerTree->GetEntry(nextEntryTree);
+    // Read the decisions. Only the branches of the needed triggers are touched
+    if (preloadBits)
+    {
+        for (unsigned i = 0; i < branches.size(); ++i)
+            buffer[i] = TestTriggerBit(preloadedBits[i], nextEntryTree);
+    }
+    else
+    {
+        for (auto const &branch: branches)
+            branch->GetEntry(nextEntryTree);
+    }
+    
     ++nextEntryTree;
     
     return true;
 }
 
 
+bool TriggerSelectionMC::RequiresEventID() const
+{
+    return false;
+}
+
+
 bool TriggerSelectionMC::PassTrigger() const
 {
     // Check all the requested triggers
@@ -270,24 +417,51 @@ TriggerSelectionInterface *TriggerSelectionMC::Clone() const
     
     
     // Feed it to the appropriate constructor
-    return new TriggerSelectionMC(pureRanges);
+    TriggerSelectionMC *clone = new TriggerSelectionMC(pureRanges);
+    clone->SetPreloadTriggerBits(preloadBits);
+    
+    return clone;
 }
 
 
 
 TriggerSelection::TriggerSelection(vector<TriggerRange const *> const &ranges_):
     TriggerSelectionInterface(),
-    ranges(ranges_)
+    ranges(ranges_),
+    selectionForData(false), preloadBits(false)
 {}
 
 
+void TriggerSelection::SetPreloadTriggerBits(bool preload /*= true*/)
+{
+    preloadBits = preload;
+    
+    // Drop the selection object so that it is recreated with the new flag
+    selection.reset();
+}
+
+
 void TriggerSelection::UpdateTree(TTree *triggerTree_, bool isData)
 {
-    // Create a new object to perform the trigger selection
-    if (isData)
-        selection.reset(new TriggerSelectionData(ranges));
-    else
-        selection.reset(new TriggerSelectionMC(ranges));
+    // Create a new object to perform the trigger selection unless an object of the right type
+    //already exists. Reusing it avoids sorting the trigger ranges for each file
+    if (not selection or isData != selectionForData)
+    {
+        if (isData)
+        {
+            TriggerSelectionData *dataSelection = new TriggerSelectionData(ranges);
+            dataSelection->SetPreloadTriggerBits(preloadBits);
+            selection.reset(dataSelection);
+        }
+        else
+        {
+            TriggerSelectionMC *mcSelection = new TriggerSelectionMC(ranges);
+            mcSelection->SetPreloadTriggerBits(preloadBits);
+            selection.reset(mcSelection);
+        }
+        
+        selectionForData = isData;
+    }
     
     
     // Set the trigger tree in the selection object
@@ -306,6 +480,23 @@ bool TriggerSelection::ReadNextEvent(EventID const &eventID)
 }
 
 
+bool TriggerSelection::ReadEvent(unsigned long entry, EventID const &eventID)
+{
+    // A sanity check
+    if (not selection)
+        throw logic_error("TriggerSelection::ReadEvent: Attempting to read an unspecified "
+         "trigger tree.");
+    
+    return selection->ReadEvent(entry, eventID);
+}
+
+
+bool TriggerSelection::RequiresEventID() const
+{
+    return (selection) ? selection->RequiresEventID() : true;
+}
+
+
 bool TriggerSelection::PassTrigger() const
 {
     return selection->PassTrigger();
@@ -320,5 +511,8 @@ double TriggerSelection::GetWeight(PECReader const &reader) const
 
 TriggerSelectionInterface *TriggerSelection::Clone() const
 {
-    return new TriggerSelection(ranges);
+    TriggerSelection *clone = new TriggerSelection(ranges);
+    clone->SetPreloadTriggerBits(preloadBits);
+    
+    return clone;
 }
\ No newline at end of file
@@ -18,7 +18,8 @@ WeightPileUp::WeightPileUp(string const &dataPUFileName, string const &mcPUFileN
     FileInPath pathResolver;
     
     
-    // Open file with MC-truth pile-up distributions
+    // Open file with MC-truth pile-up distributions. The file is shared among all copies of this
+    //object, which can be used in different threads
     ROOTLock::Lock();
     mcPUFile.reset(new TFile((pathResolver.Resolve("PileUp/", mcPUFileName)).c_str()));
     ROOTLock::Unlock();
@@ -32,10 +33,8 @@ WeightPileUp::WeightPileUp(string const &dataPUFileName, double systError_):
     FileInPath pathResolver;
     
     
-    // ROOT objects are created below. Mark it as a critical block
-    ROOTLock::Lock();
-    
-    // Read the target (real data) pile-up distribution
+    // Read the target (real data) pile-up distribution. The file is local to this method, and
+    //thread safety of ROOT routines is provided by ROOT itself (see ROOTLock::EnableThreadSafety)
     TFile dataPUFile((pathResolver.Resolve("PileUp/", dataPUFileName)).c_str());
     dataPUHist.reset(dynamic_cast<TH1 *>(dataPUFile.Get("pileup")));
     
@@ -48,9 +47,6 @@ WeightPileUp::WeightPileUp(string const &dataPUFileName, double systError_):
     dataPUHist->SetBinContent(dataPUHist->GetNbinsX() + 1, 0.);
     
     dataPUFile.Close();
-    
-    // End of critical block
-    ROOTLock::Unlock();
 }
 
 
@@ -97,12 +93,10 @@ void WeightPileUp::SetDataset(Dataset const &)
          1.017E-04, 7.126E-05, 4.948E-05, 3.405E-05, 2.322E-05, 1.570E-05, 5.005E-06};
         
         
-        // Create a new MC pile-up histogram
-        ROOTLock::Lock();
+        // Create a new MC pile-up histogram. It is owned by this object, so no lock is needed
         mcPUHist.reset(new TH1D("nominal", "", pileUpTruthHist.size(),
          0., pileUpTruthHist.size()));
         mcPUHist->SetDirectory(nullptr);
-        ROOTLock::Unlock();
         
         // Fill it
         for (unsigned bin = 1; bin <= pileUpTruthHist.size(); ++bin)
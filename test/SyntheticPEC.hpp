@@ -0,0 +1,671 @@
+/**
+ * \file SyntheticPEC.hpp
+ * \author Andrey Popov
+ * 
+ * The module defines functions to generate synthetic files in the PEC format together with the
+ * payload files needed for reweighting. They are used by test and benchmark programs, which thus
+ * do not depend on any external input. The module also provides helpers shared by these programs
+ * to prepare the working directory, to define the dataset, and to set up a typical analysis
+ * configuration. Everything is defined in the header since every test program is built from a
+ * single source file.
+ */
+
+#pragma once
+
+#include <TFile.h>
+#include <TTree.h>
+#include <TH1.h>
+#include <TH2D.h>
+#include <TRandom3.h>
+
+#include <Dataset.hpp>
+#include <PECReaderConfig.hpp>
+#include <GenericEventSelection.hpp>
+#include <BTagger.hpp>
+#include <BTagEfficiencies.hpp>
+#include <BTagScaleFactors.hpp>
+#include <WeightBTag.hpp>
+#include <TriggerSelection.hpp>
+#include <WeightPileUp.hpp>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <list>
+#include <memory>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdlib>
+#include <cmath>
+
+
+/**
+ * \brief Writes a synthetic PEC file with the given number of events
+ * 
+ * The file contains all the trees and branches read by PECReader for simulation, as well as a
+ * trigger tree with the decision of trigger "IsoMu24_eta2p1". It can also be processed as real
+ * data since the branches specific to simulation are then simply not read. Multiplicities and
+ * kinematics of physics objects are drawn from simple distributions that resemble a sample of
+ * semileptonic ttbar events with a reasonable admixture of soft activity, so that realistic
+ * fractions of events pass typical selections. The trigger fires in events that contain a muon
+ * with pt > 24 GeV and |eta| < 2.1. Event numbers are consecutive and start from firstEvent; all
+ * events belong to run 1. For a given seed, the content of the file is reproducible.
+ * 
+ * Throws an exception if the file cannot be created.
+ */
+inline void WriteSyntheticPECFile(std::string const &fileName, unsigned long nEvents,
+ unsigned seed = 1, unsigned long firstEvent = 1)
+{
+    unsigned const maxSize = 64;
+    TRandom3 rGen(seed);
+    
+    TFile file(fileName.c_str(), "recreate");
+    
+    if (file.IsZombie())
+        throw std::runtime_error(std::string("WriteSyntheticPECFile: Failed to create file \"") +
+         fileName + "\".");
+    
+    
+    // Buffers for all the branches. Types match the ones used in PECReader
+    ULong64_t run, lumi, event;
+    
+    UChar_t eleSize;
+    Float_t elePt[maxSize], eleEta[maxSize], elePhi[maxSize], eleRelIso[maxSize], eleDB[maxSize],
+     eleMVAID[maxSize];
+    Bool_t eleTriggerPreselection[maxSize], elePassConversion[maxSize], eleSelectionA[maxSize],
+     eleCharge[maxSize];
+    
+    UChar_t muSize;
+    Float_t muPt[maxSize], muEta[maxSize], muPhi[maxSize], muRelIso[maxSize], muDB[maxSize];
+    Bool_t muQualityTight[maxSize], muCharge[maxSize];
+    
+    UChar_t jetSize;
+    Float_t jetPt[maxSize], jetEta[maxSize], jetPhi[maxSize], jetMass[maxSize], jetCSV[maxSize],
+     jetTCHP[maxSize], jetCharge[maxSize], jetPullAngle[maxSize], jecUncertainty[maxSize],
+     jerFactorUp[maxSize], jerFactorDown[maxSize];
+    Char_t jetFlavour[maxSize];
+    
+    Float_t softJetPt, softJetEta, softJetPhi, softJetMass, softJetHt;
+    Float_t softJetPtJERUp, softJetEtaJERUp, softJetPhiJERUp, softJetMassJERUp, softJetHtJERUp;
+    Float_t softJetPtJERDown, softJetEtaJERDown, softJetPhiJERDown, softJetMassJERDown,
+     softJetHtJERDown;
+    
+    UChar_t metSize;
+    Float_t metPt[maxSize], metPhi[maxSize];
+    
+    UChar_t pvSize;
+    Float_t rho, puTrueNumInteractions;
+    
+    Short_t processID;
+    UChar_t hardPartSize;
+    Char_t hardPartPdgId[maxSize], hardPartFirstMother[maxSize], hardPartLastMother[maxSize];
+    Float_t hardPartPt[maxSize], hardPartEta[maxSize], hardPartPhi[maxSize], hardPartMass[maxSize];
+    
+    UChar_t genJetSize;
+    Float_t genJetPt[maxSize], genJetEta[maxSize], genJetPhi[maxSize], genJetMass[maxSize];
+    
+    UChar_t psSize;
+    Short_t psPdgId[maxSize];
+    UChar_t psOrigin[maxSize];
+    Float_t psPt[maxSize], psEta[maxSize], psPhi[maxSize];
+    
+    Bool_t triggerAccept;
+    
+    
+    // Create the trees in the same directories as in real PEC files
+    TTree *eventIDTree, *basicInfoTree, *puInfoTree, *generatorInfoTree, *triggerTree,
+     *genJetsTree, *psTree;
+    
+    auto makeTree = [&file](std::string const &dir, std::string const &name)
+    {
+        TDirectory *d = file.GetDirectory(dir.c_str());
+        
+        if (not d)
+            d = file.mkdir(dir.c_str());
+        
+        d->cd();
+        return new TTree(name.c_str(), "");
+    };
+    
+    eventIDTree = makeTree("eventContent", "EventID");
+    eventIDTree->Branch("run", &run, "run/l");
+    eventIDTree->Branch("lumi", &lumi, "lumi/l");
+    eventIDTree->Branch("event", &event, "event/l");
+    
+    basicInfoTree = makeTree("eventContent", "BasicInfo");
+    basicInfoTree->Branch("eleSize", &eleSize, "eleSize/b");
+    basicInfoTree->Branch("elePt", elePt, "elePt[eleSize]/F");
+    basicInfoTree->Branch("eleEta", eleEta, "eleEta[eleSize]/F");
+    basicInfoTree->Branch("elePhi", elePhi, "elePhi[eleSize]/F");
+    basicInfoTree->Branch("eleRelIso", eleRelIso, "eleRelIso[eleSize]/F");
+    basicInfoTree->Branch("eleDB", eleDB, "eleDB[eleSize]/F");
+    basicInfoTree->Branch("eleTriggerPreselection", eleTriggerPreselection,
+     "eleTriggerPreselection[eleSize]/O");
+    basicInfoTree->Branch("eleMVAID", eleMVAID, "eleMVAID[eleSize]/F");
+    basicInfoTree->Branch("elePassConversion", elePassConversion, "elePassConversion[eleSize]/O");
+    basicInfoTree->Branch("eleSelectionA", eleSelectionA, "eleSelectionA[eleSize]/O");
+    basicInfoTree->Branch("eleCharge", eleCharge, "eleCharge[eleSize]/O");
+    
+    basicInfoTree->Branch("muSize", &muSize, "muSize/b");
+    basicInfoTree->Branch("muPt", muPt, "muPt[muSize]/F");
+    basicInfoTree->Branch("muEta", muEta, "muEta[muSize]/F");
+    basicInfoTree->Branch("muPhi", muPhi, "muPhi[muSize]/F");
+    basicInfoTree->Branch("muRelIso", muRelIso, "muRelIso[muSize]/F");
+    basicInfoTree->Branch("muDB", muDB, "muDB[muSize]/F");
+    basicInfoTree->Branch("muQualityTight", muQualityTight, "muQualityTight[muSize]/O");
+    basicInfoTree->Branch("muCharge", muCharge, "muCharge[muSize]/O");
+    
+    basicInfoTree->Branch("jetSize", &jetSize, "jetSize/b");
+    basicInfoTree->Branch("jetPt", jetPt, "jetPt[jetSize]/F");
+    basicInfoTree->Branch("jetEta", jetEta, "jetEta[jetSize]/F");
+    basicInfoTree->Branch("jetPhi", jetPhi, "jetPhi[jetSize]/F");
+    basicInfoTree->Branch("jetMass", jetMass, "jetMass[jetSize]/F");
+    basicInfoTree->Branch("jetCSV", jetCSV, "jetCSV[jetSize]/F");
+    basicInfoTree->Branch("jetTCHP", jetTCHP, "jetTCHP[jetSize]/F");
+    basicInfoTree->Branch("jetCharge", jetCharge, "jetCharge[jetSize]/F");
+    basicInfoTree->Branch("jetPullAngle", jetPullAngle, "jetPullAngle[jetSize]/F");
+    basicInfoTree->Branch("jetFlavour", jetFlavour, "jetFlavour[jetSize]/B");
+    basicInfoTree->Branch("jecUncertainty", jecUncertainty, "jecUncertainty[jetSize]/F");
+    basicInfoTree->Branch("jerFactorUp", jerFactorUp, "jerFactorUp[jetSize]/F");
+    basicInfoTree->Branch("jerFactorDown", jerFactorDown, "jerFactorDown[jetSize]/F");
+    
+    basicInfoTree->Branch("softJetPt", &softJetPt, "softJetPt/F");
+    basicInfoTree->Branch("softJetEta", &softJetEta, "softJetEta/F");
+    basicInfoTree->Branch("softJetPhi", &softJetPhi, "softJetPhi/F");
+    basicInfoTree->Branch("softJetMass", &softJetMass, "softJetMass/F");
+    basicInfoTree->Branch("softJetHt", &softJetHt, "softJetHt/F");
+    basicInfoTree->Branch("softJetPtJERUp", &softJetPtJERUp, "softJetPtJERUp/F");
+    basicInfoTree->Branch("softJetEtaJERUp", &softJetEtaJERUp, "softJetEtaJERUp/F");
+    basicInfoTree->Branch("softJetPhiJERUp", &softJetPhiJERUp, "softJetPhiJERUp/F");
+    basicInfoTree->Branch("softJetMassJERUp", &softJetMassJERUp, "softJetMassJERUp/F");
+    basicInfoTree->Branch("softJetHtJERUp", &softJetHtJERUp, "softJetHtJERUp/F");
+    basicInfoTree->Branch("softJetPtJERDown", &softJetPtJERDown, "softJetPtJERDown/F");
+    basicInfoTree->Branch("softJetEtaJERDown", &softJetEtaJERDown, "softJetEtaJERDown/F");
+    basicInfoTree->Branch("softJetPhiJERDown", &softJetPhiJERDown, "softJetPhiJERDown/F");
+    basicInfoTree->Branch("softJetMassJERDown", &softJetMassJERDown, "softJetMassJERDown/F");
+    basicInfoTree->Branch("softJetHtJERDown", &softJetHtJERDown, "softJetHtJERDown/F");
+    
+    basicInfoTree->Branch("metSize", &metSize, "metSize/b");
+    basicInfoTree->Branch("metPt", metPt, "metPt[metSize]/F");
+    basicInfoTree->Branch("metPhi", metPhi, "metPhi[metSize]/F");
+    
+    puInfoTree = makeTree("eventContent", "PUInfo");
+    puInfoTree->Branch("pvSize", &pvSize, "pvSize/b");
+    puInfoTree->Branch("rho", &rho, "rho/F");
+    puInfoTree->Branch("puTrueNumInteractions", &puTrueNumInteractions,
+     "puTrueNumInteractions/F");
+    
+    generatorInfoTree = makeTree("eventContent", "GeneratorInfo");
+    generatorInfoTree->Branch("processID", &processID, "processID/S");
+    generatorInfoTree->Branch("hardPartSize", &hardPartSize, "hardPartSize/b");
+    generatorInfoTree->Branch("hardPartPdgId", hardPartPdgId, "hardPartPdgId[hardPartSize]/B");
+    generatorInfoTree->Branch("hardPartFirstMother", hardPartFirstMother,
+     "hardPartFirstMother[hardPartSize]/B");
+    generatorInfoTree->Branch("hardPartLastMother", hardPartLastMother,
+     "hardPartLastMother[hardPartSize]/B");
+    generatorInfoTree->Branch("hardPartPt", hardPartPt, "hardPartPt[hardPartSize]/F");
+    generatorInfoTree->Branch("hardPartEta", hardPartEta, "hardPartEta[hardPartSize]/F");
+    generatorInfoTree->Branch("hardPartPhi", hardPartPhi, "hardPartPhi[hardPartSize]/F");
+    generatorInfoTree->Branch("hardPartMass", hardPartMass, "hardPartMass[hardPartSize]/F");
+    
+    triggerTree = makeTree("trigger", "TriggerInfo");
+    triggerTree->Branch("IsoMu24_eta2p1__accept", &triggerAccept, "IsoMu24_eta2p1__accept/O");
+    
+    genJetsTree = makeTree("genJets", "GenJets");
+    genJetsTree->Branch("jetSize", &genJetSize, "jetSize/b");
+    genJetsTree->Branch("jetPt", genJetPt, "jetPt[jetSize]/F");
+    genJetsTree->Branch("jetEta", genJetEta, "jetEta[jetSize]/F");
+    genJetsTree->Branch("jetPhi", genJetPhi, "jetPhi[jetSize]/F");
+    genJetsTree->Branch("jetMass", genJetMass, "jetMass[jetSize]/F");
+    
+    psTree = makeTree("heavyFlavours", "PartonShowerInfo");
+    psTree->Branch("psSize", &psSize, "psSize/b");
+    psTree->Branch("psPdgId", psPdgId, "psPdgId[psSize]/S");
+    psTree->Branch("psOrigin", psOrigin, "psOrigin[psSize]/b");
+    psTree->Branch("psPt", psPt, "psPt[psSize]/F");
+    psTree->Branch("psEta", psEta, "psEta[psSize]/F");
+    psTree->Branch("psPhi", psPhi, "psPhi[psSize]/F");
+    
+    
+    // Auxiliary functions to draw random numbers
+    auto multiplicity = [&rGen](double mean, unsigned max)
+    {
+        return UChar_t(std::min<unsigned>(rGen.Poisson(mean), max));
+    };
+    
+    auto phi = [&rGen]()
+    {
+        return Float_t(rGen.Uniform(-M_PI, M_PI));
+    };
+    
+    auto sortByPt = [](Float_t *pt, unsigned n)
+    {
+        std::sort(pt, pt + n, [](Float_t a, Float_t b){return (a > b);});
+    };
+    
+    
+    // Generate the events
+    for (unsigned long ev = 0; ev < nEvents; ++ev)
+    {
+        run = 1;
+        lumi = 1 + (firstEvent + ev) / 1000;
+        event = firstEvent + ev;
+        
+        
+        // Electrons and muons. About one third of events contain a tight isolated lepton
+        eleSize = multiplicity(0.6, 8);
+        
+        for (unsigned i = 0; i < eleSize; ++i)
+        {
+            elePt[i] = 10. + rGen.Exp(25.);
+            eleEta[i] = rGen.Uniform(-2.5, 2.5);
+            elePhi[i] = phi();
+            eleRelIso[i] = rGen.Exp(0.15);
+            eleDB[i] = rGen.Gaus(0., 0.02);
+            eleTriggerPreselection[i] = (rGen.Uniform() < 0.9);
+            eleMVAID[i] = rGen.Uniform(-1., 1.);
+            elePassConversion[i] = (rGen.Uniform() < 0.95);
+            eleSelectionA[i] = (rGen.Uniform() < 0.8);
+            eleCharge[i] = (rGen.Uniform() < 0.5);
+        }
+        
+        sortByPt(elePt, eleSize);
+        
+        muSize = multiplicity(0.8, 8);
+        triggerAccept = false;
+        
+        for (unsigned i = 0; i < muSize; ++i)
+        {
+            muPt[i] = 10. + rGen.Exp(25.);
+            muEta[i] = rGen.Uniform(-2.4, 2.4);
+            muPhi[i] = phi();
+            muRelIso[i] = rGen.Exp(0.12);
+            muDB[i] = rGen.Gaus(0., 0.02);
+            muQualityTight[i] = (rGen.Uniform() < 0.9);
+            muCharge[i] = (rGen.Uniform() < 0.5);
+        }
+        
+        sortByPt(muPt, muSize);
+        
+        for (unsigned i = 0; i < muSize; ++i)
+            if (muPt[i] > 24. and std::fabs(muEta[i]) < 2.1)
+                triggerAccept = true;
+        
+        
+        // Jets. Flavours and b-tagging discriminators are correlated in a simple way
+        jetSize = multiplicity(5.5, maxSize);
+        
+        for (unsigned i = 0; i < jetSize; ++i)
+            jetPt[i] = 20. + rGen.Exp(35.);
+        
+        sortByPt(jetPt, jetSize);
+        
+        for (unsigned i = 0; i < jetSize; ++i)
+        {
+            jetEta[i] = rGen.Gaus(0., 1.8);
+            jetPhi[i] = phi();
+            jetMass[i] = jetPt[i] * rGen.Uniform(0.05, 0.2);
+            
+            double const u = rGen.Uniform();
+            jetFlavour[i] = (u < 0.15) ? 5 : ((u < 0.25) ? 4 : ((u < 0.6) ? 21 : 1));
+            jetFlavour[i] *= (rGen.Uniform() < 0.5) ? -1 : 1;
+            
+            if (std::abs(jetFlavour[i]) == 5)
+                jetCSV[i] = 1. - rGen.Exp(0.15);
+            else if (std::abs(jetFlavour[i]) == 4)
+                jetCSV[i] = rGen.Uniform();
+            else
+                jetCSV[i] = rGen.Exp(0.15);
+            
+            jetCSV[i] = std::max<Float_t>(std::min<Float_t>(jetCSV[i], 1.), 0.);
+            jetTCHP[i] = 10. * jetCSV[i] + rGen.Gaus(0., 0.5);
+            
+            jetCharge[i] = rGen.Gaus(0., 0.3);
+            jetPullAngle[i] = phi();
+            jecUncertainty[i] = 0.01 + rGen.Exp(0.02);
+            jerFactorUp[i] = 1. + std::fabs(rGen.Gaus(0., 0.05));
+            jerFactorDown[i] = 1. - std::fabs(rGen.Gaus(0., 0.05));
+        }
+        
+        softJetPt = rGen.Exp(20.);
+        softJetEta = rGen.Gaus(0., 2.);
+        softJetPhi = phi();
+        softJetMass = softJetPt * rGen.Uniform(0.1, 0.5);
+        softJetHt = softJetPt + rGen.Exp(20.);
+        
+        softJetPtJERUp = softJetPt * 1.02;
+        softJetEtaJERUp = softJetEta;
+        softJetPhiJERUp = softJetPhi;
+        softJetMassJERUp = softJetMass * 1.02;
+        softJetHtJERUp = softJetHt * 1.02;
+        
+        softJetPtJERDown = softJetPt * 0.98;
+        softJetEtaJERDown = softJetEta;
+        softJetPhiJERDown = softJetPhi;
+        softJetMassJERDown = softJetMass * 0.98;
+        softJetHtJERDown = softJetHt * 0.98;
+        
+        
+        // Several versions of MET are stored, as in real files
+        metSize = 8;
+        metPt[0] = rGen.Exp(40.);
+        metPhi[0] = phi();
+        
+        for (unsigned i = 1; i < metSize; ++i)
+        {
+            metPt[i] = metPt[0] * rGen.Gaus(1., 0.05);
+            metPhi[i] = metPhi[0] + rGen.Gaus(0., 0.02);
+        }
+        
+        
+        // Pile-up
+        puTrueNumInteractions = std::max(0., rGen.Gaus(20., 5.));
+        pvSize = std::min(maxSize, unsigned(rGen.Poisson(0.7 * puTrueNumInteractions)) + 1);
+        rho = 0.5 * puTrueNumInteractions + rGen.Exp(2.);
+        
+        
+        // Hard interaction: a semileptonic ttbar pair. The indices of the particles are fixed
+        processID = 0;
+        hardPartSize = 10;
+        Char_t const pdgIds[] = {21, 21, 6, -6, 24, 5, -24, -5, -13, 14};
+        Char_t const mothers[] = {-1, -1, 0, 0, 2, 2, 3, 3, 4, 4};
+        Char_t const lastMothers[] = {-1, -1, 1, 1, 2, 2, 3, 3, 4, 4};
+        Float_t const masses[] = {0., 0., 172.5, 172.5, 80.4, 4.8, 80.4, 4.8, 0.105, 0.};
+        
+        for (unsigned i = 0; i < hardPartSize; ++i)
+        {
+            hardPartPdgId[i] = pdgIds[i];
+            hardPartFirstMother[i] = mothers[i];
+            hardPartLastMother[i] = lastMothers[i];
+            hardPartPt[i] = (i < 2) ? 0. : 20. + rGen.Exp(60.);
+            hardPartEta[i] = (i < 2) ? 0. : rGen.Gaus(0., 1.5);
+            hardPartPhi[i] = phi();
+            hardPartMass[i] = masses[i];
+        }
+        
+        
+        // Generator jets roughly follow the reconstructed ones
+        genJetSize = jetSize;
+        
+        for (unsigned i = 0; i < genJetSize; ++i)
+        {
+            genJetPt[i] = jetPt[i] * rGen.Gaus(1., 0.1);
+            genJetEta[i] = jetEta[i] + rGen.Gaus(0., 0.05);
+            genJetPhi[i] = jetPhi[i] + rGen.Gaus(0., 0.05);
+            genJetMass[i] = jetMass[i];
+        }
+        
+        
+        // Heavy-flavour partons from the parton shower
+        psSize = multiplicity(3., 16);
+        
+        for (unsigned i = 0; i < psSize; ++i)
+        {
+            psPdgId[i] = ((rGen.Uniform() < 0.6) ? 5 : 4) * ((rGen.Uniform() < 0.5) ? -1 : 1);
+            psOrigin[i] = UChar_t(rGen.Uniform(0., 4.));
+            psPt[i] = rGen.Exp(30.);
+            psEta[i] = rGen.Gaus(0., 2.);
+            psPhi[i] = phi();
+        }
+        
+        
+        // Fill all the trees
+        for (TTree *t: {eventIDTree, basicInfoTree, puInfoTree, generatorInfoTree, triggerTree,
+         genJetsTree, psTree})
+            t->Fill();
+    }
+    
+    
+    // Write the trees, which are owned by the file, and close it
+    file.Write();
+    file.Close();
+}
+
+
+/**
+ * \brief Writes a file with the target pile-up distribution as expected by class WeightPileUp
+ * 
+ * The distribution is a Gaussian with a mean of 21 and a width of 5.5 interactions, which is
+ * close to the distribution in simulation but not identical to it.
+ */
+inline void WriteSyntheticPileUpFile(std::string const &fileName)
+{
+    TFile file(fileName.c_str(), "recreate");
+    
+    if (file.IsZombie())
+        throw std::runtime_error(std::string("WriteSyntheticPileUpFile: Failed to create file \"") +
+         fileName + "\".");
+    
+    TH1D hist("pileup", "", 600, 0., 60.);
+    
+    for (int bin = 1; bin <= hist.GetNbinsX(); ++bin)
+    {
+        double const x = 0.1 * (bin - 0.5);
+        hist.SetBinContent(bin, std::exp(-0.5 * std::pow((x - 21.) / 5.5, 2)));
+    }
+    
+    hist.Write();
+    file.Close();
+}
+
+
+/**
+ * \brief Writes a file with b-tagging efficiencies as expected by class BTagEfficiencies
+ * 
+ * Histograms for all jet flavours and working points are written into the root directory of the
+ * file, with names starting with the given process label. The efficiencies depend on jet pt and
+ * pseudorapidity smoothly.
+ */
+inline void WriteSyntheticBTagEffFile(std::string const &fileName, std::string const &label)
+{
+    TFile file(fileName.c_str(), "recreate");
+    
+    if (file.IsZombie())
+        throw std::runtime_error(std::string("WriteSyntheticBTagEffFile: Failed to create "
+         "file \"") + fileName + "\".");
+    
+    std::vector<double> const ptBinning = {20., 30., 40., 50., 60., 70., 80., 100., 120., 160.,
+     210., 260., 320., 400., 500., 670., 1000.};
+    std::vector<double> etaBinning;
+    
+    for (int i = 0; i <= 20; ++i)
+        etaBinning.push_back(-2.5 + 0.25 * i);
+    
+    
+    // Efficiencies on the plateau for the tight, medium, and loose working points
+    std::vector<std::pair<std::string, std::vector<double>>> const flavours = {
+     {"b", {0.55, 0.70, 0.85}}, {"c", {0.05, 0.20, 0.40}}, {"uds", {0.002, 0.015, 0.12}},
+     {"g", {0.003, 0.02, 0.15}}};
+    std::vector<std::string> const wpCodes = {"T", "M", "L"};
+    
+    for (auto const &fl: flavours)
+        for (unsigned iWP = 0; iWP < wpCodes.size(); ++iWP)
+        {
+            TH2D hist((label + "_" + fl.first + "_" + wpCodes[iWP]).c_str(), "",
+             ptBinning.size() - 1, ptBinning.data(), etaBinning.size() - 1, etaBinning.data());
+            
+            for (unsigned iPt = 1; iPt < ptBinning.size(); ++iPt)
+                for (unsigned iEta = 1; iEta < etaBinning.size(); ++iEta)
+                {
+                    double const pt = 0.5 * (ptBinning[iPt - 1] + ptBinning[iPt]);
+                    double const eta = 0.5 * (etaBinning[iEta - 1] + etaBinning[iEta]);
+                    double const eff = fl.second[iWP] * (1. - 0.3 * std::exp(-pt / 50.)) *
+                     (1. - 0.1 * std::fabs(eta));
+                    
+                    hist.SetBinContent(iPt, iEta, eff);
+                }
+            
+            hist.Write();
+        }
+    
+    file.Close();
+}
+
+
+/// Checks if a file exists
+inline bool FileExists(std::string const &path)
+{
+    struct stat fileStat;
+    return (stat(path.c_str(), &fileStat) == 0);
+}
+
+
+/**
+ * \brief Creates the working directory and normalises its path
+ * 
+ * A trailing slash is appended to the path. If absolute is true, a relative path is converted
+ * into an absolute one, which is needed for the payload files since FileInPath only accepts
+ * absolute paths or paths relative to the installation directory.
+ */
+inline void PrepareWorkDirectory(std::string &workDir, bool absolute = true)
+{
+    if (workDir.back() != '/')
+        workDir += '/';
+    
+    mkdir(workDir.c_str(), 0755);
+    
+    if (absolute and workDir.front() != '/')
+    {
+        char *cwd = getcwd(nullptr, 0);
+        workDir = std::string(cwd) + "/" + workDir;
+        free(cwd);
+    }
+}
+
+
+/// Returns the name of the i-th synthetic file with the given number of events
+inline std::string SyntheticFileName(std::string const &workDir, unsigned long eventsPerFile,
+ unsigned i)
+{
+    std::ostringstream ost;
+    ost << workDir << "synthetic_" << eventsPerFile << "_" << i << ".root";
+    return ost.str();
+}
+
+
+/**
+ * \brief Returns names of synthetic PEC files in the working directory, generating missing ones
+ * 
+ * The number of events is encoded in the file names so that files of a different size are not
+ * reused accidentally. Event numbers in file i start from i * eventsPerFile + 1, and the file is
+ * generated with seed i + 1. If generate is false, only the names are returned; this is useful
+ * for processes that rely on another process to create the files.
+ */
+inline std::vector<std::string> EnsureSyntheticFiles(std::string const &workDir, unsigned nFiles,
+ unsigned long eventsPerFile, bool generate = true)
+{
+    std::vector<std::string> fileNames;
+    
+    for (unsigned i = 0; i < nFiles; ++i)
+    {
+        fileNames.emplace_back(SyntheticFileName(workDir, eventsPerFile, i));
+        
+        if (generate and not FileExists(fileNames.back()))
+        {
+            std::cout << "Generating file \"" << fileNames.back() << "\"..." << std::endl;
+            WriteSyntheticPECFile(fileNames.back(), eventsPerFile, i + 1, i * eventsPerFile + 1);
+        }
+    }
+    
+    return fileNames;
+}
+
+
+/**
+ * \brief Creates a list with a single semileptonic ttbar dataset that includes the given files
+ * 
+ * The number of events of the dataset is set to the total number of events in the files.
+ */
+inline std::list<Dataset> MakeSyntheticDatasets(std::vector<std::string> const &fileNames,
+ unsigned long eventsPerFile)
+{
+    std::list<Dataset> datasets;
+    datasets.emplace_back(std::list<Dataset::Process>{Dataset::Process::ttbar,
+     Dataset::Process::ttSemilep}, Dataset::Generator::MadGraph,
+     Dataset::ShowerGenerator::Pythia);
+    
+    for (auto const &name: fileNames)
+        datasets.back().AddFile(name, 234., fileNames.size() * eventsPerFile);
+    
+    return datasets;
+}
+
+
+/**
+ * \struct SyntheticAnalysis
+ * \brief A typical set of modules for PECReader to process synthetic files
+ * 
+ * Includes a muon trigger, an event selection with b-tagging, and b-tagging and pile-up
+ * reweighting. The payload files are created in the given working directory unless they exist.
+ * The object must outlive all run managers and readers that use it; since modules refer to each
+ * other, it cannot be copied.
+ */
+struct SyntheticAnalysis
+{
+    /// Constructor
+    SyntheticAnalysis(std::string const &workDir):
+        bTagger(new BTagger(BTagger::Algorithm::CSV, BTagger::WorkingPoint::Medium)),
+        selection(30., bTagger),
+        triggerRanges{TriggerRange(0, -1, "IsoMu24_eta2p1", 19.7e3, "IsoMu24_eta2p1")},
+        triggerSelection(triggerRanges),
+        bTagEff(PayloadFile(workDir + "btagEff.root", true)),
+        bTagSF(bTagger->GetAlgorithm()),
+        bTagReweighter(bTagger, bTagEff, bTagSF),
+        puReweighter(PayloadFile(workDir + "pileup.root", false), 0.06)
+    {
+        selection.AddLeptonThreshold(Lepton::Flavour::Muon, 26.);
+        selection.AddJetTagBin(2, 1);
+        selection.AddJetTagBin(3, 1);
+        selection.AddJetTagBin(4, 2);
+        
+        bTagEff.SetDefaultProcessLabel("ttbar");
+    }
+    
+    SyntheticAnalysis(SyntheticAnalysis const &) = delete;
+    SyntheticAnalysis &operator=(SyntheticAnalysis const &) = delete;
+    
+    /**
+     * \brief Sets the modules in the given configuration of PECReader
+     * 
+     * The trigger and event selection are always set; the reweighting modules only if requested.
+     */
+    void Configure(PECReaderConfig &config, bool reweighting = true)
+    {
+        config.SetModule(&triggerSelection);
+        config.SetModule(&selection);
+        config.SetModule(bTagger);
+        
+        if (reweighting)
+        {
+            config.SetModule(&bTagReweighter);
+            config.SetModule(&puReweighter);
+        }
+    }
+    
+    /// Writes the b-tagging efficiencies or the pile-up profile unless the file exists
+    static std::string PayloadFile(std::string const &fileName, bool bTagging)
+    {
+        if (not FileExists(fileName))
+        {
+            if (bTagging)
+                WriteSyntheticBTagEffFile(fileName, "ttbar");
+            else
+                WriteSyntheticPileUpFile(fileName);
+        }
+        
+        return fileName;
+    }
+    
+    std::shared_ptr<BTagger const> bTagger;
+    GenericEventSelection selection;
+    std::list<TriggerRange> triggerRanges;
+    TriggerSelection triggerSelection;
+    BTagEfficiencies bTagEff;
+    BTagScaleFactors bTagSF;
+    WeightBTag bTagReweighter;
+    WeightPileUp puReweighter;
+};
@@ -0,0 +1,129 @@
+/**
+ * The program counts heap allocations performed by PECReader per event. After a few events
+ * needed to warm up the buffers and the arena for per-event objects, no allocations are expected.
+ * The input is a synthetic PEC file, which is generated in the working directory unless it exists.
+ * 
+ * Usage: allocations [nEvents] [workDirectory]
+ */
+
+#include <SyntheticPEC.hpp>
+
+#include <GenericEventSelection.hpp>
+#include <Dataset.hpp>
+#include <PECReader.hpp>
+#include <BTagger.hpp>
+#include <TriggerSelection.hpp>
+
+#include <iostream>
+#include <memory>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+
+using namespace std;
+
+
+// A global counter of heap allocations
+atomic<unsigned long> nAllocations(0);
+
+
+void *operator new(size_t size)
+{
+    ++nAllocations;
+    
+    if (void *p = malloc(size))
+        return p;
+    
+    throw bad_alloc();
+}
+
+
+void operator delete(void *p) noexcept
+{
+    free(p);
+}
+
+
+int main(int argc, char **argv)
+{
+    // Parse the arguments
+    unsigned const nEvents = (argc > 1) ? atoi(argv[1]) : 10000;
+    string workDir((argc > 2) ? argv[2] : "allocations-data");
+    unsigned const nWarmUpEvents = 100;
+    
+    if (nEvents <= nWarmUpEvents)
+    {
+        cerr << "Usage: " << argv[0] << " [nEvents] [workDirectory]\n";
+        cerr << "The number of events must exceed " << nWarmUpEvents << ".\n";
+        return 1;
+    }
+    
+    PrepareWorkDirectory(workDir, false);
+    
+    
+    // Define the b-tagging objects
+    shared_ptr<BTagger const> bTagger(
+     new BTagger(BTagger::Algorithm::CSV, BTagger::WorkingPoint::Tight));
+    
+    
+    // Define the event selection
+    GenericEventSelection sel(30., bTagger);
+    sel.AddLeptonThreshold(Lepton::Flavour::Muon, 26.);
+    sel.AddJetTagBin(2, 0);
+    sel.AddJetTagBin(3, 0);
+    sel.AddJetTagBin(3, 1);
+    
+    
+    // Define a dataset with a single synthetic file. It is generated before the counting starts
+    list<Dataset> const datasets(
+     MakeSyntheticDatasets(EnsureSyntheticFiles(workDir, 1, nEvents), nEvents));
+    Dataset const &dataset = datasets.front();
+    
+    
+    // Define the triggers
+    list<TriggerRange> triggerRanges;
+    triggerRanges.emplace_back(0, -1, "IsoMu24_eta2p1", 19.7e3, "IsoMu24_eta2p1");
+    
+    TriggerSelection triggerSel(triggerRanges);
+    
+    
+    // Build an instance of PECReader that reads all the generator-level information
+    PECReader reader(dataset);
+    reader.SetTriggerSelection(&triggerSel);
+    reader.SetEventSelection(&sel);
+    reader.SetReadHardInteraction();
+    reader.SetReadGenJets();
+    reader.SetReadPartonShower();
+    reader.NextSourceFile();
+    
+    
+    // Loop over events and count allocations in each of them
+    unsigned long nAllocationsAfterWarmUp = 0;
+    unsigned nEventsWithAllocations = 0;
+    
+    for (unsigned i = 0; i < nEvents; ++i)
+    {
+        unsigned long const nAllocationsBefore = nAllocations;
+        
+        if (not reader.NextEvent())
+            break;
+        
+        unsigned long const nAllocationsEvent = nAllocations - nAllocationsBefore;
+        
+        if (i >= nWarmUpEvents)
+        {
+            nAllocationsAfterWarmUp += nAllocationsEvent;
+            
+            if (nAllocationsEvent > 0)
+                ++nEventsWithAllocations;
+        }
+    }
+    
+    
+    cout << "Heap allocations after warm-up: " << nAllocationsAfterWarmUp << " in " <<
+     nEventsWithAllocations << " events\n";
+    
+    
+    return (nAllocationsAfterWarmUp == 0) ? 0 : 1;
+}
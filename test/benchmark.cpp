@@ -0,0 +1,158 @@
+/**
+ * The program measures the throughput of the event loop on synthetic PEC files. The files, as well
+ * as the payload files for reweighting, are generated locally on the first run and reused
+ * afterwards. Several configurations of increasing complexity are processed with different
+ * numbers of threads:
+ *   - PECReader alone, without any selection;
+ *   - PECReader with a trigger selection and GenericEventSelection;
+ *   - the same with b-tagging and pile-up reweighting;
+ *   - the same with a path of plugins that filter events and write output trees.
+ * For each configuration and number of threads, the wall time and the number of read events per
+ * second are reported.
+ * 
+ * Usage: benchmark [maxThreads] [nFiles] [eventsPerFile] [workDirectory]
+ * By default, the number of threads is scanned in powers of two up to the number of hardware
+ * threads, and the number of files is twice the maximal number of threads (the files are the
+ * units of work distributed among threads).
+ */
+
+#include <SyntheticPEC.hpp>
+
+#include <RunManager.hpp>
+#include <MetFilterPlugin.hpp>
+#include <JetPtFilterPlugin.hpp>
+#include <BasicKinematicsPlugin.hpp>
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <list>
+#include <memory>
+#include <chrono>
+#include <thread>
+#include <cstdlib>
+
+
+using namespace std;
+
+
+/// Configurations of the event loop to be benchmarked
+enum class Config
+{
+    Reader,
+    Selection,
+    Weights,
+    FullPath
+};
+
+
+/// Returns a short description of the configuration
+string ConfigName(Config config)
+{
+    switch (config)
+    {
+        case Config::Reader:
+            return "PECReader";
+        
+        case Config::Selection:
+            return "+selection";
+        
+        case Config::Weights:
+            return "+weights";
+        
+        case Config::FullPath:
+            return "+plugins";
+    }
+    
+    return "";
+}
+
+
+int main(int argc, char **argv)
+{
+    // Parse the arguments
+    unsigned const nHardwareThreads = max(thread::hardware_concurrency(), 1u);
+    unsigned const maxThreads = (argc > 1) ? atoi(argv[1]) : nHardwareThreads;
+    unsigned const nFiles = (argc > 2) ? atoi(argv[2]) : 2 * maxThreads;
+    unsigned long const eventsPerFile = (argc > 3) ? atol(argv[3]) : 20000;
+    string workDir((argc > 4) ? argv[4] : "benchmark-data");
+    
+    if (maxThreads == 0 or nFiles == 0 or eventsPerFile == 0)
+    {
+        cerr << "Usage: " << argv[0] << " [maxThreads] [nFiles] [eventsPerFile] [workDirectory]\n";
+        return 1;
+    }
+    
+    PrepareWorkDirectory(workDir);
+    vector<string> const fileNames(EnsureSyntheticFiles(workDir, nFiles, eventsPerFile));
+    
+    
+    // Numbers of threads to try
+    vector<unsigned> nThreadsList;
+    
+    for (unsigned n = 1; n < maxThreads; n *= 2)
+        nThreadsList.push_back(n);
+    
+    nThreadsList.push_back(maxThreads);
+    
+    
+    // Loop over the configurations
+    unsigned long const nEventsTotal = nFiles * eventsPerFile;
+    
+    cout << "\n" << nFiles << " files, " << nEventsTotal << " events in total\n\n";
+    cout << setw(12) << "config" << setw(10) << "threads" << setw(12) << "time, s" <<
+     setw(14) << "events/s" << setw(12) << "speed-up" << endl;
+    
+    for (Config config: {Config::Reader, Config::Selection, Config::Weights, Config::FullPath})
+    {
+        double singleThreadRate = 0.;
+        
+        for (unsigned nThreads: nThreadsList)
+        {
+            // Define the dataset and the modules. The modules must outlive the run manager
+            list<Dataset> datasets(MakeSyntheticDatasets(fileNames, eventsPerFile));
+            SyntheticAnalysis analysis(workDir);
+            
+            
+            // Set up the run manager
+            RunManager manager(datasets.begin(), datasets.end());
+            
+            if (config != Config::Reader)
+                analysis.Configure(manager.GetPECReaderConfig(),
+                 config == Config::Weights or config == Config::FullPath);
+            
+            if (config == Config::FullPath)
+            {
+                manager.RegisterPlugin(new MetFilterPlugin(20.));
+                manager.RegisterPlugin(new JetPtFilterPlugin(2, 40.));
+                manager.RegisterPlugin(new BasicKinematicsPlugin(workDir + "output"));
+            }
+            
+            
+            // Process the dataset and measure the wall time
+            auto const start = chrono::steady_clock::now();
+            manager.Process(int(nThreads));
+            auto const end = chrono::steady_clock::now();
+            
+            double const time = chrono::duration<double>(end - start).count();
+            double const rate = nEventsTotal / time;
+            
+            if (nThreads == 1)
+                singleThreadRate = rate;
+            
+            
+            // Report the results
+            cout << setw(12) << ConfigName(config) << setw(10) << nThreads << setw(12) <<
+             fixed << setprecision(2) << time << setw(14) << setprecision(0) << rate;
+            
+            if (singleThreadRate > 0.)
+                cout << setw(12) << setprecision(2) << rate / singleThreadRate;
+            
+            cout << endl;
+        }
+    }
+    
+    
+    return 0;
+}
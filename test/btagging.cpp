@@ -0,0 +1,200 @@
+/**
+ * The program checks that the batched evaluation of b-tagging decisions with
+ * BTagger::ComputeTagBits agrees with the evaluation for individual jets with BTagger::IsTagged and
+ * BTagger::ComputeTagBits(Jet const &). Jets are generated for all the supported algorithms with
+ * discriminators drawn from a broad distribution and, in addition, set exactly to the thresholds
+ * and to their float neighbours, where a mismatch between single and double precision would show
+ * up. Pseudorapidities cover the whole acceptance, but values within 0.01 of its boundary are
+ * avoided since the pseudorapidity recomputed from the four-momentum of a jet might differ from
+ * the stored one in the last bits. Finally, it is checked that the decisions cached in a jet are
+ * invalidated when its four-momentum is changed.
+ * 
+ * Usage: btagging [nJets] [seed]
+ * The program returns a non-zero code if any decision differs.
+ */
+
+#include <BTagger.hpp>
+#include <BTagSFInterface.hpp>
+#include <PhysicsObjects.hpp>
+
+#include <TRandom3.h>
+#include <TLorentzVector.h>
+
+#include <iostream>
+#include <vector>
+#include <limits>
+#include <stdexcept>
+#include <cstdlib>
+#include <cmath>
+
+
+using namespace std;
+
+
+/// Sets the discriminator of the given algorithm in the jet
+void SetDiscriminator(Jet &jet, BTagger::Algorithm algo, float value)
+{
+    switch (algo)
+    {
+        case BTagger::Algorithm::CSV:
+            jet.SetBTags(value, 0., 0.);
+            break;
+        
+        case BTagger::Algorithm::JP:
+            jet.SetBTags(0., value, 0.);
+            break;
+        
+        default:
+            jet.SetBTags(0., 0., value);
+            break;
+    }
+}
+
+
+/**
+ * \brief Compares the batched and individual decisions for the given b-tagger
+ * 
+ * Returns the number of jets with inconsistent decisions.
+ */
+unsigned long CheckAlgorithm(BTagger const &bTagger, unsigned nRandomJets, TRandom3 &rGen)
+{
+    double const maxAbsEta = BTagSFInterface::GetMaxPseudorapidity();
+    vector<BTagger::WorkingPoint> const allWPs{BTagger::WorkingPoint::Tight,
+     BTagger::WorkingPoint::Medium, BTagger::WorkingPoint::Loose};
+    
+    
+    // Discriminators exactly at the thresholds and at the neighbouring float values
+    vector<float> discriminatorValues;
+    
+    for (auto const &wp: allWPs)
+    {
+        double threshold;
+        
+        try
+        {
+            threshold = bTagger.GetThreshold(wp);
+        }
+        catch (runtime_error const &)
+        {
+            continue;
+        }
+        
+        float const f = threshold;
+        float const inf = numeric_limits<float>::infinity();
+        
+        for (float const d: {f, nextafter(f, inf), nextafter(f, -inf),
+         nextafter(nextafter(f, inf), inf), nextafter(nextafter(f, -inf), -inf)})
+            discriminatorValues.push_back(d);
+    }
+    
+    for (unsigned i = 0; i < nRandomJets; ++i)
+        discriminatorValues.push_back(rGen.Uniform(-1., 5.));
+    
+    
+    // Build the jets and the columns
+    vector<Jet> jets;
+    vector<float> discriminators, etas;
+    
+    for (float const d: discriminatorValues)
+    {
+        double eta;
+        
+        do
+            eta = rGen.Uniform(-3., 3.);
+        while (fabs(fabs(eta) - maxAbsEta) < 0.01);
+        
+        TLorentzVector p4;
+        p4.SetPtEtaPhiM(rGen.Uniform(20., 200.), float(eta), rGen.Uniform(-3., 3.), 5.);
+        
+        jets.emplace_back(p4);
+        SetDiscriminator(jets.back(), bTagger.GetAlgorithm(), d);
+        
+        discriminators.push_back(bTagger.GetDiscriminator(jets.back()));
+        etas.push_back(jets.back().Eta());
+    }
+    
+    
+    // Evaluate the decisions in the batched mode and compare them with individual jets
+    vector<unsigned char> bits(jets.size());
+    bTagger.ComputeTagBits(jets.size(), discriminators.data(), etas.data(), bits.data());
+    
+    unsigned long nErrors = 0;
+    
+    for (unsigned i = 0; i < jets.size(); ++i)
+    {
+        unsigned expected = 0;
+        
+        for (auto const &wp: allWPs)
+        {
+            try
+            {
+                expected |= unsigned(bTagger.IsTagged(wp, jets[i])) << int(wp);
+            }
+            catch (runtime_error const &)
+            {}
+        }
+        
+        if (bits[i] != expected or bTagger.ComputeTagBits(jets[i]) != expected)
+        {
+            cout << "Decisions differ for discriminator " << discriminators[i] << " and " <<
+             "pseudorapidity " << etas[i] << " with b-tagger " << bTagger.GetTextCode() <<
+             ": batched " << unsigned(bits[i]) << ", expected " << expected << "." << endl;
+            ++nErrors;
+        }
+    }
+    
+    return nErrors;
+}
+
+
+/**
+ * \brief Checks that a change of the four-momentum invalidates the cached decisions
+ * 
+ * A jet tagged inside the acceptance is moved outside of it, after which it must not be tagged.
+ * Returns the number of errors.
+ */
+unsigned long CheckInvalidation(BTagger const &bTagger)
+{
+    double const maxAbsEta = BTagSFInterface::GetMaxPseudorapidity();
+    TLorentzVector p4;
+    p4.SetPtEtaPhiM(50., 0., 0., 5.);
+    
+    vector<Jet> jets{Jet(p4)};
+    SetDiscriminator(jets.front(), bTagger.GetAlgorithm(), 100.);
+    bTagger.TagJets(jets);
+    
+    bool const taggedBefore = bTagger.IsTagged(jets.front());
+    jets.front().SetPtEtaPhiM(50., maxAbsEta + 0.5, 0., 5.);
+    
+    if (not taggedBefore or bTagger.IsTagged(jets.front()))
+    {
+        cout << "Cached decisions are not updated after the jet has been moved outside of the " <<
+         "acceptance with b-tagger " << bTagger.GetTextCode() << "." << endl;
+        return 1;
+    }
+    
+    return 0;
+}
+
+
+int main(int argc, char **argv)
+{
+    // Parse the arguments
+    unsigned const nJets = (argc > 1) ? atoi(argv[1]) : 100000;
+    unsigned const seed = (argc > 2) ? atoi(argv[2]) : 1;
+    
+    TRandom3 rGen(seed);
+    unsigned long nErrors = 0;
+    
+    for (auto const &algo: {BTagger::Algorithm::CSV, BTagger::Algorithm::JP,
+     BTagger::Algorithm::TCHP})
+    {
+        nErrors += CheckAlgorithm(BTagger(algo), nJets, rGen);
+        nErrors += CheckInvalidation(BTagger(algo));
+    }
+    
+    
+    cout << ((nErrors == 0) ? "B-tagging test passed." : "B-tagging test FAILED.") << endl;
+    
+    return (nErrors == 0) ? 0 : 2;
+}
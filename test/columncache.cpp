@@ -0,0 +1,247 @@
+/**
+ * The program checks reading and validation of column cache files. A cache with a scalar column
+ * and a column of variable length is written with ColumnCacheWriter and read back with
+ * ColumnCache, and all the values are compared. Then copies of the file are corrupted in several
+ * ways (truncated file, block position outside of the file, inconsistent offsets, a value larger
+ * than the buffer of the user), and it is checked that ColumnCache refuses to open them.
+ * 
+ * Usage: columncache [nEntries] [workDirectory]
+ * The program returns a non-zero code if any inconsistency is found.
+ */
+
+#include <ColumnCache.hpp>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <utility>
+#include <cstring>
+#include <cstdlib>
+#include <cstdint>
+#include <cstddef>
+
+
+using namespace std;
+
+
+/// Maximal number of elements in the column of variable length
+unsigned const maxElements = 8;
+
+
+/// Returns the number of elements of the column of variable length in the given entry
+unsigned NumElements(unsigned long entry)
+{
+    return (entry * 7 + 3) % (maxElements + 1);
+}
+
+
+/// Returns the value of the given element in the given entry
+float ElementValue(unsigned long entry, unsigned i)
+{
+    return entry + 0.125f * i;
+}
+
+
+/// Reads the whole file into a string
+string ReadFile(string const &fileName)
+{
+    ifstream file(fileName, ios::binary);
+    return string(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+}
+
+
+/// Writes the given content into a file
+void WriteFile(string const &fileName, string const &content)
+{
+    ofstream file(fileName, ios::binary | ios::trunc);
+    file.write(content.data(), content.size());
+}
+
+
+/// Writes a value of the given type at the given position of a string
+template<typename T>
+void Patch(string &content, uint64_t pos, T value)
+{
+    memcpy(&content[pos], &value, sizeof(value));
+}
+
+
+/// Reads a value of the given type at the given position of a string
+template<typename T>
+T Peek(string const &content, uint64_t pos)
+{
+    T value;
+    memcpy(&value, &content[pos], sizeof(value));
+    return value;
+}
+
+
+/**
+ * \brief Reads all the entries from the cache and compares them with the expectation
+ * 
+ * Returns the number of wrong entries.
+ */
+unsigned long CheckContent(ColumnCache const &cache, unsigned long nEntries)
+{
+    unsigned long nErrors = 0;
+    
+    for (unsigned long entry = 0; entry < nEntries; ++entry)
+    {
+        unsigned nBytesScalar, nBytesArray;
+        auto const scalar = static_cast<uint64_t const *>(cache.GetData(0, entry, nBytesScalar));
+        auto const array = static_cast<float const *>(cache.GetData(1, entry, nBytesArray));
+        
+        bool ok = (nBytesScalar == sizeof(uint64_t) and *scalar == entry * entry and
+         nBytesArray == NumElements(entry) * sizeof(float));
+        
+        for (unsigned i = 0; ok and i < NumElements(entry); ++i)
+            ok = (array[i] == ElementValue(entry, i));
+        
+        if (not ok)
+            ++nErrors;
+    }
+    
+    return nErrors;
+}
+
+
+int main(int argc, char **argv)
+{
+    // Parse the arguments
+    unsigned long const nEntries = (argc > 1) ? atol(argv[1]) : 10000;
+    string workDir((argc > 2) ? argv[2] : "columncache-data");
+    unsigned const blockSize = 1000;
+    
+    if (nEntries < 2 * blockSize)
+    {
+        cerr << "Usage: " << argv[0] << " [nEntries] [workDirectory]\n";
+        cerr << "The number of entries must be at least " << 2 * blockSize << ".\n";
+        return 1;
+    }
+    
+    if (workDir.back() != '/')
+        workDir += '/';
+    
+    mkdir(workDir.c_str(), 0755);
+    
+    
+    // Write the cache
+    string const fileName(workDir + "test.colcache");
+    ColumnCacheKey const key{12345, 67890, 0xABCDEF, nEntries, 2};
+    vector<unsigned> const maxSizes{sizeof(uint64_t), maxElements * sizeof(float)};
+    
+    {
+        ColumnCacheWriter writer(fileName, key, blockSize);
+        vector<float> values(maxElements);
+        
+        for (unsigned long entry = 0; entry < nEntries; ++entry)
+        {
+            uint64_t const scalar = entry * entry;
+            writer.Append(0, &scalar, sizeof(scalar));
+            
+            for (unsigned i = 0; i < NumElements(entry); ++i)
+                values[i] = ElementValue(entry, i);
+            
+            writer.Append(1, values.data(), NumElements(entry) * sizeof(float));
+            writer.EndEntry();
+        }
+        
+        if (not writer.Finish())
+        {
+            cout << "Failed to write the cache." << endl;
+            return 2;
+        }
+    }
+    
+    
+    // Read the cache back
+    unsigned nErrors = 0;
+    ColumnCache cache;
+    
+    if (not cache.Open(fileName, key, maxSizes))
+    {
+        cout << "Failed to open a valid cache." << endl;
+        return 2;
+    }
+    
+    unsigned long const nWrongEntries = CheckContent(cache, nEntries);
+    cache.Close();
+    
+    if (nWrongEntries > 0)
+    {
+        cout << nWrongEntries << " entries are read wrongly." << endl;
+        ++nErrors;
+    }
+    
+    
+    // A cache with a different key or with smaller buffers must be rejected
+    ColumnCacheKey otherKey(key);
+    otherKey.sourceMTime += 1;
+    
+    if (cache.Open(fileName, otherKey, maxSizes))
+    {
+        cout << "A cache for a different source file is accepted." << endl;
+        ++nErrors;
+    }
+    
+    if (cache.Open(fileName, key, {sizeof(uint64_t), (maxElements - 1) * unsigned(sizeof(float))}))
+    {
+        cout << "A cache with values larger than the buffers is accepted." << endl;
+        ++nErrors;
+    }
+    
+    
+    // Corrupt copies of the file in several ways. Positions of the structures are read from the
+    //header and the first blocks
+    string const original(ReadFile(fileName));
+    uint64_t const blockIndexPos =
+     Peek<uint64_t>(original, offsetof(ColumnCache::Header, blockIndexPos));
+    uint64_t const secondBlockPos = Peek<uint64_t>(original, blockIndexPos + 8);
+    uint64_t const arrayColumnPos = secondBlockPos + Peek<uint64_t>(original, secondBlockPos + 8);
+    
+    vector<pair<string, string>> corrupted;
+    
+    corrupted.emplace_back("truncated file", original.substr(0, original.size() * 2 / 3));
+    
+    corrupted.emplace_back("block outside of the file", original);
+    Patch<uint64_t>(corrupted.back().second, blockIndexPos + 8, original.size() + 8);
+    
+    corrupted.emplace_back("block index outside of the file", original);
+    Patch<uint64_t>(corrupted.back().second, offsetof(ColumnCache::Header, blockIndexPos),
+     uint64_t(-8));
+    
+    corrupted.emplace_back("column outside of the file", original);
+    Patch<uint64_t>(corrupted.back().second, secondBlockPos + 8, uint64_t(1) << 62);
+    
+    corrupted.emplace_back("decreasing offsets", original);
+    Patch<uint32_t>(corrupted.back().second, arrayColumnPos + 4 * 10, uint32_t(-1));
+    
+    corrupted.emplace_back("value larger than the buffer", original);
+    Patch<uint32_t>(corrupted.back().second, arrayColumnPos + 4 * blockSize,
+     Peek<uint32_t>(original, arrayColumnPos + 4 * (blockSize - 1)) +
+     (maxElements + 1) * sizeof(float));
+    
+    for (auto const &c: corrupted)
+    {
+        string const corruptedFileName(workDir + "corrupted.colcache");
+        WriteFile(corruptedFileName, c.second);
+        
+        if (cache.Open(corruptedFileName, key, maxSizes))
+        {
+            cout << "A cache with " << c.first << " is accepted." << endl;
+            ++nErrors;
+            cache.Close();
+        }
+        
+        unlink(corruptedFileName.c_str());
+    }
+    
+    
+    cout << ((nErrors == 0) ? "Column cache test passed." : "Column cache test FAILED.") << endl;
+    
+    return (nErrors == 0) ? 0 : 2;
+}
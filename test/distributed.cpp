@@ -0,0 +1,403 @@
+/**
+ * The program demonstrates the distributed mode of RunManager and validates its results. The
+ * coordinator serves synthetic PEC files to worker processes over a socket. The path contains a
+ * filter that accepts events with even event numbers and a plugin that writes the number and the
+ * sum of event numbers of the accepted events in each file into a small text file, using the
+ * atomic commit of output files. The coordinator prints the merged cut-flow and statistics of the
+ * workers; then the program reads the output files and compares them and the merged cut-flow with
+ * the known content of the input files. The output directory is cleaned before the processing.
+ * 
+ * If at least three local workers are started, failures are injected to test the recovery: the
+ * worker that gets the first file throws an exception in the middle of it, and the worker that
+ * gets the second file is killed at the same point. Both files must be reprocessed by other
+ * workers, and the results of the failed attempts must not be counted.
+ * 
+ * By default the program starts a coordinator with four local workers that communicate via a Unix
+ * domain socket. To involve other nodes, run the coordinator with a TCP address (e.g.
+ * "coordinator *:5555"), possibly with zero local workers, and start the workers elsewhere with
+ * "worker host:5555" and the same other arguments. The working directory must then be shared.
+ * 
+ * Usage: distributed [coordinator|worker] [address|-] [nLocalWorkers] [nFiles] [eventsPerFile]
+ *  [workDirectory]
+ * The program returns a non-zero code if any inconsistency is found.
+ */
+
+#include <SyntheticPEC.hpp>
+
+#include <Dataset.hpp>
+#include <RunManager.hpp>
+#include <Processor.hpp>
+#include <PECReaderPlugin.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <unistd.h>
+#include <signal.h>
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <list>
+#include <stdexcept>
+#include <cstdlib>
+
+
+using namespace std;
+
+
+/**
+ * \class EvenEventFilter
+ * \brief Accepts events with even event numbers
+ */
+class EvenEventFilter: public Plugin
+{
+public:
+    /// Constructor
+    EvenEventFilter();
+
+public:
+    /// Creates a newly-initialised copy
+    Plugin *Clone() const;
+    
+    /// Saves pointer to the reader
+    void BeginRun(Dataset const &);
+    
+    /// Checks the event number
+    bool ProcessEvent();
+
+private:
+    /// Pointer to the reader plugin
+    PECReaderPlugin const *reader;
+};
+
+
+EvenEventFilter::EvenEventFilter():
+    Plugin("EvenEvents")
+{}
+
+
+Plugin *EvenEventFilter::Clone() const
+{
+    return new EvenEventFilter;
+}
+
+
+void EvenEventFilter::BeginRun(Dataset const &)
+{
+    reader = dynamic_cast<PECReaderPlugin const *>(processor->GetPluginBefore("Reader", name));
+}
+
+
+bool EvenEventFilter::ProcessEvent()
+{
+    return ((*reader)->GetEventID().Event() % 2 == 0);
+}
+
+
+/**
+ * \class CountWriter
+ * \brief Writes the number and the sum of event numbers of the seen events for each input file
+ * 
+ * The output file is written under a temporary name and renamed when complete.
+ */
+class CountWriter: public Plugin
+{
+public:
+    /// Constructor
+    CountWriter(string const &outDirectory);
+
+public:
+    /// Creates a newly-initialised copy
+    Plugin *Clone() const;
+    
+    /// Creates the output file and resets the counters
+    void BeginRun(Dataset const &dataset);
+    
+    /// Writes the counters and commits the output file
+    void EndRun();
+    
+    /// Counts the event
+    bool ProcessEvent();
+
+private:
+    /// Pointer to the reader plugin
+    PECReaderPlugin const *reader;
+    
+    /// Directory to store output files
+    string outDirectory;
+    
+    /// Name of the current output file
+    string outFileName;
+    
+    /// Current output file
+    ofstream outFile;
+    
+    /// Number of events and sum of their event numbers in the current input file
+    unsigned long nEvents;
+    unsigned long long sum;
+};
+
+
+CountWriter::CountWriter(string const &outDirectory_):
+    Plugin("CountWriter"),
+    outDirectory(outDirectory_)
+{}
+
+
+Plugin *CountWriter::Clone() const
+{
+    return new CountWriter(outDirectory);
+}
+
+
+void CountWriter::BeginRun(Dataset const &dataset)
+{
+    reader = dynamic_cast<PECReaderPlugin const *>(processor->GetPluginBefore("Reader", name));
+    
+    outFileName = outDirectory + dataset.GetFiles().front().GetBaseName() + ".txt";
+    outFile.open(GetTempFileName(outFileName));
+    
+    nEvents = 0;
+    sum = 0;
+}
+
+
+void CountWriter::EndRun()
+{
+    outFile << nEvents << " " << sum << endl;
+    outFile.close();
+    
+    CommitOutputFile(outFileName);
+}
+
+
+bool CountWriter::ProcessEvent()
+{
+    ++nEvents;
+    sum += (*reader)->GetEventID().Event();
+    
+    return true;
+}
+
+
+/**
+ * \class FaultInjector
+ * \brief Makes the worker process fail while it holds a file
+ * 
+ * A failure is requested by a marker file in the given directory, named after the input file with
+ * a postfix ".throw" or ".kill". The first worker that opens the input file removes the marker and
+ * fails in the middle of the file by throwing an exception or by killing itself, respectively.
+ * Since the marker is removed atomically, only one attempt fails. The plugin accepts all events.
+ */
+class FaultInjector: public Plugin
+{
+public:
+    /// Constructor from the directory with marker files and the index of the event to fail at
+    FaultInjector(string const &markerDirectory, unsigned long failAt);
+
+public:
+    /// Creates a newly-initialised copy
+    Plugin *Clone() const;
+    
+    /// Checks if a failure is requested for the file
+    void BeginRun(Dataset const &dataset);
+    
+    /// Fails if requested
+    bool ProcessEvent();
+
+private:
+    /// Directory with marker files
+    string markerDirectory;
+    
+    /// Requested kind of failure for the current file
+    enum class Failure
+    {
+        None,
+        Throw,
+        Kill
+    } failure;
+    
+    /// Index of the event at which the failure happens
+    unsigned long failAt;
+    
+    /// Number of events seen in the current file
+    unsigned long nEvents;
+};
+
+
+FaultInjector::FaultInjector(string const &markerDirectory_, unsigned long failAt_):
+    Plugin("FaultInjector"),
+    markerDirectory(markerDirectory_),
+    failAt(failAt_)
+{}
+
+
+Plugin *FaultInjector::Clone() const
+{
+    return new FaultInjector(markerDirectory, failAt);
+}
+
+
+void FaultInjector::BeginRun(Dataset const &dataset)
+{
+    string const markerBase(markerDirectory + dataset.GetFiles().front().GetBaseName());
+    
+    if (unlink((markerBase + ".throw").c_str()) == 0)
+        failure = Failure::Throw;
+    else if (unlink((markerBase + ".kill").c_str()) == 0)
+        failure = Failure::Kill;
+    else
+        failure = Failure::None;
+    
+    nEvents = 0;
+}
+
+
+bool FaultInjector::ProcessEvent()
+{
+    if (failure != Failure::None and nEvents++ == failAt)
+    {
+        if (failure == Failure::Throw)
+            throw runtime_error("FaultInjector::ProcessEvent: Injected failure.");
+        
+        cout.flush();
+        raise(SIGKILL);
+    }
+    
+    return true;
+}
+
+
+int main(int argc, char **argv)
+{
+    // Parse the arguments
+    string const mode((argc > 1) ? argv[1] : "coordinator");
+    string const address((argc > 2 and string(argv[2]) != "-") ? argv[2] : "");
+    unsigned const nLocalWorkers = (argc > 3) ? atoi(argv[3]) : 4;
+    unsigned const nFiles = (argc > 4) ? atoi(argv[4]) : 40;
+    unsigned long const eventsPerFile = (argc > 5) ? atol(argv[5]) : 1000;
+    string workDir((argc > 6) ? argv[6] : "distributed-data");
+    
+    if ((mode != "coordinator" and mode != "worker") or (mode == "worker" and address.empty()) or
+     nFiles == 0 or eventsPerFile == 0)
+    {
+        cerr << "Usage: " << argv[0] << " [coordinator|worker] [address|-] [nLocalWorkers] " <<
+         "[nFiles] [eventsPerFile] [workDirectory]\n";
+        return 1;
+    }
+    
+    PrepareWorkDirectory(workDir, false);
+    string const outDir(workDir + "output/");
+    
+    // Outputs of a previous run must not be mistaken for the new ones
+    if (mode == "coordinator")
+        boost::filesystem::remove_all(outDir);
+    
+    mkdir(outDir.c_str(), 0755);
+    
+    
+    // Generate the input files unless they have already been created. Only the coordinator
+    //writes them. Event numbers in file i start from i * eventsPerFile + 1
+    vector<string> const fileNames(EnsureSyntheticFiles(workDir, nFiles, eventsPerFile,
+     mode == "coordinator"));
+    
+    
+    // Define the dataset and the path. Workers must be configured identically to the coordinator
+    list<Dataset> datasets(MakeSyntheticDatasets(fileNames, eventsPerFile));
+    
+    RunManager manager(datasets.begin(), datasets.end());
+    manager.RegisterPlugin(new FaultInjector(workDir, eventsPerFile / 2));
+    manager.RegisterPlugin(new EvenEventFilter);
+    manager.RegisterPlugin(new CountWriter(outDir));
+    
+    
+    // A worker only processes the files it is given
+    if (mode == "worker")
+    {
+        manager.RunWorkerProcess(address);
+        return 0;
+    }
+    
+    // Request failures for the first two files. The markers are named after the input files,
+    //which are located in the same directory. Markers left by an aborted run are removed
+    vector<string> markers;
+    
+    if (nFiles >= 2)
+    {
+        markers.emplace_back(fileNames[0].substr(0, fileNames[0].length() - 5) + ".throw");
+        markers.emplace_back(fileNames[1].substr(0, fileNames[1].length() - 5) + ".kill");
+    }
+    
+    for (auto const &m: markers)
+    {
+        if (nLocalWorkers >= 3)
+            ofstream(m).close();
+        else
+            unlink(m.c_str());
+    }
+    
+    manager.ProcessDistributed(nLocalWorkers, address);
+    
+    
+    // Check that the requested failures have happened
+    unsigned nErrors = 0;
+    
+    for (auto const &m: markers)
+    {
+        if (FileExists(m))
+        {
+            cout << "Failure requested with \"" << m << "\" has not been injected." << endl;
+            ++nErrors;
+        }
+    }
+    
+    
+    // Check the merged cut-flow. All the events pass the reader and the fault injector, and half
+    //of them have even event numbers
+    unsigned long const nEventsTotal = nFiles * eventsPerFile;
+    vector<unsigned long> const cutFlowExpected = {nEventsTotal, nEventsTotal, nEventsTotal / 2,
+     nEventsTotal / 2};
+    
+    if (manager.GetCutFlow() != cutFlowExpected)
+    {
+        cout << "Merged cut-flow is inconsistent:";
+        
+        for (unsigned long const n: manager.GetCutFlow())
+            cout << " " << n;
+        
+        cout << endl;
+        ++nErrors;
+    }
+    
+    
+    // Check the output files. File i must contain half of its events, the ones with even numbers
+    
+    for (unsigned i = 0; i < nFiles; ++i)
+    {
+        unsigned long const first = i * eventsPerFile + 1, last = (i + 1) * eventsPerFile;
+        unsigned long const firstEven = first + first % 2, lastEven = last - last % 2;
+        unsigned long const nExpected = (lastEven - firstEven) / 2 + 1;
+        unsigned long long const sumExpected =
+         (unsigned long long)(firstEven + lastEven) * nExpected / 2;
+        
+        ostringstream ost;
+        ost << outDir << "synthetic_" << eventsPerFile << "_" << i << ".txt";
+        ifstream outFile(ost.str());
+        
+        unsigned long n = 0;
+        unsigned long long sum = 0;
+        
+        if (not (outFile >> n >> sum) or n != nExpected or sum != sumExpected)
+        {
+            cout << "File \"" << ost.str() << "\" is missing or inconsistent." << endl;
+            ++nErrors;
+        }
+    }
+    
+    cout << ((nErrors == 0) ? "Distributed processing test passed." :
+     "Distributed processing test FAILED.") << endl;
+    
+    return (nErrors == 0) ? 0 : 2;
+}
@@ -0,0 +1,237 @@
+/**
+ * The program checks EventShapes against configurations with known answers:
+ *   - eigenvalues of several symmetric matrices computed with EventShapes::SymmetricEigenvalues,
+ *     including degenerate ones;
+ *   - two back-to-back momenta (a pencil-like event);
+ *   - six momenta along the coordinate axes (an isotropic event);
+ *   - three momenta of equal magnitude at 120 degrees in a plane (a symmetric three-jet event).
+ * For all of them, the eigenvalues of both momentum tensors, sphericity, aplanarity, C and D
+ * parameters, and thrust are compared with the analytical values. Each configuration is also
+ * rotated randomly, which must not change the results. Finally, in random events thrust found by
+ * EventShapes is compared with a scan over many directions, which it must never fall below.
+ * 
+ * Usage: eventshapes [nRandomEvents] [seed]
+ * The program returns a non-zero code if any inconsistency is found.
+ */
+
+#include <EventShapes.hpp>
+
+#include <TRandom3.h>
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <cstdlib>
+#include <cmath>
+
+
+using namespace std;
+
+
+/// Three-momentum
+typedef array<double, 3> Vector;
+
+
+/**
+ * \brief Tolerance for the comparisons with analytical values
+ * 
+ * The trigonometric solution for the eigenvalues loses about half of the significant digits when
+ * two eigenvalues coincide, which is the case for all the configurations below.
+ */
+double const tolerance = 1e-6;
+
+
+/// Number of errors found so far
+unsigned nErrors = 0;
+
+
+/// Compares a value with the expectation and reports a mismatch
+void Check(string const &label, double value, double expected)
+{
+    if (fabs(value - expected) > tolerance)
+    {
+        cout << label << ": " << value << " instead of " << expected << "." << endl;
+        ++nErrors;
+    }
+}
+
+
+/// Compares three values with the expectation
+void Check(string const &label, array<double, 3> const &values, array<double, 3> const &expected)
+{
+    for (unsigned i = 0; i < 3; ++i)
+        Check(label + "[" + to_string(i) + "]", values[i], expected[i]);
+}
+
+
+/// Rotates a vector with the given rotation matrix
+Vector Rotate(array<Vector, 3> const &rotation, Vector const &v)
+{
+    Vector res{{0., 0., 0.}};
+    
+    for (unsigned i = 0; i < 3; ++i)
+        for (unsigned j = 0; j < 3; ++j)
+            res[i] += rotation[i][j] * v[j];
+    
+    return res;
+}
+
+
+/// Builds a random rotation matrix from three Euler angles
+array<Vector, 3> RandomRotation(TRandom3 &rGen)
+{
+    double const a = rGen.Uniform(0., 2. * M_PI), b = acos(rGen.Uniform(-1., 1.)),
+     c = rGen.Uniform(0., 2. * M_PI);
+    double const ca = cos(a), sa = sin(a), cb = cos(b), sb = sin(b), cc = cos(c), sc = sin(c);
+    
+    return array<Vector, 3>{{
+     Vector{{ca * cc - sa * cb * sc, -ca * sc - sa * cb * cc, sa * sb}},
+     Vector{{sa * cc + ca * cb * sc, -sa * sc + ca * cb * cc, -ca * sb}},
+     Vector{{sb * sc, sb * cc, cb}}}};
+}
+
+
+/// Analytical values of the event-shape variables
+struct Expectation
+{
+    array<double, 3> sphericityEigenvalues, linearEigenvalues;
+    double sphericity, aplanarity, c, d, thrust;
+};
+
+
+/**
+ * \brief Checks a configuration of momenta against the expectation
+ * 
+ * The configuration is checked as it is and after a random rotation.
+ */
+void CheckConfiguration(string const &label, vector<Vector> const &momenta,
+ Expectation const &expected, TRandom3 &rGen)
+{
+    array<Vector, 3> const rotation(RandomRotation(rGen));
+    
+    for (bool rotate: {false, true})
+    {
+        EventShapes shapes;
+        
+        for (auto const &p: momenta)
+        {
+            Vector const q = (rotate) ? Rotate(rotation, p) : p;
+            shapes.AddMomentum(q[0], q[1], q[2]);
+        }
+        
+        string const fullLabel(label + ((rotate) ? " (rotated)" : ""));
+        
+        Check(fullLabel + ", sphericity eigenvalues", shapes.GetSphericityEigenvalues(),
+         expected.sphericityEigenvalues);
+        Check(fullLabel + ", linear eigenvalues", shapes.GetLinearEigenvalues(),
+         expected.linearEigenvalues);
+        Check(fullLabel + ", sphericity", shapes.Sphericity(), expected.sphericity);
+        Check(fullLabel + ", aplanarity", shapes.Aplanarity(), expected.aplanarity);
+        Check(fullLabel + ", C", shapes.C(), expected.c);
+        Check(fullLabel + ", D", shapes.D(), expected.d);
+        Check(fullLabel + ", thrust", shapes.Thrust(), expected.thrust);
+    }
+}
+
+
+/// Returns the maximal value of sum |p.n| / sum |p| over random unit vectors n
+double ScanThrust(vector<Vector> const &momenta, unsigned nDirections, TRandom3 &rGen)
+{
+    double sumP = 0.;
+    
+    for (auto const &p: momenta)
+        sumP += sqrt(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]);
+    
+    double maxSum = 0.;
+    
+    for (unsigned i = 0; i < nDirections; ++i)
+    {
+        double const cosTheta = rGen.Uniform(-1., 1.), phi = rGen.Uniform(0., 2. * M_PI);
+        double const sinTheta = sqrt(1. - cosTheta * cosTheta);
+        Vector const n{{sinTheta * cos(phi), sinTheta * sin(phi), cosTheta}};
+        
+        double sum = 0.;
+        
+        for (auto const &p: momenta)
+            sum += fabs(p[0] * n[0] + p[1] * n[1] + p[2] * n[2]);
+        
+        maxSum = max(maxSum, sum);
+    }
+    
+    return maxSum / sumP;
+}
+
+
+int main(int argc, char **argv)
+{
+    // Parse the arguments
+    unsigned const nRandomEvents = (argc > 1) ? atoi(argv[1]) : 100;
+    unsigned const seed = (argc > 2) ? atoi(argv[2]) : 1;
+    
+    TRandom3 rGen(seed);
+    
+    
+    // Eigenvalues of symmetric matrices given as (a00, a11, a22, a01, a02, a12)
+    Check("Diagonal matrix", EventShapes::SymmetricEigenvalues({{3., 1., 2., 0., 0., 0.}}),
+     {{3., 2., 1.}});
+    Check("Block-diagonal matrix", EventShapes::SymmetricEigenvalues({{2., 2., 5., 1., 0., 0.}}),
+     {{5., 3., 1.}});
+    Check("Degenerate matrix", EventShapes::SymmetricEigenvalues({{4., 4., 4., 1., 1., 1.}}),
+     {{6., 3., 3.}});
+    Check("Scalar matrix", EventShapes::SymmetricEigenvalues({{7., 7., 7., 0., 0., 0.}}),
+     {{7., 7., 7.}});
+    Check("Rank-one matrix", EventShapes::SymmetricEigenvalues({{1., 4., 9., 2., 3., 6.}}),
+     {{14., 0., 0.}});
+    
+    
+    // Two back-to-back momenta. The tensors have a single non-zero eigenvalue
+    CheckConfiguration("Back-to-back", {{{0., 0., 50.}}, {{0., 0., -50.}}},
+     {{{1., 0., 0.}}, {{1., 0., 0.}}, 0., 0., 0., 0., 1.}, rGen);
+    
+    
+    // Momenta along the coordinate axes. The tensors are proportional to the identity matrix,
+    //and the thrust axis is a diagonal of the cube
+    CheckConfiguration("Isotropic", {{{30., 0., 0.}}, {{-30., 0., 0.}}, {{0., 30., 0.}},
+     {{0., -30., 0.}}, {{0., 0., 30.}}, {{0., 0., -30.}}},
+     {{{1. / 3, 1. / 3, 1. / 3}}, {{1. / 3, 1. / 3, 1. / 3}}, 1., 0.5, 1., 1., 1. / sqrt(3.)},
+     rGen);
+    
+    
+    // A symmetric three-jet event. The thrust axis is along one of the momenta
+    double const s = sqrt(3.) / 2.;
+    CheckConfiguration("Planar", {{{40., 0., 0.}}, {{-20., 40. * s, 0.}}, {{-20., -40. * s, 0.}}},
+     {{{0.5, 0.5, 0.}}, {{0.5, 0.5, 0.}}, 0.75, 0., 0.75, 0., 2. / 3.}, rGen);
+    
+    
+    // Random events. Thrust is a maximum over all directions and therefore cannot be smaller than
+    //the result of the scan. It is also bounded from both sides
+    for (unsigned ev = 0; ev < nRandomEvents; ++ev)
+    {
+        vector<Vector> momenta;
+        EventShapes shapes;
+        unsigned const n = 2 + rGen.Uniform(10.);
+        
+        for (unsigned i = 0; i < n; ++i)
+        {
+            momenta.push_back({{rGen.Gaus(0., 30.), rGen.Gaus(0., 30.), rGen.Gaus(0., 60.)}});
+            shapes.AddMomentum(momenta.back()[0], momenta.back()[1], momenta.back()[2]);
+        }
+        
+        double const thrust = shapes.Thrust();
+        double const scan = ScanThrust(momenta, 20000, rGen);
+        
+        if (thrust < scan - tolerance or thrust > 1. + tolerance or thrust < 0.5 - tolerance)
+        {
+            cout << "Random event " << ev << ": thrust " << thrust << " is inconsistent with " <<
+             "the scan, which gives " << scan << "." << endl;
+            ++nErrors;
+        }
+    }
+    
+    
+    cout << ((nErrors == 0) ? "Event shapes test passed." : "Event shapes test FAILED.") << endl;
+    
+    return (nErrors == 0) ? 0 : 2;
+}
@@ -0,0 +1,392 @@
+/**
+ * The program validates HardProcessRecord against the pointer-linked graph of GenParticle objects
+ * that PECReader used to build directly from the input arrays. A hand-written semileptonic ttbar
+ * event with copies of W bosons and exotic particles is checked first, followed by a number of
+ * random events with arbitrary (including invalid) references to mothers. In every event the
+ * mothers and daughters of all the particles, the search for the first particle with a given PDG
+ * ID (including PDG IDs outside the range of the lookup table), the first top quark, the decays of
+ * W bosons, and the recursive search for daughters are compared. The same record is refilled for
+ * all the events.
+ * 
+ * Usage: hardprocess [nRandomEvents] [seed]
+ * The program returns a non-zero code if any inconsistency is found.
+ */
+
+#include <HardProcessRecord.hpp>
+#include <GenParticle.hpp>
+
+#include <TRandom3.h>
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdlib>
+
+
+using namespace std;
+
+
+/// Raw description of a particle in the same format as in the input files
+struct RawParticle
+{
+    int pdgId;
+    float pt, eta, phi, mass;
+    int firstMother, lastMother;
+};
+
+
+/**
+ * \brief Builds the graph of generator particles in the way PECReader used to do it
+ * 
+ * The vector is filled in place because the particles refer to each other by pointers.
+ */
+void BuildReferenceGraph(vector<RawParticle> const &raw, vector<GenParticle> &particles)
+{
+    particles.clear();
+    particles.reserve(raw.size());
+    int const n = raw.size();
+    
+    for (auto const &r: raw)
+    {
+        TLorentzVector p4;
+        p4.SetPtEtaPhiM(r.pt, r.eta, r.phi, r.mass);
+        particles.emplace_back(p4, r.pdgId);
+    }
+    
+    for (int i = 0; i < n; ++i)
+    {
+        int iMother = raw[i].firstMother;
+        
+        if (iMother >= 0 and iMother < n)
+        {
+            particles[i].AddMother(&particles[iMother]);
+            particles[iMother].AddDaughter(&particles[i]);
+        }
+        
+        if (raw[i].firstMother != raw[i].lastMother)
+        {
+            iMother = raw[i].lastMother;
+            
+            if (iMother >= 0 and iMother < n)
+            {
+                particles[i].AddMother(&particles[iMother]);
+                particles[iMother].AddDaughter(&particles[i]);
+            }
+        }
+    }
+}
+
+
+/// Returns the index of a particle in the reference graph or -1 for a null pointer
+int IndexOf(vector<GenParticle> const &particles, GenParticle const *p)
+{
+    return (p) ? int(p - particles.data()) : -1;
+}
+
+
+/// Returns the index of a particle in the record or -1 for an invalid view
+int IndexOf(HardProcessRecord::ParticleView const &p)
+{
+    return (p) ? int(p.GetIndex()) : -1;
+}
+
+
+/**
+ * \brief Compares a list of linked particles in the graph and in the record
+ * 
+ * Returns true if the lists agree.
+ */
+bool CompareLinks(vector<GenParticle> const &particles, GenParticle::collection_t const &expected,
+ HardProcessRecord::ParticleRange const &links)
+{
+    if (expected.size() != links.size())
+        return false;
+    
+    for (unsigned k = 0; k < expected.size(); ++k)
+        if (IndexOf(particles, expected[k]) != IndexOf(links[k]))
+            return false;
+    
+    return true;
+}
+
+
+/**
+ * \brief Compares the record with the reference graph
+ * 
+ * The label identifies the event in the printout. Returns the number of errors.
+ */
+unsigned CompareEvent(string const &label, vector<RawParticle> const &raw,
+ HardProcessRecord const &record)
+{
+    vector<GenParticle> particles;
+    BuildReferenceGraph(raw, particles);
+    
+    unsigned nErrors = 0;
+    auto report = [&label, &nErrors](string const &what)
+    {
+        cout << label << ": " << what << endl;
+        ++nErrors;
+    };
+    
+    
+    if (record.GetNumParticles() != particles.size())
+    {
+        report("wrong number of particles");
+        return nErrors;
+    }
+    
+    
+    // Properties of individual particles and their links
+    for (unsigned i = 0; i < particles.size(); ++i)
+    {
+        GenParticle const &p = particles[i];
+        HardProcessRecord::ParticleView const v = record[i];
+        
+        if (v.GetIndex() != i or v.GetPdgId() != p.GetPdgId() or
+         record.GetPdgId(i) != p.GetPdgId())
+            report("wrong PDG ID of particle " + to_string(i));
+        
+        TLorentzVector const p4(v.P4());
+        
+        if (p4.Px() != p.P4().Px() or p4.Py() != p.P4().Py() or p4.Pz() != p.P4().Pz() or
+         p4.E() != p.P4().E())
+            report("wrong momentum of particle " + to_string(i));
+        
+        if (not CompareLinks(particles, p.GetMothers(), v.GetMothers()))
+            report("wrong mothers of particle " + to_string(i));
+        
+        if (not CompareLinks(particles, p.GetDaughters(), v.GetDaughters()))
+            report("wrong daughters of particle " + to_string(i));
+        
+        if (IndexOf(particles, p.GetFirstMother()) != IndexOf(v.GetFirstMother()) or
+         p.GetFirstMotherPdgId() != v.GetFirstMotherPdgId())
+            report("wrong first mother of particle " + to_string(i));
+        
+        for (auto const &ids: {initializer_list<int>{5, -5},
+         initializer_list<int>{11, 13, -11, -13}, initializer_list<int>{1000006, -1000022}})
+        {
+            if (IndexOf(particles, p.FindFirstDaughter(ids)) != IndexOf(v.FindFirstDaughter(ids)))
+                report("wrong first daughter of particle " + to_string(i));
+            
+            if (IndexOf(particles, p.FindFirstDaughterRecursive(ids)) !=
+             IndexOf(v.FindFirstDaughterRecursive(ids)))
+                report("wrong recursive search from particle " + to_string(i));
+        }
+    }
+    
+    
+    // The first particle with a given PDG ID. The list includes PDG IDs outside the range of the
+    //lookup table and at its boundaries, as well as PDG IDs that are absent in the event
+    vector<int> pdgIds{6, -6, 24, -24, 5, -5, 11, -13, 21, 127, -128, 128, -129, 1000006,
+     -1000022, 2212};
+    
+    for (auto const &p: particles)
+        pdgIds.push_back(p.GetPdgId());
+    
+    for (int const pdgId: pdgIds)
+    {
+        int expected = -1;
+        
+        for (unsigned i = 0; i < particles.size(); ++i)
+            if (particles[i].GetPdgId() == pdgId)
+            {
+                expected = i;
+                break;
+            }
+        
+        if (record.FindFirst(pdgId) != expected)
+            report("wrong first particle with PDG ID " + to_string(pdgId));
+    }
+    
+    
+    // The first top quark or antiquark
+    int expectedTop = -1;
+    
+    for (unsigned i = 0; i < particles.size(); ++i)
+        if (abs(particles[i].GetPdgId()) == 6)
+        {
+            expectedTop = i;
+            break;
+        }
+    
+    if (IndexOf(record.GetFirstTop()) != expectedTop)
+        report("wrong first top quark");
+    
+    
+    // Decays of W bosons. Only W bosons that do not decay into other W bosons are considered, and
+    //their first two daughters are taken
+    vector<HardProcessRecord::WDecay> expectedDecays;
+    
+    for (unsigned i = 0; i < particles.size(); ++i)
+    {
+        if (abs(particles[i].GetPdgId()) != 24)
+            continue;
+        
+        HardProcessRecord::WDecay decay{i, {-1, -1}};
+        unsigned nDaughters = 0;
+        bool isCopy = false;
+        
+        for (auto const &d: particles[i].GetDaughters())
+        {
+            if (abs(d->GetPdgId()) == 24)
+                isCopy = true;
+            else if (nDaughters < 2)
+                decay.daughters[nDaughters++] = IndexOf(particles, d);
+        }
+        
+        if (not isCopy and nDaughters > 0)
+            expectedDecays.push_back(decay);
+    }
+    
+    auto const &decays = record.GetWDecays();
+    
+    if (decays.size() != expectedDecays.size())
+        report("wrong number of W decays");
+    else
+        for (unsigned k = 0; k < decays.size(); ++k)
+            if (decays[k].w != expectedDecays[k].w or
+             decays[k].daughters[0] != expectedDecays[k].daughters[0] or
+             decays[k].daughters[1] != expectedDecays[k].daughters[1])
+                report("wrong decay of W boson " + to_string(expectedDecays[k].w));
+    
+    return nErrors;
+}
+
+
+/// Fills the record from the raw particles
+void FillRecord(HardProcessRecord &record, vector<RawParticle> const &raw)
+{
+    record.Clear();
+    
+    for (auto const &r: raw)
+        record.AddParticle(r.pdgId, r.pt, r.eta, r.phi, r.mass, r.firstMother, r.lastMother);
+    
+    record.Finalize();
+}
+
+
+/**
+ * \brief Returns a hand-written semileptonic ttbar event
+ * 
+ * The W bosons are copied before they decay, one of the b quarks radiates a gluon, and the event
+ * contains a stop and a neutralino, whose PDG IDs are outside the range of the lookup table.
+ */
+vector<RawParticle> MakeTTbarEvent()
+{
+    return {
+     {2212, 0.f, 0.f, 0.f, 0.938f, -1, -1},         // 0: proton
+     {2212, 0.f, 0.f, 0.f, 0.938f, -1, -1},         // 1: proton
+     {21, 0.f, 5.f, 0.f, 0.f, 0, 0},                // 2: gluon
+     {21, 0.f, -5.f, 0.f, 0.f, 1, 1},               // 3: gluon
+     {-6, 80.f, -0.5f, 2.f, 172.5f, 2, 3},          // 4: top antiquark
+     {6, 90.f, 0.3f, -1.f, 172.5f, 2, 3},           // 5: top quark
+     {-24, 50.f, -0.7f, 2.3f, 80.4f, 4, 4},         // 6: W- from the antitop
+     {-5, 60.f, -0.1f, 1.5f, 4.8f, 4, 4},           // 7: b antiquark
+     {24, 40.f, 0.9f, -0.8f, 80.4f, 5, 5},          // 8: W+ from the top
+     {5, 70.f, 0.1f, -1.3f, 4.8f, 5, 5},            // 9: b quark
+     {-24, 51.f, -0.7f, 2.3f, 80.4f, 6, 6},         // 10: copy of W-
+     {24, 41.f, 0.9f, -0.8f, 80.4f, 8, -1},         // 11: copy of W+
+     {13, 30.f, 0.4f, -0.5f, 0.106f, 10, 10},       // 12: muon
+     {-14, 25.f, -1.2f, 2.8f, 0.f, 10, 10},         // 13: muon antineutrino
+     {2, 35.f, 1.1f, -0.2f, 0.f, 11, 11},           // 14: u quark
+     {-1, 20.f, 0.6f, -1.9f, 0.f, 11, 11},          // 15: d antiquark
+     {21, 10.f, 0.2f, -1.1f, 0.f, 9, 9},            // 16: gluon radiated by the b quark
+     {5, 62.f, 0.1f, -1.4f, 4.8f, 9, 9},            // 17: b quark after radiation
+     {1000006, 300.f, 0.f, 1.f, 500.f, 2, 3},       // 18: stop
+     {-1000022, 200.f, 0.5f, 1.2f, 100.f, 18, 18},  // 19: neutralino
+     {6, 100.f, -0.2f, 0.4f, 172.5f, 18, 18}        // 20: top quark from the stop
+    };
+}
+
+
+/**
+ * \brief Generates a random event
+ * 
+ * References to mothers point to preceding particles, as in real events, so that the graph has no
+ * cycles. Some of them are negative or point outside of the record and must be ignored. PDG IDs
+ * cover the range of the lookup table together with its boundaries and values far outside of it.
+ */
+vector<RawParticle> MakeRandomEvent(TRandom3 &rGen)
+{
+    vector<int> const pdgIds{1, -1, 2, 5, -5, 6, -6, 11, -13, 14, 21, 22, 24, -24, 25, 127, -128,
+     128, -129, 1000006, -1000022, 2212};
+    
+    unsigned const n = rGen.Integer(40);
+    vector<RawParticle> raw;
+    
+    for (unsigned i = 0; i < n; ++i)
+    {
+        auto mother = [&rGen, i, n]() -> int
+        {
+            double const u = rGen.Uniform();
+            
+            if (u < 0.1)
+                return -1;
+            else if (u < 0.15)
+                return n + rGen.Integer(3);
+            else
+                return (i > 0) ? int(rGen.Integer(i)) : -1;
+        };
+        
+        int const firstMother = mother();
+        int const lastMother = (rGen.Uniform() < 0.5) ? firstMother : mother();
+        
+        raw.push_back({pdgIds[rGen.Integer(pdgIds.size())], float(rGen.Exp(50.)),
+         float(rGen.Uniform(-3., 3.)), float(rGen.Uniform(-3.14, 3.14)),
+         float(rGen.Uniform(0., 200.)), firstMother, lastMother});
+    }
+    
+    return raw;
+}
+
+
+int main(int argc, char **argv)
+{
+    // Parse the arguments
+    unsigned const nRandomEvents = (argc > 1) ? atoi(argv[1]) : 1000;
+    unsigned const seed = (argc > 2) ? atoi(argv[2]) : 1;
+    
+    
+    // The same record is used for all the events to check that it is reset properly
+    HardProcessRecord record;
+    unsigned long nErrors = 0;
+    
+    
+    // Check the hand-written event and some known answers
+    vector<RawParticle> const ttbar(MakeTTbarEvent());
+    FillRecord(record, ttbar);
+    nErrors += CompareEvent("ttbar event", ttbar, record);
+    
+    auto const &decays = record.GetWDecays();
+    
+    if (decays.size() != 2 or decays[0].w != 10 or decays[0].daughters[0] != 12 or
+     decays[0].daughters[1] != 13 or decays[1].w != 11 or decays[1].daughters[0] != 14 or
+     decays[1].daughters[1] != 15)
+    {
+        cout << "ttbar event: unexpected W decays" << endl;
+        ++nErrors;
+    }
+    
+    if (IndexOf(record.GetFirstTop()) != 4 or record.FindFirst(1000006) != 18 or
+     record.FindFirst(-1000022) != 19 or record.FindFirst(-1000006) != -1)
+    {
+        cout << "ttbar event: unexpected results of the search by PDG ID" << endl;
+        ++nErrors;
+    }
+    
+    
+    // Check random events
+    TRandom3 rGen(seed);
+    
+    for (unsigned ev = 0; ev < nRandomEvents; ++ev)
+    {
+        vector<RawParticle> const raw(MakeRandomEvent(rGen));
+        FillRecord(record, raw);
+        nErrors += CompareEvent("Random event " + to_string(ev), raw, record);
+    }
+    
+    
+    cout << ((nErrors == 0) ? "Hard process test passed." : "Hard process test FAILED.") << endl;
+    
+    return (nErrors == 0) ? 0 : 2;
+}
@@ -0,0 +1,275 @@
+/**
+ * The program validates HistogramPlugin on synthetic PEC files. Three runs are performed:
+ *   - a multithreaded run without any selection, in which histograms are filled with special
+ *     values chosen by the event number (boundaries of the range, values outside of it, NaN), so
+ *     that the content of every bin, including under- and overflows, is known;
+ *   - a multithreaded run with an event selection, reweighting, and systematical variations of
+ *     the weight;
+ *   - the same run with a single thread.
+ * In the first run the bin contents are compared with the expectation. The histograms from the
+ * last two runs must agree within the rounding errors, and all the histograms with weight
+ * variations must be present under the documented names. Finally, it is checked that an output
+ * file in a missing directory leads to an exception.
+ * 
+ * Usage: histograms [nThreads] [nFiles] [eventsPerFile] [workDirectory]
+ * The program returns a non-zero code if any inconsistency is found.
+ */
+
+#include <SyntheticPEC.hpp>
+
+#include <RunManager.hpp>
+#include <HistogramPlugin.hpp>
+
+#include <TFile.h>
+#include <TH1.h>
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <list>
+#include <memory>
+#include <utility>
+#include <limits>
+#include <stdexcept>
+#include <cstdlib>
+#include <cmath>
+
+
+using namespace std;
+
+
+/// Special values for the 1D histogram with 4 bins in [0, 1) and their global bin indices
+vector<pair<double, int>> const values1D = {{0., 1}, {1., 5},
+ {numeric_limits<double>::quiet_NaN(), 0}, {-0.5, 0}, {0.25, 2}, {0.999999, 4}};
+
+
+/// Special values for the 2D histogram with 2 x 3 bins in [0, 1) x [0, 3) and their global bins
+vector<pair<pair<double, double>, int>> const values2D = {{{0.5, 3.}, 2 + 4 * 4},
+ {{2., 5.}, 3 + 4 * 4}, {{numeric_limits<double>::quiet_NaN(), 1.5}, 0 + 4 * 2},
+ {{0., -1.}, 1 + 4 * 0}};
+
+
+/// Quantities filled into the histograms with special values
+double Edge1D(PECReader const &reader)
+{
+    return values1D[reader.GetEventID().Event() % values1D.size()].first;
+}
+
+
+double Edge2DX(PECReader const &reader)
+{
+    return values2D[reader.GetEventID().Event() % values2D.size()].first.first;
+}
+
+
+double Edge2DY(PECReader const &reader)
+{
+    return values2D[reader.GetEventID().Event() % values2D.size()].first.second;
+}
+
+
+/// Checks if two numbers agree within the rounding errors
+bool Agree(double a, double b)
+{
+    return (fabs(a - b) <= 1e-9 * max(fabs(a), fabs(b)) + 1e-12);
+}
+
+
+/// Opens a ROOT file and reads a histogram; returns a null pointer if it is not found
+unique_ptr<TH1> ReadHistogram(TFile &file, string const &name)
+{
+    TH1 *hist = dynamic_cast<TH1 *>(file.Get(name.c_str()));
+    
+    if (hist)
+        hist->SetDirectory(nullptr);
+    
+    return unique_ptr<TH1>(hist);
+}
+
+
+/**
+ * \brief Checks histograms filled with the special values
+ * 
+ * All the events are accepted, and the central weight is the same for all of them. Event numbers
+ * run from 1 to nEvents. Returns the number of errors.
+ */
+unsigned CheckEdges(string const &fileName, unsigned long nEvents)
+{
+    TFile file(fileName.c_str());
+    unique_ptr<TH1> hist1D(ReadHistogram(file, "Edges"));
+    unique_ptr<TH1> hist2D(ReadHistogram(file, "Edges2D"));
+    
+    if (not hist1D or not hist2D)
+    {
+        cout << "Histograms with special values are missing." << endl;
+        return 1;
+    }
+    
+    
+    // Count the events per value. The value is chosen with the remainder of event number
+    vector<unsigned long> counts1D(6, 0), counts2D(4 * 5, 0);
+    
+    for (unsigned long event = 1; event <= nEvents; ++event)
+    {
+        ++counts1D[values1D[event % values1D.size()].second];
+        ++counts2D[values2D[event % values2D.size()].second];
+    }
+    
+    
+    // Compare the bin contents. The common weight is deduced from the total sum
+    unsigned nErrors = 0;
+    
+    for (auto const &h: {make_pair(hist1D.get(), &counts1D), make_pair(hist2D.get(), &counts2D)})
+    {
+        double total = 0.;
+        
+        for (unsigned bin = 0; bin < h.second->size(); ++bin)
+            total += h.first->GetBinContent(bin);
+        
+        double const weight = total / nEvents;
+        
+        for (unsigned bin = 0; bin < h.second->size(); ++bin)
+        {
+            if (not Agree(h.first->GetBinContent(bin), weight * (*h.second)[bin]))
+            {
+                cout << "Bin " << bin << " of histogram \"" << h.first->GetName() <<
+                 "\" contains " << h.first->GetBinContent(bin) << " instead of " <<
+                 weight * (*h.second)[bin] << "." << endl;
+                ++nErrors;
+            }
+        }
+    }
+    
+    return nErrors;
+}
+
+
+/**
+ * \brief Compares histograms with the given names in the two files
+ * 
+ * Returns the number of missing or inconsistent histograms.
+ */
+unsigned CompareFiles(string const &fileName1, string const &fileName2,
+ vector<string> const &histNames)
+{
+    TFile file1(fileName1.c_str()), file2(fileName2.c_str());
+    unsigned nErrors = 0;
+    
+    for (auto const &name: histNames)
+    {
+        unique_ptr<TH1> hist1(ReadHistogram(file1, name)), hist2(ReadHistogram(file2, name));
+        
+        if (not hist1 or not hist2)
+        {
+            cout << "Histogram \"" << name << "\" is missing." << endl;
+            ++nErrors;
+            continue;
+        }
+        
+        for (int bin = 0; bin < hist1->GetNcells(); ++bin)
+        {
+            if (not Agree(hist1->GetBinContent(bin), hist2->GetBinContent(bin)) or
+             not Agree(hist1->GetBinError(bin), hist2->GetBinError(bin)))
+            {
+                cout << "Histogram \"" << name << "\" differs in bin " << bin << "." << endl;
+                ++nErrors;
+                break;
+            }
+        }
+    }
+    
+    return nErrors;
+}
+
+
+int main(int argc, char **argv)
+{
+    // Parse the arguments
+    unsigned const nThreads = (argc > 1) ? atoi(argv[1]) : 4;
+    unsigned const nFiles = (argc > 2) ? atoi(argv[2]) : 8;
+    unsigned long const eventsPerFile = (argc > 3) ? atol(argv[3]) : 2000;
+    string workDir((argc > 4) ? argv[4] : "histograms-data");
+    
+    if (nThreads == 0 or nFiles == 0 or eventsPerFile == 0)
+    {
+        cerr << "Usage: " << argv[0] << " [nThreads] [nFiles] [eventsPerFile] [workDirectory]\n";
+        return 1;
+    }
+    
+    PrepareWorkDirectory(workDir);
+    vector<string> const fileNames(EnsureSyntheticFiles(workDir, nFiles, eventsPerFile));
+    unsigned nErrors = 0;
+    
+    
+    // Fill histograms with special values without any selection
+    {
+        list<Dataset> datasets(MakeSyntheticDatasets(fileNames, eventsPerFile));
+        RunManager manager(datasets.begin(), datasets.end());
+        
+        HistogramPlugin *plugin = new HistogramPlugin(workDir + "edges.root");
+        plugin->Book1D("Edges", "", 4, 0., 1., Edge1D);
+        plugin->Book2D("Edges2D", "", 2, 0., 1., 3, 0., 3., Edge2DX, Edge2DY);
+        manager.RegisterPlugin(plugin);
+        
+        manager.Process(int(nThreads));
+        nErrors += CheckEdges(workDir + "edges.root", nFiles * eventsPerFile);
+    }
+    
+    
+    // Fill realistic histograms with weight variations with several threads and with a single one
+    SyntheticAnalysis analysis(workDir);
+    
+    for (unsigned n: {nThreads, 1u})
+    {
+        list<Dataset> datasets(MakeSyntheticDatasets(fileNames, eventsPerFile));
+        RunManager manager(datasets.begin(), datasets.end());
+        analysis.Configure(manager.GetPECReaderConfig());
+        manager.GetPECReaderConfig().SetSystematics(SystVariation(SystTypeAlgo::WeightOnly, 0));
+        
+        HistogramPlugin *plugin = new HistogramPlugin(workDir + "threads" + to_string(n) + ".root");
+        plugin->Book1D("MET", "", 50, 0., 250., [](PECReader const &r){return r.GetMET().Pt();});
+        plugin->Book2D("Lep", "", 40, 20., 220., 24, -2.4, 2.4,
+         [](PECReader const &r){return r.GetLeptons().front().Pt();},
+         [](PECReader const &r){return r.GetLeptons().front().Eta();});
+        plugin->AddSystWeights(SystTypeWeight::PileUp, "PileUp");
+        plugin->AddSystWeights(SystTypeWeight::TagRate, "TagRate", 2);
+        manager.RegisterPlugin(plugin);
+        
+        manager.Process(int(n));
+    }
+    
+    vector<string> histNames;
+    
+    for (auto const &base: {"MET", "Lep"})
+        for (auto const &suffix: {"", "_PileUpUp", "_PileUpDown", "_TagRate0Up",
+         "_TagRate0Down", "_TagRate1Up", "_TagRate1Down"})
+            histNames.emplace_back(string(base) + suffix);
+    
+    nErrors += CompareFiles(workDir + "threads" + to_string(nThreads) + ".root",
+     workDir + "threads1.root", histNames);
+    
+    
+    // An output file that cannot be created must be reported with an exception
+    {
+        list<Dataset> datasets(MakeSyntheticDatasets({fileNames.front()}, eventsPerFile));
+        RunManager manager(datasets.begin(), datasets.end());
+        
+        HistogramPlugin *plugin = new HistogramPlugin(workDir + "missing/hists.root");
+        plugin->Book1D("MET", "", 50, 0., 250., [](PECReader const &r){return r.GetMET().Pt();});
+        manager.RegisterPlugin(plugin);
+        
+        try
+        {
+            manager.Process(1);
+            cout << "No exception is thrown for a file in a missing directory." << endl;
+            ++nErrors;
+        }
+        catch (runtime_error const &)
+        {}
+    }
+    
+    
+    cout << ((nErrors == 0) ? "Histogram test passed." : "Histogram test FAILED.") << endl;
+    
+    return (nErrors == 0) ? 0 : 2;
+}
@@ -0,0 +1,350 @@
+/**
+ * The program measures the cost of individual calls to the interfaces used to compute event
+ * weights and b-tagging decisions: BTagger::IsTagged, BTagEfficiencies::GetEfficiency,
+ * BTagScaleFactors::GetScaleFactor, WeightBTag::CalcWeight, and WeightPileUp::GetWeights. The
+ * inputs are generated once with realistic distributions of jet transverse momenta,
+ * pseudorapidities, flavours, and b-tagging discriminators, and the same inputs are given to all
+ * the implementations. For every call, the time in nanoseconds and the number of calls per second
+ * are reported.
+ * 
+ * Several implementations of the same interface can be registered for a benchmark. The first one
+ * is the reference. In the comparison mode all of them are run side by side, and for each
+ * alternative the speed relative to the reference and the maximal absolute deviation of its
+ * results from the reference ones are printed. A new implementation (for instance, one based on a
+ * lookup table) is validated by adding it to the corresponding benchmark below.
+ * 
+ * Usage: microbench [--compare] [minCalls]
+ * The payload files for b-tagging and pile-up reweighting are written into the working directory.
+ */
+
+#include <SyntheticPEC.hpp>
+
+#include <Dataset.hpp>
+#include <PhysicsObjects.hpp>
+#include <BTagger.hpp>
+#include <BTagEfficiencies.hpp>
+#include <BTagScaleFactors.hpp>
+#include <WeightBTag.hpp>
+#include <WeightPileUp.hpp>
+
+#include <TRandom3.h>
+
+#include <unistd.h>
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <functional>
+#include <memory>
+#include <chrono>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+
+
+using namespace std;
+
+
+/**
+ * \class MicroBenchmark
+ * \brief Measures and compares the speed of several implementations of the same interface
+ * 
+ * Each implementation computes results for all the inputs in a single pass and writes them into
+ * the given array. Implementations that process one input per call are registered with method
+ * AddImplementation, which wraps them in a loop; since the wrapper is a template, the call is not
+ * hidden behind an additional indirection. Batched implementations are registered with method
+ * AddBatchImplementation.
+ */
+class MicroBenchmark
+{
+public:
+    /// Constructor from a name of the benchmark and the number of inputs
+    MicroBenchmark(string const &name, unsigned nInputs);
+
+public:
+    /// Registers an implementation that computes the result for the input with the given index
+    template<typename F>
+    void AddImplementation(string const &name, F const &f);
+    
+    /// Registers an implementation that computes results for all the inputs at once
+    void AddBatchImplementation(string const &name, function<void(double *)> const &f);
+    
+    /**
+     * \brief Runs the benchmark and prints the results
+     * 
+     * Each implementation is run over the inputs as many times as needed to perform at least
+     * minCalls calls. If compare is false, only the reference implementation is run.
+     */
+    void Run(unsigned long minCalls, bool compare) const;
+
+private:
+    /// Name of the benchmark
+    string name;
+    
+    /// Number of inputs
+    unsigned nInputs;
+    
+    /// Registered implementations
+    vector<pair<string, function<void(double *)>>> implementations;
+};
+
+
+MicroBenchmark::MicroBenchmark(string const &name_, unsigned nInputs_):
+    name(name_), nInputs(nInputs_)
+{}
+
+
+template<typename F>
+void MicroBenchmark::AddImplementation(string const &name, F const &f)
+{
+    unsigned const n = nInputs;
+    
+    implementations.emplace_back(name, [f, n](double *results)
+    {
+        for (unsigned i = 0; i < n; ++i)
+            results[i] = f(i);
+    });
+}
+
+
+void MicroBenchmark::AddBatchImplementation(string const &name, function<void(double *)> const &f)
+{
+    implementations.emplace_back(name, f);
+}
+
+
+void MicroBenchmark::Run(unsigned long minCalls, bool compare) const
+{
+    unsigned const nPasses = max<unsigned long>((minCalls + nInputs - 1) / nInputs, 1);
+    unsigned const nImplementations = (compare) ? implementations.size() : 1;
+    
+    vector<double> referenceResults(nInputs), results(nInputs);
+    double referenceTime = 0.;
+    
+    for (unsigned iImpl = 0; iImpl < nImplementations; ++iImpl)
+    {
+        auto const &impl = implementations[iImpl].second;
+        double *buffer = (iImpl == 0) ? referenceResults.data() : results.data();
+        
+        
+        // Warm up the caches and measure the time
+        impl(buffer);
+        
+        auto const start = chrono::steady_clock::now();
+        
+        for (unsigned pass = 0; pass < nPasses; ++pass)
+            impl(buffer);
+        
+        auto const end = chrono::steady_clock::now();
+        
+        double const nsPerCall =
+         chrono::duration<double, nano>(end - start).count() / (double(nPasses) * nInputs);
+        
+        
+        // Report the results
+        cout << setw(34) << left << ((iImpl == 0) ? name : "") << setw(30) <<
+         implementations[iImpl].first << right << setw(10) << fixed << setprecision(2) <<
+         nsPerCall << setw(12) << setprecision(2) << 1e3 / nsPerCall;
+        
+        if (iImpl == 0)
+            referenceTime = nsPerCall;
+        else
+        {
+            double maxDeviation = 0.;
+            
+            for (unsigned i = 0; i < nInputs; ++i)
+                maxDeviation = max(maxDeviation, fabs(results[i] - referenceResults[i]));
+            
+            cout << setw(10) << setprecision(2) << referenceTime / nsPerCall << setw(12) <<
+             scientific << setprecision(1) << maxDeviation;
+        }
+        
+        cout << endl;
+    }
+}
+
+
+int main(int argc, char **argv)
+{
+    // Parse the arguments
+    bool compare = false;
+    unsigned long minCalls = 10000000;
+    
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--compare") == 0)
+            compare = true;
+        else
+            minCalls = atol(argv[i]);
+    }
+    
+    
+    // Create the payload files. FileInPath requires an absolute path
+    char *cwd = getcwd(nullptr, 0);
+    string const workDir = string(cwd) + "/";
+    free(cwd);
+    
+    WriteSyntheticBTagEffFile(workDir + "microbench_btagEff.root", "ttbar");
+    WriteSyntheticPileUpFile(workDir + "microbench_pileup.root");
+    
+    
+    // Generate jets. Only jets in the tracker acceptance and above the usual threshold are
+    //considered since the others are not b-tagged and do not enter the weights
+    TRandom3 rGen(1);
+    unsigned const nJets = 10000;
+    vector<Jet> jets;
+    jets.reserve(nJets);
+    
+    while (jets.size() < nJets)
+    {
+        double const pt = 20. + rGen.Exp(50.);
+        double const eta = rGen.Gaus(0., 1.3);
+        
+        if (fabs(eta) > 2.4)
+            continue;
+        
+        TLorentzVector p4;
+        p4.SetPtEtaPhiM(pt, eta, rGen.Uniform(-M_PI, M_PI), pt * rGen.Uniform(0.05, 0.2));
+        Jet jet(p4);
+        
+        double const u = rGen.Uniform();
+        int const flavour = (u < 0.2) ? 5 : ((u < 0.3) ? 4 : ((u < 0.65) ? 21 : 1));
+        jet.SetParentID(flavour * ((rGen.Uniform() < 0.5) ? -1 : 1));
+        
+        double const csv = (flavour == 5) ? 1. - rGen.Exp(0.15) :
+         ((flavour == 4) ? rGen.Uniform() : rGen.Exp(0.15));
+        jet.SetCSV(max(min(csv, 1.), 0.));
+        
+        jets.push_back(jet);
+    }
+    
+    
+    // Group the jets into events with realistic multiplicities
+    vector<vector<Jet>> events;
+    unsigned curJet = 0;
+    
+    while (true)
+    {
+        unsigned const n = 2 + rGen.Poisson(2.5);
+        
+        if (curJet + n > jets.size())
+            break;
+        
+        events.emplace_back(jets.begin() + curJet, jets.begin() + curJet + n);
+        curJet += n;
+    }
+    
+    
+    // Numbers of pile-up interactions
+    vector<double> nTruth(nJets);
+    
+    for (auto &n: nTruth)
+        n = max(0., rGen.Gaus(20., 5.));
+    
+    
+    // Create the objects under study
+    Dataset dataset(list<Dataset::Process>{Dataset::Process::ttbar, Dataset::Process::ttSemilep},
+     Dataset::Generator::MadGraph, Dataset::ShowerGenerator::Pythia);
+    dataset.AddFile(workDir + "ttbar.root", 1., 1);
+    
+    shared_ptr<BTagger const> bTagger(
+     new BTagger(BTagger::Algorithm::CSV, BTagger::WorkingPoint::Medium));
+    BTagger::WorkingPoint const wp = BTagger::WorkingPoint::Medium;
+    
+    BTagEfficiencies bTagEff(workDir + "microbench_btagEff.root");
+    bTagEff.SetDefaultProcessLabel("ttbar");
+    bTagEff.LoadPayload(dataset);
+    
+    BTagScaleFactors bTagSF(bTagger->GetAlgorithm());
+    
+    WeightBTag bTagReweighter(bTagger, bTagEff, bTagSF);
+    bTagReweighter.LoadPayload(dataset);
+    
+    WeightPileUp puReweighter(workDir + "microbench_pileup.root", 0.06);
+    puReweighter.SetDataset(dataset);
+    
+    
+    // Copies of the jets with cached b-tagging decisions
+    vector<Jet> taggedJets(jets);
+    bTagger->TagJets(taggedJets);
+    
+    vector<vector<Jet>> taggedEvents(events);
+    
+    for (auto &event: taggedEvents)
+        bTagger->TagJets(event);
+    
+    // Flat arrays for the batched b-tagging
+    vector<float> discriminators(nJets), etas(nJets);
+    vector<unsigned char> tagBits(nJets);
+    
+    for (unsigned i = 0; i < nJets; ++i)
+    {
+        discriminators[i] = bTagger->GetDiscriminator(jets[i]);
+        etas[i] = jets[i].Eta();
+    }
+    
+    
+    // Interfaces are accessed via pointers to base classes, as it is done in PECReader
+    BTagEffInterface const *eff = &bTagEff;
+    BTagSFInterface const *sf = &bTagSF;
+    WeightBTagInterface const *bTagWeight = &bTagReweighter;
+    WeightPileUpInterface const *puWeight = &puReweighter;
+    
+    
+    // Define the benchmarks
+    vector<MicroBenchmark> benchmarks;
+    
+    benchmarks.emplace_back("BTagger::IsTagged", nJets);
+    benchmarks.back().AddImplementation("discriminator vs threshold",
+     [&](unsigned i){return double(bTagger->IsTagged(wp, jets[i]));});
+    benchmarks.back().AddImplementation("cached tag bits",
+     [&](unsigned i){return double(bTagger->IsTagged(wp, taggedJets[i]));});
+    benchmarks.back().AddBatchImplementation("batched ComputeTagBits", [&](double *results)
+    {
+        bTagger->ComputeTagBits(nJets, discriminators.data(), etas.data(), tagBits.data());
+        
+        for (unsigned i = 0; i < nJets; ++i)
+            results[i] = (tagBits[i] >> int(wp)) & 1;
+    });
+    
+    benchmarks.emplace_back("BTagEfficiencies::GetEfficiency", nJets);
+    benchmarks.back().AddImplementation("BTagEfficiencies",
+     [&](unsigned i){return eff->GetEfficiency(wp, jets[i], jets[i].GetParentID());});
+    
+    benchmarks.emplace_back("BTagScaleFactors::GetScaleFactor", nJets);
+    benchmarks.back().AddImplementation("BTagScaleFactors",
+     [&](unsigned i){return sf->GetScaleFactor(wp, jets[i], jets[i].GetParentID());});
+    
+    benchmarks.emplace_back("BTagScaleFactors::GetScaleFactor(up)", nJets);
+    benchmarks.back().AddImplementation("BTagScaleFactors", [&](unsigned i)
+     {return sf->GetScaleFactor(wp, jets[i], jets[i].GetParentID(),
+     BTagSFInterface::Variation::Up);});
+    
+    benchmarks.emplace_back("WeightBTag::CalcWeight", events.size());
+    benchmarks.back().AddImplementation("WeightBTag",
+     [&](unsigned i){return bTagWeight->CalcWeight(events[i]);});
+    benchmarks.back().AddImplementation("WeightBTag, cached tag bits",
+     [&](unsigned i){return bTagWeight->CalcWeight(taggedEvents[i]);});
+    
+    benchmarks.emplace_back("WeightPileUp::GetWeights", nTruth.size());
+    benchmarks.back().AddImplementation("WeightPileUp",
+     [&](unsigned i){return puWeight->GetWeights(nTruth[i]).central;});
+    
+    
+    // Run them
+    cout << setw(34) << left << "interface" << setw(30) << "implementation" << right <<
+     setw(10) << "ns/call" << setw(12) << "Mcalls/s";
+    
+    if (compare)
+        cout << setw(10) << "speed-up" << setw(12) << "max |diff|";
+    
+    cout << endl;
+    
+    for (auto const &b: benchmarks)
+        b.Run(minCalls, compare);
+    
+    
+    return 0;
+}
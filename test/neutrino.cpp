@@ -0,0 +1,97 @@
+/**
+ * The program validates NeutrinoPzSolver against the original routine Nu4Momentum and compares
+ * their speed. The kinematics of the lepton and MET are generated randomly.
+ */
+
+#include <NeutrinoPzSolver.hpp>
+#include <CalculatePzNu.hpp>
+
+#include <TRandom3.h>
+#include <TLorentzVector.h>
+
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <cmath>
+
+
+using namespace std;
+
+
+int main()
+{
+    // Generate the kinematics
+    unsigned const nEvents = 1000000;
+    TRandom3 rGen(4357);
+    
+    vector<TLorentzVector> leptons(nEvents);
+    vector<float> metPts(nEvents), metPhis(nEvents);
+    vector<double> lepPx(nEvents), lepPy(nEvents), lepPz(nEvents), lepE(nEvents);
+    vector<double> metPx(nEvents), metPy(nEvents);
+    
+    for (unsigned i = 0; i < nEvents; ++i)
+    {
+        leptons[i].SetPtEtaPhiM(20. + 200. * rGen.Rndm(), rGen.Uniform(-2.5, 2.5),
+         rGen.Uniform(-M_PI, M_PI), 0.);
+        metPts[i] = 200. * rGen.Rndm();
+        metPhis[i] = rGen.Uniform(-M_PI, M_PI);
+        
+        lepPx[i] = leptons[i].Px();
+        lepPy[i] = leptons[i].Py();
+        lepPz[i] = leptons[i].Pz();
+        lepE[i] = leptons[i].E();
+        metPx[i] = float(metPts[i] * cos(metPhis[i]));
+        metPy[i] = float(metPts[i] * sin(metPhis[i]));
+    }
+    
+    
+    // Run the original routine
+    vector<double> pzOriginal(nEvents);
+    auto start = chrono::steady_clock::now();
+    
+    for (unsigned i = 0; i < nEvents; ++i)
+        pzOriginal[i] = Nu4Momentum(leptons[i], metPts[i], metPhis[i]).Pz();
+    
+    double const timeOriginal =
+     chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    
+    
+    // Run the new solver in the batch mode
+    vector<double> pzNew(nEvents);
+    start = chrono::steady_clock::now();
+    
+    NeutrinoPzSolver::Solve(nEvents, lepPx.data(), lepPy.data(), lepPz.data(), lepE.data(),
+     metPx.data(), metPy.data(), pzNew.data());
+    
+    double const timeNew = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    
+    
+    // Compare the results. The original routine squares MET in single precision and solves the
+    //cubic equations in long double, and thus small differences are expected
+    double const tolerances[] = {1e-2, 1e-4, 1e-6};
+    unsigned nDeviations[3] = {0, 0, 0};
+    double maxDeviation = 0.;
+    
+    for (unsigned i = 0; i < nEvents; ++i)
+    {
+        double const deviation = fabs(pzNew[i] - pzOriginal[i]) / max(1., fabs(pzOriginal[i]));
+        maxDeviation = max(maxDeviation, deviation);
+        
+        for (unsigned t = 0; t < 3; ++t)
+            if (deviation > tolerances[t])
+                ++nDeviations[t];
+    }
+    
+    
+    cout << "Time per event, ns: original " << timeOriginal / nEvents * 1e9 << ", new " <<
+     timeNew / nEvents * 1e9 << '\n';
+    cout << "Maximal relative deviation: " << maxDeviation << '\n';
+    
+    for (unsigned t = 0; t < 3; ++t)
+        cout << "Fraction of events with relative deviation above " << tolerances[t] << ": " <<
+         double(nDeviations[t]) / nEvents << '\n';
+    
+    
+    // Large deviations are only possible in numerically unstable configurations
+    return (double(nDeviations[0]) / nEvents < 1e-4) ? 0 : 1;
+}
@@ -0,0 +1,225 @@
+/**
+ * The program checks NtuplePlugin on synthetic PEC files. The plugin is configured with a shared
+ * scalar intermediate, which is requested by two output variables and by another intermediate,
+ * and with an output variable that depends on an intermediate of its own. Only some of the
+ * variables are requested. Evaluations of the intermediates and of the variables are counted. It
+ * is checked that:
+ *   - the shared intermediate is evaluated exactly once per event;
+ *   - variables that have not been requested and intermediates needed only for them are never
+ *     evaluated;
+ *   - each output tree contains exactly the requested branches and one entry per event, and the
+ *     stored values are consistent with each other.
+ * 
+ * Usage: ntuple [nThreads] [nFiles] [eventsPerFile] [workDirectory]
+ * The program returns a non-zero code if any inconsistency is found.
+ */
+
+#include <SyntheticPEC.hpp>
+
+#include <Dataset.hpp>
+#include <RunManager.hpp>
+#include <NtuplePlugin.hpp>
+
+#include <TFile.h>
+#include <TTree.h>
+#include <TObjArray.h>
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <list>
+#include <set>
+#include <atomic>
+#include <cstdlib>
+#include <cmath>
+
+
+using namespace std;
+
+
+/// Number of events seen by the plugin
+atomic<unsigned long> nEventsSeen(0);
+
+/// Number of evaluations of the shared intermediate
+atomic<unsigned long> nSharedEvaluations(0);
+
+/// Number of evaluations of the variable that is not requested and of its intermediate
+atomic<unsigned long> nUnrequestedEvaluations(0);
+
+
+/// Creates the plugin and registers the intermediates and the variables
+NtuplePlugin *MakePlugin(string const &outDirectory)
+{
+    NtuplePlugin *plugin = new NtuplePlugin(outDirectory);
+    
+    
+    // The shared intermediate is needed by two variables and by another intermediate
+    auto const shared = plugin->DefineScalar("Shared", [](NtuplePlugin::Context &c)
+    {
+        ++nSharedEvaluations;
+        return c->GetMET().Pt() + c->GetLeptons().size();
+    });
+    
+    auto const derived = plugin->DefineScalar("Derived",
+     [shared](NtuplePlugin::Context &c){return c.Get(shared) * c.Get(shared);});
+    
+    
+    // The intermediate needed only by a variable that is not requested
+    auto const unused = plugin->DefineScalar("Unused", [](NtuplePlugin::Context &)
+    {
+        ++nUnrequestedEvaluations;
+        return 1.;
+    });
+    
+    
+    // Output variables
+    plugin->AddVariable("event", [](NtuplePlugin::Context &c){return c->GetEventID().Event();},
+     NtuplePlugin::Type::ULong64);
+    plugin->AddVariable("Twice", [shared](NtuplePlugin::Context &c){return 2. * c.Get(shared);});
+    plugin->AddVariable("Plus1", [shared](NtuplePlugin::Context &c){return c.Get(shared) + 1.;});
+    plugin->AddVariable("Square", [derived](NtuplePlugin::Context &c){return c.Get(derived);});
+    plugin->AddVariable("NotRequested", [unused](NtuplePlugin::Context &c)
+    {
+        ++nUnrequestedEvaluations;
+        return c.Get(unused);
+    });
+    
+    plugin->RequestVariables({"event", "Twice", "Plus1", "Square"});
+    
+    
+    // The filter accepts all the events and is only used to count them
+    plugin->SetEventFilter([](NtuplePlugin::Context &){++nEventsSeen; return true;});
+    
+    return plugin;
+}
+
+
+/**
+ * \brief Checks the output file written for the given input file
+ * 
+ * Returns the number of errors.
+ */
+unsigned CheckOutput(string const &fileName, unsigned long eventsPerFile)
+{
+    TFile file(fileName.c_str());
+    TTree *tree = dynamic_cast<TTree *>(file.Get("Vars"));
+    
+    if (not tree)
+    {
+        cout << "Tree \"Vars\" is not found in file \"" << fileName << "\"." << endl;
+        return 1;
+    }
+    
+    unsigned nErrors = 0;
+    
+    
+    // Compare the list of branches with the requested variables
+    set<string> branchNames;
+    
+    TObjArray const *branches = tree->GetListOfBranches();
+    
+    for (int i = 0; i < branches->GetEntriesFast(); ++i)
+        branchNames.insert(branches->At(i)->GetName());
+    
+    if (branchNames != set<string>{"event", "Twice", "Plus1", "Square"})
+    {
+        cout << "File \"" << fileName << "\" contains unexpected set of branches:";
+        
+        for (auto const &name: branchNames)
+            cout << " " << name;
+        
+        cout << endl;
+        ++nErrors;
+    }
+    
+    if ((unsigned long)tree->GetEntries() != eventsPerFile)
+    {
+        cout << "File \"" << fileName << "\" contains " << tree->GetEntries() << " entries " <<
+         "instead of " << eventsPerFile << "." << endl;
+        ++nErrors;
+    }
+    
+    if (nErrors > 0)
+        return nErrors;
+    
+    
+    // The values of the variables are computed from the same intermediate
+    Float_t twice, plus1, square;
+    tree->SetBranchAddress("Twice", &twice);
+    tree->SetBranchAddress("Plus1", &plus1);
+    tree->SetBranchAddress("Square", &square);
+    
+    for (long entry = 0; entry < tree->GetEntries(); ++entry)
+    {
+        tree->GetEntry(entry);
+        double const shared = plus1 - 1.;
+        
+        if (fabs(twice - 2. * shared) > 1e-4 * fabs(twice) + 1e-4 or
+         fabs(square - shared * shared) > 1e-4 * fabs(square) + 1e-4)
+        {
+            cout << "Inconsistent values in entry " << entry << " of file \"" << fileName <<
+             "\"." << endl;
+            ++nErrors;
+            break;
+        }
+    }
+    
+    return nErrors;
+}
+
+
+int main(int argc, char **argv)
+{
+    // Parse the arguments
+    unsigned const nThreads = (argc > 1) ? atoi(argv[1]) : 2;
+    unsigned const nFiles = (argc > 2) ? atoi(argv[2]) : 4;
+    unsigned long const eventsPerFile = (argc > 3) ? atol(argv[3]) : 1000;
+    string workDir((argc > 4) ? argv[4] : "ntuple-data");
+    
+    if (nThreads == 0 or nFiles == 0 or eventsPerFile == 0)
+    {
+        cerr << "Usage: " << argv[0] << " [nThreads] [nFiles] [eventsPerFile] [workDirectory]\n";
+        return 1;
+    }
+    
+    PrepareWorkDirectory(workDir, false);
+    vector<string> const fileNames(EnsureSyntheticFiles(workDir, nFiles, eventsPerFile));
+    string const outDirectory(workDir + "ntuples/");
+    
+    
+    // Process the files without any selection
+    list<Dataset> datasets(MakeSyntheticDatasets(fileNames, eventsPerFile));
+    RunManager manager(datasets.begin(), datasets.end());
+    manager.RegisterPlugin(MakePlugin(outDirectory));
+    manager.Process(int(nThreads));
+    
+    
+    // Check the numbers of evaluations
+    unsigned long const nEvents = nFiles * eventsPerFile;
+    unsigned nErrors = 0;
+    
+    if (nEventsSeen != nEvents or nSharedEvaluations != nEventsSeen)
+    {
+        cout << "The shared intermediate is evaluated " << nSharedEvaluations << " times in " <<
+         nEventsSeen << " events (" << nEvents << " events expected)." << endl;
+        ++nErrors;
+    }
+    
+    if (nUnrequestedEvaluations != 0)
+    {
+        cout << "The variable that has not been requested or its intermediate is evaluated " <<
+         nUnrequestedEvaluations << " times." << endl;
+        ++nErrors;
+    }
+    
+    
+    // Check the output files
+    for (auto const &d: datasets)
+        for (auto const &f: d.GetFiles())
+            nErrors += CheckOutput(outDirectory + f.GetBaseName() + ".root", eventsPerFile);
+    
+    
+    cout << ((nErrors == 0) ? "Ntuple test passed." : "Ntuple test FAILED.") << endl;
+    
+    return (nErrors == 0) ? 0 : 2;
+}
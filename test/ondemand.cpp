@@ -0,0 +1,201 @@
+/**
+ * The program checks that generator-level collections built by PECReader on demand are memoized
+ * per event. Synthetic PEC files are processed with the hard interaction, generator jets, and
+ * partons from parton shower requested. A dedicated plugin registers a filter evaluated by the
+ * reader after the jets have been built, i.e. for candidate events that have not been accepted
+ * yet. In the filter every collection is requested twice; the first request must read the
+ * corresponding branches, and the second one must not read anything. The filter rejects events
+ * with odd event numbers. In the accepted events the plugin requests all the collections again,
+ * which must not trigger any reads either since they have been built for the same event in the
+ * filter. Numbers of reads are measured with PECReader::GetNumBranchReadsSourceFile.
+ * 
+ * Usage: ondemand [nThreads] [nFiles] [eventsPerFile] [workDirectory]
+ * The program returns a non-zero code if any inconsistency is found.
+ */
+
+#include <SyntheticPEC.hpp>
+
+#include <Dataset.hpp>
+#include <RunManager.hpp>
+#include <Processor.hpp>
+#include <PECReaderPlugin.hpp>
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <list>
+#include <atomic>
+#include <functional>
+#include <cstdlib>
+
+
+using namespace std;
+
+
+/// Returns the number of branch reads triggered by the given request to the reader
+unsigned long long CountReads(PECReader const &reader, function<void()> const &request)
+{
+    unsigned long long const nReadsBefore = reader.GetNumBranchReadsSourceFile();
+    request();
+    
+    return reader.GetNumBranchReadsSourceFile() - nReadsBefore;
+}
+
+
+/**
+ * \class OnDemandPlugin
+ * \brief Requests the collections built on demand and checks the numbers of branch reads
+ * 
+ * Numbers of checked and inconsistent events are accumulated in global atomic counters.
+ */
+class OnDemandPlugin: public Plugin
+{
+public:
+    /// Constructor
+    OnDemandPlugin();
+
+public:
+    /// Creates a newly-initialised copy
+    Plugin *Clone() const;
+    
+    /// Saves pointer to the reader plugin
+    void BeginRun(Dataset const &);
+    
+    /**
+     * \brief Checks that the collections are not read again in an accepted event
+     * 
+     * Accepts events with even event numbers, as the filter does.
+     */
+    bool ProcessEvent();
+    
+    /// Registers the filter that requests the collections in candidate events
+    bool RegisterEarlyFilters(PECReader &reader) const;
+
+public:
+    /// Number of candidate events seen by the filter
+    static atomic<unsigned long> nCandidates;
+    
+    /// Number of accepted events
+    static atomic<unsigned long> nAccepted;
+    
+    /// Number of events in which the numbers of reads are not as expected
+    static atomic<unsigned long> nBadEvents;
+
+private:
+    /// Requests all the collections and checks that each of them is read once
+    static bool Filter(PECReader const &reader);
+
+private:
+    /// Pointer to the reader plugin
+    PECReaderPlugin const *reader;
+};
+
+
+atomic<unsigned long> OnDemandPlugin::nCandidates(0);
+atomic<unsigned long> OnDemandPlugin::nAccepted(0);
+atomic<unsigned long> OnDemandPlugin::nBadEvents(0);
+
+
+OnDemandPlugin::OnDemandPlugin():
+    Plugin("OnDemand")
+{}
+
+
+Plugin *OnDemandPlugin::Clone() const
+{
+    return new OnDemandPlugin;
+}
+
+
+void OnDemandPlugin::BeginRun(Dataset const &)
+{
+    reader = dynamic_cast<PECReaderPlugin const *>(processor->GetPluginBefore("Reader", name));
+}
+
+
+bool OnDemandPlugin::ProcessEvent()
+{
+    PECReader const &r = **reader;
+    
+    // The collections have been built in the filter for this event
+    unsigned long long const nReads = CountReads(r, [&r](){r.GetHardProcessRecord();
+     r.GetHardGenParticles(); r.GetGenJets(); r.GetShowerPartons();});
+    
+    if (nReads != 0 or r.GetEventID().Event() % 2 != 0)
+        ++nBadEvents;
+    
+    ++nAccepted;
+    return (r.GetEventID().Event() % 2 == 0);
+}
+
+
+bool OnDemandPlugin::RegisterEarlyFilters(PECReader &r) const
+{
+    r.AddEventFilter(PECReader::EventFilterStage::Jets, Filter);
+    return true;
+}
+
+
+bool OnDemandPlugin::Filter(PECReader const &r)
+{
+    vector<function<void()>> const requests{[&r](){r.GetHardProcessRecord();},
+     [&r](){r.GetGenJets();}, [&r](){r.GetShowerPartons();}};
+    bool ok = true;
+    
+    for (auto const &request: requests)
+        ok = (ok and CountReads(r, request) > 0 and CountReads(r, request) == 0);
+    
+    // The linked particles are built from the record without reading the branches
+    ok = (ok and CountReads(r, [&r](){r.GetHardGenParticles();}) == 0);
+    
+    if (not ok)
+        ++nBadEvents;
+    
+    ++nCandidates;
+    return (r.GetEventID().Event() % 2 == 0);
+}
+
+
+int main(int argc, char **argv)
+{
+    // Parse the arguments
+    unsigned const nThreads = (argc > 1) ? atoi(argv[1]) : 2;
+    unsigned const nFiles = (argc > 2) ? atoi(argv[2]) : 4;
+    unsigned long const eventsPerFile = (argc > 3) ? atol(argv[3]) : 500;
+    string workDir((argc > 4) ? argv[4] : "ondemand-data");
+    
+    if (nThreads == 0 or nFiles == 0 or eventsPerFile == 0)
+    {
+        cerr << "Usage: " << argv[0] << " [nThreads] [nFiles] [eventsPerFile] [workDirectory]\n";
+        return 1;
+    }
+    
+    PrepareWorkDirectory(workDir, false);
+    vector<string> const fileNames(EnsureSyntheticFiles(workDir, nFiles, eventsPerFile));
+    
+    
+    // Process the files. No selection is applied, so all the events are candidates
+    list<Dataset> datasets(MakeSyntheticDatasets(fileNames, eventsPerFile));
+    RunManager manager(datasets.begin(), datasets.end());
+    
+    PECReaderConfig &config = manager.GetPECReaderConfig();
+    config.SetReadHardInteraction(true);
+    config.SetReadGenJets(true);
+    config.SetReadPartonShower(true);
+    
+    manager.RegisterPlugin(new OnDemandPlugin);
+    manager.Process(int(nThreads));
+    
+    
+    // Check the results
+    unsigned long const nEvents = nFiles * eventsPerFile;
+    bool const success = (OnDemandPlugin::nCandidates == nEvents and
+     OnDemandPlugin::nAccepted == nEvents / 2 and OnDemandPlugin::nBadEvents == 0);
+    
+    cout << OnDemandPlugin::nCandidates << " candidate events, " << OnDemandPlugin::nAccepted <<
+     " accepted events, " << OnDemandPlugin::nBadEvents << " events with unexpected reads." << endl;
+    cout << ((success) ? "On-demand reading test passed." : "On-demand reading test FAILED.") <<
+     endl;
+    
+    return (success) ? 0 : 2;
+}
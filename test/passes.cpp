@@ -0,0 +1,241 @@
+/**
+ * The program checks repeated calls to RunManager::Process with the persistent pool of threads.
+ * Synthetic PEC files are processed in several passes by the same instance of RunManager:
+ *   - the first half of the files with the requested number of threads and a single plugin;
+ *   - the second half with one more thread, after a second plugin has been registered;
+ *   - the first half again with a single thread, so that the same files are processed twice;
+ *   - an empty pass, in which no datasets remain.
+ * Datasets are split into per-node queues in all the passes. In each pass it is checked that every
+ * plugin has processed each of the files added for the pass exactly once and has read all their
+ * events, that no other file has been processed, and that EndPass has been called exactly once
+ * for every plugin.
+ * 
+ * Usage: passes [nThreads] [nFiles] [eventsPerFile] [workDirectory]
+ * The program returns a non-zero code if any inconsistency is found.
+ */
+
+#include <SyntheticPEC.hpp>
+
+#include <Dataset.hpp>
+#include <RunManager.hpp>
+#include <Plugin.hpp>
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <list>
+#include <map>
+#include <mutex>
+#include <cstdlib>
+
+
+using namespace std;
+
+
+/**
+ * \class CountingPlugin
+ * \brief Counts events in each processed file
+ * 
+ * The results are accumulated in global containers indexed with the name of the plugin, so that
+ * all the clones of a plugin contribute to the same entry.
+ */
+class CountingPlugin: public Plugin
+{
+public:
+    /// Constructor
+    CountingPlugin(string const &name);
+
+public:
+    /// Creates a newly-initialised copy
+    Plugin *Clone() const;
+    
+    /// Remembers the name of the file and resets the counter
+    void BeginRun(Dataset const &dataset);
+    
+    /// Records the number of events in the processed file
+    void EndRun();
+    
+    /// Counts the event
+    bool ProcessEvent();
+    
+    /// Counts the calls to this method
+    void EndPass();
+
+public:
+    /// Numbers of events read in each file, indexed with names of the plugin and of the file
+    static map<string, map<string, vector<unsigned long>>> eventCounts;
+    
+    /// Numbers of calls to EndPass, indexed with name of the plugin
+    static map<string, unsigned> nEndPassCalls;
+    
+    /// Mutex to protect the containers above
+    static mutex countsMutex;
+
+private:
+    /// Name of the file being processed
+    string fileName;
+    
+    /// Number of events read in the current file
+    unsigned long nEvents;
+};
+
+
+map<string, map<string, vector<unsigned long>>> CountingPlugin::eventCounts;
+map<string, unsigned> CountingPlugin::nEndPassCalls;
+mutex CountingPlugin::countsMutex;
+
+
+CountingPlugin::CountingPlugin(string const &name):
+    Plugin(name)
+{}
+
+
+Plugin *CountingPlugin::Clone() const
+{
+    return new CountingPlugin(name);
+}
+
+
+void CountingPlugin::BeginRun(Dataset const &dataset)
+{
+    fileName = dataset.GetFiles().front().name;
+    nEvents = 0;
+}
+
+
+void CountingPlugin::EndRun()
+{
+    lock_guard<mutex> lock(countsMutex);
+    eventCounts[name][fileName].push_back(nEvents);
+}
+
+
+bool CountingPlugin::ProcessEvent()
+{
+    ++nEvents;
+    return true;
+}
+
+
+void CountingPlugin::EndPass()
+{
+    lock_guard<mutex> lock(countsMutex);
+    ++nEndPassCalls[name];
+}
+
+
+/**
+ * \brief Checks the counts collected in a pass and resets them
+ * 
+ * Each of the given plugins must have processed each of the given files exactly once, reading
+ * eventsPerFile events, and must have been notified about the end of the pass once. Returns the
+ * number of errors.
+ */
+unsigned CheckPass(string const &label, vector<string> const &pluginNames,
+ vector<string> const &fileNames, unsigned long eventsPerFile)
+{
+    unsigned nErrors = 0;
+    
+    for (auto const &pluginName: pluginNames)
+    {
+        auto &counts = CountingPlugin::eventCounts[pluginName];
+        
+        for (auto const &fileName: fileNames)
+        {
+            auto const res = counts.find(fileName);
+            
+            if (res == counts.end() or res->second.size() != 1 or
+             res->second.front() != eventsPerFile)
+            {
+                cout << label << ": plugin \"" << pluginName << "\" has not processed file \"" <<
+                 fileName << "\" exactly once." << endl;
+                ++nErrors;
+            }
+            
+            if (res != counts.end())
+                counts.erase(res);
+        }
+        
+        for (auto const &c: counts)
+        {
+            cout << label << ": plugin \"" << pluginName << "\" has processed unexpected file \"" <<
+             c.first << "\"." << endl;
+            ++nErrors;
+        }
+        
+        if (CountingPlugin::nEndPassCalls[pluginName] != 1)
+        {
+            cout << label << ": EndPass has been called " <<
+             CountingPlugin::nEndPassCalls[pluginName] << " times for plugin \"" << pluginName <<
+             "\"." << endl;
+            ++nErrors;
+        }
+    }
+    
+    
+    // Reset the counts for the next pass
+    CountingPlugin::eventCounts.clear();
+    CountingPlugin::nEndPassCalls.clear();
+    
+    return nErrors;
+}
+
+
+int main(int argc, char **argv)
+{
+    // Parse the arguments
+    unsigned const nThreads = (argc > 1) ? atoi(argv[1]) : 3;
+    unsigned const nFiles = (argc > 2) ? atoi(argv[2]) : 8;
+    unsigned long const eventsPerFile = (argc > 3) ? atol(argv[3]) : 100;
+    string workDir((argc > 4) ? argv[4] : "passes-data");
+    
+    if (nThreads == 0 or nFiles < 2 or eventsPerFile == 0)
+    {
+        cerr << "Usage: " << argv[0] << " [nThreads] [nFiles] [eventsPerFile] [workDirectory]\n";
+        cerr << "At least two files are needed.\n";
+        return 1;
+    }
+    
+    PrepareWorkDirectory(workDir, false);
+    vector<string> const fileNames(EnsureSyntheticFiles(workDir, nFiles, eventsPerFile));
+    vector<string> const firstHalf(fileNames.begin(), fileNames.begin() + nFiles / 2);
+    vector<string> const secondHalf(fileNames.begin() + nFiles / 2, fileNames.end());
+    unsigned nErrors = 0;
+    
+    
+    // The first pass with a single plugin
+    list<Dataset> datasets(MakeSyntheticDatasets(firstHalf, eventsPerFile));
+    RunManager manager(datasets.begin(), datasets.end());
+    manager.SetThreadPlacement(false, true);
+    manager.RegisterPlugin(new CountingPlugin("First"));
+    
+    manager.Process(int(nThreads));
+    nErrors += CheckPass("Pass 1", {"First"}, firstHalf, eventsPerFile);
+    
+    
+    // The second pass with another plugin and an extended pool
+    datasets = MakeSyntheticDatasets(secondHalf, eventsPerFile);
+    manager.AddDatasets(datasets.begin(), datasets.end());
+    manager.RegisterPlugin(new CountingPlugin("Second"));
+    
+    manager.Process(int(nThreads + 1));
+    nErrors += CheckPass("Pass 2", {"First", "Second"}, secondHalf, eventsPerFile);
+    
+    
+    // The same files as in the first pass are processed again with a single active thread
+    datasets = MakeSyntheticDatasets(firstHalf, eventsPerFile);
+    manager.AddDatasets(datasets.begin(), datasets.end());
+    
+    manager.Process(1);
+    nErrors += CheckPass("Pass 3", {"First", "Second"}, firstHalf, eventsPerFile);
+    
+    
+    // A pass without any datasets. The plugins are still notified about its end
+    manager.Process(int(nThreads));
+    nErrors += CheckPass("Pass 4", {"First", "Second"}, {}, eventsPerFile);
+    
+    
+    cout << ((nErrors == 0) ? "Passes test passed." : "Passes test FAILED.") << endl;
+    
+    return (nErrors == 0) ? 0 : 2;
+}
@@ -0,0 +1,112 @@
+/**
+ * The program studies how the processing scales with the number of threads. The same workload
+ * (PECReader with event selection, b-tagging and pile-up reweighting, and a plugin writing output
+ * trees) is run with 1, 2, 4, ... threads on synthetic PEC files. For each run the contention
+ * profiler of RunManager is enabled, so that the usage of the global locks and the activity of
+ * individual threads is printed by the framework. At the end a table with the wall time, the
+ * throughput, the speed-up with respect to a single thread, and the parallel efficiency (speed-up
+ * divided by the number of threads) is printed.
+ * 
+ * Usage: scaling [maxThreads] [nFiles] [eventsPerFile] [workDirectory]
+ * The input files are shared with program benchmark if the same working directory is used.
+ */
+
+#include <SyntheticPEC.hpp>
+
+#include <RunManager.hpp>
+#include <BasicKinematicsPlugin.hpp>
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <list>
+#include <memory>
+#include <chrono>
+#include <thread>
+#include <cstdlib>
+
+
+using namespace std;
+
+
+/// Results of a single run
+struct RunResult
+{
+    unsigned nThreads;
+    double time;
+};
+
+
+int main(int argc, char **argv)
+{
+    // Parse the arguments
+    unsigned const nHardwareThreads = max(thread::hardware_concurrency(), 1u);
+    unsigned const maxThreads = (argc > 1) ? atoi(argv[1]) : nHardwareThreads;
+    unsigned const nFiles = (argc > 2) ? atoi(argv[2]) : 2 * maxThreads;
+    unsigned long const eventsPerFile = (argc > 3) ? atol(argv[3]) : 20000;
+    string workDir((argc > 4) ? argv[4] : "benchmark-data");
+    
+    if (maxThreads == 0 or nFiles == 0 or eventsPerFile == 0)
+    {
+        cerr << "Usage: " << argv[0] << " [maxThreads] [nFiles] [eventsPerFile] [workDirectory]\n";
+        return 1;
+    }
+    
+    PrepareWorkDirectory(workDir);
+    vector<string> const fileNames(EnsureSyntheticFiles(workDir, nFiles, eventsPerFile));
+    
+    
+    // Run the same workload with different numbers of threads
+    unsigned long const nEventsTotal = nFiles * eventsPerFile;
+    vector<RunResult> results;
+    
+    for (unsigned nThreads = 1; ; nThreads = min(2 * nThreads, maxThreads))
+    {
+        cout << "\nProcessing with " << nThreads << " thread(s)..." << endl;
+        
+        
+        // Define the dataset and the modules. The modules must outlive the run manager
+        list<Dataset> datasets(MakeSyntheticDatasets(fileNames, eventsPerFile));
+        SyntheticAnalysis analysis(workDir);
+        
+        
+        // Set up the run manager
+        RunManager manager(datasets.begin(), datasets.end());
+        analysis.Configure(manager.GetPECReaderConfig());
+        
+        manager.RegisterPlugin(new BasicKinematicsPlugin(workDir + "output"));
+        manager.SetContentionProfiling();
+        
+        
+        // Process the dataset and measure the wall time
+        auto const start = chrono::steady_clock::now();
+        manager.Process(int(nThreads));
+        auto const end = chrono::steady_clock::now();
+        
+        results.push_back({nThreads, chrono::duration<double>(end - start).count()});
+        
+        if (nThreads == maxThreads)
+            break;
+    }
+    
+    
+    // Print the scaling table
+    cout << "\n" << nFiles << " files, " << nEventsTotal << " events in total\n\n";
+    cout << setw(10) << "threads" << setw(12) << "time, s" << setw(14) << "events/s" <<
+     setw(12) << "speed-up" << setw(14) << "efficiency" << endl;
+    
+    double const singleThreadTime = results.front().time;
+    
+    for (auto const &r: results)
+    {
+        double const speedUp = singleThreadTime / r.time;
+        
+        cout << setw(10) << r.nThreads << fixed << setw(12) << setprecision(2) << r.time <<
+         setw(14) << setprecision(0) << nEventsTotal / r.time << setw(12) << setprecision(2) <<
+         speedUp << setw(13) << setprecision(1) << 100. * speedUp / r.nThreads << "%" << endl;
+    }
+    
+    
+    return 0;
+}
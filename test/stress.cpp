@@ -0,0 +1,225 @@
+/**
+ * The program is a stress test for concurrent opening and closing of input files. Input files are
+ * opened and closed by PECReader without the global ROOT lock, relying on the thread-safety mode
+ * of ROOT. To provoke possible races, a large number of small synthetic PEC files is processed with
+ * more threads than there are hardware threads, so that threads finish their files and open new
+ * ones at nearly the same moments. The processing is repeated several times. In each iteration a
+ * dedicated plugin counts the events and sums their event numbers in every file, and the results
+ * are compared with the known content of the files. The program also verifies that the global
+ * ROOT lock has not been acquired at all during the processing.
+ * 
+ * Usage: stress [nThreads] [nIterations] [nFiles] [eventsPerFile] [workDirectory]
+ * The program returns a non-zero code if any inconsistency is found.
+ */
+
+#include <SyntheticPEC.hpp>
+
+#include <Dataset.hpp>
+#include <RunManager.hpp>
+#include <Processor.hpp>
+#include <PECReaderPlugin.hpp>
+#include <ContentionProfiler.hpp>
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <list>
+#include <atomic>
+#include <thread>
+#include <cstdlib>
+
+
+using namespace std;
+
+
+/**
+ * \class ChecksumPlugin
+ * \brief Counts events in each processed file and compares the result with the expectation
+ * 
+ * Files are assumed to contain eventsPerFile events each, with consecutive event numbers. Totals
+ * over all files and the number of files with a wrong content are accumulated in global atomic
+ * counters.
+ */
+class ChecksumPlugin: public Plugin
+{
+public:
+    /// Constructor
+    ChecksumPlugin(unsigned long eventsPerFile);
+
+public:
+    /// Creates a newly-initialised copy
+    Plugin *Clone() const;
+    
+    /// Saves pointer to the reader and resets the counters
+    void BeginRun(Dataset const &);
+    
+    /// Checks the content of the processed file and updates the global counters
+    void EndRun();
+    
+    /// Counts the event
+    bool ProcessEvent();
+
+public:
+    /// Total number of processed files
+    static atomic<unsigned> nFilesTotal;
+    
+    /// Number of files whose content does not match the expectation
+    static atomic<unsigned> nBadFiles;
+    
+    /// Total number of processed events
+    static atomic<unsigned long> nEventsTotal;
+    
+    /// Sum of event numbers over all processed events
+    static atomic<unsigned long long> eventNumberSum;
+
+private:
+    /// Pointer to the reader plugin
+    PECReaderPlugin const *reader;
+    
+    /// Expected number of events in each file
+    unsigned long eventsPerFile;
+    
+    /// Number of events in the current file
+    unsigned long nEvents;
+    
+    /// Smallest and largest event numbers in the current file
+    unsigned long minEventNumber, maxEventNumber;
+    
+    /// Sum of event numbers in the current file
+    unsigned long long sum;
+};
+
+
+atomic<unsigned> ChecksumPlugin::nFilesTotal(0);
+atomic<unsigned> ChecksumPlugin::nBadFiles(0);
+atomic<unsigned long> ChecksumPlugin::nEventsTotal(0);
+atomic<unsigned long long> ChecksumPlugin::eventNumberSum(0);
+
+
+ChecksumPlugin::ChecksumPlugin(unsigned long eventsPerFile_):
+    Plugin("Checksum"),
+    eventsPerFile(eventsPerFile_)
+{}
+
+
+Plugin *ChecksumPlugin::Clone() const
+{
+    return new ChecksumPlugin(eventsPerFile);
+}
+
+
+void ChecksumPlugin::BeginRun(Dataset const &)
+{
+    reader = dynamic_cast<PECReaderPlugin const *>(processor->GetPluginBefore("Reader", name));
+    
+    nEvents = 0;
+    minEventNumber = -1;
+    maxEventNumber = 0;
+    sum = 0;
+}
+
+
+void ChecksumPlugin::EndRun()
+{
+    // A file contains consecutive event numbers from minEventNumber to maxEventNumber
+    unsigned long long const expectedSum =
+     (unsigned long long)(minEventNumber + maxEventNumber) * eventsPerFile / 2;
+    
+    if (nEvents != eventsPerFile or maxEventNumber - minEventNumber + 1 != eventsPerFile or
+     sum != expectedSum)
+        ++nBadFiles;
+    
+    ++nFilesTotal;
+    nEventsTotal += nEvents;
+    eventNumberSum += sum;
+}
+
+
+bool ChecksumPlugin::ProcessEvent()
+{
+    unsigned long const eventNumber = (*reader)->GetEventID().Event();
+    
+    ++nEvents;
+    sum += eventNumber;
+    minEventNumber = min(minEventNumber, eventNumber);
+    maxEventNumber = max(maxEventNumber, eventNumber);
+    
+    return true;
+}
+
+
+int main(int argc, char **argv)
+{
+    // Parse the arguments
+    unsigned const nHardwareThreads = max(thread::hardware_concurrency(), 1u);
+    unsigned const nThreads = (argc > 1) ? atoi(argv[1]) : 2 * nHardwareThreads;
+    unsigned const nIterations = (argc > 2) ? atoi(argv[2]) : 10;
+    unsigned const nFiles = (argc > 3) ? atoi(argv[3]) : 50 * nThreads;
+    unsigned long const eventsPerFile = (argc > 4) ? atol(argv[4]) : 20;
+    string workDir((argc > 5) ? argv[5] : "stress-data");
+    
+    if (nThreads == 0 or nIterations == 0 or nFiles == 0 or eventsPerFile == 0)
+    {
+        cerr << "Usage: " << argv[0] <<
+         " [nThreads] [nIterations] [nFiles] [eventsPerFile] [workDirectory]\n";
+        return 1;
+    }
+    
+    PrepareWorkDirectory(workDir, false);
+    
+    
+    // Generate the input files unless they have already been created. Event numbers in file i
+    //start from i * eventsPerFile + 1
+    vector<string> const fileNames(EnsureSyntheticFiles(workDir, nFiles, eventsPerFile));
+    
+    unsigned long const nEventsExpected = nFiles * eventsPerFile;
+    unsigned long long const sumExpected =
+     (unsigned long long)nEventsExpected * (nEventsExpected + 1) / 2;
+    
+    
+    // Process the files repeatedly
+    cout << "Processing " << nFiles << " files with " << nEventsExpected << " events in total " <<
+     "using " << nThreads << " threads, " << nIterations << " iterations" << endl;
+    
+    bool success = true;
+    
+    for (unsigned iteration = 0; iteration < nIterations; ++iteration)
+    {
+        ChecksumPlugin::nFilesTotal = 0;
+        ChecksumPlugin::nBadFiles = 0;
+        ChecksumPlugin::nEventsTotal = 0;
+        ChecksumPlugin::eventNumberSum = 0;
+        
+        
+        // Define the dataset
+        list<Dataset> datasets(MakeSyntheticDatasets(fileNames, eventsPerFile));
+        
+        
+        // Process it. The profiler is enabled to count acquisitions of the ROOT lock
+        RunManager manager(datasets.begin(), datasets.end());
+        manager.RegisterPlugin(new ChecksumPlugin(eventsPerFile));
+        manager.SetContentionProfiling();
+        manager.Process(int(nThreads));
+        
+        
+        // Check the results
+        unsigned long const nROOTLocks =
+         ContentionProfiler::GetLockStats(ContentionProfiler::LockID::ROOT).nAcquisitions;
+        bool const passed = (ChecksumPlugin::nFilesTotal == nFiles and
+         ChecksumPlugin::nBadFiles == 0 and ChecksumPlugin::nEventsTotal == nEventsExpected and
+         ChecksumPlugin::eventNumberSum == sumExpected and nROOTLocks == 0);
+        
+        cout << "Iteration " << iteration << ": " << ChecksumPlugin::nFilesTotal << " files (" <<
+         ChecksumPlugin::nBadFiles << " inconsistent), " << ChecksumPlugin::nEventsTotal <<
+         " events, checksum " <<
+         ((ChecksumPlugin::eventNumberSum == sumExpected) ? "OK" : "FAIL") << ", " <<
+         nROOTLocks << " acquisitions of ROOT lock: " << ((passed) ? "PASSED" : "FAILED") << endl;
+        
+        success = success and passed;
+    }
+    
+    
+    cout << ((success) ? "Stress test passed." : "Stress test FAILED.") << endl;
+    
+    return (success) ? 0 : 2;
+}
@@ -0,0 +1,173 @@
+/**
+ * The program checks that trigger decisions are read correctly by TriggerSelection. A small file
+ * with a trigger tree is generated, in which the decisions of several triggers follow known
+ * patterns. Run 1 occupies the first half of the entries and run 2 the second one. The file is
+ * read in data mode, where trigger "A" is used for run 1 and trigger "B" for run 2, and in MC
+ * mode, where an event is accepted if either trigger fires. Both modes are tested with and
+ * without preloading of the decisions, and the decision of every event is compared with the
+ * expectation.
+ * 
+ * Usage: triggers [nEntries] [workDirectory]
+ * The program returns a non-zero code if any decision is wrong.
+ */
+
+#include <TriggerSelection.hpp>
+#include <EventID.hpp>
+
+#include <TFile.h>
+#include <TTree.h>
+
+#include <sys/stat.h>
+
+#include <iostream>
+#include <string>
+#include <list>
+#include <memory>
+#include <stdexcept>
+#include <cstdlib>
+
+
+using namespace std;
+
+
+/// Decision of trigger "A" in the given entry
+bool DecisionA(unsigned long entry)
+{
+    return (entry % 3 == 0);
+}
+
+
+/// Decision of trigger "B" in the given entry
+bool DecisionB(unsigned long entry)
+{
+    return (entry % 5 == 0 or entry % 7 == 1);
+}
+
+
+/**
+ * \brief Writes a trigger tree with decisions of triggers "A", "B", and "C"
+ * 
+ * Trigger "C" fires in every event; it is never requested and must not affect the results.
+ */
+void WriteTriggerFile(string const &fileName, unsigned long nEntries)
+{
+    TFile file(fileName.c_str(), "recreate");
+    
+    if (file.IsZombie())
+        throw runtime_error(string("WriteTriggerFile: Failed to create file \"") + fileName +
+         "\".");
+    
+    file.mkdir("trigger")->cd();
+    TTree *tree = new TTree("TriggerInfo", "");
+    
+    Bool_t a, b, c;
+    tree->Branch("A__accept", &a, "A__accept/O");
+    tree->Branch("B__accept", &b, "B__accept/O");
+    tree->Branch("C__accept", &c, "C__accept/O");
+    
+    for (unsigned long entry = 0; entry < nEntries; ++entry)
+    {
+        a = DecisionA(entry);
+        b = DecisionB(entry);
+        c = true;
+        tree->Fill();
+    }
+    
+    file.Write();
+    file.Close();
+}
+
+
+/**
+ * \brief Reads the whole trigger tree with the given selection and checks every decision
+ * 
+ * Returns the number of wrong decisions.
+ */
+unsigned long CheckDecisions(TriggerSelection &selection, TTree *tree, bool isData)
+{
+    unsigned long const nEntries = tree->GetEntries();
+    selection.UpdateTree(tree, isData);
+    
+    unsigned long nErrors = 0;
+    unsigned long entry = 0;
+    
+    while (selection.ReadNextEvent(EventID((entry < nEntries / 2) ? 1 : 2, 1, entry + 1)))
+    {
+        bool expected;
+        
+        if (isData)
+            expected = (entry < nEntries / 2) ? DecisionA(entry) : DecisionB(entry);
+        else
+            expected = DecisionA(entry) or DecisionB(entry);
+        
+        if (selection.PassTrigger() != expected)
+            ++nErrors;
+        
+        ++entry;
+    }
+    
+    if (entry != nEntries)
+        ++nErrors;
+    
+    return nErrors;
+}
+
+
+int main(int argc, char **argv)
+{
+    // Parse the arguments
+    unsigned long const nEntries = (argc > 1) ? atol(argv[1]) : 1000;
+    string workDir((argc > 2) ? argv[2] : "triggers-data");
+    
+    if (nEntries < 2)
+    {
+        cerr << "Usage: " << argv[0] << " [nEntries] [workDirectory]\n";
+        return 1;
+    }
+    
+    if (workDir.back() != '/')
+        workDir += '/';
+    
+    mkdir(workDir.c_str(), 0755);
+    
+    
+    // Write the file and open it for reading
+    string const fileName(workDir + "triggers.root");
+    WriteTriggerFile(fileName, nEntries);
+    
+    unique_ptr<TFile> file(TFile::Open(fileName.c_str()));
+    TTree *tree = dynamic_cast<TTree *>(file->Get("trigger/TriggerInfo"));
+    
+    
+    // Define the trigger ranges
+    list<TriggerRange> ranges;
+    ranges.emplace_back(1, 1, "A", 1., "A");
+    ranges.emplace_back(2, 2, "B", 1., "B");
+    
+    
+    // Check the decisions in all the modes. Each selection object reads the tree twice to make
+    //sure that it is correctly reconfigured for a new tree
+    bool success = true;
+    
+    for (bool isData: {true, false})
+        for (bool preload: {false, true})
+        {
+            TriggerSelection selection(ranges);
+            selection.SetPreloadTriggerBits(preload);
+            
+            unsigned long nErrors = 0;
+            
+            for (unsigned pass = 0; pass < 2; ++pass)
+                nErrors += CheckDecisions(selection, tree, isData);
+            
+            cout << ((isData) ? "Data" : "MC") << ((preload) ? ", preloaded" : "") << ": " <<
+             nErrors << " wrong decisions" << endl;
+            
+            success = success and (nErrors == 0);
+        }
+    
+    
+    cout << ((success) ? "Trigger test passed." : "Trigger test FAILED.") << endl;
+    
+    return (success) ? 0 : 2;
+}